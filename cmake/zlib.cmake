@@ -0,0 +1,11 @@
+#
+# Copyright (C) 2020 Codership Oy <info@codership.com>
+#
+# zlib is used for IST stream and write set compression. It is required:
+# a node must be able to decompress write sets replicated by any peer.
+#
+
+find_package(ZLIB REQUIRED)
+include_directories(SYSTEM ${ZLIB_INCLUDE_DIRS})
+set(GALERA_ZLIB_LIBS ${ZLIB_LIBRARIES})
+message(STATUS "GALERA_ZLIB_LIBS: ${GALERA_ZLIB_LIBS}")
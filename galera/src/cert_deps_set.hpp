@@ -0,0 +1,109 @@
+//
+// Copyright (C) 2020 Codership Oy <info@codership.com>
+//
+
+#ifndef GALERA_CERT_DEPS_SET_HPP
+#define GALERA_CERT_DEPS_SET_HPP
+
+#include "wsrep_api.h"
+
+#include "gu_deqmap.hpp"
+
+#include <set>
+#include <algorithm>
+#include <cassert>
+
+namespace galera
+{
+    /*!
+     * Multiset of last seen seqnos of certified but not yet committed trxs.
+     *
+     * Last seen seqnos are mostly increasing and are close to each other,
+     * so they are counted in a seqno-indexed ring: insertion, removal and
+     * min lookup are O(1). Seqnos too far from the ring range (which is
+     * possible for trxs that fail certification) are kept in a small
+     * std::multiset not to bloat the ring with holes.
+     */
+    class CertDepsSet
+    {
+    public:
+
+        CertDepsSet() : ring_(0), outliers_(), size_(0) {}
+
+        size_t size()  const { return size_;      }
+        bool   empty() const { return size_ == 0; }
+
+        void insert(wsrep_seqno_t const seqno)
+        {
+            if (ring_.empty() ||
+                (seqno + MAX_GAP >= ring_.index_begin() &&
+                 seqno < ring_.index_end() + MAX_GAP))
+            {
+                Ring::iterator const i(ring_.find(seqno));
+
+                if (i != ring_.end())
+                    ++(*i); // this may be a hole (0), but not the front
+                else
+                    ring_.insert(seqno, 1);
+            }
+            else
+            {
+                outliers_.insert(seqno);
+            }
+
+            ++size_;
+        }
+
+        /*! removes one instance of seqno which must be in the set */
+        void erase(wsrep_seqno_t const seqno)
+        {
+            Ring::iterator const i(ring_.find(seqno));
+
+            if (i != ring_.end() && *i > 0)
+            {
+                if (--(*i) == 0) ring_.erase(seqno); // trims the ends
+            }
+            else
+            {
+                std::multiset<wsrep_seqno_t>::iterator const o
+                    (outliers_.find(seqno));
+                assert(o != outliers_.end());
+                outliers_.erase(o);
+            }
+
+            assert(size_ > 0);
+            --size_;
+        }
+
+        /*! returns the smallest seqno in a non-empty set */
+        wsrep_seqno_t min() const
+        {
+            assert(!empty());
+
+            if (outliers_.empty()) return ring_.index_begin();
+            if (ring_.empty())     return *outliers_.begin();
+
+            return std::min(ring_.index_begin(), *outliers_.begin());
+        }
+
+        void clear()
+        {
+            ring_.clear(0);
+            outliers_.clear();
+            size_ = 0;
+        }
+
+    private:
+
+        /* max number of holes to be inserted in the ring at once */
+        static wsrep_seqno_t const MAX_GAP = 1 << 16;
+
+        typedef gu::DeqMap<wsrep_seqno_t, size_t> Ring;
+
+        Ring                         ring_;
+        std::multiset<wsrep_seqno_t> outliers_;
+        size_t                       size_;
+    };
+}
+
+#endif // GALERA_CERT_DEPS_SET_HPP
@@ -0,0 +1,232 @@
+//
+// Copyright (C) 2020 Codership Oy <info@codership.com>
+//
+
+#ifndef GALERA_CERT_INDEX_NG_HPP
+#define GALERA_CERT_INDEX_NG_HPP
+
+#include "key_entry_ng.hpp"
+
+#include "gu_macros.h"
+
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <stdint.h>
+
+namespace galera
+{
+    /*!
+     * Certification index for NG (v3+) write sets.
+     *
+     * This is an open addressing hash table with Robin Hood probing and
+     * backward shift deletion. Key entries are stored by value in the table
+     * slots together with the key hash, so lookups don't need to chase
+     * pointers to heap allocated entries and insertions/erasures don't
+     * allocate memory (except for growing the table).
+     *
+     * Pointers to entries returned by find() and insert() are invalidated
+     * by the following insert() or erase().
+     */
+    class CertIndexNG
+    {
+    public:
+
+        CertIndexNG()
+            :
+            slots_(MIN_CAPACITY),
+            mask_ (MIN_CAPACITY - 1),
+            shift_(64 - MIN_CAPACITY_BITS),
+            size_ (0)
+        {}
+
+        size_t size()         const { return size_;         }
+        size_t bucket_count() const { return slots_.size(); }
+
+        /*! returns entry matching the key or NULL if not found */
+        KeyEntryNG* find(const KeySet::KeyPart& key)
+        {
+            size_t const hash(key.hash());
+            size_t       pos(home(hash));
+
+            for (uint32_t dist(1); dist <= slots_[pos].dist_; ++dist)
+            {
+                Slot& s(slots_[pos]);
+
+                if (s.hash_ == hash && s.entry_.key().matches(key))
+                {
+                    return &s.entry_;
+                }
+
+                pos = (pos + 1) & mask_;
+            }
+
+            return NULL;
+        }
+
+        /*! inserts new unreferenced entry for the key which must not be
+         *  in the index yet and returns it */
+        KeyEntryNG* insert(const KeySet::KeyPart& key)
+        {
+            assert(find(key) == NULL);
+
+            if (gu_unlikely((size_ + 1) * 8 > slots_.size() * 7))
+            {
+                rehash(slots_.size() * 2);
+            }
+
+            Slot tmp;
+            tmp.hash_ = key.hash();
+            KeyEntryNG ke(key);
+            tmp.entry_.swap(ke);
+
+            ++size_;
+
+            return &slots_[place(tmp)].entry_;
+        }
+
+        /*! erases unreferenced entry previously returned by find() or
+         *  insert() */
+        void erase(KeyEntryNG* const entry)
+        {
+            assert(entry->referenced() == false);
+
+            size_t pos(slot_of(entry));
+            size_t next((pos + 1) & mask_);
+
+            /* shift following displaced entries one slot back */
+            while (slots_[next].dist_ > 1)
+            {
+                slots_[pos].swap(slots_[next]);
+                --slots_[pos].dist_;
+                pos  = next;
+                next = (next + 1) & mask_;
+            }
+
+            slots_[pos].clear();
+            --size_;
+        }
+
+        /*! removes all entries and releases table memory */
+        void clear()
+        {
+            std::vector<Slot>(MIN_CAPACITY).swap(slots_);
+            mask_  = MIN_CAPACITY - 1;
+            shift_ = 64 - MIN_CAPACITY_BITS;
+            size_  = 0;
+        }
+
+    private:
+
+        static unsigned int const MIN_CAPACITY_BITS = 6;
+        static size_t       const MIN_CAPACITY      = 1 << MIN_CAPACITY_BITS;
+
+        struct Slot
+        {
+            Slot() : hash_(0), dist_(0), entry_(KeySet::KeyPart()) {}
+
+            /* Slots are copied only when the table vector is created and
+             * they are empty at that point. */
+            Slot(const Slot& s) : hash_(0), dist_(0), entry_(KeySet::KeyPart())
+            {
+                assert(s.dist_ == 0);
+            }
+
+            void swap(Slot& s)
+            {
+                std::swap(hash_, s.hash_);
+                std::swap(dist_, s.dist_);
+                entry_.swap(s.entry_);
+            }
+
+            void clear()
+            {
+                KeyEntryNG ke((KeySet::KeyPart()));
+                entry_.swap(ke);
+                hash_ = 0;
+                dist_ = 0;
+            }
+
+            size_t     hash_;
+            uint32_t   dist_;  // probe sequence length + 1, 0 for empty slot
+            KeyEntryNG entry_;
+
+        private:
+            Slot& operator=(const Slot&);
+        };
+
+        /* Fibonacci hashing: key hashes are already uniform, but their
+         * lower bits may be correlated with the selection of index shard */
+        size_t home(size_t const hash) const
+        {
+            return (uint64_t(hash) * GU_ULONG_LONG(0x9E3779B97F4A7C15))
+                >> shift_;
+        }
+
+        size_t slot_of(const KeyEntryNG* const entry) const
+        {
+            const char* const base
+                (reinterpret_cast<const char*>(&slots_[0].entry_));
+            size_t const pos
+                ((reinterpret_cast<const char*>(entry) - base) / sizeof(Slot));
+            assert(pos < slots_.size());
+            assert(&slots_[pos].entry_ == entry);
+            return pos;
+        }
+
+        /* places the slot content into the table, displacing entries closer
+         * to their home slots, returns position of the original content */
+        size_t place(Slot& tmp)
+        {
+            size_t pos(home(tmp.hash_));
+            size_t ret(slots_.size());
+
+            tmp.dist_ = 1;
+
+            while (true)
+            {
+                Slot& s(slots_[pos]);
+
+                if (s.dist_ == 0)
+                {
+                    s.swap(tmp);
+                    return (ret == slots_.size() ? pos : ret);
+                }
+
+                if (s.dist_ < tmp.dist_)
+                {
+                    s.swap(tmp);
+                    if (ret == slots_.size()) ret = pos;
+                }
+
+                pos = (pos + 1) & mask_;
+                ++tmp.dist_;
+            }
+        }
+
+        void rehash(size_t const capacity)
+        {
+            std::vector<Slot> old(capacity);
+            old.swap(slots_);
+
+            mask_ = capacity - 1;
+            --shift_;
+            assert((size_t(1) << (64 - shift_)) == capacity);
+
+            for (size_t i(0); i < old.size(); ++i)
+            {
+                if (old[i].dist_ > 0) place(old[i]);
+            }
+        }
+
+        CertIndexNG(const CertIndexNG&);
+        CertIndexNG& operator=(const CertIndexNG&);
+
+        std::vector<Slot> slots_;
+        size_t            mask_;
+        unsigned int      shift_;
+        size_t            size_;
+    };
+}
+
+#endif // GALERA_CERT_INDEX_NG_HPP
@@ -30,9 +30,24 @@ static std::string const CERT_PARAM_MAX_LENGTH   (CERT_PARAM_PREFIX +
                                                   "max_length");
 static std::string const CERT_PARAM_LENGTH_CHECK (CERT_PARAM_PREFIX +
                                                   "length_check");
+static std::string const CERT_PARAM_INDEX_SHARDS (CERT_PARAM_PREFIX +
+                                                  "index_shards");
+static std::string const CERT_PARAM_PURGE_KEYS   (CERT_PARAM_PREFIX +
+                                                  "purge_keys_threshold");
+static std::string const CERT_PARAM_PURGE_BYTES  (CERT_PARAM_PREFIX +
+                                                  "purge_bytes_threshold");
+static std::string const CERT_PARAM_PURGE_TRXS   (CERT_PARAM_PREFIX +
+                                                  "purge_trxs_threshold");
+static std::string const CERT_PARAM_PURGE_SLICE  (CERT_PARAM_PREFIX +
+                                                  "purge_slice");
 
 static std::string const CERT_PARAM_LOG_CONFLICTS_DEFAULT("no");
 static std::string const CERT_PARAM_OPTIMISTIC_PA_DEFAULT("yes");
+static std::string const CERT_PARAM_INDEX_SHARDS_DEFAULT ("8");
+static std::string const CERT_PARAM_PURGE_KEYS_DEFAULT   ("1024");
+static std::string const CERT_PARAM_PURGE_BYTES_DEFAULT  ("128M");
+static std::string const CERT_PARAM_PURGE_TRXS_DEFAULT   ("127");
+static std::string const CERT_PARAM_PURGE_SLICE_DEFAULT  ("PT0.001S");
 
 /*** It is EXTREMELY important that these constants are the same on all nodes.
  *** Don't change them ever!!! ***/
@@ -44,6 +59,11 @@ galera::Certification::register_params(gu::Config& cnf)
 {
     cnf.add(CERT_PARAM_LOG_CONFLICTS, CERT_PARAM_LOG_CONFLICTS_DEFAULT);
     cnf.add(CERT_PARAM_OPTIMISTIC_PA, CERT_PARAM_OPTIMISTIC_PA_DEFAULT);
+    cnf.add(CERT_PARAM_INDEX_SHARDS,  CERT_PARAM_INDEX_SHARDS_DEFAULT);
+    cnf.add(CERT_PARAM_PURGE_KEYS,    CERT_PARAM_PURGE_KEYS_DEFAULT);
+    cnf.add(CERT_PARAM_PURGE_BYTES,   CERT_PARAM_PURGE_BYTES_DEFAULT);
+    cnf.add(CERT_PARAM_PURGE_TRXS,    CERT_PARAM_PURGE_TRXS_DEFAULT);
+    cnf.add(CERT_PARAM_PURGE_SLICE,   CERT_PARAM_PURGE_SLICE_DEFAULT);
     /* The defaults below are deliberately not reflected in conf: people
      * should not know about these dangerous setting unless they read RTFM. */
     cnf.add(CERT_PARAM_MAX_LENGTH);
@@ -70,6 +90,50 @@ length_check(const gu::Config& conf)
         return gu::Config::from_config<int>(CERT_PARAM_LENGTH_CHECK_DEFAULT);
 }
 
+static size_t
+index_shards(const gu::Config& conf)
+{
+    int const ret(conf.get<int>(CERT_PARAM_INDEX_SHARDS));
+
+    if (ret < 1 || ret > 1024)
+    {
+        gu_throw_error(EINVAL) << "Bad value " << ret << " for '"
+                               << CERT_PARAM_INDEX_SHARDS
+                               << "', must be in [1, 1024]";
+    }
+
+    return ret;
+}
+
+static size_t
+purge_threshold(const std::string& key, const std::string& value)
+{
+    long long const ret(gu::Config::from_config<long long>(value));
+
+    if (ret < 0)
+    {
+        gu_throw_error(EINVAL) << "Bad value " << ret << " for '" << key
+                               << "', must be non-negative";
+    }
+
+    return ret;
+}
+
+static gu::datetime::Period
+purge_slice(const std::string& value)
+{
+    gu::datetime::Period const ret(value);
+
+    if (ret.get_nsecs() <= 0)
+    {
+        gu_throw_error(EINVAL) << "Bad value '" << value << "' for '"
+                               << CERT_PARAM_PURGE_SLICE
+                               << "', must be positive";
+    }
+
+    return ret;
+}
+
 void
 galera::Certification::purge_for_trx_v1to2(TrxHandle* trx)
 {
@@ -115,42 +179,103 @@ galera::Certification::purge_for_trx_v1to2(TrxHandle* trx)
 void
 galera::Certification::purge_for_trx_v3(TrxHandle* trx)
 {
-    const KeySetIn& keys(trx->write_set_in().keyset());
-    keys.rewind();
+    ShardedKeys keys;
+    shard_keys(trx->write_set_in().keyset(), keys);
 
     // Unref all referenced and remove if was referenced only by us
-    for (long i = 0; i < keys.count(); ++i)
+    for (size_t i(0); i < keys.size();)
     {
-        const KeySet::KeyPart& kp(keys.next());
+        size_t const s(keys[i].first);
+        CertIndexShard& shard(*shards_[s]);
+        gu::Lock lock(shard.mutex_);
 
-        KeyEntryNG ke(kp);
-        CertIndexNG::iterator const ci(cert_index_ng_.find(&ke));
-
-//        assert(ci != cert_index_ng_.end());
-        if (gu_unlikely(cert_index_ng_.end() == ci))
+        for (; i < keys.size() && keys[i].first == s; ++i)
         {
-            log_warn << "Missing key";
-            continue;
-        }
+            const KeySet::KeyPart& kp(keys[i].second);
 
-        KeyEntryNG* const kep(*ci);
-        assert(kep->referenced());
+            KeyEntryNG* const kep(shard.index_.find(kp));
 
-        wsrep_key_type_t const p(kp.wsrep_type(trx->version()));
+//            assert(kep != NULL);
+            if (gu_unlikely(NULL == kep))
+            {
+                log_warn << "Missing key";
+                continue;
+            }
 
-        if (kep->ref_trx(p) == trx)
-        {
-            kep->unref(p, trx);
+            assert(kep->referenced());
+
+            wsrep_key_type_t const p(kp.wsrep_type(trx->version()));
 
-            if (kep->referenced() == false)
+            if (kep->ref_trx(p) == trx)
             {
-                cert_index_ng_.erase(ci);
-                delete kep;
+                kep->unref(p, trx);
+
+                if (kep->referenced() == false)
+                {
+                    shard.index_.erase(kep);
+                }
             }
         }
     }
 }
 
+/* orders sharded keys by shard index */
+static inline bool
+shard_less(const std::pair<size_t, galera::KeySet::KeyPart>& l,
+           const std::pair<size_t, galera::KeySet::KeyPart>& r)
+{
+    return l.first < r.first;
+}
+
+void
+galera::Certification::shard_keys(const KeySetIn& key_set,
+                                  ShardedKeys&    keys) const
+{
+    long const key_count(key_set.count());
+
+    keys.clear();
+    keys.reserve(key_count);
+
+    key_set.rewind();
+
+    for (long i(0); i < key_count; ++i)
+    {
+        const KeySet::KeyPart& kp(key_set.next());
+        keys.push_back(std::make_pair(shard_of(kp), kp));
+    }
+
+    /* stable sort preserves the key set order within a shard, which is
+     * important for duplicate keys of different types */
+    if (shards_.size() > 1)
+    {
+        std::stable_sort(keys.begin(), keys.end(), shard_less);
+    }
+}
+
+size_t
+galera::Certification::index_ng_size() const
+{
+    size_t ret(0);
+
+    for (size_t i(0); i < shards_.size(); ++i)
+    {
+        gu::Lock lock(shards_[i]->mutex_);
+        ret += shards_[i]->index_.size();
+    }
+
+    return ret;
+}
+
+void
+galera::Certification::clear_index_ng()
+{
+    for (size_t i(0); i < shards_.size(); ++i)
+    {
+        gu::Lock lock(shards_[i]->mutex_);
+        shards_[i]->index_.clear();
+    }
+}
+
 void
 galera::Certification::purge_for_trx(TrxHandle* trx)
 {
@@ -486,6 +611,7 @@ check_against(const galera::KeyEntryNG*   const found,
               wsrep_key_type_t            const key_type,
               galera::TrxHandle*          const trx,
               bool                        const log_conflict,
+              wsrep_seqno_t               const purged,
               wsrep_seqno_t&                    depends_seqno)
 {
     const galera::TrxHandle* const ref_trx(found->ref_trx(REF_KEY_TYPE));
@@ -495,7 +621,9 @@ check_against(const galera::KeyEntryNG*   const found,
 
     bool conflict(false);
 
-    if (gu_likely(0 != ref_trx))
+    /* Keys of purged trxs are removed from the index in background, skip
+     * them so that the result does not depend on the purge progress. */
+    if (gu_likely(0 != ref_trx) && ref_trx->global_seqno() > purged)
     {
         if (REF_KEY_TYPE == WSREP_KEY_EXCLUSIVE && ref_trx)
         {
@@ -538,6 +666,13 @@ check_against(const galera::KeyEntryNG*   const found,
                  REF_KEY_TYPE == WSREP_KEY_EXCLUSIVE)
         {
             depends_seqno = std::max(ref_trx->global_seqno(), depends_seqno);
+
+            // exclusive references form a chain, but of several shared
+            // references only the last one is in the index
+            if (REF_KEY_TYPE == WSREP_KEY_EXCLUSIVE)
+                trx->add_pa_dep(ref_trx->global_seqno());
+            else
+                trx->set_pa_base_seqno(ref_trx->global_seqno());
         }
     }
 
@@ -549,7 +684,8 @@ static inline bool
 certify_and_depend_v3to4(const galera::KeyEntryNG*   const found,
                          const galera::KeySet::KeyPart&    key,
                          galera::TrxHandle*          const trx,
-                         bool                        const log_conflict)
+                         bool                        const log_conflict,
+                         wsrep_seqno_t               const purged)
 {
     wsrep_seqno_t depends_seqno(trx->depends_seqno());
     wsrep_key_type_t const key_type(key.wsrep_type(trx->version()));
@@ -570,13 +706,13 @@ certify_and_depend_v3to4(const galera::KeyEntryNG*   const found,
      * step.
      */
     if (check_against<WSREP_KEY_EXCLUSIVE>
-        (found, key, key_type, trx, log_conflict, depends_seqno) ||
+        (found, key, key_type, trx, log_conflict, purged, depends_seqno) ||
         (key_type == WSREP_KEY_EXCLUSIVE &&
          /* exclusive keys must be checked against shared */
          (check_against<WSREP_KEY_SEMI>
-          (found, key, key_type, trx, log_conflict, depends_seqno) ||
+          (found, key, key_type, trx, log_conflict, purged, depends_seqno) ||
           check_against<WSREP_KEY_SHARED>
-          (found, key, key_type, trx, log_conflict, depends_seqno))))
+          (found, key, key_type, trx, log_conflict, purged, depends_seqno))))
     {
         return true;
     }
@@ -590,21 +726,20 @@ certify_and_depend_v3to4(const galera::KeyEntryNG*   const found,
 
 /* returns true on collision, false otherwise */
 static bool
-certify_v3to4(galera::Certification::CertIndexNG& cert_index_ng,
-              const galera::KeySet::KeyPart&      key,
-              galera::TrxHandle*                  trx,
-              bool const                          store_keys,
-              bool const                          log_conflicts)
+certify_v3to4(galera::CertIndexNG&             cert_index_ng,
+              const galera::KeySet::KeyPart& key,
+              galera::TrxHandle*             trx,
+              bool const                     store_keys,
+              bool const                     log_conflicts,
+              wsrep_seqno_t const            purged)
 {
-    galera::KeyEntryNG ke(key);
-    galera::Certification::CertIndexNG::iterator ci(cert_index_ng.find(&ke));
+    galera::KeyEntryNG* const kep(cert_index_ng.find(key));
 
-    if (cert_index_ng.end() == ci)
+    if (NULL == kep)
     {
         if (store_keys)
         {
-            galera::KeyEntryNG* const kep(new galera::KeyEntryNG(ke));
-            ci = cert_index_ng.insert(kep).first;
+            cert_index_ng.insert(key);
 
             cert_debug << "created new entry";
         }
@@ -614,74 +749,79 @@ certify_v3to4(galera::Certification::CertIndexNG& cert_index_ng,
     {
         cert_debug << "found existing entry";
 
-        galera::KeyEntryNG* const kep(*ci);
         // Note: For we skip certification for isolated trxs, only
         // cert index and key_list is populated.
         return (!trx->is_toi() &&
-                certify_and_depend_v3to4(kep, key, trx, log_conflicts));
+                certify_and_depend_v3to4(kep, key, trx, log_conflicts,
+                                         purged));
     }
 }
 
 galera::Certification::TestResult
-galera::Certification::do_test_v3to4(TrxHandle* trx, bool store_keys)
+galera::Certification::do_test_v3to4(TrxHandle* trx, bool store_keys,
+                                      const ShardedKeys& keys,
+                                      wsrep_seqno_t const purged)
 {
     cert_debug << "BEGIN CERTIFICATION v" << trx->version() << ": " << *trx;
 
-#ifndef NDEBUG
-    // to check that cleanup after cert failure returns cert_index_
-    // to original size
-    size_t prev_cert_index_size(cert_index_.size());
-#endif // NDEBUG
-
-    const KeySetIn& key_set(trx->write_set_in().keyset());
-    long const      key_count(key_set.count());
-    long            processed(0);
+    /* Keys are grouped by index shard, so that every shard lock is taken
+     * only once per pass over the key set. Shards are visited in ascending
+     * order. */
 
-    key_set.rewind();
+    size_t const key_count(keys.size());
+    size_t       processed(0);
+    bool         conflict(false);
 
-    for (; processed < key_count; ++processed)
+    while (!conflict && processed < key_count)
     {
-        const KeySet::KeyPart& key(key_set.next());
+        size_t const s(keys[processed].first);
+        CertIndexShard& shard(*shards_[s]);
+        gu::Lock lock(shard.mutex_);
 
-        if (certify_v3to4(cert_index_ng_, key, trx, store_keys, log_conflicts_))
+        for (; processed < key_count && keys[processed].first == s;
+             ++processed)
         {
-            goto cert_fail;
+            if (certify_v3to4(shard.index_, keys[processed].second, trx,
+                              store_keys, log_conflicts_, purged))
+            {
+                conflict = true;
+                break;
+            }
         }
     }
 
-    trx->set_depends_seqno(std::max(trx->depends_seqno(), last_pa_unsafe_));
-
-    if (store_keys == true)
+    if (gu_likely(!conflict))
     {
-        assert (key_count == processed);
-
-        key_set.rewind();
-        for (long i(0); i < key_count; ++i)
+        if (store_keys == true)
         {
-            const KeySet::KeyPart& k(key_set.next());
-            KeyEntryNG ke(k);
-            CertIndexNG::const_iterator ci(cert_index_ng_.find(&ke));
+            assert (key_count == processed);
 
-            if (ci == cert_index_ng_.end())
+            for (size_t i(0); i < key_count;)
             {
-                gu_throw_fatal << "could not find key '" << k
-                               << "' from cert index";
-            }
+                size_t const s(keys[i].first);
+                CertIndexShard& shard(*shards_[s]);
+                gu::Lock lock(shard.mutex_);
 
-            KeyEntryNG* const kep(*ci);
+                for (; i < key_count && keys[i].first == s; ++i)
+                {
+                    const KeySet::KeyPart& k(keys[i].second);
+                    KeyEntryNG* kep(shard.index_.find(k));
 
-            kep->ref(k.wsrep_type(trx->version()), k, trx);
+                    if (gu_unlikely(NULL == kep))
+                    {
+                        /* the entry found during the test pass was purged
+                         * meanwhile, shard lock is not held between passes */
+                        kep = shard.index_.insert(k);
+                    }
 
+                    kep->ref(k.wsrep_type(trx->version()), k, trx);
+                }
+            }
         }
 
-        if (trx->pa_unsafe()) last_pa_unsafe_ = trx->global_seqno();
-
-        key_count_ += key_count;
+        cert_debug << "END CERTIFICATION (success): " << *trx;
+        return TEST_OK;
     }
-    cert_debug << "END CERTIFICATION (success): " << *trx;
-    return TEST_OK;
-
-cert_fail:
 
     cert_debug << "END CERTIFICATION (failed): " << *trx;
 
@@ -689,45 +829,42 @@ cert_fail:
 
     if (store_keys == true)
     {
-        /* Clean up key entries allocated for this trx */
-        key_set.rewind();
-
-        /* 'strictly less' comparison is essential in the following loop:
+        /* Clean up key entries allocated for this trx.
+         * 'strictly less' comparison is essential in the following loop:
          * processed key failed cert and was not added to index */
-        for (long i(0); i < processed; ++i)
+        for (size_t i(0); i < processed;)
         {
-            KeyEntryNG ke(key_set.next());
+            size_t const s(keys[i].first);
+            CertIndexShard& shard(*shards_[s]);
+            gu::Lock lock(shard.mutex_);
 
-            // Clean up cert_index_ from entries which were added by this trx
-            CertIndexNG::iterator ci(cert_index_ng_.find(&ke));
-
-            if (gu_likely(ci != cert_index_ng_.end()))
+            for (; i < processed && keys[i].first == s; ++i)
             {
-                KeyEntryNG* kep(*ci);
+                const KeySet::KeyPart& k(keys[i].second);
 
-                if (kep->referenced() == false)
+                // Clean up index from entries which were added by this trx
+                KeyEntryNG* const kep(shard.index_.find(k));
+
+                if (gu_likely(NULL != kep))
                 {
-                    // kel was added to cert_index_ by this trx -
-                    // remove from cert_index_ and fall through to delete
-                    cert_index_ng_.erase(ci);
+                    if (kep->referenced() == false)
+                    {
+                        // kel was added to index by this trx -
+                        // remove from index
+                        shard.index_.erase(kep);
+                    }
                 }
-                else continue;
-
-                assert(kep->referenced() == false);
-
-                delete kep;
-
-            }
-            else if(ke.key().wsrep_type(trx->version()) == WSREP_KEY_SHARED)
-            {
-                assert(0); // we actually should never be here, the key should
-                           // be either added to cert_index_ or be there already
-                log_warn  << "could not find shared key '"
-                          << ke.key() << "' from cert index";
+                else if(k.wsrep_type(trx->version()) == WSREP_KEY_SHARED)
+                {
+                    assert(0); // we actually should never be here, the key
+                               // should be either added to index or be
+                               // there already
+                    log_warn  << "could not find shared key '"
+                              << k << "' from cert index";
+                }
+                else { /* non-shared keys can duplicate shared in key set */ }
             }
-            else { /* non-shared keys can duplicate shared in the key set */ }
         }
-        assert(cert_index_.size() == prev_cert_index_size);
     }
 
     return TEST_FAILED;
@@ -751,8 +888,8 @@ trx_cert_version_match(int const trx_version, int const cert_version)
     }
 }
 
-galera::Certification::TestResult
-galera::Certification::do_test(TrxHandle* trx, bool store_keys)
+bool
+galera::Certification::do_test_precheck(TrxHandle* trx) const
 {
     assert(trx->source_id() != WSREP_UUID_UNDEFINED);
 
@@ -762,7 +899,7 @@ galera::Certification::do_test(TrxHandle* trx, bool store_keys)
                  << trx->version()
                  << " does not match certification protocol version: "
                  << version_;
-        return TEST_FAILED;
+        return false;
     }
 
     if (gu_unlikely(trx->last_seen_seqno() < initial_position_ ||
@@ -786,13 +923,18 @@ galera::Certification::do_test(TrxHandle* trx, bool store_keys)
                      << " exceeds the limit of " << max_length_;
         }
 
-        return TEST_FAILED;
+        return false;
     }
 
-    TestResult res(TEST_FAILED);
-
-    gu::Lock lock(mutex_); // why do we need that? - e.g. set_trx_committed()
+    return true;
+}
 
+/* must be called under mutex_, initializes parent seqno and certifies
+ * v1-2 trxs, returns certification index version */
+int
+galera::Certification::do_test_init_(TrxHandle* trx, bool store_keys,
+                                     TestResult& res)
+{
     /* initialize parent seqno */
     if ((trx->flags() & (TrxHandle::F_ISOLATION | TrxHandle::F_PA_UNSAFE))
         || trx_map_.empty())
@@ -801,8 +943,7 @@ galera::Certification::do_test(TrxHandle* trx, bool store_keys)
     }
     else
     {
-        trx->set_depends_seqno(
-            trx_map_.begin()->second->global_seqno() - 1);
+        trx->set_depends_seqno(trx_map_.front()->global_seqno() - 1);
 
         if (optimistic_pa_ == false &&
             trx->last_seen_seqno() > trx->depends_seqno())
@@ -817,25 +958,97 @@ galera::Certification::do_test(TrxHandle* trx, bool store_keys)
         break;
     case 3:
     case 4:
-        res = do_test_v3to4(trx, store_keys);
+        trx->init_pa_deps(trx->depends_seqno());
+        // NG index is sharded and certified outside of mutex_
+        res = TEST_OK;
         break;
     default:
         gu_throw_fatal << "certification test for version "
                        << version_ << " not implemented";
     }
 
+    return version_;
+}
+
+/* must be called under mutex_, returns current index size */
+size_t
+galera::Certification::do_test_finish_(TrxHandle* trx, bool store_keys,
+                                       int version, TestResult res)
+{
+    if (version >= 3 && res == TEST_OK)
+    {
+        trx->set_depends_seqno(std::max(trx->depends_seqno(),
+                                        last_pa_unsafe_));
+        trx->set_pa_base_seqno(last_pa_unsafe_);
+
+        if (store_keys == true)
+        {
+            if (trx->pa_unsafe()) last_pa_unsafe_ = trx->global_seqno();
+
+            key_count_ += trx->write_set_in().keyset().count();
+        }
+    }
+
+    size_t index_size(0);
+
     if (store_keys == true && res == TEST_OK)
     {
         ++trx_count_;
-        gu::Lock lock(stats_mutex_);
-        ++n_certified_;
-        deps_dist_ += (trx->global_seqno() - trx->depends_seqno());
-        cert_interval_ += (trx->global_seqno() - trx->last_seen_seqno() - 1);
-        index_size_ = (cert_index_.size() + cert_index_ng_.size());
+        index_size = cert_index_.size() + index_ng_size();
     }
 
     byte_count_ += trx->size();
 
+    return index_size;
+}
+
+/* must be called under stats_mutex_ */
+void
+galera::Certification::update_stats_(const TrxHandle* trx, size_t index_size)
+{
+    ++n_certified_;
+    deps_dist_ += (trx->global_seqno() - trx->depends_seqno());
+    cert_interval_ += (trx->global_seqno() - trx->last_seen_seqno() - 1);
+    index_size_ = index_size;
+}
+
+galera::Certification::TestResult
+galera::Certification::do_test(TrxHandle* trx, bool store_keys)
+{
+    assert(trx->source_id() != WSREP_UUID_UNDEFINED);
+
+    if (!do_test_precheck(trx)) return TEST_FAILED;
+
+    TestResult    res(TEST_FAILED);
+    int           version;
+    wsrep_seqno_t purged;
+
+    {
+        gu::Lock lock(mutex_); // why do we need that? - e.g. set_trx_committed()
+        version = do_test_init_(trx, store_keys, res);
+        purged  = purged_seqno_();
+    }
+
+    if (version >= 3)
+    {
+        ShardedKeys keys;
+        shard_keys(trx->write_set_in().keyset(), keys);
+        res = do_test_v3to4(trx, store_keys, keys, purged);
+    }
+
+    size_t index_size;
+
+    {
+        gu::Lock lock(mutex_);
+        index_size = do_test_finish_(trx, store_keys, version, res);
+    }
+
+    if (store_keys == true && res == TEST_OK)
+    {
+        gu::Lock lock(stats_mutex_);
+        update_stats_(trx, index_size);
+    }
+
     return res;
 }
 
@@ -884,9 +1097,13 @@ galera::Certification::Certification(gu::Config& conf, ServiceThd& thd, gcache::
     :
     version_               (-1),
     conf_                  (conf),
-    trx_map_               (),
+    trx_map_               (0),
+    trx_map_count_         (0),
     cert_index_            (),
-    cert_index_ng_         (),
+    shards_                (),
+    batch_                 (),
+    purge_queue_           (),
+    purge_pos_             (0),
     deps_set_              (),
     service_thd_           (thd),
     gcache_                (gcache),
@@ -894,6 +1111,11 @@ galera::Certification::Certification(gu::Config& conf, ServiceThd& thd, gcache::
     mutex_                 (WSREP_PFS_INSTR_TAG_CERT_MUTEX),
 #else
     mutex_                 (),
+#endif /* HAVE_PSI_INTERFACE */
+#ifdef HAVE_PSI_INTERFACE
+    purge_mutex_           (WSREP_PFS_INSTR_TAG_CERT_MUTEX),
+#else
+    purge_mutex_           (),
 #endif /* HAVE_PSI_INTERFACE */
     trx_size_warn_count_   (0),
     initial_position_      (-1),
@@ -914,18 +1136,34 @@ galera::Certification::Certification(gu::Config& conf, ServiceThd& thd, gcache::
     key_count_             (0),
     byte_count_            (0),
     trx_count_             (0),
+    purge_keys_threshold_  (purge_threshold(CERT_PARAM_PURGE_KEYS,
+                                            conf.get(CERT_PARAM_PURGE_KEYS))),
+    purge_bytes_threshold_ (purge_threshold(CERT_PARAM_PURGE_BYTES,
+                                            conf.get(CERT_PARAM_PURGE_BYTES))),
+    purge_trxs_threshold_  (purge_threshold(CERT_PARAM_PURGE_TRXS,
+                                            conf.get(CERT_PARAM_PURGE_TRXS))),
+    purge_slice_           (purge_slice(conf.get(CERT_PARAM_PURGE_SLICE))),
 
     max_length_            (max_length(conf)),
     max_length_check_      (length_check(conf)),
     log_conflicts_         (conf.get<bool>(CERT_PARAM_LOG_CONFLICTS)),
     optimistic_pa_         (conf.get<bool>(CERT_PARAM_OPTIMISTIC_PA))
-{}
+{
+    size_t const n_shards(index_shards(conf));
+
+    shards_.reserve(n_shards);
+
+    for (size_t i(0); i < n_shards; ++i)
+    {
+        shards_.push_back(new CertIndexShard());
+    }
+}
 
 
 galera::Certification::~Certification()
 {
     log_debug << "cert index usage at exit "   << cert_index_.size();
-    log_debug << "cert trx map usage at exit " << trx_map_.size();
+    log_debug << "cert trx map usage at exit " << trx_map_count_;
     log_debug << "deps set usage at exit "     << deps_set_.size();
 
     double avg_cert_interval(0);
@@ -936,11 +1174,20 @@ galera::Certification::~Certification()
     log_debug << "avg cert interval "          << avg_cert_interval;
     log_debug << "cert index size "            << index_size;
 
-    gu::Lock lock(mutex_);
+    {
+        gu::Lock lock(mutex_);
+
+        for_each(trx_map_.begin(), trx_map_.end(), PurgeAndDiscard(*this));
+        service_thd_.release_seqno(position_);
+    }
 
-    for_each(trx_map_.begin(), trx_map_.end(), PurgeAndDiscard(*this));
-    service_thd_.release_seqno(position_);
+    // completes background purge, must not be called under mutex_ which
+    // the purge may need
     service_thd_.flush();
+    assert(purge_queue_.empty());
+
+    clear_index_ng();
+    std::for_each(shards_.begin(), shards_.end(), gu::DeleteObject());
 }
 
 
@@ -962,13 +1209,20 @@ void galera::Certification::assign_initial_position(wsrep_seqno_t seqno,
                        << version << " not supported";
     }
 
+    // complete background purge before touching the index. Purge may need
+    // mutex_, so flush before taking it: no new purge can be scheduled
+    // meanwhile, as the caller holds the monitors.
+    service_thd_.flush();
+
     gu::Lock lock(mutex_);
 
+    assert(purge_queue_.empty());
+
     if (seqno >= position_)
     {
         std::for_each(trx_map_.begin(), trx_map_.end(), PurgeAndDiscard(*this));
         assert(cert_index_.size() == 0);
-        assert(cert_index_ng_.size() == 0);
+        assert(index_ng_size() == 0);
     }
     else
     {
@@ -976,15 +1230,17 @@ void galera::Certification::assign_initial_position(wsrep_seqno_t seqno,
                  << seqno;
         std::for_each(cert_index_.begin(), cert_index_.end(),
                       gu::DeleteObject());
-        std::for_each(cert_index_ng_.begin(), cert_index_ng_.end(),
-                      gu::DeleteObject());
-        std::for_each(trx_map_.begin(), trx_map_.end(),
-                      Unref2nd<TrxMap::value_type>());
+        clear_index_ng();
+        for (TrxMap::iterator i(trx_map_.begin()); i != trx_map_.end(); ++i)
+        {
+            if (!TrxMap::not_set(*i)) (*i)->unref();
+        }
         cert_index_.clear();
-        cert_index_ng_.clear();
     }
 
-    trx_map_.clear();
+    trx_map_.clear(seqno + 1);
+    trx_map_count_ = 0;
+    deps_set_.clear();
 
     log_info << "Assign initial position for certification: " << seqno
              << ", protocol version: " << version;
@@ -1027,7 +1283,7 @@ wsrep_seqno_t galera::Certification::get_safe_to_discard_seqno_() const
     }
     else
     {
-        retval = (*deps_set_.begin()) - 1;
+        retval = deps_set_.min() - 1;
     }
     return retval;
 }
@@ -1039,98 +1295,284 @@ galera::Certification::purge_trxs_upto_(wsrep_seqno_t const seqno,
 {
     assert (seqno > 0);
 
-    TrxMap::iterator purge_bound(trx_map_.upper_bound(seqno));
+    TrxMap::iterator const purge_bound
+        (trx_map_.begin() +
+         (trx_map_.upper_bound(seqno) - trx_map_.index_begin()));
 
     log_debug << "purging index up to " << seqno;
 
-    for_each(trx_map_.begin(), purge_bound, PurgeAndDiscard(*this));
+    /* Only trxs are detached from trx map here, their keys are purged from
+     * the index by the service thread in bounded slices, so that purging
+     * does not stall certification. The purged keys may be seen by
+     * certification meanwhile, check_against() skips them by comparing
+     * with purged_seqno_(), so the result is the same as if they were
+     * gone. Old index is not sharded and is protected by mutex_, so it is
+     * purged right away. */
+    PurgeGen gen(seqno, handle_gcache);
+
+    for (TrxMap::iterator i(trx_map_.begin()); i != purge_bound; ++i)
+    {
+        if (TrxMap::not_set(*i)) continue;
+
+        assert(trx_map_count_ > 0);
+        --trx_map_count_;
+
+        if ((*i)->new_version())
+            gen.trxs_.push_back(*i);
+        else
+            PurgeAndDiscard(*this)(*i);
+    }
+
     trx_map_.erase(trx_map_.begin(), purge_bound);
 
-    if (handle_gcache)
+    bool schedule(false);
+    {
+        gu::Lock lock(purge_mutex_);
+
+        /* gcache release must follow the purge of preceding generations */
+        if (gen.trxs_.size() > 0 || purge_queue_.size() > 0)
+        {
+            purge_queue_.push_back(gen);
+            schedule = true;
+        }
+    }
+
+    if (schedule)
+    {
+        service_thd_.schedule(this);
+    }
+    else if (handle_gcache)
     {
         log_debug << "releasing seqno from gcache " << seqno;
         service_thd_.release_seqno(seqno);
     }
 
-    if (0 == ((trx_map_.size() + 1) % 10000))
+    if (0 == ((trx_map_count_ + 1) % 10000))
     {
-        log_debug << "trx map after purge: length: " << trx_map_.size()
+        log_debug << "trx map after purge: length: " << trx_map_count_
                   << ", requested purge seqno: " << seqno
-                  << ", real purge seqno: " << trx_map_.begin()->first - 1;
+                  << ", real purge seqno: " << trx_map_.index_begin() - 1;
     }
 
     return seqno;
 }
 
 
-galera::Certification::TestResult
-galera::Certification::append_trx(TrxHandle* trx)
+bool
+galera::Certification::run_slice()
 {
-    assert(trx->global_seqno() >= 0 && trx->local_seqno() >= 0);
-    assert(trx->global_seqno() > position_);
+    PurgeGen*            gen;
+    gu::datetime::Period slice;
 
-    trx->ref();
     {
-        gu::Lock lock(mutex_);
+        gu::Lock lock(purge_mutex_);
+        if (purge_queue_.empty()) return false;
+        gen   = &purge_queue_.front();
+        slice = purge_slice_;
+    }
+
+    gu::datetime::Date const deadline(gu::datetime::Date::monotonic() + slice);
+
+    while (true)
+    {
+        /* purge_queue_ is appended concurrently, but only this thread
+         * removes generations, so the front one stays valid */
+        while (purge_pos_ < gen->trxs_.size())
+        {
+            PurgeAndDiscard(*this)(gen->trxs_[purge_pos_]);
+            ++purge_pos_;
+
+            if (!(gu::datetime::Date::monotonic() < deadline)) return true;
+        }
+
+        if (gen->handle_gcache_)
+        {
+            log_debug << "releasing seqno from gcache " << gen->seqno_;
+            service_thd_.release_seqno(gen->seqno_);
+        }
+
+        gu::Lock lock(purge_mutex_);
+
+        purge_queue_.pop_front();
+        purge_pos_ = 0;
+
+        if (purge_queue_.empty()) return false;
+
+        gen = &purge_queue_.front();
+    }
+}
+
+
+/* must be called under mutex_ */
+void
+galera::Certification::append_prepare_(TrxHandle* trx)
+{
+    if (gu_unlikely(trx->global_seqno() != position_ + 1))
+    {
+        // this is perfectly normal if trx is rolled back just after
+        // replication, keeping the log though
+        log_debug << "seqno gap, position: " << position_
+                  << " trx seqno " << trx->global_seqno();
+    }
+
+    if (gu_unlikely(!trx_map_.empty() &&
+                    (trx->last_seen_seqno() + 1) < trx_map_.index_begin()))
+    {
+        /* See #733 - for now it is false positive */
+        cert_debug
+            << "WARNING: last_seen_seqno is below certification index: "
+            << trx_map_.index_begin() << " > " << trx->last_seen_seqno();
+    }
+
+    position_ = trx->global_seqno();
+
+    if (gu_unlikely(!(position_ & max_length_check_) &&
+                    (trx_map_count_ > static_cast<size_t>(max_length_))))
+    {
+        log_debug << "trx map size: " << trx_map_count_
+                  << " - check if status.last_committed is incrementing";
+
+        wsrep_seqno_t       trim_seqno(position_ - max_length_);
+        wsrep_seqno_t const stds      (get_safe_to_discard_seqno_());
 
-        if (gu_unlikely(trx->global_seqno() != position_ + 1))
+        if (trim_seqno > stds)
         {
-            // this is perfectly normal if trx is rolled back just after
-            // replication, keeping the log though
-            log_debug << "seqno gap, position: " << position_
-                      << " trx seqno " << trx->global_seqno();
+            log_warn << "Attempt to trim certification index at "
+                     << trim_seqno << ", above safe-to-discard: " << stds;
+            trim_seqno = stds;
         }
+        else
+        {
+            cert_debug << "purging index up to " << trim_seqno;
+        }
+
+        purge_trxs_upto_(trim_seqno, true);
+    }
+}
+
+galera::Certification::TestResult
+galera::Certification::append_trx(TrxHandle* trx)
+{
+    TestResult res;
+    append_trxs(&trx, 1, &res);
+    return res;
+}
+
+void
+galera::Certification::append_trxs(TrxHandle* const* trxs, size_t const n,
+                                   TestResult* const res)
+{
+    /* append_trx() calls are serialized by the caller, so the batch
+     * context can be reused without locking */
+    if (batch_.size() < n) batch_.resize(n);
+
+    /* Walk over the key sets of all write sets before entering critical
+     * sections: this warms up the caches and computes key shards. */
+    for (size_t i(0); i < n; ++i)
+    {
+        TrxHandle* const trx(trxs[i]);
+
+        assert(trx->global_seqno() >= 0 && trx->local_seqno() >= 0);
+        assert(trx->global_seqno() > position_);
+        assert(i == 0 || trx->global_seqno() > trxs[i - 1]->global_seqno());
+
+        trx->ref();
 
-        if (gu_unlikely((trx->last_seen_seqno() + 1) < trx_map_.begin()->first))
+        batch_[i].version    = -1;
+        batch_[i].index_size = 0;
+
+        if (trx->new_version())
         {
-            /* See #733 - for now it is false positive */
-            cert_debug
-                << "WARNING: last_seen_seqno is below certification index: "
-                << trx_map_.begin()->first << " > " << trx->last_seen_seqno();
+            shard_keys(trx->write_set_in().keyset(), batch_[i].keys);
         }
 
-        position_ = trx->global_seqno();
+        res[i] = (trx->preordered() || do_test_precheck(trx)) ?
+            TEST_OK : TEST_FAILED;
+    }
+
+    {
+        gu::Lock lock(mutex_);
 
-        if (gu_unlikely(!(position_ & max_length_check_) &&
-                        (trx_map_.size() > static_cast<size_t>(max_length_))))
+        for (size_t i(0); i < n; ++i)
         {
-            log_debug << "trx map size: " << trx_map_.size()
-                      << " - check if status.last_committed is incrementing";
+            TrxHandle* const trx(trxs[i]);
 
-            wsrep_seqno_t       trim_seqno(position_ - max_length_);
-            wsrep_seqno_t const stds      (get_safe_to_discard_seqno_());
+            append_prepare_(trx);
 
-            if (trim_seqno > stds)
+            if (res[i] == TEST_OK && !trx->preordered())
             {
-                log_warn << "Attempt to trim certification index at "
-                         << trim_seqno << ", above safe-to-discard: " << stds;
-                trim_seqno = stds;
-            }
-            else
-            {
-                cert_debug << "purging index up to " << trim_seqno;
+                batch_[i].version = do_test_init_(trx, true, res[i]);
+                batch_[i].purged  = purged_seqno_();
             }
 
-            purge_trxs_upto_(trim_seqno, true);
+            /* Insertion of trx before certification of its keys does not
+             * change its parent seqno: if trx map was empty it is
+             * initialized from trx own seqno anyways. */
+            TrxMap::iterator const dup(trx_map_.find(trx->global_seqno()));
+            if (dup != trx_map_.end() && !TrxMap::not_set(*dup))
+                gu_throw_fatal << "duplicate trx entry " << *trx;
+
+            trx_map_.insert(trx->global_seqno(), trx);
+            ++trx_map_count_;
+
+            deps_set_.insert(trx->last_seen_seqno());
+            assert(deps_set_.size() <= trx_map_count_);
         }
     }
 
-    const TestResult retval(test(trx));
+    /* Trxs are now in trx map and their last seen seqnos are in deps set,
+     * so they can't be purged until committed. */
+    for (size_t i(0); i < n; ++i)
+    {
+        if (res[i] != TEST_OK) continue;
+
+        if (trxs[i]->preordered())
+        {
+            res[i] = do_test_preordered(trxs[i]);
+        }
+        else if (batch_[i].version >= 3)
+        {
+            res[i] = do_test_v3to4(trxs[i], true, batch_[i].keys,
+                                   batch_[i].purged);
+        }
+    }
 
     {
         gu::Lock lock(mutex_);
 
-        if (trx_map_.insert(
-                std::make_pair(trx->global_seqno(), trx)).second == false)
-            gu_throw_fatal << "duplicate trx entry " << *trx;
+        for (size_t i(0); i < n; ++i)
+        {
+            if (batch_[i].version >= 0)
+            {
+                batch_[i].index_size =
+                    do_test_finish_(trxs[i], true, batch_[i].version, res[i]);
+            }
+        }
+    }
 
-        deps_set_.insert(trx->last_seen_seqno());
-        assert(deps_set_.size() <= trx_map_.size());
+    {
+        gu::Lock lock(stats_mutex_);
+
+        for (size_t i(0); i < n; ++i)
+        {
+            if (batch_[i].version >= 0 && res[i] == TEST_OK)
+            {
+                update_stats_(trxs[i], batch_[i].index_size);
+            }
+        }
     }
 
-    trx->mark_certified();
+    for (size_t i(0); i < n; ++i)
+    {
+        if (gu_unlikely(res[i] != TEST_OK))
+        {
+            // make sure that last depends seqno is -1 for trxs that failed
+            // certification
+            trxs[i]->set_depends_seqno(WSREP_SEQNO_UNDEFINED);
+        }
 
-    return retval;
+        trxs[i]->mark_certified();
+    }
 }
 
 
@@ -1146,12 +1588,10 @@ wsrep_seqno_t galera::Certification::set_trx_committed(TrxHandle* trx)
         {
             // trxs with depends_seqno == -1 haven't gone through
             // append_trx
-            DepsSet::iterator i(deps_set_.find(trx->last_seen_seqno()));
-            assert(i != deps_set_.end());
-
-            if (deps_set_.size() == 1) safe_to_discard_seqno_ = *i;
+            if (deps_set_.size() == 1)
+                safe_to_discard_seqno_ = trx->last_seen_seqno();
 
-            deps_set_.erase(i);
+            deps_set_.erase(trx->last_seen_seqno());
         }
 
         if (gu_unlikely(gcache_.cleanup_required() || index_purge_required()))
@@ -1171,11 +1611,11 @@ galera::TrxHandle* galera::Certification::get_trx(wsrep_seqno_t seqno)
     gu::Lock lock(mutex_);
     TrxMap::iterator i(trx_map_.find(seqno));
 
-    if (i == trx_map_.end()) return 0;
+    if (i == trx_map_.end() || TrxMap::not_set(*i)) return 0;
 
-    i->second->ref();
+    (*i)->ref();
 
-    return i->second;
+    return *i;
 }
 
 void
@@ -1215,6 +1655,30 @@ galera::Certification::param_set(const std::string& key,
         set_boolean_parameter(optimistic_pa_, value, CERT_PARAM_OPTIMISTIC_PA,
                               "\"optimistic\" parallel applying.");
     }
+    else if (key == CERT_PARAM_PURGE_KEYS)
+    {
+        size_t const val(purge_threshold(key, value));
+        gu::Lock lock(mutex_);
+        purge_keys_threshold_ = val;
+    }
+    else if (key == CERT_PARAM_PURGE_BYTES)
+    {
+        size_t const val(purge_threshold(key, value));
+        gu::Lock lock(mutex_);
+        purge_bytes_threshold_ = val;
+    }
+    else if (key == CERT_PARAM_PURGE_TRXS)
+    {
+        size_t const val(purge_threshold(key, value));
+        gu::Lock lock(mutex_);
+        purge_trxs_threshold_ = val;
+    }
+    else if (key == CERT_PARAM_PURGE_SLICE)
+    {
+        gu::datetime::Period const val(purge_slice(value));
+        gu::Lock lock(purge_mutex_);
+        purge_slice_ = val;
+    }
     else
     {
         throw gu::NotFound();
@@ -7,19 +7,25 @@
 
 #include "trx_handle.hpp"
 #include "key_entry_ng.hpp"
+#include "cert_index_ng.hpp"
+#include "cert_deps_set.hpp"
 #include "galera_service_thd.hpp"
 
 #include "gu_unordered.hpp"
 #include "gu_lock.hpp"
 #include "gu_config.hpp"
+#include "gu_datetime.hpp"
+#include "gu_deqmap.hpp"
 
 #include <map>
 #include <set>
 #include <list>
+#include <deque>
+#include <vector>
 
 namespace galera
 {
-    class Certification
+    class Certification : private ServiceThd::Task
     {
     public:
 
@@ -31,15 +37,74 @@ namespace galera
         typedef gu::UnorderedSet<KeyEntryOS*,
                                  KeyEntryPtrHash, KeyEntryPtrEqual> CertIndex;
 
-        typedef gu::UnorderedSet<KeyEntryNG*,
-                                 KeyEntryPtrHashNG, KeyEntryPtrEqualNG>
-        CertIndexNG;
-
     private:
 
-        typedef std::multiset<wsrep_seqno_t>        DepsSet;
+        typedef CertDepsSet                                DepsSet;
+
+        /* certified trxs indexed by global seqno, seqnos which don't
+         * correspond to certified trxs are NULL holes */
+        typedef gu::DeqMap<wsrep_seqno_t, TrxHandle*> TrxMap;
+
+        /* Partition of the NG certification index. Keys are distributed
+         * among shards by KeySet::KeyPart::hash() and every shard is
+         * protected by its own mutex, so key lookups, insertions and purging
+         * don't need to hold the certification mutex_. Total order of
+         * certification is still provided by the caller (local monitor) and
+         * checked against position_. */
+        class CertIndexShard
+        {
+        public:
+            CertIndexShard()
+                :
+#ifdef HAVE_PSI_INTERFACE
+                // instrumented as part of certification mutex
+                mutex_(WSREP_PFS_INSTR_TAG_CERT_MUTEX),
+#else
+                mutex_(),
+#endif /* HAVE_PSI_INTERFACE */
+                index_()
+            {}
+
+#ifdef HAVE_PSI_INTERFACE
+            gu::MutexWithPFS mutex_;
+#else
+            gu::Mutex        mutex_;
+#endif /* HAVE_PSI_INTERFACE */
+            CertIndexNG      index_;
+
+        private:
+            CertIndexShard(const CertIndexShard&);
+            CertIndexShard& operator=(const CertIndexShard&);
+        };
+
+        /* write set keys paired with their shard indices, sorted by shard */
+        typedef std::vector<std::pair<size_t, KeySet::KeyPart> > ShardedKeys;
 
-        typedef std::map<wsrep_seqno_t, TrxHandle*> TrxMap;
+        /* Index purge generation: trxs detached from trx_map_ by a single
+         * purge_trxs_upto_() call. Their keys are purged from the index
+         * by the service thread and then the purge seqno is released
+         * in gcache (if required), so write sets are valid until then. */
+        struct PurgeGen
+        {
+            PurgeGen(wsrep_seqno_t const seqno, bool const handle_gcache)
+                : seqno_(seqno), handle_gcache_(handle_gcache), trxs_()
+            {}
+
+            wsrep_seqno_t           seqno_;
+            bool                    handle_gcache_;
+            std::vector<TrxHandle*> trxs_;
+        };
+
+        /* per trx context of append_trxs() */
+        struct BatchTrx
+        {
+            BatchTrx() : keys(), version(-1), index_size(0), purged(0) {}
+
+            ShardedKeys   keys;
+            int           version;
+            size_t        index_size;
+            wsrep_seqno_t purged;
+        };
 
     public:
 
@@ -54,6 +119,11 @@ namespace galera
 
         void assign_initial_position(wsrep_seqno_t seqno, int versiono);
         TestResult append_trx(TrxHandle*);
+
+        /*! Certifies a run of trxs ordered by seqno. Trx map and counters
+         *  are updated in one critical section for the whole run.
+         *  Certification results are returned in res array. */
+        void append_trxs(TrxHandle* const* trxs, size_t n, TestResult* res);
         TestResult test(TrxHandle*, bool = true);
         wsrep_seqno_t position() const { return position_; }
 
@@ -108,37 +178,69 @@ namespace galera
 
         size_t bucket_count ()
         {
-            return cert_index_.bucket_count() +
-                cert_index_ng_.bucket_count();
+            size_t ret(cert_index_.bucket_count());
+
+            for (size_t i(0); i < shards_.size(); ++i)
+            {
+                gu::Lock lock(shards_[i]->mutex_);
+                ret += shards_[i]->index_.bucket_count();
+            }
+
+            return ret;
         }
 
+        size_t shard_count() const { return shards_.size(); }
+
         void param_set(const std::string& key, const std::string& value);
 
     private:
 
         TestResult do_test(TrxHandle*, bool);
+        bool       do_test_precheck(TrxHandle*) const;
         TestResult do_test_v1to2(TrxHandle*, bool);
-        TestResult do_test_v3to4(TrxHandle*, bool);
+        TestResult do_test_v3to4(TrxHandle*, bool, const ShardedKeys&,
+                                 wsrep_seqno_t purged);
         TestResult do_test_preordered(TrxHandle*);
         void purge_for_trx(TrxHandle*);
         void purge_for_trx_v1to2(TrxHandle*);
         void purge_for_trx_v3(TrxHandle*);
 
+        size_t shard_of(const KeySet::KeyPart& kp) const
+        {
+            /* lower hash bits select a bucket within the shard index,
+             * use higher bits to select the shard */
+            return (kp.hash() >> 16) % shards_.size();
+        }
+
+        void shard_keys(const KeySetIn&, ShardedKeys&) const;
+        size_t index_ng_size() const;
+        void clear_index_ng();
+
         // unprotected variants for internal use
+        void   append_prepare_(TrxHandle*);
+        int    do_test_init_(TrxHandle*, bool, TestResult&);
+        /* trxs up to this seqno are purged from trx map, their keys are
+         * ignored by certification even if still in the index */
+        wsrep_seqno_t purged_seqno_() const
+        {
+            return trx_map_.index_begin() - 1;
+        }
+        size_t do_test_finish_(TrxHandle*, bool, int version, TestResult);
+        void   update_stats_(const TrxHandle*, size_t index_size);
         wsrep_seqno_t get_safe_to_discard_seqno_() const;
         wsrep_seqno_t purge_trxs_upto_(wsrep_seqno_t, bool sync);
 
+        /* background index purge slice, runs in service thread,
+         * ServiceThd::flush() waits for the purge to complete */
+        bool run_slice();
+
         bool index_purge_required()
         {
-            static unsigned int const KEYS_THRESHOLD (1   << 10); // 1K
-            static unsigned int const BYTES_THRESHOLD(128 << 20); // 128M
-            static unsigned int const TRXS_THRESHOLD (127);
-
             /* if either key count, byte count or trx count exceed their
              * threshold, zero up counts and return true. */
-            return ((key_count_  > KEYS_THRESHOLD  ||
-                     byte_count_ > BYTES_THRESHOLD ||
-                     trx_count_  > TRXS_THRESHOLD)
+            return ((key_count_  > purge_keys_threshold_  ||
+                     byte_count_ > purge_bytes_threshold_ ||
+                     trx_count_  > purge_trxs_threshold_)
                      &&
                      (key_count_ = 0, byte_count_ = 0, trx_count_ = 0, true));
         }
@@ -149,10 +251,11 @@ namespace galera
 
             PurgeAndDiscard(Certification& cert) : cert_(cert) { }
 
-            void operator()(TrxMap::value_type& vt) const
+            void operator()(TrxHandle* const trx) const
             {
+                if (TrxMap::not_set(trx)) return; // hole in trx map
+
                 {
-                    TrxHandle* trx(vt.second);
                     TrxHandleLock lock(*trx);
 
                     if (trx->is_committed() == false)
@@ -172,7 +275,7 @@ namespace galera
                                   << " refcnt " << trx->refcnt();
                     }
                 }
-                vt.second->unref();
+                trx->unref();
             }
 
             PurgeAndDiscard(const PurgeAndDiscard& other) : cert_(other.cert_)
@@ -187,8 +290,12 @@ namespace galera
         int           version_;
         gu::Config&   conf_;
         TrxMap        trx_map_;
+        size_t        trx_map_count_; // trxs in trx_map_ without holes
         CertIndex     cert_index_;
-        CertIndexNG   cert_index_ng_;
+        std::vector<CertIndexShard*> shards_;
+        std::vector<BatchTrx>        batch_;
+        std::deque<PurgeGen>         purge_queue_;
+        size_t                       purge_pos_; // in purge_queue_.front()
         DepsSet       deps_set_;
         ServiceThd&   service_thd_;
         gcache::GCache& gcache_;
@@ -197,6 +304,12 @@ namespace galera
                       mutex_;
 #else
         gu::Mutex     mutex_;
+#endif /* HAVE_PSI_INTERFACE */
+#ifdef HAVE_PSI_INTERFACE
+        gu::MutexWithPFS
+                      purge_mutex_; // protects purge_queue_ and purge_slice_
+#else
+        gu::Mutex     purge_mutex_; // protects purge_queue_ and purge_slice_
 #endif /* HAVE_PSI_INTERFACE */
         size_t        trx_size_warn_count_;
         wsrep_seqno_t initial_position_;
@@ -220,6 +333,13 @@ namespace galera
         size_t        byte_count_;
         size_t        trx_count_;
 
+        /* index purge is reported as required when any of these counters
+         * exceeds its threshold */
+        size_t        purge_keys_threshold_;
+        size_t        purge_bytes_threshold_;
+        size_t        purge_trxs_threshold_;
+        gu::datetime::Period purge_slice_; // max duration of purge slice
+
         /* The only reason those are not static constants is because
          * there might be a need to thange them without recompilation.
          * see #454 */
@@ -4,3 +4,85 @@
 
 #include "data_set.hpp"
 
+#include "gu_deflate.hpp"
+#include "gu_serialize.hpp"
+
+#include <cstring>
+
+namespace
+{
+    // favor speed, compression is done in the replicating thread
+    int const    COMPRESSION_LEVEL(1);
+    // uncompressed size prefix of VER2 record
+    size_t const PLAIN_SIZE_LEN(8);
+    // sanity limit on uncompressed size
+    uint64_t const PLAIN_SIZE_MAX(0x7fffffff);
+}
+
+bool
+galera::DataSetOut::compress (const GatherVector&      plain,
+                              size_t const             plain_size,
+                              std::vector<gu::byte_t>& buf)
+{
+    gu::Deflate def(COMPRESSION_LEVEL);
+
+    for (size_t i(0); i < plain->size(); ++i)
+    {
+        def.append(plain[i].ptr, plain[i].size);
+    }
+
+    def.flush();
+
+    if (PLAIN_SIZE_LEN + def.size() >= plain_size) return false;
+
+    buf.resize(PLAIN_SIZE_LEN + def.size());
+    gu::serialize8(uint64_t(plain_size), &buf[0], buf.size(), 0);
+    ::memcpy(&buf[PLAIN_SIZE_LEN], def.data(), def.size());
+
+    return true;
+}
+
+void
+galera::DataSetIn::decompress () const
+{
+    typedef gu::RecordSetIn<DataSet::RecordIn> base;
+
+    base::rewind();
+    gu::Buf const z(base::next().buf());
+    base::rewind();
+
+    const gu::byte_t* const ptr(static_cast<const gu::byte_t*>(z.ptr));
+    uint64_t size(0);
+
+    if (z.size > ssize_t(PLAIN_SIZE_LEN))
+    {
+        gu::unserialize8(ptr, z.size, 0, size);
+    }
+
+    if (0 == size || size > PLAIN_SIZE_MAX)
+    {
+        gu_throw_error(EPROTO) << "Invalid compressed data set: record size "
+                               << z.size << ", uncompressed size " << size;
+    }
+
+    std::vector<gu::byte_t> buf(size);
+
+    gu::Inflate inf;
+    inf.input(ptr + PLAIN_SIZE_LEN, z.size - PLAIN_SIZE_LEN);
+
+    size_t got(0);
+    size_t n;
+    while (got < size && (n = inf.output(&buf[got], size - got)) > 0)
+    {
+        got += n;
+    }
+
+    if (got != size)
+    {
+        gu_throw_error(EPROTO) << "Compressed data set truncated: got "
+                               << got << " bytes out of " << size;
+    }
+
+    plain_.init(&buf[0], size, true); // verifies plain set checksum
+    plain_buf_.swap(buf);
+}
@@ -9,6 +9,8 @@
 #include "gu_rset.hpp"
 #include "gu_vlq.hpp"
 
+#include <vector>
+
 
 namespace galera
 {
@@ -19,14 +21,21 @@ namespace galera
         enum Version
         {
             EMPTY = 0,
-            VER1
+            VER1,
+            VER2  /* VER1 data set compressed into a single record */
         };
 
+        /* Max version of the sets as they are built. VER2 is produced only
+         * by compressing a complete VER1 data set, see DataSetOut::compress()
+         */
         static Version const MAX_VERSION = VER1;
 
+        /* Max version that can be read */
+        static Version const MAX_IN_VERSION = VER2;
+
         static Version version (unsigned int ver)
         {
-            if (gu_likely (ver <= MAX_VERSION))
+            if (gu_likely (ver <= MAX_IN_VERSION))
                 return static_cast<Version>(ver);
 
             gu_throw_error (EINVAL) << "Unrecognized DataSet version: " << ver;
@@ -116,6 +125,13 @@ namespace galera
 
         typedef gu::RecordSet::GatherVector GatherVector;
 
+        /* Compresses serialized VER1 set into buf as VER2 record:
+         * 8 bytes of uncompressed size followed by zlib stream.
+         * @return false if compression does not make it smaller */
+        static bool
+        compress (const GatherVector& plain, size_t plain_size,
+                  std::vector<gu::byte_t>& buf);
+
     private:
 
         // depending on version we may pack data differently
@@ -127,7 +143,8 @@ namespace galera
             switch (ver)
             {
             case DataSet::EMPTY: break; /* Can't create EMPTY DataSetOut */
-            case DataSet::VER1:  return gu::RecordSet::CHECK_MMH128;
+            case DataSet::VER1:
+            case DataSet::VER2:  return gu::RecordSet::CHECK_MMH128;
             }
             throw;
         }
@@ -142,28 +159,65 @@ namespace galera
         DataSetIn (DataSet::Version ver, const gu::byte_t* buf, size_t size)
             :
             gu::RecordSetIn<DataSet::RecordIn>(buf, size, false),
-            version_(ver)
+            version_(ver),
+            plain_  (),
+            plain_buf_()
         {}
 
         DataSetIn () : gu::RecordSetIn<DataSet::RecordIn>(),
-                       version_(DataSet::EMPTY)
+                       version_(DataSet::EMPTY),
+                       plain_  (),
+                       plain_buf_()
         {}
 
         void init (DataSet::Version ver, const gu::byte_t* buf, size_t size)
         {
             gu::RecordSetIn<DataSet::RecordIn>::init(buf, size, false);
             version_ = ver;
+            plain_buf_.clear();
+        }
+
+        DataSet::Version version () const { return version_; }
+
+        /* VER2 set is decompressed on first access to records */
+        int count () const
+        {
+            if (gu_unlikely(DataSet::VER2 == version_))
+            {
+                if (plain_buf_.empty()) decompress();
+                return plain_.count();
+            }
+
+            return gu::RecordSetIn<DataSet::RecordIn>::count();
         }
 
         gu::Buf next () const
         {
+            if (gu_unlikely(DataSet::VER2 == version_))
+            {
+                if (plain_buf_.empty()) decompress();
+                return plain_.next().buf();
+            }
+
             return gu::RecordSetIn<DataSet::RecordIn>::next().buf();
         }
 
+        void rewind () const
+        {
+            gu::RecordSetIn<DataSet::RecordIn>::rewind();
+            plain_.rewind();
+        }
+
     private:
 
+        void decompress () const;
+
         DataSet::Version version_;
 
+        /* decompressed VER1 set */
+        mutable gu::RecordSetIn<DataSet::RecordIn> plain_;
+        mutable std::vector<gu::byte_t>            plain_buf_;
+
     }; /* class DataSetIn */
 
 #if defined(__GNUG__)
@@ -34,6 +34,7 @@ namespace galera
                                              gcs_seqno_t seqno) = 0;
         virtual void    close() = 0;
         virtual ssize_t recv(gcs_action& act) = 0;
+        virtual ssize_t try_recv(gcs_action& act) = 0;
 
         typedef WriteSetNG::GatherVector WriteSetVector;
 
@@ -119,6 +120,11 @@ namespace galera
             return gcs_recv(conn_, &act);
         }
 
+        ssize_t try_recv(struct gcs_action& act)
+        {
+            return gcs_try_recv(conn_, &act);
+        }
+
         ssize_t sendv(const WriteSetVector& actv, size_t act_len,
                       gcs_act_type_t act_type, bool scheduled)
         {
@@ -294,6 +300,8 @@ namespace galera
 
         ssize_t recv(gcs_action& act);
 
+        ssize_t try_recv(gcs_action&) { return -EAGAIN; }
+
         ssize_t sendv(const WriteSetVector&, size_t, gcs_act_type_t, bool)
         { return -ENOSYS; }
 
@@ -7,10 +7,13 @@
 
 #include "galera_service_thd.hpp"
 
+#include <cassert>
+
 const uint32_t galera::ServiceThd::A_NONE = 0;
 
 static const uint32_t A_LAST_COMMITTED = 1U <<  0;
 static const uint32_t A_RELEASE_SEQNO  = 1U <<  1;
+static const uint32_t A_TASK           = 1U <<  2;
 static const uint32_t A_FLUSH          = 1U << 30;
 static const uint32_t A_EXIT           = 1U << 31;
 
@@ -88,6 +91,17 @@ galera::ServiceThd::thd_func (void* arg)
                              << data.release_seqno_ << ": " << e.what();
                 }
             }
+
+            if (data.act_ & A_TASK)
+            {
+                if (data.task_->run_slice())
+                {
+                    // more to do, reschedule after other pending actions
+                    gu::Lock lock(st->mtx_);
+                    st->data_.task_ = data.task_;
+                    st->data_.act_ |= A_TASK;
+                }
+            }
         }
     }
 
@@ -148,7 +162,7 @@ void
 galera::ServiceThd::reset()
 {
     gu::Lock lock(mtx_);
-    data_.act_ = A_NONE;
+    data_.act_ &= A_TASK; // task owns resources, it must be completed
     data_.last_committed_ = 0;
 }
 
@@ -181,3 +195,17 @@ galera::ServiceThd::release_seqno(gcs_seqno_t seqno)
         data_.act_ |= A_RELEASE_SEQNO;
     }
 }
+
+void
+galera::ServiceThd::schedule(Task* const task)
+{
+    gu::Lock lock(mtx_);
+
+    assert(NULL == data_.task_ || task == data_.task_);
+
+    data_.task_ = task;
+
+    if (data_.act_ == A_NONE) cond_.signal();
+
+    data_.act_ |= A_TASK;
+}
@@ -16,6 +16,17 @@ namespace galera
     {
     public:
 
+        /*! Work to be done in background in a series of bounded slices,
+         *  so that it does not delay other service actions */
+        class Task
+        {
+        public:
+            /*! does a slice of work, returns true if there is more to do */
+            virtual bool run_slice() = 0;
+        protected:
+            virtual ~Task() {}
+        };
+
         ServiceThd (GcsI& gcs, gcache::GCache& gcache);
 
         ~ServiceThd ();
@@ -38,6 +49,11 @@ namespace galera
         /*! release write sets up to and including seqno */
         void release_seqno (gcs_seqno_t seqno);
 
+        /*! schedule task slices to be run until the task is done,
+         *  only one task can be scheduled at a time. flush() waits
+         *  for the task to be done. */
+        void schedule (Task* task);
+
     private:
 
         static const uint32_t A_NONE;
@@ -46,11 +62,13 @@ namespace galera
         {
             gcs_seqno_t last_committed_;
             gcs_seqno_t release_seqno_;
+            Task*       task_;
             uint32_t    act_;
 
             Data() :
                 last_committed_(0),
                 release_seqno_ (0),
+                task_          (NULL),
                 act_           (A_NONE)
             {}
         };
@@ -11,6 +11,9 @@
 #include "galera_info.hpp"
 
 #include <cassert>
+#include <algorithm>
+
+size_t const galera::GcsActionSource::MAX_CERT_BATCH;
 
 // Exception-safe way to release action pointer when it goes out
 // of scope
@@ -98,6 +101,151 @@ galera::GcsActionTrx::~GcsActionTrx()
 }
 
 
+namespace
+{
+    // Exception-safe way to hold a batch of received trxs
+    class GcsActionTrxBatch
+    {
+    public:
+
+        explicit GcsActionTrxBatch(galera::TrxHandle::SlavePool& pool)
+            : pool_(pool), n_(0)
+        {}
+
+        ~GcsActionTrxBatch()
+        {
+            for (size_t i(0); i < n_; ++i)
+            {
+                assert(trxs_[i]->refcnt() >= 1);
+                trxs_[i]->unlock();
+                trxs_[i]->unref();
+            }
+        }
+
+        void push_back(const struct gcs_action& act)
+        {
+            assert(n_ < galera::GcsActionSource::MAX_CERT_BATCH);
+            assert(act.seqno_l != GCS_SEQNO_ILL);
+            assert(act.seqno_g != GCS_SEQNO_ILL);
+
+            galera::TrxHandle* const trx(galera::TrxHandle::New(pool_));
+
+            try
+            {
+                gu_trace(trx->unserialize(
+                             static_cast<const gu::byte_t*>(act.buf),
+                             act.size, 0));
+            }
+            catch (...)
+            {
+                trx->unref();
+                throw;
+            }
+
+            trx->set_received(act.buf, act.seqno_l, act.seqno_g);
+            trx->lock();
+            trx->set_state(galera::TrxHandle::S_REPLICATING);
+
+            trxs_[n_++] = trx;
+        }
+
+        galera::TrxHandle* const* trxs() const { return trxs_; }
+        size_t                    size() const { return n_;    }
+
+        // trxs are unlocked and from now on owned by the caller
+        void hand_over()
+        {
+            for (size_t i(0); i < n_; ++i) trxs_[i]->unlock();
+            n_ = 0;
+        }
+
+    private:
+
+        GcsActionTrxBatch(const GcsActionTrxBatch&);
+        void operator=(const GcsActionTrxBatch&);
+
+        galera::TrxHandle::SlavePool& pool_;
+        galera::TrxHandle* trxs_[galera::GcsActionSource::MAX_CERT_BATCH];
+        size_t             n_;
+    };
+
+    // Exception-safe way to hold received action until it is handed over
+    class ActionGuard
+    {
+    public:
+
+        ActionGuard(struct gcs_action& act, gcache::GCache& gcache)
+            : act_(act), gcache_(gcache), owned_(false)
+        {}
+
+        ~ActionGuard()
+        {
+            if (owned_) { Release release(act_, gcache_); }
+        }
+
+        void set_owned(bool const owned) { owned_ = owned; }
+
+    private:
+
+        ActionGuard(const ActionGuard&);
+        void operator=(const ActionGuard&);
+
+        struct gcs_action& act_;
+        gcache::GCache&    gcache_;
+        bool               owned_;
+    };
+
+    // Locks certified trx taken from the ready queue for applying
+    // and releases it when it goes out of scope
+    class ReadyTrx
+    {
+    public:
+
+        explicit ReadyTrx(galera::TrxHandle* const trx) : trx_(trx)
+        {
+            trx_->lock();
+        }
+
+        ~ReadyTrx()
+        {
+            assert(trx_->refcnt() >= 1);
+            trx_->unlock();
+            trx_->unref();
+        }
+
+    private:
+
+        ReadyTrx(const ReadyTrx&);
+        void operator=(const ReadyTrx&);
+
+        galera::TrxHandle* const trx_;
+    };
+}
+
+
+galera::GcsActionSource::~GcsActionSource()
+{
+    // actions left in the ready queue when receivers have exited
+    while (!ready_.empty())
+    {
+        ReadyAction& ra(ready_.front());
+
+        if (ra.trx_ != 0)
+        {
+            ra.trx_->unref();
+        }
+        else if (ra.rc_ > 0)
+        {
+            Release release(ra.act_, gcache_);
+        }
+
+        ready_.pop_front();
+    }
+
+    log_info << trx_pool_;
+}
+
+
 void galera::GcsActionSource::dispatch(void* const              recv_ctx,
                                        const struct gcs_action& act,
                                        bool&                    exit_loop)
@@ -168,10 +316,201 @@ void galera::GcsActionSource::dispatch(void* const              recv_ctx,
 
 
 ssize_t galera::GcsActionSource::process(void* recv_ctx, bool& exit_loop)
+{
+    // thread which was asked to exit does not collect any more actions
+    size_t const limit(exit_loop ? 1 : std::min(replicator_.max_cert_batch(),
+                                                MAX_CERT_BATCH));
+
+    ReadyAction ra;
+
+    if (pop_ready(ra, limit)) return process_ready(recv_ctx, ra, exit_loop);
+
+    if (limit > 1) return process_batch(recv_ctx, limit, exit_loop);
+
+    struct gcs_action act;
+
+    ssize_t const rc(gcs_.recv(act));
+
+    return process_action(recv_ctx, act, rc, exit_loop);
+}
+
+
+/* Takes the next action from the ready queue. With batching waits until
+ * the queue is not empty or the calling thread becomes the receiver. */
+bool galera::GcsActionSource::pop_ready(ReadyAction& ra, size_t const limit)
+{
+    gu::Lock lock(ready_mtx_);
+
+    while (limit > 1 && ready_.empty() && receiving_) lock.wait(ready_cond_);
+
+    if (!ready_.empty())
+    {
+        ra = ready_.front();
+        ready_.pop_front();
+        return true;
+    }
+
+    if (limit > 1) receiving_ = true;
+
+    return false;
+}
+
+
+void galera::GcsActionSource::end_receiving()
+{
+    gu::Lock lock(ready_mtx_);
+
+    if (receiving_)
+    {
+        receiving_ = false;
+        ready_cond_.broadcast();
+    }
+}
+
+
+ssize_t galera::GcsActionSource::process_ready(void* const  recv_ctx,
+                                               ReadyAction& ra,
+                                               bool&        exit_loop)
+{
+    if (0 == ra.trx_)
+    {
+        return process_action(recv_ctx, ra.act_, ra.rc_, exit_loop);
+    }
+
+    ReadyTrx trx(ra.trx_);
+    gu_trace(replicator_.process_trx_result(recv_ctx, ra.trx_, ra.retval_));
+    exit_loop = ra.trx_->exit_loop(); // this is the end of trx lifespan
+
+    return ra.rc_;
+}
+
+
+/* Receives an action and, if it is a write set, collects the write sets
+ * which are already waiting in the recv queue and certifies them in one
+ * batch. Certified trxs and the action which ended the batch go through
+ * the ready queue, so that they are applied by all receiving threads in
+ * parallel. Must be called by the receiver thread. */
+ssize_t galera::GcsActionSource::process_batch(void* const  recv_ctx,
+                                               size_t const limit,
+                                               bool&        exit_loop)
 {
     struct gcs_action act;
+    struct gcs_action pending_act;
+    ssize_t           rc;
+    ssize_t           pending_rc(0);
+    bool              pending(false);
+    ssize_t           sizes[MAX_CERT_BATCH];
+    wsrep_status_t    retvals[MAX_CERT_BATCH];
+    bool              certified(false);
+
+    GcsActionTrxBatch batch(trx_pool_);
+    ActionGuard       pending_guard(pending_act, gcache_);
+
+    try
+    {
+        rc = gcs_.recv(act);
+    }
+    catch (...)
+    {
+        end_receiving();
+        throw;
+    }
+
+    if (rc <= 0 || GCS_ACT_TORDERED != act.type)
+    {
+        end_receiving();
+        return process_action(recv_ctx, act, rc, exit_loop);
+    }
+
+    try
+    {
+        while (true)
+        {
+            assert(act.seqno_g > 0);
+            sizes[batch.size()] = rc;
+            gu_trace(batch.push_back(act));
+            ++received_;
+            received_bytes_ += rc;
+
+            if (batch.size() == limit) break;
+
+            rc = gcs_.try_recv(act);
+
+            // empty queue or error which will be returned by the next recv()
+            if (GCS_ACT_ERROR == act.type) break;
+
+            // batch must be a run of consecutive local seqnos, as local
+            // monitor is entered only once for all of them
+            if (rc <= 0 || GCS_ACT_TORDERED != act.type ||
+                act.seqno_l != batch.trxs()[batch.size()-1]->local_seqno() + 1)
+            {
+                pending_act = act;
+                pending_rc  = rc;
+                pending     = true;
+                pending_guard.set_owned(rc > 0);
+                break;
+            }
+        }
+
+        gu_trace(certified = replicator_.cert_trxs(batch.trxs(), batch.size(),
+                                                   retvals));
+
+        gu::Lock lock(ready_mtx_);
+
+        size_t const old_size(ready_.size());
+
+        try
+        {
+            ReadyAction ra;
 
-    ssize_t rc(gcs_.recv(act));
+            for (size_t i(0); certified && i < batch.size(); ++i)
+            {
+                ra.trx_    = batch.trxs()[i];
+                ra.retval_ = retvals[i];
+                ra.rc_     = sizes[i];
+                ready_.push_back(ra);
+            }
+
+            if (pending)
+            {
+                ra.trx_ = 0;
+                ra.act_ = pending_act;
+                ra.rc_  = pending_rc;
+                ready_.push_back(ra);
+            }
+        }
+        catch (...)
+        {
+            ready_.resize(old_size);
+            throw;
+        }
+
+        if (certified) batch.hand_over();
+        pending_guard.set_owned(false);
+
+        receiving_ = false;
+        ready_cond_.broadcast();
+    }
+    catch (...)
+    {
+        end_receiving();
+        throw;
+    }
+
+    // this thread takes its share of the batch too
+    ReadyAction ra;
+
+    if (pop_ready(ra, 1)) return process_ready(recv_ctx, ra, exit_loop);
+
+    return sizes[0];
+}
+
+
+ssize_t galera::GcsActionSource::process_action(void* const        recv_ctx,
+                                                struct gcs_action& act,
+                                                ssize_t            rc,
+                                                bool&              exit_loop)
+{
     if (rc > 0)
     {
         Release release(act, gcache_);
@@ -13,6 +13,9 @@
 #include "GCache.hpp"
 
 #include "gu_atomic.hpp"
+#include "gu_lock.hpp"
+
+#include <deque>
 
 namespace galera
 {
@@ -23,6 +26,9 @@ namespace galera
         /* to be returned in case of inconsistency event */
         static int const INCONSISTENCY_CODE = -ENOTRECOVERABLE;
 
+        /* max number of consecutive write sets certified as one batch */
+        static size_t const MAX_CERT_BATCH = 256;
+
         GcsActionSource(TrxHandle::SlavePool& sp,
                         GCS_IMPL&             gcs,
                         Replicator&           replicator,
@@ -33,13 +39,14 @@ namespace galera
             replicator_    (replicator),
             gcache_        (gcache    ),
             received_      (0         ),
-            received_bytes_(0         )
+            received_bytes_(0         ),
+            ready_mtx_     (          ),
+            ready_cond_    (          ),
+            ready_         (          ),
+            receiving_     (false     )
         { }
 
-        ~GcsActionSource()
-        {
-            log_info << trx_pool_;
-        }
+        ~GcsActionSource();
 
         ssize_t   process(void*, bool& exit_loop);
         long long received()       const { return received_(); }
@@ -47,6 +54,21 @@ namespace galera
 
     private:
 
+        /* Received action waiting in the ready queue: either a certified
+         * trx with its certification result or any other action. */
+        struct ReadyAction
+        {
+            TrxHandle*        trx_;
+            wsrep_status_t    retval_;
+            struct gcs_action act_;
+            ssize_t           rc_;
+        };
+
+        ssize_t process_action(void*, gcs_action&, ssize_t, bool& exit_loop);
+        ssize_t process_batch(void*, size_t limit, bool& exit_loop);
+        ssize_t process_ready(void*, ReadyAction&, bool& exit_loop);
+        bool    pop_ready(ReadyAction&, size_t limit);
+        void    end_receiving();
         void dispatch(void*, const gcs_action&, bool& exit_loop);
 
         TrxHandle::SlavePool& trx_pool_;
@@ -55,6 +77,14 @@ namespace galera
         gcache::GCache&       gcache_;
         gu::Atomic<long long> received_;
         gu::Atomic<long long> received_bytes_;
+
+        /* With batching only one thread at a time receives from GCS and
+         * certifies a batch, the rest wait for actions in ready_ queue,
+         * so that certified trxs are applied in parallel. */
+        gu::Mutex               ready_mtx_;
+        gu::Cond                ready_cond_;
+        std::deque<ReadyAction> ready_;
+        bool                    receiving_;
     };
 
     class GcsActionTrx
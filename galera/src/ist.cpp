@@ -21,6 +21,49 @@ namespace
 {
     static std::string const CONF_KEEP_KEYS     ("ist.keep_keys");
     static bool        const CONF_KEEP_KEYS_DEFAULT (true);
+
+    // size of the IST receiver read-ahead buffer
+    static size_t      const RECV_BUF_SIZE      (1 << 20);
+    // max number of write sets handed to appliers at once
+    static size_t      const RECV_BATCH_SIZE    (64);
+    // limits on write sets received but not yet taken by appliers
+    static size_t      const RECV_QUEUE_MAX_TRX (1024);
+    static size_t      const RECV_QUEUE_MAX_SIZE(64 << 20);
+    // limits on write sets read ahead from each of multiple IST connections
+    static size_t      const STREAM_QUEUE_MAX_TRX (256);
+    static size_t      const STREAM_QUEUE_MAX_SIZE(16 << 20);
+
+    // number of connections IST sender may split the range over
+    static std::string const CONF_SEND_STREAMS  ("ist.send_streams");
+    static int         const CONF_SEND_STREAMS_DEFAULT (1);
+    static int         const SEND_STREAMS_MAX   (16);
+    // seqnos sent in a row over one of multiple connections
+    static wsrep_seqno_t const STREAM_CHUNK     (64);
+
+    // bytes of write sets IST sender gathers into a single write,
+    // 0 sends each write set separately
+    static std::string const CONF_SEND_BATCH    ("ist.send_batch_size");
+    static size_t      const CONF_SEND_BATCH_DEFAULT (256 << 10);
+
+    // compress IST stream if the receiver supports it
+    static std::string const CONF_COMPRESSION   ("ist.compression");
+    static bool        const CONF_COMPRESSION_DEFAULT (false);
+    // favor speed, the stream should keep up with the network
+    static int         const COMPRESSION_LEVEL  (1);
+
+    // handshake response flags for the given receiver handshake flags
+    uint8_t response_flags(const gu::Config& conf, uint8_t const hs_flags)
+    {
+        using galera::ist::Handshake;
+
+        if ((hs_flags & Handshake::F_COMPRESS) &&
+            conf.get(CONF_COMPRESSION, CONF_COMPRESSION_DEFAULT))
+        {
+            return Handshake::F_COMPRESS;
+        }
+
+        return 0;
+    }
 }
 
 
@@ -87,9 +130,13 @@ galera::ist::register_params(gu::Config& conf)
     conf.add(Receiver::RECV_ADDR);
     conf.add(Receiver::RECV_BIND);
     conf.add(CONF_KEEP_KEYS);
+    conf.add(CONF_SEND_STREAMS);
+    conf.add(CONF_SEND_BATCH);
+    conf.add(CONF_COMPRESSION);
 }
 
 galera::ist::Receiver::Receiver(gu::Config&           conf,
+                                gcache::GCache&       gc,
                                 TrxHandle::SlavePool& sp,
                                 const char*           addr)
     :
@@ -101,15 +148,19 @@ galera::ist::Receiver::Receiver(gu::Config&           conf,
 #ifdef HAVE_PSI_INTERFACE
     mutex_        (WSREP_PFS_INSTR_TAG_IST_RECEIVER_MUTEX),
     cond_         (WSREP_PFS_INSTR_TAG_IST_RECEIVER_CONDVAR),
+    recv_cond_    (WSREP_PFS_INSTR_TAG_IST_CONSUMER_CONDVAR),
 #else
     mutex_        (),
     cond_         (),
+    recv_cond_    (),
 #endif /* HAVE_PSI_INTERFACE */
-    consumers_    (),
+    queue_        (),
+    queue_bytes_  (0),
     current_seqno_(-1),
     first_seqno_  (-1),
     last_seqno_   (-1),
     conf_         (conf),
+    gcache_       (gc),
     trx_pool_     (sp),
     thread_       (),
     error_code_   (0),
@@ -153,6 +204,419 @@ galera::ist::Receiver::~Receiver()
 { }
 
 
+extern "C" void* run_receiver_stream(void* arg);
+
+namespace galera
+{
+    namespace ist
+    {
+        /* A single IST connection on the receiver side. With one connection
+         * write sets are read from it directly by the receiver thread, with
+         * several ones each connection gets a reader thread which parses
+         * write sets into a queue, and the receiver thread merges the queues
+         * in seqno order. */
+        class ReceiverStream
+        {
+        public:
+
+            ReceiverStream(asio::io_service&     io_service,
+                           asio::ssl::context&   ssl_ctx,
+                           bool                  use_ssl,
+                           TrxHandle::SlavePool& sp,
+                           int                   version,
+                           bool                  keep_keys,
+                           gcache::GCache&       gcache,
+                           gu::Mutex&            mutex,
+                           gu::Cond&             cond)
+                :
+                socket_     (io_service),
+                ssl_stream_ (io_service, ssl_ctx),
+                use_ssl_    (use_ssl),
+                /* message flags are explicit in protocol version 4+ */
+                hs_flags_   (Handshake::F_MULTI_STREAM |
+                             (version > 3 ? Handshake::F_COMPRESS : 0)),
+                proto_      (sp, version, keep_keys),
+                reader_     (socket_, use_ssl ? 0 : RECV_BUF_SIZE),
+                ssl_reader_ (ssl_stream_, use_ssl ? RECV_BUF_SIZE : 0),
+                consumed_   (0),
+                watchdog_cb_(*this),
+                watchdog_   (&watchdog_cb_),
+                gcache_     (gcache),
+                mutex_      (mutex),
+                cond_       (cond),
+                queue_      (),
+                queue_bytes_(0),
+                thread_     (),
+                error_      (0),
+                started_    (false),
+                eof_        (false),
+                stopped_    (false)
+            { }
+
+            ~ReceiverStream() { stop(); }
+
+            void accept(asio::ip::tcp::acceptor& acceptor)
+            {
+                try
+                {
+                    if (use_ssl_ == true)
+                    {
+                        acceptor.accept(ssl_stream_.lowest_layer());
+                        gu::set_fd_options(ssl_stream_.lowest_layer());
+                        ssl_stream_.handshake(
+                            asio::ssl::stream<asio::ip::tcp::socket>::server);
+                    }
+                    else
+                    {
+                        acceptor.accept(socket_);
+                        gu::set_fd_options(socket_);
+                    }
+                }
+                catch (asio::system_error& e)
+                {
+                    gu_throw_error(e.code().value())
+                        << "accept() failed" << "', asio error '"
+                        << e.what() << "': " << gu::extra_error_info(e.code());
+                }
+            }
+
+            /* returns the number of connections announced by sender */
+            int handshake()
+            {
+                int     streams;
+                uint8_t flags(0);
+
+                if (use_ssl_ == true)
+                {
+                    proto_.send_handshake(ssl_stream_, hs_flags_);
+                    streams = proto_.recv_handshake_response(ssl_stream_,
+                                                             &flags);
+                    proto_.send_ctrl(ssl_stream_, Ctrl::C_OK);
+                }
+                else
+                {
+                    proto_.send_handshake(socket_, hs_flags_);
+                    streams = proto_.recv_handshake_response(socket_, &flags);
+                    proto_.send_ctrl(socket_, Ctrl::C_OK);
+                }
+
+                if (flags & Handshake::F_COMPRESS)
+                {
+                    if (use_ssl_) ssl_reader_.decompress();
+                    else          reader_.decompress();
+                }
+
+                return streams;
+            }
+
+            void use_gcache() { proto_.use_gcache(gcache_); }
+
+            /* Reads next write set from the connection, 0 on EOF.
+             * @param bytes number of bytes it took on the wire */
+            TrxHandle* recv(size_t& bytes)
+            {
+                watchdog_.start();
+                TrxHandle* const trx(use_ssl_ ?
+                                     proto_.recv_trx(ssl_reader_) :
+                                     proto_.recv_trx(reader_));
+                watchdog_.stop();
+
+                uint64_t const consumed(use_ssl_ ?
+                                        ssl_reader_.consumed() :
+                                        reader_.consumed());
+                bytes     = consumed - consumed_;
+                consumed_ = consumed;
+
+                return trx;
+            }
+
+            /* whether next write set can be read without blocking */
+            bool buffered() const
+            {
+                return (use_ssl_ ? ssl_reader_.buffered() :
+                        reader_.buffered()) > 0;
+            }
+
+            void start()
+            {
+                int const err(gu_thread_create(&thread_, 0,
+                                               &run_receiver_stream, this));
+                if (err != 0)
+                {
+                    gu_throw_error(err) << "Unable to create IST stream thread";
+                }
+                started_ = true;
+            }
+
+            /* reader thread body */
+            void run()
+            {
+                int err(0);
+
+                try
+                {
+                    for (;;)
+                    {
+                        size_t           bytes;
+                        TrxHandle* const trx(recv(bytes));
+
+                        gu::Lock lock(mutex_);
+
+                        while (full() && !stopped_) lock.wait(cond_);
+
+                        if (stopped_)
+                        {
+                            if (trx != 0) discard(trx);
+                            return;
+                        }
+
+                        if (trx == 0)
+                        {
+                            eof_ = true;
+                        }
+                        else
+                        {
+                            queue_.push_back(std::make_pair(trx, bytes));
+                            queue_bytes_ += bytes;
+                        }
+
+                        cond_.broadcast();
+
+                        if (eof_) return;
+                    }
+                }
+                catch (asio::system_error& e)
+                {
+                    err = e.code().value();
+                }
+                catch (gu::Exception& e)
+                {
+                    err = e.get_errno();
+                }
+
+                gu::Lock lock(mutex_);
+                if (!stopped_)
+                {
+                    log_error << "got error while reading ist stream: "
+                              << err << " (" << ::strerror(err) << ')';
+                }
+                error_ = (err != 0 ? err : EPROTO);
+                eof_   = true;
+                cond_.broadcast();
+            }
+
+            /* The following must be called with mutex locked */
+
+            /* returns the next queued write set or 0 if the queue is empty */
+            TrxHandle* front() const
+            {
+                return queue_.empty() ? 0 : queue_.front().first;
+            }
+
+            TrxHandle* pop(size_t& bytes)
+            {
+                bool const was_full(full());
+
+                TrxHandle* const trx(queue_.front().first);
+                bytes = queue_.front().second;
+                queue_.pop_front();
+                queue_bytes_ -= bytes;
+
+                if (was_full) cond_.broadcast();
+
+                return trx;
+            }
+
+            /* reader is done and all write sets were taken */
+            bool done()  const { return eof_ && queue_.empty(); }
+            /* reader is not going to make progress without pop() */
+            bool idle()  const { return eof_ || !queue_.empty(); }
+            int  error() const { return error_; }
+
+            /* Stops reader thread if any, closes the connection and discards
+             * write sets left in the queue. */
+            void stop()
+            {
+                {
+                    gu::Lock lock(mutex_);
+                    stopped_ = true;
+                    cond_.broadcast();
+                }
+
+                shutdown();
+
+                if (started_)
+                {
+                    gu_thread_join(thread_, 0);
+                    started_ = false;
+                }
+
+                asio::error_code ec;
+                if (use_ssl_ == true)
+                {
+                    ssl_stream_.lowest_layer().close(ec);
+                }
+                else
+                {
+                    socket_.close(ec);
+                }
+
+                while (queue_.empty() == false)
+                {
+                    discard(queue_.front().first);
+                    queue_.pop_front();
+                }
+                queue_bytes_ = 0;
+            }
+
+            /* write set that is not going to be applied */
+            void discard(TrxHandle* trx)
+            {
+                if (trx->action() != 0)
+                {
+                    gcache_.free(const_cast<void*>(trx->action()));
+                }
+                trx->unref();
+            }
+
+        private:
+
+            bool full() const
+            {
+                return (queue_.size() >= STREAM_QUEUE_MAX_TRX ||
+                        queue_bytes_  >= STREAM_QUEUE_MAX_SIZE);
+            }
+
+            void shutdown()
+            {
+                asio::error_code ec;
+                if (use_ssl_ == true)
+                {
+                    ssl_stream_.lowest_layer().shutdown(
+                        asio::socket_base::shutdown_both, ec);
+                }
+                else
+                {
+                    socket_.shutdown(asio::socket_base::shutdown_both, ec);
+                }
+            }
+
+            struct WatchdogCallback : public SocketWatchdogCb
+            {
+                explicit WatchdogCallback(ReceiverStream& s) : stream(s) { }
+
+                virtual void operator()()
+                {
+                    log_info << "SocketWatchdog expired";
+                    stream.shutdown();
+                }
+
+                ReceiverStream& stream;
+            };
+
+            typedef asio::ssl::stream<asio::ip::tcp::socket> ssl_stream_t;
+            typedef std::deque<std::pair<TrxHandle*, size_t> > queue_t;
+
+            asio::ip::tcp::socket                 socket_;
+            ssl_stream_t                          ssl_stream_;
+            bool const                            use_ssl_;
+            uint8_t const                         hs_flags_;
+            Proto                                 proto_;
+            ReadAheadStream<asio::ip::tcp::socket> reader_;
+            ReadAheadStream<ssl_stream_t>         ssl_reader_;
+            uint64_t                              consumed_;
+            WatchdogCallback                      watchdog_cb_;
+            SocketWatchdog                        watchdog_;
+            gcache::GCache&                       gcache_;
+            gu::Mutex&                            mutex_;
+            gu::Cond&                             cond_;
+            queue_t                               queue_;
+            size_t                                queue_bytes_;
+            gu_thread_t                           thread_;
+            int                                   error_;
+            bool                                  started_;
+            bool                                  eof_;
+            bool                                  stopped_;
+
+            ReceiverStream(const ReceiverStream&);
+            ReceiverStream& operator=(const ReceiverStream&);
+        };
+    }
+}
+
+
+extern "C" void* run_receiver_stream(void* arg)
+{
+    static_cast<galera::ist::ReceiverStream*>(arg)->run();
+    return 0;
+}
+
+
+/* Takes the write set with the given seqno from the heads of stream queues.
+ * Returns 0 when all streams are finished.
+ * @param more  whether the next seqno is available without waiting
+ * @param bytes number of bytes the write set took on the wire */
+static galera::TrxHandle*
+merge_streams(std::vector<galera::ist::ReceiverStream*>& streams,
+              gu::Mutex&          mutex,
+              gu::Cond&           cond,
+              wsrep_seqno_t const seqno,
+              bool&               more,
+              size_t&             bytes)
+{
+    gu::Lock lock(mutex);
+
+    for (;;)
+    {
+        galera::TrxHandle* trx(0);
+        bool done(true);
+        bool idle(true);
+
+        for (size_t i(0); i < streams.size(); ++i)
+        {
+            galera::ist::ReceiverStream& s(*streams[i]);
+
+            if (gu_unlikely(s.error() != 0))
+            {
+                gu_throw_error(s.error()) << "IST stream " << i << " failed";
+            }
+
+            galera::TrxHandle* const head(s.front());
+
+            if (head != 0 && head->global_seqno() == seqno)
+            {
+                trx = s.pop(bytes);
+                break;
+            }
+
+            done = done && s.done();
+            idle = idle && s.idle();
+        }
+
+        if (trx != 0)
+        {
+            more = false;
+            for (size_t i(0); i < streams.size() && !more; ++i)
+            {
+                galera::TrxHandle* const head(streams[i]->front());
+                more = (head != 0 && head->global_seqno() == seqno + 1);
+            }
+            return trx;
+        }
+
+        if (done) return 0;
+
+        if (idle)
+        {
+            gu_throw_error(EPROTO) << "IST streams do not contain seqno "
+                                   << seqno;
+        }
+
+        lock.wait(cond);
+    }
+}
+
+
 extern "C" void* run_receiver_thread(void* arg)
 {
 #ifdef HAVE_PSI_INTERFACE
@@ -382,48 +846,43 @@ galera::ist::Receiver::prepare(wsrep_seqno_t first_seqno,
 
 void galera::ist::Receiver::run()
 {
-    asio::ip::tcp::socket socket(io_service_);
-    asio::ssl::stream<asio::ip::tcp::socket> ssl_stream(io_service_, ssl_ctx_);
+    gu::Mutex                   streams_mutex;
+    gu::Cond                    streams_cond;
+    std::vector<ReceiverStream*> streams;
+    bool const keep_keys(conf_.get(CONF_KEEP_KEYS, CONF_KEEP_KEYS_DEFAULT));
+
+    streams.push_back(new ReceiverStream(io_service_, ssl_ctx_, use_ssl_,
+                                         trx_pool_, version_, keep_keys,
+                                         gcache_, streams_mutex,
+                                         streams_cond));
     try
     {
-        if (use_ssl_ == true)
-        {
-            acceptor_.accept(ssl_stream.lowest_layer());
-            gu::set_fd_options(ssl_stream.lowest_layer());
-            ssl_stream.handshake(asio::ssl::stream<asio::ip::tcp::socket>::server);
-        }
-        else
-        {
-            acceptor_.accept(socket);
-            gu::set_fd_options(socket);
-        }
+        streams[0]->accept(acceptor_);
     }
-    catch (asio::system_error& e)
+    catch (...)
     {
-        gu_throw_error(e.code().value()) << "accept() failed"
-                                         << "', asio error '"
-                                         << e.what() << "': "
-                                         << gu::extra_error_info(e.code());
+        delete streams[0];
+        throw;
     }
-    acceptor_.close();
+
     int ec(0);
+    /* write sets received but not yet handed to appliers */
+    queue_t batch;
     try
     {
-        Proto p(trx_pool_, version_,
-                conf_.get(CONF_KEEP_KEYS, CONF_KEEP_KEYS_DEFAULT));
+        int const n_streams(streams[0]->handshake());
 
-        if (use_ssl_ == true)
+        /* sender may split IST over several connections, accept the rest */
+        for (int i(1); i < n_streams; ++i)
         {
-            p.send_handshake(ssl_stream);
-            p.recv_handshake_response(ssl_stream);
-            p.send_ctrl(ssl_stream, Ctrl::C_OK);
-        }
-        else
-        {
-            p.send_handshake(socket);
-            p.recv_handshake_response(socket);
-            p.send_ctrl(socket, Ctrl::C_OK);
+            streams.push_back(new ReceiverStream(io_service_, ssl_ctx_,
+                                                 use_ssl_, trx_pool_, version_,
+                                                 keep_keys, gcache_,
+                                                 streams_mutex, streams_cond));
+            streams.back()->accept(acceptor_);
+            (void)streams.back()->handshake();
         }
+        acceptor_.close();
 
         /* wait for ready signal from the STR thread */
         {
@@ -438,6 +897,12 @@ void galera::ist::Receiver::run()
             }
         }
 
+        /* gcache history has been reset for the new state by now */
+        for (size_t i(0); i < streams.size(); ++i)
+        {
+            streams[i]->use_gcache();
+        }
+
         gu::Progress<wsrep_seqno_t> progress(
             "Receiving IST",
             " events",
@@ -446,74 +911,94 @@ void galera::ist::Receiver::run()
              * once per BOTH 10 seconds (default) and 16 events */
             16);
 
+        if (streams.size() > 1)
         {
-            struct WatchdogCallback : public SocketWatchdogCb {
+            log_info << "Receiving IST over " << streams.size()
+                     << " connections";
 
-              bool use_ssl;
-              asio::ip::tcp::socket& socket;
-              asio::ssl::stream<asio::ip::tcp::socket>& ssl_stream;
-
-              WatchdogCallback(bool use_ssl, asio::ip::tcp::socket& socket, asio::ssl::stream<asio::ip::tcp::socket>& ssl_stream) 
-              : use_ssl(use_ssl), socket(socket), ssl_stream(ssl_stream) {
-              }
+            for (size_t i(0); i < streams.size(); ++i)
+            {
+                streams[i]->start();
+            }
+        }
 
-              virtual void operator()() {
-                  log_info << "SocketWatchdog expired";
-                  if (use_ssl) {
-                      ssl_stream.lowest_layer().shutdown(asio::socket_base::shutdown_both);
-                  } else {
-                      socket.shutdown(asio::socket_base::shutdown_both);
-                  }
-              }
-            };
+        /* Write sets are parsed out of the read-ahead buffer (or taken from
+         * stream queues) and handed to appliers in batches whenever the next
+         * one is not readily available or the batch is full. */
+        while (true)
+        {
+            TrxHandle* trx;
+            bool       more;
+            size_t     bytes;
+            if (streams.size() == 1)
+            {
+                trx  = streams[0]->recv(bytes);
+                more = streams[0]->buffered();
+            }
+            else
+            {
+                trx = merge_streams(streams, streams_mutex, streams_cond,
+                                    current_seqno_, more, bytes);
+            }
 
-            WatchdogCallback cb(use_ssl_, socket, ssl_stream);
-            SocketWatchdog watchdog(&cb);
-            while (true)
+            if (trx != 0)
             {
-                watchdog.start();
-                TrxHandle* trx;
-                if (use_ssl_ == true)
+                if (trx->global_seqno() != current_seqno_)
                 {
-                    trx = p.recv_trx(ssl_stream);
+                    log_error << "unexpected trx seqno: " << trx->global_seqno()
+                              << " expected: " << current_seqno_;
+                    streams[0]->discard(trx);
+                    ec = EINVAL;
+                    goto err;
                 }
-                else
+
+                /* write set was received into gcache buffer */
+                if (trx->action() != 0)
                 {
-                    trx = p.recv_trx(socket);
+                    gcache_.seqno_assign(trx->action(), trx->global_seqno(),
+                                         trx->depends_seqno());
                 }
-                watchdog.stop();
-                if (trx != 0)
-                {
-                    if (trx->global_seqno() != current_seqno_)
-                    {
-                        log_error << "unexpected trx seqno: " << trx->global_seqno()
-                                  << " expected: " << current_seqno_;
-                        ec = EINVAL;
-                        goto err;
-                    }
-                    ++current_seqno_;
 
-                    progress.update(1);
-                }
-                gu::Lock lock(mutex_);
-                assert(ready_ || interrupted_);
-                while (consumers_.empty())
+                ++current_seqno_;
+
+                progress.update(1, bytes);
+
+                batch.push_back(std::make_pair(trx, bytes));
+
+                if (more && batch.size() < RECV_BATCH_SIZE)
                 {
-                    if (interrupted_)
-                    {
-                        goto Intrrupted;
-                    }
-                    lock.wait(cond_);
+                    continue;
                 }
-                Consumer* cons(consumers_.top());
-                consumers_.pop();
-                cons->trx(trx);
-                cons->cond().signal();
-                if (trx == 0)
+            }
+            gu::Lock lock(mutex_);
+            assert(ready_ || interrupted_);
+            while (queue_.size() >= RECV_QUEUE_MAX_TRX ||
+                   queue_bytes_ >= RECV_QUEUE_MAX_SIZE)
+            {
+                if (interrupted_)
                 {
-                    log_debug << "eof received, closing socket";
-                    break;
+                    goto Intrrupted;
                 }
+                lock.wait(cond_);
+            }
+            for (queue_t::iterator i(batch.begin()); i != batch.end(); ++i)
+            {
+                queue_.push_back(*i);
+                queue_bytes_ += i->second;
+            }
+            if (batch.size() > 1)
+            {
+                recv_cond_.broadcast();
+            }
+            else
+            {
+                recv_cond_.signal();
+            }
+            batch.clear();
+            if (trx == 0)
+            {
+                log_debug << "eof received, closing socket";
+                break;
             }
         }
 
@@ -539,16 +1024,13 @@ void galera::ist::Receiver::run()
 
 Intrrupted:
 err:
-    gu::Lock lock(mutex_);
-    if (use_ssl_ == true)
+    for (size_t i(0); i < streams.size(); ++i)
     {
-        ssl_stream.lowest_layer().close();
-        // ssl_stream.shutdown();
-    }
-    else
-    {
-        socket.close();
+        delete streams[i];
     }
+    acceptor_.close();
+
+    gu::Lock lock(mutex_);
 
     running_ = false;
     if (ec != EINTR && current_seqno_ - 1 < last_seqno_)
@@ -561,11 +1043,13 @@ err:
     {
         error_code_ = ec;
     }
-    while (consumers_.empty() == false)
+    /* write sets received before the error are still good to apply */
+    for (queue_t::iterator i(batch.begin()); i != batch.end(); ++i)
     {
-        consumers_.top()->cond().signal();
-        consumers_.pop();
+        queue_.push_back(*i);
+        queue_bytes_ += i->second;
     }
+    recv_cond_.broadcast();
 }
 
 
@@ -578,28 +1062,29 @@ void galera::ist::Receiver::ready()
 
 int galera::ist::Receiver::recv(TrxHandle** trx)
 {
-    Consumer cons;
     gu::Lock lock(mutex_);
-    if (running_ == false)
+    while (queue_.empty())
     {
-        if (error_code_ != 0)
+        if (running_ == false)
         {
-            gu_throw_error(error_code_) << "IST receiver reported error";
-        }
-        return EINTR;
-    }
-    consumers_.push(&cons);
-    cond_.signal();
-    lock.wait(cons.cond());
-    if (cons.trx() == 0)
-    {
-        if (error_code_ != 0)
-        {
-            gu_throw_error(error_code_) << "IST receiver reported error";
+            if (error_code_ != 0)
+            {
+                gu_throw_error(error_code_) << "IST receiver reported error";
+            }
+            return EINTR;
         }
-        return EINTR;
+        lock.wait(recv_cond_);
     }
-    *trx = cons.trx();
+
+    bool const was_full(queue_.size() >= RECV_QUEUE_MAX_TRX ||
+                        queue_bytes_ >= RECV_QUEUE_MAX_SIZE);
+
+    *trx = queue_.front().first;
+    queue_bytes_ -= queue_.front().second;
+    queue_.pop_front();
+
+    if (was_full) cond_.signal();
+
     return 0;
 }
 
@@ -635,11 +1120,19 @@ wsrep_seqno_t galera::ist::Receiver::finished()
 
         running_ = false;
 
-        while (consumers_.empty() == false)
+        /* nobody is going to apply write sets left over in the queue,
+         * report only those that were handed to appliers */
+        if (queue_.empty() == false)
+        {
+            current_seqno_ = queue_.front().first->global_seqno();
+        }
+        while (queue_.empty() == false)
         {
-            consumers_.top()->cond().signal();
-            consumers_.pop();
+            queue_.front().first->unref();
+            queue_.pop_front();
         }
+        queue_bytes_ = 0;
+        recv_cond_.broadcast();
 
         recv_addr_ = "";
     }
@@ -713,8 +1206,12 @@ galera::ist::Sender::Sender(const gu::Config&  conf,
     ssl_stream_(0),
     conf_      (conf),
     gcache_    (gcache),
+    peer_      (peer),
     version_   (version),
-    use_ssl_   (false)
+    use_ssl_   (false),
+    owns_seqno_lock_(true),
+    streams_mutex_(),
+    streams_   ()
 {
     gu::URI uri(peer);
     try
@@ -765,9 +1262,52 @@ galera::ist::Sender::~Sender()
     {
         socket_.close();
     }
-    gcache_.seqno_unlock();
+    if (owns_seqno_lock_) gcache_.seqno_unlock();
 }
 
+
+namespace
+{
+    struct SendStreamArgs
+    {
+        galera::ist::Sender* sender;
+        wsrep_seqno_t        first;
+        wsrep_seqno_t        last;
+        int                  n;
+        int                  n_streams;
+        gu_thread_t          thread;
+        int                  error;
+        bool                 started;
+    };
+}
+
+
+extern "C" void* run_send_stream(void* arg)
+{
+    SendStreamArgs* const args(static_cast<SendStreamArgs*>(arg));
+
+    try
+    {
+        args->sender->send_stream(args->first, args->last,
+                                  args->n, args->n_streams);
+    }
+    catch (gu::Exception& e)
+    {
+        log_error << "IST sender stream " << args->n << " failed: "
+                  << e.what();
+        args->error = e.get_errno() ? e.get_errno() : EPROTO;
+    }
+    catch (std::exception& e)
+    {
+        log_error << "IST sender stream " << args->n << " failed: "
+                  << e.what();
+        args->error = EPROTO;
+    }
+
+    return 0;
+}
+
+
 void galera::ist::Sender::send(wsrep_seqno_t first, wsrep_seqno_t last)
 {
     if (first > last)
@@ -775,23 +1315,49 @@ void galera::ist::Sender::send(wsrep_seqno_t first, wsrep_seqno_t last)
         gu_throw_error(EINVAL) << "sender send first greater than last: "
                                << first << " > " << last ;
     }
+
+    std::vector<SendStreamArgs> streams;
+    int         err(0);
+    std::string what;
+
     try
     {
         TrxHandle::SlavePool unused(1, 0, "");
         Proto p(unused, version_,
                 conf_.get(CONF_KEEP_KEYS, CONF_KEEP_KEYS_DEFAULT));
         int32_t ctrl;
+        uint8_t flags;
+
+        if (use_ssl_ == true)
+        {
+            flags = p.recv_handshake(*ssl_stream_);
+        }
+        else
+        {
+            flags = p.recv_handshake(socket_);
+        }
+
+        /* split the range over several connections only if the receiver
+         * supports it and there is more than a chunk of seqnos to send */
+        int n_streams(1);
+        if (flags & Handshake::F_MULTI_STREAM)
+        {
+            n_streams = conf_.get(CONF_SEND_STREAMS, CONF_SEND_STREAMS_DEFAULT);
+            n_streams = std::max(1, std::min(n_streams, SEND_STREAMS_MAX));
+            n_streams = std::min<wsrep_seqno_t>(n_streams,
+                                                (last - first)/STREAM_CHUNK+1);
+        }
+
+        uint8_t const rflags(response_flags(conf_, flags));
 
         if (use_ssl_ == true)
         {
-            p.recv_handshake(*ssl_stream_);
-            p.send_handshake_response(*ssl_stream_);
+            p.send_handshake_response(*ssl_stream_, n_streams, rflags);
             ctrl = p.recv_ctrl(*ssl_stream_);
         }
         else
         {
-            p.recv_handshake(socket_);
-            p.send_handshake_response(socket_);
+            p.send_handshake_response(socket_, n_streams, rflags);
             ctrl = p.recv_ctrl(socket_);
         }
         if (ctrl < 0)
@@ -800,71 +1366,147 @@ void galera::ist::Sender::send(wsrep_seqno_t first, wsrep_seqno_t last)
                 << "ist send failed, peer reported error: " << ctrl;
         }
 
-        std::vector<gcache::GCache::Buffer> buf_vec(
-            std::min(static_cast<size_t>(last - first + 1),
-                     static_cast<size_t>(1024)));
-        ssize_t n_read;
-        while ((n_read = gcache_.seqno_get_buffers(buf_vec, first)) > 0)
+        if (rflags & Handshake::F_COMPRESS)
         {
-            GU_DBUG_SYNC_WAIT("ist_sender_send_after_get_buffers")
-            //log_info << "read " << first << " + " << n_read << " from gcache";
-            for (wsrep_seqno_t i(0); i < n_read; ++i)
+            log_info << "IST sender using compression";
+            p.use_compression(COMPRESSION_LEVEL);
+        }
+
+        if (n_streams > 1)
+        {
+            log_info << "IST sender using " << n_streams << " connections";
+
+            SendStreamArgs const init = { 0, first, last, 0, n_streams,
+                                          gu_thread_t(), 0, false };
+            streams.resize(n_streams - 1, init);
+
+            for (size_t i(0); i < streams.size(); ++i)
             {
-                // log_info << "sending " << buf_vec[i].seqno_g();
-                if (use_ssl_ == true)
-                {
-                    p.send_trx(*ssl_stream_, buf_vec[i]);
-                }
-                else
+                Sender* const s(new Sender(conf_, gcache_, peer_, version_));
+                s->owns_seqno_lock_ = false;
                 {
-                    p.send_trx(socket_, buf_vec[i]);
+                    gu::Lock lock(streams_mutex_);
+                    streams_.push_back(s);
                 }
 
-                if (buf_vec[i].seqno_g() == last)
+                streams[i].sender = s;
+                streams[i].n      = i + 1;
+
+                int const ret(gu_thread_create(&streams[i].thread, 0,
+                                               &run_send_stream, &streams[i]));
+                if (ret != 0)
                 {
-                    if (use_ssl_ == true)
-                    {
-                        p.send_ctrl(*ssl_stream_, Ctrl::C_EOF);
-                    }
-                    else
-                    {
-                        p.send_ctrl(socket_, Ctrl::C_EOF);
-                    }
-                    // wait until receiver closes the connection
-                    try
-                    {
-                        gu::byte_t b;
-                        size_t n;
-                        if (use_ssl_ == true)
-                        {
-                            n = asio::read(*ssl_stream_, asio::buffer(&b, 1));
-                        }
-                        else
-                        {
-                            n = asio::read(socket_, asio::buffer(&b, 1));
-                        }
-                        if (n > 0)
-                        {
-                            log_warn << "received " << n
-                                     << " bytes, expected none";
-                        }
-                    }
-                    catch (asio::system_error& e)
-                    { }
-                    return;
+                    gu_throw_error(ret) << "Unable to create IST stream thread";
                 }
+                streams[i].started = true;
             }
-            first += n_read;
-            // resize buf_vec to avoid scanning gcache past last
-            size_t next_size(std::min(static_cast<size_t>(last - first + 1),
-                                      static_cast<size_t>(1024)));
+        }
+
+        if (use_ssl_ == true)
+        {
+            send_range(*ssl_stream_, p, first, last, 0, n_streams);
+        }
+        else
+        {
+            send_range(socket_, p, first, last, 0, n_streams);
+        }
+    }
+    catch (asio::system_error& e)
+    {
+        std::ostringstream os;
+        os << e.code() << "', asio error '" << e.what() << "'";
+        err  = e.code().value();
+        what = os.str();
+    }
+    catch (gu::Exception& e)
+    {
+        err  = e.get_errno() ? e.get_errno() : EPROTO;
+        what = e.what();
+    }
+
+    /* the other streams are useless if this one failed */
+    if (err != 0)
+    {
+        gu::Lock lock(streams_mutex_);
+        for (size_t i(0); i < streams_.size(); ++i)
+        {
+            streams_[i]->cancel();
+        }
+    }
 
-            if (buf_vec.size() != next_size)
+    for (size_t i(0); i < streams.size(); ++i)
+    {
+        if (streams[i].started)
+        {
+            gu_thread_join(streams[i].thread, 0);
+            if (0 == err && streams[i].error != 0)
             {
-                buf_vec.resize(next_size);
+                err  = streams[i].error;
+                what = "stream failed";
             }
         }
     }
+
+    {
+        gu::Lock lock(streams_mutex_);
+        for (size_t i(0); i < streams_.size(); ++i)
+        {
+            delete streams_[i];
+        }
+        streams_.clear();
+    }
+
+    if (err != 0)
+    {
+        gu_throw_error(err) << "ist send failed: " << what;
+    }
+}
+
+
+void galera::ist::Sender::send_stream(wsrep_seqno_t const first,
+                                      wsrep_seqno_t const last,
+                                      int const n, int const n_streams)
+{
+    try
+    {
+        TrxHandle::SlavePool unused(1, 0, "");
+        Proto p(unused, version_,
+                conf_.get(CONF_KEEP_KEYS, CONF_KEEP_KEYS_DEFAULT));
+        int32_t ctrl;
+        uint8_t rflags;
+
+        if (use_ssl_ == true)
+        {
+            rflags = response_flags(conf_, p.recv_handshake(*ssl_stream_));
+            p.send_handshake_response(*ssl_stream_, n_streams, rflags);
+            ctrl = p.recv_ctrl(*ssl_stream_);
+        }
+        else
+        {
+            rflags = response_flags(conf_, p.recv_handshake(socket_));
+            p.send_handshake_response(socket_, n_streams, rflags);
+            ctrl = p.recv_ctrl(socket_);
+        }
+        if (ctrl < 0)
+        {
+            gu_throw_error(EPROTO)
+                << "ist send failed, peer reported error: " << ctrl;
+        }
+
+        if (rflags & Handshake::F_COMPRESS)
+        {
+            p.use_compression(COMPRESSION_LEVEL);
+        }
+
+        if (use_ssl_ == true)
+        {
+            send_range(*ssl_stream_, p, first, last, n, n_streams);
+        }
+        else
+        {
+            send_range(socket_, p, first, last, n, n_streams);
+        }
+    }
     catch (asio::system_error& e)
     {
         gu_throw_error(e.code().value()) << "ist send failed: " << e.code()
@@ -874,6 +1516,68 @@ void galera::ist::Sender::send(wsrep_seqno_t first, wsrep_seqno_t last)
 }
 
 
+/* Sends every n-th chunk of STREAM_CHUNK seqnos of the range, followed by
+ * EOF. With a single connection the whole range is sent. */
+template <class ST>
+void galera::ist::Sender::send_range(ST&                 socket,
+                                     Proto&              p,
+                                     wsrep_seqno_t const first,
+                                     wsrep_seqno_t const last,
+                                     int const           n,
+                                     int const           n_streams)
+{
+    wsrep_seqno_t const chunk_size(n_streams > 1 ? STREAM_CHUNK :
+                                   last - first + 1);
+
+    size_t const batch_max(conf_.get(CONF_SEND_BATCH,
+                                     CONF_SEND_BATCH_DEFAULT));
+
+    std::vector<gcache::GCache::Buffer> buf_vec;
+
+    for (wsrep_seqno_t chunk(first + n * chunk_size); chunk <= last;
+         chunk += n_streams * chunk_size)
+    {
+        wsrep_seqno_t const chunk_last(std::min(chunk + chunk_size - 1, last));
+
+        for (wsrep_seqno_t seqno(chunk); seqno <= chunk_last; )
+        {
+            // size buf_vec to avoid scanning gcache past chunk_last
+            buf_vec.resize(std::min(static_cast<size_t>(chunk_last - seqno + 1),
+                                    static_cast<size_t>(1024)));
+
+            ssize_t const n_read(gcache_.seqno_get_buffers(buf_vec, seqno));
+
+            if (n_read <= 0) { p.send_batch(socket); return; }
+
+            GU_DBUG_SYNC_WAIT("ist_sender_send_after_get_buffers")
+            for (wsrep_seqno_t i(0); i < n_read; ++i)
+            {
+                p.add_trx(buf_vec[i]);
+
+                // buffers stay valid as long as the range is seqno locked
+                if (p.batch_size() >= batch_max) p.send_batch(socket);
+            }
+
+            seqno += n_read;
+        }
+    }
+
+    p.send_batch(socket);
+    p.send_ctrl(socket, Ctrl::C_EOF);
+
+    // wait until receiver closes the connection
+    try
+    {
+        gu::byte_t b;
+        size_t n_recv(asio::read(socket, asio::buffer(&b, 1)));
+        if (n_recv > 0)
+        {
+            log_warn << "received " << n_recv << " bytes, expected none";
+        }
+    }
+    catch (asio::system_error& e)
+    { }
+}
 
 
 extern "C"
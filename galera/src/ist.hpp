@@ -14,8 +14,9 @@
 #include "gu_monitor.hpp"
 #include "gu_asio.hpp"
 
-#include <stack>
+#include <deque>
 #include <set>
+#include <vector>
 
 namespace gcache
 {
@@ -28,6 +29,8 @@ namespace galera
 
     namespace ist
     {
+        class Proto;
+
         void register_params(gu::Config& conf);
 
         class Receiver
@@ -36,7 +39,8 @@ namespace galera
             static std::string const RECV_ADDR;
             static std::string const RECV_BIND;
 
-            Receiver(gu::Config& conf, TrxHandle::SlavePool&, const char* addr);
+            Receiver(gu::Config& conf, gcache::GCache&, TrxHandle::SlavePool&,
+                     const char* addr);
             ~Receiver();
 
             std::string   prepare(wsrep_seqno_t, wsrep_seqno_t, int);
@@ -62,53 +66,24 @@ namespace galera
 #ifdef HAVE_PSI_INTERFACE
             gu::MutexWithPFS                              mutex_;
             gu::CondWithPFS                               cond_;
+            gu::CondWithPFS                               recv_cond_;
 #else
             gu::Mutex                                     mutex_;
             gu::Cond                                      cond_;
+            gu::Cond                                      recv_cond_;
 #endif /* HAVE_PSI_INTERFACE */
 
-            class Consumer
-            {
-            public:
-
-#ifdef HAVE_PSI_INTERFACE
-                Consumer()
-                    :
-                    cond_(WSREP_PFS_INSTR_TAG_IST_CONSUMER_CONDVAR),
-                    trx_(0)
-                { }
-#else
-                Consumer() : cond_(), trx_(0) { }
-#endif
-                ~Consumer() { }
-
-#ifdef HAVE_PSI_INTERFACE
-                gu::CondWithPFS&  cond()        { return cond_; }
-#else
-                gu::Cond&  cond()              { return cond_; }
-#endif /* HAVE_PSI_INTERFACE */
-                void       trx(TrxHandle* trx) { trx_ = trx;   }
-                TrxHandle* trx() const         { return trx_;  }
-
-            private:
-
-                // Non-copyable
-                Consumer(const Consumer&);
-                Consumer& operator=(const Consumer&);
-
-#ifdef HAVE_PSI_INTERFACE
-                gu::CondWithPFS   cond_;
-#else
-                gu::Cond   cond_;
-#endif /* HAVE_PSI_INTERFACE */
-                TrxHandle* trx_;
-            };
+            // received write sets waiting to be applied, in seqno order,
+            // with the number of bytes each took on the wire
+            typedef std::deque<std::pair<TrxHandle*, size_t> > queue_t;
+            queue_t                                       queue_;
+            size_t                                        queue_bytes_;
 
-            std::stack<Consumer*> consumers_;
             wsrep_seqno_t         current_seqno_;
             wsrep_seqno_t         first_seqno_;
             wsrep_seqno_t         last_seqno_;
             gu::Config&           conf_;
+            gcache::GCache&       gcache_;
             TrxHandle::SlavePool& trx_pool_;
             gu_thread_t           thread_;
             int                   error_code_;
@@ -145,6 +120,12 @@ namespace galera
                 {
                     socket_.close();
                 }
+
+                gu::Lock lock(streams_mutex_);
+                for (size_t i(0); i < streams_.size(); ++i)
+                {
+                    streams_[i]->cancel();
+                }
             }
 
 
@@ -158,17 +139,38 @@ namespace galera
                 {
                     socket_.shutdown(asio::socket_base::shutdown_both);
                 }
+
+                gu::Lock lock(streams_mutex_);
+                for (size_t i(0); i < streams_.size(); ++i)
+                {
+                    streams_[i]->terminate();
+                }
             }
+
+            // sends the share of (first, last) range of the n-th out of
+            // n_streams connections, see send()
+            void send_stream(wsrep_seqno_t first, wsrep_seqno_t last,
+                             int n, int n_streams);
+
         private:
 
+            template <class ST>
+            void send_range(ST& socket, Proto& p,
+                            wsrep_seqno_t first, wsrep_seqno_t last,
+                            int n, int n_streams);
+
             asio::io_service                          io_service_;
             asio::ip::tcp::socket                     socket_;
             asio::ssl::context                        ssl_ctx_;
             asio::ssl::stream<asio::ip::tcp::socket>* ssl_stream_;
             const gu::Config&                         conf_;
             gcache::GCache&                           gcache_;
+            std::string const                         peer_;
             int                                       version_;
             bool                                      use_ssl_;
+            bool                                      owns_seqno_lock_;
+            gu::Mutex                                 streams_mutex_;
+            std::vector<Sender*>                      streams_; // extra ones
 
             Sender(const Sender&);
             void operator=(const Sender&);
@@ -13,6 +13,10 @@
 #include "gu_serialize.hpp"
 #include "gu_vector.hpp"
 #include "gu_array.hpp"
+#include "gu_deflate.hpp"
+
+#include <algorithm>
+#include <cstring>
 
 //
 // Message class must have non-virtual destructor until
@@ -195,18 +199,31 @@ namespace galera
         class Handshake : public Message
         {
         public:
-            Handshake(int version = -1)
+            enum
+            {
+                // receiver can accept IST split over several connections
+                F_MULTI_STREAM = 1 << 0,
+                // receiver can decompress IST stream
+                F_COMPRESS     = 1 << 1
+            };
+            Handshake(int version = -1, uint8_t flags = 0)
                 :
-                Message(version, Message::T_HANDSHAKE, 0, 0, 0)
+                Message(version, Message::T_HANDSHAKE, flags, 0, 0)
             { }
         };
 
+        /* ctrl field carries the number of connections the sender is going
+         * to use, 0 from older senders means 1. F_COMPRESS flag tells that
+         * everything the sender sends after the receiver's C_OK is
+         * compressed. */
         class HandshakeResponse : public Message
         {
         public:
-            HandshakeResponse(int version = -1)
+            HandshakeResponse(int version = -1, int8_t streams = 0,
+                              uint8_t flags = 0)
                 :
-                Message(version, Message::T_HANDSHAKE_RESPONSE, 0, 0, 0)
+                Message(version, Message::T_HANDSHAKE_RESPONSE, flags, streams,
+                        0)
             { }
         };
 
@@ -235,22 +252,171 @@ namespace galera
         };
 
 
+        /*
+         * Read-ahead wrapper over a synchronous stream.
+         *
+         * Pulls data from the underlying stream in large chunks so that many
+         * small protocol messages can be parsed out of a single socket read.
+         * Models asio SyncReadStream and can be passed to asio::read() and
+         * Proto::recv_trx() in place of the socket. Reads larger than the
+         * buffer capacity go directly to the underlying stream.
+         * After decompress() the data read from the stream is inflated.
+         */
+        template <class ST>
+        class ReadAheadStream
+        {
+        public:
+
+            ReadAheadStream(ST& stream, size_t capacity)
+                :
+                stream_  (stream),
+                buf_     (capacity),
+                begin_   (0),
+                end_     (0),
+                consumed_(0),
+                inflate_ (0),
+                zbuf_    ()
+            { }
+
+            ~ReadAheadStream() { delete inflate_; }
+
+            /* must be called before anything compressed is read ahead */
+            void decompress()
+            {
+                assert(begin_ == end_);
+                if (0 == inflate_)
+                {
+                    inflate_ = new gu::Inflate();
+                    zbuf_.resize(buf_.size());
+                }
+            }
+
+            template <class MBS>
+            size_t read_some(const MBS& bufs)
+            {
+                asio::error_code ec;
+                size_t const n(read_some(bufs, ec));
+                asio::detail::throw_error(ec, "read_some");
+                return n;
+            }
+
+            template <class MBS>
+            size_t read_some(const MBS& bufs, asio::error_code& ec)
+            {
+                ec = asio::error_code();
+
+                if (begin_ == end_)
+                {
+                    if (inflate_)
+                    {
+                        begin_ = 0;
+                        end_   = inflate(ec);
+                        if (gu_unlikely(0 == end_)) return 0;
+                    }
+                    else if (asio::buffer_size(bufs) >= buf_.size())
+                    {
+                        size_t const n(stream_.read_some(bufs, ec));
+                        consumed_ += n;
+                        return n;
+                    }
+
+                    else
+                    {
+                        begin_ = 0;
+                        end_   = stream_.read_some(asio::buffer(&buf_[0],
+                                                                buf_.size()),
+                                                   ec);
+                        if (gu_unlikely(0 == end_)) return 0;
+                    }
+                }
+
+                size_t const n(asio::buffer_copy(bufs,
+                                                 asio::buffer(&buf_[begin_],
+                                                              end_ - begin_)));
+                begin_    += n;
+                consumed_ += n;
+                return n;
+            }
+
+            /* number of bytes read ahead and not consumed yet */
+            size_t   buffered() const { return end_ - begin_; }
+
+            /* total number of bytes consumed from the stream */
+            uint64_t consumed() const { return consumed_; }
+
+        private:
+
+            /* fills buf_ with decompressed data, reads the stream as needed */
+            size_t inflate(asio::error_code& ec)
+            {
+                for (;;)
+                {
+                    size_t const n(inflate_->output(&buf_[0], buf_.size()));
+                    if (n > 0) return n;
+
+                    size_t const z(stream_.read_some(asio::buffer(&zbuf_[0],
+                                                                  zbuf_.size()),
+                                                     ec));
+                    if (gu_unlikely(0 == z)) return 0;
+
+                    inflate_->input(&zbuf_[0], z);
+                }
+            }
+
+            ST&          stream_;
+            gu::Buffer   buf_;
+            size_t       begin_;
+            size_t       end_;
+            uint64_t     consumed_;
+            gu::Inflate* inflate_;
+            gu::Buffer   zbuf_;
+
+            ReadAheadStream(const ReadAheadStream&);
+            ReadAheadStream& operator=(const ReadAheadStream&);
+        };
+
+
         class Proto
         {
         public:
 
             Proto(TrxHandle::SlavePool& sp, int version, bool keep_keys)
                 :
-                trx_pool_ (sp),
-                raw_sent_ (0),
-                real_sent_(0),
-                version_  (version),
-                keep_keys_(keep_keys)
+                trx_pool_   (sp),
+                gcache_     (0),
+                gcache_from_(0),
+                batch_buf_  (),
+                batch_      (),
+                batch_size_ (0),
+                batch_trxs_ (0),
+                deflate_    (0),
+                raw_sent_   (0),
+                real_sent_  (0),
+                version_    (version),
+                keep_keys_  (keep_keys)
             { }
 
+            /* Makes recv_trx() receive write sets straight into gcache
+             * buffers, trx->action() then points to the buffer. It is up to
+             * the caller to assign seqno to the buffer (in seqno order) or
+             * to free it. Write sets already present in gcache are received
+             * as usual. */
+            void use_gcache(gcache::GCache& gcache)
+            {
+                gcache_      = &gcache;
+                gcache_from_ = gcache.seqno_last() + 1;
+            }
+
+            /* Compresses everything sent by send_batch() and send_ctrl()
+             * from now on. Both ends must agree on that in handshake. */
+            void use_compression(int level)
+            {
+                if (0 == deflate_) deflate_ = new gu::Deflate(level);
+            }
+
             ~Proto()
             {
-                if (raw_sent_ > 0)
+                if (deflate_ != 0 && raw_sent_ > 0)
                 {
                     log_info << "ist proto finished, raw sent: "
                              << raw_sent_
@@ -260,12 +426,14 @@ namespace galera
                              << (raw_sent_ == 0 ? 0. :
                                  static_cast<double>(real_sent_)/raw_sent_);
                 }
+
+                delete deflate_;
             }
 
             template <class ST>
-            void send_handshake(ST& socket)
+            void send_handshake(ST& socket, uint8_t flags = 0)
             {
-                Handshake  hs(version_);
+                Handshake  hs(version_, flags);
                 gu::Buffer buf(hs.serial_size());
                 size_t offset(hs.serialize(&buf[0], buf.size(), 0));
                 size_t n(asio::write(socket, asio::buffer(&buf[0],
@@ -276,8 +444,9 @@ namespace galera
                 }
             }
 
+            /* returns handshake flags */
             template <class ST>
-            void recv_handshake(ST& socket)
+            uint8_t recv_handshake(ST& socket)
             {
                 Message    msg(version_);
                 gu::Buffer buf(msg.serial_size());
@@ -319,12 +488,15 @@ namespace galera
                                            << version_;
                 }
                 // TODO: Figure out protocol versions to use
+
+                return msg.flags();
             }
 
             template <class ST>
-            void send_handshake_response(ST& socket)
+            void send_handshake_response(ST& socket, int8_t streams = 0,
+                                         uint8_t flags = 0)
             {
-                HandshakeResponse hsr(version_);
+                HandshakeResponse hsr(version_, streams, flags);
                 gu::Buffer buf(hsr.serial_size());
                 size_t offset(hsr.serialize(&buf[0], buf.size(), 0));
                 size_t n(asio::write(socket, asio::buffer(&buf[0], buf.size())));
@@ -335,8 +507,10 @@ namespace galera
                 }
             }
 
+            /* returns the number of IST connections announced by sender,
+             * response flags are stored in flags if given */
             template <class ST>
-            void recv_handshake_response(ST& socket)
+            int recv_handshake_response(ST& socket, uint8_t* flags = 0)
             {
                 Message    msg(version_);
                 gu::Buffer buf(msg.serial_size());
@@ -370,6 +544,10 @@ namespace galera
                     gu_throw_error(EINVAL) << "unexpected message type: "
                                            << msg.type();
                 }
+
+                if (flags) *flags = msg.flags();
+
+                return std::max<int>(msg.ctrl(), 1);
             }
 
             template <class ST>
@@ -378,7 +556,7 @@ namespace galera
                 Ctrl       ctrl(version_, code);
                 gu::Buffer buf(ctrl.serial_size());
                 size_t offset(ctrl.serialize(&buf[0], buf.size(), 0));
-                size_t n(asio::write(socket, asio::buffer(&buf[0],buf.size())));
+                size_t n(write(socket, asio::buffer(&buf[0], buf.size())));
                 if (n != offset)
                 {
                     gu_throw_error(EPROTO) << "error sending ctrl message";
@@ -414,41 +592,36 @@ namespace galera
             }
 
 
-            template <class ST>
-            void send_trx(ST&                           socket,
-                          const gcache::GCache::Buffer& buffer)
+            /* Appends write set message to the send batch. Message headers
+             * and payload pieces smaller than BATCH_COPY_MAX are copied into
+             * the batch buffer so that many small write sets go out as a
+             * few large buffers, bigger payloads are referenced in place
+             * and must stay valid until send_batch(). */
+            void add_trx(const gcache::GCache::Buffer& buffer)
             {
                 const bool rolled_back(buffer.seqno_d() == -1);
 
                 galera::WriteSetIn ws;
-                gu::array<asio::const_buffer, 3>::type cbs;
-                size_t      payload_size; /* size of the 2nd cbs buffer */
-                size_t      sent;
+                WriteSetIn::GatherVector out;
+                size_t      payload_size; /* total size of out buffers */
 
                 if (gu_unlikely(rolled_back))
                 {
                     payload_size = 0;
                 }
+                else if (keep_keys_ || version_ < WS_NG_VERSION)
+                {
+                    payload_size = buffer.size();
+                    gu::Buf const tmp = { buffer.ptr(), buffer.size() };
+                    out->push_back(tmp);
+                }
                 else
                 {
-                    if (keep_keys_ || version_ < WS_NG_VERSION)
-                    {
-                        payload_size = buffer.size();
-                        const void* const ptr(buffer.ptr());
-                        cbs[1] = asio::const_buffer(ptr, payload_size);
-                        cbs[2] = asio::const_buffer(ptr, 0);
-                    }
-                    else
-                    {
-                        gu::Buf tmp = { buffer.ptr(), buffer.size() };
-                        ws.read_buf (tmp, 0);
-
-                        WriteSetIn::GatherVector out;
-                        payload_size = ws.gather (out, false, false);
-                        assert (2 == out->size());
-                        cbs[1] = asio::const_buffer(out[0].ptr, out[0].size);
-                        cbs[2] = asio::const_buffer(out[1].ptr, out[1].size);
-                    }
+                    gu::Buf tmp = { buffer.ptr(), buffer.size() };
+                    ws.read_buf (tmp, 0);
+
+                    payload_size = ws.gather (out, false, false);
+                    assert (out->size() >= 2);
                 }
 
                 size_t const trx_meta_size(
@@ -458,25 +631,87 @@ namespace galera
 
                 Trx trx_msg(version_, trx_meta_size + payload_size);
 
-                gu::Buffer buf(trx_msg.serial_size() + trx_meta_size);
-                size_t  offset(trx_msg.serialize(&buf[0], buf.size(), 0));
+                size_t const hdr_size(trx_msg.serial_size() + trx_meta_size);
+                size_t offset(batch_buf_.size());
+                batch_buf_.resize(offset + hdr_size);
 
-                offset = gu::serialize8(buffer.seqno_g(),
-                                        &buf[0], buf.size(), offset);
-                offset = gu::serialize8(buffer.seqno_d(),
-                                        &buf[0], buf.size(), offset);
-                cbs[0] = asio::const_buffer(&buf[0], buf.size());
+                offset = trx_msg.serialize(&batch_buf_[0], batch_buf_.size(),
+                                           offset);
+                offset = gu::serialize8(buffer.seqno_g(), &batch_buf_[0],
+                                        batch_buf_.size(), offset);
+                offset = gu::serialize8(buffer.seqno_d(), &batch_buf_[0],
+                                        batch_buf_.size(), offset);
+                batch_append(NULL, hdr_size);
 
-                if (gu_likely(payload_size))
+                for (size_t i(0); i < out->size(); ++i)
                 {
-                    sent = asio::write(socket, cbs);
+                    const gu::byte_t* const ptr
+                        (static_cast<const gu::byte_t*>(out[i].ptr));
+                    size_t const size(out[i].size);
+
+                    /* this always copies WriteSetIn header which lives in ws */
+                    if (size < BATCH_COPY_MAX)
+                    {
+                        size_t const off(batch_buf_.size());
+                        batch_buf_.resize(off + size);
+                        ::memcpy(&batch_buf_[off], ptr, size);
+                        batch_append(NULL, size);
+                    }
+                    else
+                    {
+                        batch_append(ptr, size);
+                    }
                 }
-                else
+
+                ++batch_trxs_;
+            }
+
+            /* number of bytes and write sets in the send batch */
+            size_t batch_size() const { return batch_size_; }
+            size_t batch_trxs() const { return batch_trxs_; }
+
+            /* Sends the whole batch with a single gathered write. */
+            template <class ST>
+            void send_batch(ST& socket)
+            {
+                if (0 == batch_size_) return;
+
+                std::vector<asio::const_buffer> cbs;
+                cbs.reserve(batch_.size());
+
+                size_t local(0);
+                for (size_t i(0); i < batch_.size(); ++i)
                 {
-                    sent = asio::write(socket, asio::buffer(cbs[0]));
+                    if (batch_[i].ptr)
+                    {
+                        cbs.push_back(asio::const_buffer(batch_[i].ptr,
+                                                         batch_[i].size));
+                    }
+                    else
+                    {
+                        cbs.push_back(asio::const_buffer(&batch_buf_[local],
+                                                         batch_[i].size));
+                        local += batch_[i].size;
+                    }
                 }
 
-                log_debug << "sent " << sent << " bytes";
+                size_t const sent(write(socket, cbs));
+
+                log_debug << "sent " << sent << " bytes in " << batch_trxs_
+                          << " write sets";
+
+                batch_.clear();
+                batch_buf_.clear();
+                batch_size_ = 0;
+                batch_trxs_ = 0;
+            }
+
+            template <class ST>
+            void send_trx(ST&                           socket,
+                          const gcache::GCache::Buffer& buffer)
+            {
+                add_trx(buffer);
+                send_batch(socket);
             }
 
 
@@ -523,6 +758,9 @@ namespace galera
 
                     galera::TrxHandle* trx(galera::TrxHandle::New(trx_pool_));
 
+                    bool const cache(gcache_ != 0 && seqno_g >= gcache_from_);
+                    gu::byte_t* action(0);
+
                     if (seqno_d == WSREP_SEQNO_UNDEFINED)
                     {
                         if (offset != msg.len())
@@ -531,6 +769,39 @@ namespace galera
                                 << "message size " << msg.len()
                                 << " does not match expected size " << offset;
                         }
+
+                        // rolled back write set has no body, but must
+                        // occupy its seqno to keep gcache history continuous
+                        if (cache)
+                        {
+                            action = static_cast<gu::byte_t*>
+                                (gcache_->malloc(1));
+                        }
+                    }
+                    else if (cache &&
+                             (action = static_cast<gu::byte_t*>
+                              (gcache_->malloc(msg.len() - offset))) != 0)
+                    {
+                        size_t const wsize(msg.len() - offset);
+
+                        try
+                        {
+                            n = asio::read(socket, asio::buffer(action, wsize));
+
+                            if (gu_unlikely(n != wsize))
+                            {
+                                gu_throw_error(EPROTO)
+                                    << "error reading write set data";
+                            }
+
+                            trx->unserialize(action, wsize, 0);
+                        }
+                        catch (...)
+                        {
+                            gcache_->free(action);
+                            trx->unref();
+                            throw;
+                        }
                     }
                     else
                     {
@@ -553,12 +824,12 @@ namespace galera
                     if (seqno_d == WSREP_SEQNO_UNDEFINED ||
                         trx->version() < 3)
                     {
-                        trx->set_received(0, -1, seqno_g);
+                        trx->set_received(action, -1, seqno_g);
                         trx->set_depends_seqno(seqno_d);
                     }
                     else
                     {
-                        trx->set_received_from_ws();
+                        trx->set_received_from_ws(action);
                         assert(trx->global_seqno() == seqno_g);
                         assert(trx->depends_seqno() >= seqno_d);
                     }
@@ -592,9 +863,79 @@ namespace galera
                 return 0; // keep compiler happy
             }
 
+            /* bytes of messages sent before and after compression */
+            uint64_t raw_sent()  const { return raw_sent_;  }
+            uint64_t real_sent() const { return real_sent_; }
+
         private:
 
+            /* Writes buffers to socket compressing them if requested.
+             * @return the number of uncompressed bytes written */
+            template <class ST, class CBS>
+            size_t write(ST& socket, const CBS& cbs)
+            {
+                size_t const size(asio::buffer_size(cbs));
+
+                raw_sent_ += size;
+
+                if (0 == deflate_)
+                {
+                    size_t const n(asio::write(socket, cbs));
+                    real_sent_ += n;
+                    return n;
+                }
+
+                for (typename CBS::const_iterator i(cbs.begin());
+                     i != cbs.end(); ++i)
+                {
+                    asio::const_buffer const cb(*i);
+                    deflate_->append(asio::buffer_cast<const void*>(cb),
+                                     asio::buffer_size(cb));
+                }
+                deflate_->flush();
+
+                real_sent_ += asio::write(socket,
+                                          asio::buffer(deflate_->data(),
+                                                       deflate_->size()));
+                deflate_->clear();
+
+                return size;
+            }
+
+            /* payload pieces smaller than that are copied to batch buffer */
+            static size_t const BATCH_COPY_MAX = 4096;
+
+            struct BatchBuf
+            {
+                const gu::byte_t* ptr; /* NULL if in batch buffer */
+                size_t            size;
+            };
+
+            void batch_append(const gu::byte_t* const ptr, size_t const size)
+            {
+                batch_size_ += size;
+
+                /* coalesce consecutive pieces of batch buffer */
+                if (!ptr && !batch_.empty() && !batch_.back().ptr)
+                {
+                    batch_.back().size += size;
+                }
+                else if (size > 0)
+                {
+                    BatchBuf const bb = { ptr, size };
+                    batch_.push_back(bb);
+                }
+            }
+
             TrxHandle::SlavePool& trx_pool_;
+            gcache::GCache*       gcache_;
+            wsrep_seqno_t         gcache_from_;
+
+            gu::Buffer            batch_buf_;
+            std::vector<BatchBuf> batch_;
+            size_t                batch_size_;
+            size_t                batch_trxs_;
+            gu::Deflate*          deflate_;
 
             uint64_t raw_sent_;
             uint64_t real_sent_;
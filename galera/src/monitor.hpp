@@ -1,5 +1,5 @@
 //
-// Copyright (C) 2010-2013 Codership Oy
+// Copyright (C) 2010-2020 Codership Oy
 //
 
 #ifndef GALERA_MONITOR_HPP
@@ -7,13 +7,36 @@
 
 #include "trx_handle.hpp"
 #include <gu_lock.hpp> // for gu::Mutex and gu::Cond
+#include <gu_atomic.hpp>
 #include <gu_limits.h>
 #include <gu_dbug.h>
 
 #include <vector>
+#include <algorithm>
 
 namespace galera
 {
+    /*
+     * Window positions and slot states are atomic. An entrant whose
+     * condition is already satisfied claims its slot with CAS and a leaver
+     * that shrinks the window (last_left_ + 1 == seqno) advances last_left_
+     * without taking the mutex. Waiting, out of order leaving, cancellation
+     * and draining are done under the mutex as before.
+     *
+     * A lock-free leaver takes the mutex to sweep the window and wake up
+     * waiters only if somebody has entered past it (last_entered_) or is
+     * waiting for last_left_ to advance (waiters_). Waiters publish
+     * themselves before checking last_left_ and leavers check after
+     * advancing it, so with sequentially consistent atomics at least one
+     * side sees the other.
+     *
+     * Process slots are allocated in chunks. The window starts with one
+     * chunk and is doubled under mutex when an object does not fit into
+     * it, up to max_size(). Resizing remaps slots, so it first waits with
+     * the mutex released for lock-free paths in progress (fast_) to
+     * complete, and the new ones fall back to mutex while it is in
+     * progress (resizing_).
+     */
     template <class C>
     class Monitor
     {
@@ -21,7 +44,9 @@ namespace galera
 
         struct Process
         {
-            Process() : obj_(0), cond_(), wait_cond_(), state_(S_IDLE) { }
+            Process() : obj_(0), cond_(), wait_cond_(), state_(S_IDLE),
+                        left_(-1), deps_seqno_(-1), deps_head_(-1),
+                        deps_next_(-1), blocked_on_(-1) { }
 
             const C* obj_;
             gu::Cond cond_;
@@ -33,7 +58,17 @@ namespace galera
                 S_CANCELED,
                 S_APPLYING, // Applying
                 S_FINISHED  // Finished
-            } state_;
+            };
+            gu::Atomic<int> state_;
+            // last seqno that left the slot lock-free, see interrupt()
+            wsrep_seqno_t   left_;
+            // Out of order wake-ups, under mutex: waiters blocked by the
+            // object of deps_seqno_ form a list linked by deps_next_,
+            // blocked_on_ is the object the waiter is listed at.
+            wsrep_seqno_t   deps_seqno_;
+            wsrep_seqno_t   deps_head_;
+            wsrep_seqno_t   deps_next_;
+            wsrep_seqno_t   blocked_on_;
 
         private:
 
@@ -42,8 +77,50 @@ namespace galera
             void operator=(const Process&);
         };
 
-        static const ssize_t process_size_ = (1ULL << 16);
-        static const size_t  process_mask_ = process_size_ - 1;
+        static const ssize_t chunk_size_ = (1ULL << 10);
+
+        // lock-free path guard, see resize()
+        class FastPath
+        {
+        public:
+            FastPath(Monitor& mon) : mon_(mon)
+            {
+                ++mon_.fast_;
+                ok_ = (mon_.resizing_() == 0);
+            }
+            ~FastPath()
+            {
+                --mon_.fast_;
+
+                if (gu_unlikely(mon_.resizing_() != 0))
+                {
+                    // resize() waits for us with mutex released
+                    gu::Lock lock(mon_.mutex_);
+                    mon_.cond_.broadcast();
+                }
+            }
+            bool ok() const { return ok_; }
+        private:
+            FastPath(const FastPath&);
+            void operator=(const FastPath&);
+            Monitor& mon_;
+            bool     ok_;
+        };
+
+        // registers a thread which may wait for last_left_ to advance
+        class Waiter
+        {
+        public:
+            Waiter(gu::Atomic<long>& waiters) : waiters_(waiters)
+            {
+                ++waiters_;
+            }
+            ~Waiter() { --waiters_; }
+        private:
+            Waiter(const Waiter&);
+            void operator=(const Waiter&);
+            gu::Atomic<long>& waiters_;
+        };
 
     public:
 
@@ -61,22 +138,28 @@ namespace galera
             last_entered_(-1),
             last_left_(-1),
             drain_seqno_(GU_LLONG_MAX),
-            process_(new Process[process_size_]),
+            process_(1, new Process[chunk_size_]),
+            size_(chunk_size_),
+            max_size_(DEFAULT_MAX_SIZE),
+            fast_(0),
+            resizing_(0),
+            waiters_(0),
             entered_(0),
             oooe_(0),
             oool_(0),
             win_size_(0),
-            waits_(0)
+            waits_(0),
+            wake_up_ooo_(false)
         { }
 
         ~Monitor()
         {
-            delete[] process_;
-            if (entered_ > 0)
+            for (size_t i(0); i < process_.size(); ++i) delete[] process_[i];
+            if (entered_() > 0)
             {
-                log_debug << "mon: entered " << entered_
-                         << " oooe fraction " << double(oooe_)/entered_
-                         << " oool fraction " << double(oool_)/entered_;
+                log_debug << "mon: entered " << entered_()
+                         << " oooe fraction " << double(oooe_())/entered_()
+                         << " oool fraction " << double(oool_())/entered_();
             }
             else
             {
@@ -87,10 +170,11 @@ namespace galera
         void set_initial_position(wsrep_seqno_t seqno)
         {
             gu::Lock lock(mutex_);
-            if (last_entered_ == -1 || seqno == -1)
+            if (last_entered_() == -1 || seqno == -1)
             {
                 // first call or reset
-                last_entered_ = last_left_ = seqno;
+                last_entered_ = seqno;
+                last_left_    = seqno;
             }
             else
             {
@@ -101,71 +185,84 @@ namespace galera
             }
             if (seqno != -1)
             {
-                const size_t idx(indexof(seqno));
-                process_[idx].wait_cond_.broadcast();
+                slot(seqno).wait_cond_.broadcast();
             }
         }
 
         void enter(C& obj)
         {
             const wsrep_seqno_t obj_seqno(obj.seqno());
-            const size_t        idx(indexof(obj_seqno));
+
+#ifndef GU_DBUG_ON // debug sync points are in the locked path
+            if (gu_likely(enter_fast(obj))) return;
+#endif // GU_DBUG_ON
+
             gu::Lock            lock(mutex_);
 
-            assert(obj_seqno > last_left_);
+            assert(obj_seqno > last_left_());
 
             pre_enter(obj, lock);
 
-            if (gu_likely(process_[idx].state_ != Process::S_CANCELED))
+            // slot must be looked up again after every wait: the window
+            // may have been resized
+            if (gu_likely(slot(obj_seqno).state_() != Process::S_CANCELED))
             {
-                assert(process_[idx].state_ == Process::S_IDLE);
+                assert(slot(obj_seqno).state_() == Process::S_IDLE);
 
-                process_[idx].state_ = Process::S_WAITING;
-                process_[idx].obj_   = &obj;
+                slot(obj_seqno).state_ = Process::S_WAITING;
+                slot(obj_seqno).obj_   = &obj;
 
 #ifdef GU_DBUG_ON
                 obj.debug_sync(mutex_);
 #endif // GU_DBUG_ON
+                // no need to register as a waiter: pre_enter() has advanced
+                // last_entered_ past any lock-free leaver
                 while (may_enter(obj) == false &&
-                       process_[idx].state_ == Process::S_WAITING)
+                       slot(obj_seqno).state_() == Process::S_WAITING)
                 {
+                    if (wake_up_ooo_ &&
+                        slot(obj_seqno).blocked_on_ <= last_left_())
+                    {
+                        add_dependent(obj_seqno);
+                    }
+
                     obj.unlock();
                     ++waits_;
-                    lock.wait(process_[idx].cond_);
+                    lock.wait(slot(obj_seqno).cond_);
                     obj.lock();
                 }
 
-                if (process_[idx].state_ != Process::S_CANCELED)
+                Process& a(slot(obj_seqno));
+
+                if (a.state_() != Process::S_CANCELED)
                 {
-                    assert(process_[idx].state_ == Process::S_WAITING ||
-                           process_[idx].state_ == Process::S_APPLYING);
+                    assert(a.state_() == Process::S_WAITING ||
+                           a.state_() == Process::S_APPLYING);
 
-                    process_[idx].state_ = Process::S_APPLYING;
+                    a.state_ = Process::S_APPLYING;
 
-                    ++entered_;
-                    oooe_     += ((last_left_ + 1) < obj_seqno);
-                    win_size_ += (last_entered_ - last_left_);
+                    const wsrep_seqno_t last_left(last_left_());
+                    update_stats(obj_seqno, last_entered_(), last_left);
                     return;
                 }
             }
 
-            assert(process_[idx].state_ == Process::S_CANCELED);
-            process_[idx].state_ = Process::S_IDLE;
+            assert(slot(obj_seqno).state_() == Process::S_CANCELED);
+            slot(obj_seqno).state_ = Process::S_IDLE;
 
             gu_throw_error(EINTR);
         }
 
         void leave(const C& obj)
         {
-#ifndef NDEBUG
-            size_t   idx(indexof(obj.seqno()));
-#endif /* NDEBUG */
+            if (gu_likely(leave_fast(obj))) return;
+
             gu::Lock lock(mutex_);
 
-            assert(process_[idx].state_ == Process::S_APPLYING ||
-                   process_[idx].state_ == Process::S_CANCELED);
+            assert(slot(obj.seqno()).state_() == Process::S_APPLYING ||
+                   slot(obj.seqno()).state_() == Process::S_CANCELED);
 
-            assert(process_[indexof(last_left_)].state_ == Process::S_IDLE);
+            assert(slot(last_left_()).state_() == Process::S_IDLE);
 
             post_leave(obj, lock);
         }
@@ -173,89 +270,120 @@ namespace galera
         void self_cancel(C& obj)
         {
             wsrep_seqno_t const obj_seqno(obj.seqno());
-            size_t   idx(indexof(obj_seqno));
             gu::Lock lock(mutex_);
 
-            assert(obj_seqno > last_left_);
+            assert(obj_seqno > last_left_());
+
+            Waiter waiter(waiters_);
 
-            while (obj_seqno - last_left_ >= process_size_
+            while (reserve(obj_seqno, lock) == false
                   || GU_DBUG_EVALUATE_IF ("simulate_low_process_size", 1, 0))
                 // TODO: exit on error
             {
                 log_warn << "Trying to self-cancel seqno out of process "
                          << "space: obj_seqno - last_left_ = " << obj_seqno
-                         << " - " << last_left_ << " = "
-                         << (obj_seqno - last_left_)
-                         << ", process_size_: "  << process_size_
+                         << " - " << last_left_() << " = "
+                         << (obj_seqno - last_left_())
+                         << ", max process size: "  << max_size_()
                          << ". Deadlock is very likely.";
                 obj.unlock();
                 lock.wait(cond_);
                 obj.lock();
             }
 
-            assert(process_[idx].state_ == Process::S_IDLE ||
-                   process_[idx].state_ == Process::S_CANCELED);
+            assert(slot(obj_seqno).state_() == Process::S_IDLE ||
+                   slot(obj_seqno).state_() == Process::S_CANCELED);
 
-            if (obj_seqno > last_entered_) last_entered_ = obj_seqno;
+            update_last_entered(obj_seqno);
 
-            if (obj_seqno <= drain_seqno_)
+            if (obj_seqno <= drain_seqno_())
             {
                 post_leave(obj, lock);
             }
             else
             {
-                process_[idx].state_ = Process::S_FINISHED;
+                slot(obj_seqno).state_ = Process::S_FINISHED;
             }
         }
 
         void interrupt(const C& obj)
         {
 
-            size_t   idx (indexof(obj.seqno()));
             gu::Lock lock(mutex_);
 
-            while (obj.seqno() - last_left_ >= process_size_)
-                // TODO: exit on error
             {
-                lock.wait(cond_);
+                Waiter waiter(waiters_);
+
+                while (reserve(obj.seqno(), lock) == false)
+                    // TODO: exit on error
+                {
+                    lock.wait(cond_);
+                }
+            }
+
+            Process& a(slot(obj.seqno()));
+            bool     canceled(false);
+
+            if (a.state_() == Process::S_WAITING)
+            {
+                // S_WAITING is set and cleared only under mutex
+                a.state_ = Process::S_CANCELED;
+                canceled = true;
+            }
+            else if (obj.seqno() > last_left_() &&
+                     a.state_.compare_and_swap(Process::S_IDLE,
+                                               Process::S_CANCELED))
+            {
+                // lock-free leaver frees the slot before advancing
+                // last_left_, so the slot may be idle because the object
+                // has just left
+                canceled = (a.left_ != obj.seqno());
+                if (!canceled) a.state_ = Process::S_IDLE;
             }
 
-            if ((process_[idx].state_ == Process::S_IDLE &&
-                 obj.seqno()          >  last_left_ ) ||
-                process_[idx].state_ == Process::S_WAITING )
+            if (canceled)
             {
-                process_[idx].state_ = Process::S_CANCELED;
-                process_[idx].cond_.signal();
+                a.cond_.signal();
                 // since last_left + 1 cannot be <= S_WAITING we're not
                 // modifying a window here. No broadcasting.
             }
             else
             {
                 log_debug << "interrupting " << obj.seqno()
-                          << " state " << process_[idx].state_
-                          << " le " << last_entered_
-                          << " ll " << last_left_;
+                          << " state " << a.state_()
+                          << " le " << last_entered_()
+                          << " ll " << last_left_();
             }
         }
 
-        wsrep_seqno_t last_left()   const
+        wsrep_seqno_t last_left()   const { return last_left_(); }
+        // current process window size
+        ssize_t       size()        const { return size_(); }
+        ssize_t       max_size()    const { return max_size_(); }
+
+        // true if the object with this seqno has left the monitor, possibly
+        // out of order. To be called only from object condition().
+        // May give false negatives when called on the lock-free path.
+        bool has_left(wsrep_seqno_t const seqno) const
         {
-            gu::Lock lock(mutex_);
-            return last_left_;
+            if (seqno <= last_left_()) return true;
+
+            return (seqno <= last_entered_() &&
+                    slot(seqno).state_() == Process::S_FINISHED);
         }
-        ssize_t       size()        const { return process_size_; }
 
         bool would_block (wsrep_seqno_t seqno) const
         {
-            return (seqno - last_left_ >= process_size_ ||
-                    seqno > drain_seqno_);
+            return (seqno - last_left_() >=
+                    std::max(size_(), max_size_()) ||
+                    seqno > drain_seqno_());
         }
 
         void drain(wsrep_seqno_t seqno)
         {
             gu::Lock lock(mutex_);
 
-            while (drain_seqno_ != GU_LLONG_MAX)
+            while (drain_seqno_() != GU_LLONG_MAX)
             {
                 lock.wait(cond_);
             }
@@ -271,21 +399,26 @@ namespace galera
 
         void wait(wsrep_seqno_t seqno)
         {
+            if (last_left_() >= seqno) return;
+
             gu::Lock lock(mutex_);
-            if (last_left_ < seqno)
+            Waiter   waiter(waiters_);
+            // resize() wakes up all waiters to move to the new slots
+            while (last_left_() < seqno)
             {
-                size_t idx(indexof(seqno));
-                lock.wait(process_[idx].wait_cond_);
+                lock.wait(slot(seqno).wait_cond_);
             }
         }
 
         void wait(wsrep_seqno_t seqno, const gu::datetime::Date& wait_until)
         {
+            if (last_left_() >= seqno) return;
+
             gu::Lock lock(mutex_);
-            if (last_left_ < seqno)
+            Waiter   waiter(waiters_);
+            while (last_left_() < seqno)
             {
-                size_t idx(indexof(seqno));
-                lock.wait(process_[idx].wait_cond_, wait_until);
+                lock.wait(slot(seqno).wait_cond_, wait_until);
             }
         }
 
@@ -294,11 +427,14 @@ namespace galera
         {
             gu::Lock lock(mutex_);
 
-            if (entered_ > 0)
+            long const entered(entered_());
+
+            if (entered > 0)
             {
-                *oooe = (oooe_ > 0 ? double(oooe_)/entered_ : .0);
-                *oool = (oool_ > 0 ? double(oool_)/entered_ : .0);
-                *win_size = (win_size_ > 0 ? double(win_size_)/entered_ : .0);
+                *oooe = (oooe_() > 0 ? double(oooe_())/entered : .0);
+                *oool = (oool_() > 0 ? double(oool_())/entered : .0);
+                *win_size = (win_size_() > 0 ?
+                             double(win_size_())/entered : .0);
             }
             else
             {
@@ -313,43 +449,285 @@ namespace galera
             oooe_ = 0; oool_ = 0; win_size_ = 0; entered_ = 0; waits_ = 0;
         }
 
+        /*
+         * Makes out of order leavers wake up waiters whose condition may
+         * have become true. Needed when the condition depends on more
+         * than last_left, e.g. on has_left() of particular seqnos. A
+         * waiter is listed at the object its blocked_by() returns, so a
+         * leaver checks only the waiters listed at it.
+         */
+        void set_wake_up_out_of_order(bool const val)
+        {
+            gu::Lock lock(mutex_);
+            wake_up_ooo_ = val;
+        }
+
+        static ssize_t const DEFAULT_MAX_SIZE = (1ULL << 16);
+
+        static ssize_t min_size() { return chunk_size_; }
+
+        static bool valid_max_size(ssize_t const size)
+        {
+            return (size >= chunk_size_ && (size & (size - 1)) == 0);
+        }
+
+        /*
+         * Limits process window growth, must be a power of 2 not less than
+         * chunk size. The window is never shrunk.
+         */
+        void set_max_size(ssize_t const size)
+        {
+            assert(valid_max_size(size));
+            gu::Lock lock(mutex_);
+            max_size_ = size;
+            cond_.broadcast(); // window may grow for those who wait
+        }
+
     private:
 
-        size_t indexof(wsrep_seqno_t seqno)
+        Process& slot(wsrep_seqno_t const seqno) const
+        {
+            size_t const idx(seqno & (size_() - 1));
+            return process_[idx / chunk_size_][idx % chunk_size_];
+        }
+
+        // under mutex: makes sure that seqno fits into process window,
+        // growing it if allowed, returns false if it does not fit. May
+        // release the mutex while the window is being resized.
+        bool reserve(wsrep_seqno_t const seqno, gu::Lock& lock)
+        {
+            for (;;)
+            {
+                wsrep_seqno_t const dist(seqno - last_left_());
+
+                if (gu_likely(dist < size_())) return true;
+                if (dist >= max_size_())       return false;
+
+                if (resizing_() == 0)
+                {
+                    ssize_t size(size_());
+                    while (size <= dist) size *= 2;
+
+                    resize(size, lock);
+                }
+                else
+                {
+                    lock.wait(cond_); // somebody else is resizing
+                }
+            }
+        }
+
+        // under mutex: grows process window to size
+        void resize(ssize_t const size, gu::Lock& lock)
+        {
+            resizing_ = 1;
+
+            // Lock-free paths in progress use the old slots. New ones fall
+            // back to mutex and those in progress signal on completion.
+            while (fast_() > 0) lock.wait(cond_);
+
+            ssize_t const old_size(size_());
+
+            while (ssize_t(process_.size()) * chunk_size_ < size)
+            {
+                process_.push_back(new Process[chunk_size_]);
+            }
+
+            // Slots of seqnos that may be in use are moved to their new
+            // places. Their new places are either the same or in the new
+            // chunks, so nothing is overwritten.
+            std::vector<Process*> from(old_size);
+            wsrep_seqno_t const   last_left(last_left_());
+
+            for (wsrep_seqno_t i(last_left + 1); i <= last_left + old_size;
+                 ++i)
+            {
+                from[i - last_left - 1] = &slot(i);
+            }
+
+            size_ = size;
+
+            for (wsrep_seqno_t i(last_left + 1); i <= last_left + old_size;
+                 ++i)
+            {
+                Process& a(*from[i - last_left - 1]);
+                Process& b(slot(i));
+
+                if (&a != &b) move_slot(a, b);
+            }
+
+            // waiters sleep on the old slots, let them move
+            for (ssize_t i(0); i < old_size; ++i)
+            {
+                Process& a(process_[i / chunk_size_][i % chunk_size_]);
+                a.cond_.broadcast();
+                a.wait_cond_.broadcast();
+            }
+
+            log_debug << "monitor window resized " << old_size << " -> "
+                      << size;
+
+            resizing_ = 0;
+            cond_.broadcast();
+        }
+
+        // under mutex: moves complete slot state, leaving the old one idle
+        static void move_slot(Process& a, Process& b)
         {
-            return (seqno & process_mask_);
+            b.obj_        = a.obj_;
+            b.state_      = a.state_();
+            b.left_       = a.left_;
+            b.deps_seqno_ = a.deps_seqno_;
+            b.deps_head_  = a.deps_head_;
+            b.deps_next_  = a.deps_next_;
+            b.blocked_on_ = a.blocked_on_;
+
+            a.obj_        = 0;
+            a.state_      = Process::S_IDLE;
+            a.left_       = -1;
+            a.deps_seqno_ = -1;
+            a.deps_head_  = -1;
+            a.deps_next_  = -1;
+            a.blocked_on_ = -1;
         }
 
         bool may_enter(const C& obj) const
         {
-            return obj.condition(last_entered_, last_left_);
+            return obj.condition(last_entered_(), last_left_());
+        }
+
+        void update_stats(wsrep_seqno_t const obj_seqno,
+                          wsrep_seqno_t const last_entered,
+                          wsrep_seqno_t const last_left)
+        {
+            ++entered_;
+            if (last_left + 1 < obj_seqno) ++oooe_;
+            win_size_ += (last_entered - last_left);
+        }
+
+        // advances last_entered_ to seqno unless it is already past it,
+        // returns the resulting value
+        wsrep_seqno_t update_last_entered(wsrep_seqno_t const seqno)
+        {
+            wsrep_seqno_t last_entered(last_entered_());
+
+            while (last_entered < seqno)
+            {
+                if (last_entered_.compare_and_swap(last_entered, seqno))
+                    return seqno;
+
+                last_entered = last_entered_();
+            }
+
+            return last_entered;
+        }
+
+        // enters without locking if the object may enter right away,
+        // otherwise returns false
+        bool enter_fast(C& obj)
+        {
+            FastPath fast(*this);
+            if (gu_unlikely(fast.ok() == false)) return false;
+
+            const wsrep_seqno_t obj_seqno(obj.seqno());
+            const wsrep_seqno_t last_left(last_left_());
+            Process&            a(slot(obj_seqno));
+
+            assert(obj_seqno > last_left);
+
+            // Racing drain() is not a problem: entering concurrently with
+            // setting drain_seqno_ is the same as entering right before it.
+            if (obj_seqno - last_left >= size_()      ||
+                obj_seqno > drain_seqno_()             ||
+                obj.condition(last_entered_(), last_left) == false ||
+                // fails if the slot was canceled, then it is handled
+                // under mutex
+                a.state_.compare_and_swap(Process::S_IDLE,
+                                          Process::S_APPLYING) == false)
+            {
+                return false;
+            }
+
+            update_stats(obj_seqno, update_last_entered(obj_seqno), last_left);
+
+            return true;
+        }
+
+        // leaves without locking if the object shrinks the window,
+        // otherwise returns false
+        bool leave_fast(const C& obj)
+        {
+            const wsrep_seqno_t obj_seqno(obj.seqno());
+
+            {
+                FastPath fast(*this);
+                if (gu_unlikely(fast.ok() == false)) return false;
+
+                Process& a(slot(obj_seqno));
+
+                // Nobody else can advance last_left_ past an applying slot,
+                // so if we are next to it, we own it.
+                if (last_left_() + 1 != obj_seqno ||
+                    a.state_()       != Process::S_APPLYING)
+                {
+                    return false;
+                }
+
+                a.obj_   = 0;
+                a.left_  = obj_seqno;
+                a.state_ = Process::S_IDLE;
+                last_left_ = obj_seqno;
+            }
+
+            if (gu_unlikely(last_entered_() != obj_seqno || waiters_() > 0))
+            {
+                gu::Lock lock(mutex_);
+
+                slot(obj_seqno).wait_cond_.broadcast();
+                update_last_left();
+                if (last_left_() > obj_seqno) ++oool_;
+                wake_up_next();
+                cond_.broadcast();
+            }
+
+            return true;
         }
 
         // wait until it is possible to grab slot in monitor,
         // update last entered
         void pre_enter(C& obj, gu::Lock& lock)
         {
-            assert(last_left_ <= last_entered_);
+            assert(last_left_() <= last_entered_());
 
             const wsrep_seqno_t obj_seqno(obj.seqno());
 
-            while (would_block (obj_seqno)) // TODO: exit on error
+            if (must_wait (obj_seqno, lock))
             {
-                obj.unlock();
-                lock.wait(cond_);
-                obj.lock();
+                Waiter waiter(waiters_);
+
+                while (must_wait (obj_seqno, lock)) // TODO: exit on error
+                {
+                    obj.unlock();
+                    lock.wait(cond_);
+                    obj.lock();
+                }
             }
 
-            if (last_entered_ < obj_seqno) last_entered_ = obj_seqno;
+            update_last_entered(obj_seqno);
+        }
+
+        bool must_wait(wsrep_seqno_t const seqno, gu::Lock& lock)
+        {
+            return (reserve(seqno, lock) == false || seqno > drain_seqno_());
         }
 
         void update_last_left()
         {
-            for (wsrep_seqno_t i = last_left_ + 1; i <= last_entered_; ++i)
+            for (wsrep_seqno_t i = last_left_() + 1; i <= last_entered_(); ++i)
             {
-                Process& a(process_[indexof(i)]);
+                Process& a(slot(i));
 
-                if (Process::S_FINISHED == a.state_)
+                if (Process::S_FINISHED == a.state_())
                 {
                     a.state_   = Process::S_IDLE;
                     last_left_ = i;
@@ -360,15 +738,16 @@ namespace galera
                     break;
                 }
             }
-            assert(last_left_ <= last_entered_);
+            assert(last_left_() <= last_entered_());
         }
 
         void wake_up_next()
         {
-            for (wsrep_seqno_t i = last_left_ + 1; i <= last_entered_; ++i)
+            for (wsrep_seqno_t i = last_left_() + 1; i <= last_entered_(); ++i)
             {
-                Process& a(process_[indexof(i)]);
-                if (a.state_           == Process::S_WAITING &&
+                Process& a(slot(i));
+
+                if (a.state_()         == Process::S_WAITING &&
                     may_enter(*a.obj_) == true)
                 {
                     // We need to set state to APPLYING here because if
@@ -379,42 +758,118 @@ namespace galera
                     a.state_ = Process::S_APPLYING;
                     a.cond_.signal();
                 }
+                else if (wake_up_ooo_ &&
+                         a.state_()    == Process::S_WAITING &&
+                         a.blocked_on_ <= last_left_())
+                {
+                    // the object it was listed at has left in order
+                    add_dependent(i);
+                }
+            }
+        }
+
+        // under mutex: lists the waiter at the object that blocks it, if
+        // its condition tells which one
+        void add_dependent(wsrep_seqno_t const seqno)
+        {
+            Process&            a(slot(seqno));
+            wsrep_seqno_t const dep(a.obj_->blocked_by());
+
+            a.blocked_on_ = -1;
+
+            if (dep <= last_left_() || dep >= seqno) return;
+
+            Process& d(slot(dep));
+
+            if (d.deps_seqno_ != dep) // list of a previous slot object
+            {
+                d.deps_seqno_ = dep;
+                d.deps_head_  = -1;
+            }
+
+            a.deps_next_  = d.deps_head_;
+            a.blocked_on_ = dep;
+            d.deps_head_  = seqno;
+        }
+
+        // under mutex: wakes up or relists waiters listed at the object
+        // which has just left out of order
+        void wake_up_dependents(wsrep_seqno_t const seqno)
+        {
+            Process& d(slot(seqno));
+
+            if (d.deps_seqno_ != seqno) return;
+
+            wsrep_seqno_t i(d.deps_head_);
+
+            d.deps_seqno_ = -1;
+            d.deps_head_  = -1;
+
+            while (i != -1)
+            {
+                Process&            a(slot(i));
+                wsrep_seqno_t const next(a.deps_next_);
+
+                if (a.blocked_on_ == seqno)
+                {
+                    a.blocked_on_ = -1;
+
+                    if (a.state_() == Process::S_WAITING)
+                    {
+                        if (may_enter(*a.obj_))
+                        {
+                            a.state_ = Process::S_APPLYING;
+                            a.cond_.signal();
+                        }
+                        else
+                        {
+                            add_dependent(i);
+                        }
+                    }
+                }
+
+                i = next;
             }
         }
 
         void post_leave(const C& obj, gu::Lock& lock)
         {
             const wsrep_seqno_t obj_seqno(obj.seqno());
-            const size_t idx(indexof(obj_seqno));
+            Process& a(slot(obj_seqno));
+
+            a.obj_ = 0;
 
-            if (last_left_ + 1 == obj_seqno) // we're shrinking window
+            if (last_left_() + 1 == obj_seqno) // we're shrinking window
             {
-                process_[idx].state_ = Process::S_IDLE;
-                last_left_           = obj_seqno;
-                process_[idx].wait_cond_.broadcast();
+                a.state_   = Process::S_IDLE;
+                last_left_ = obj_seqno;
+                a.wait_cond_.broadcast();
 
                 update_last_left();
-                oool_ += (last_left_ > obj_seqno);
+                if (last_left_() > obj_seqno) ++oool_;
                 // wake up waiters that may remain above us (last_left_
                 // now is max)
                 wake_up_next();
             }
             else
             {
-                process_[idx].state_ = Process::S_FINISHED;
+                // if the previous object is leaving lock-free, it will see
+                // last_entered_ past it and sweep this slot under mutex
+                a.state_ = Process::S_FINISHED;
+
+                if (wake_up_ooo_) wake_up_dependents(obj_seqno);
             }
 
-            process_[idx].obj_ = 0;
+            assert((last_left_() >= obj_seqno &&
+                    a.state_() == Process::S_IDLE) ||
+                   a.state_() == Process::S_FINISHED);
 
-            assert((last_left_ >= obj_seqno &&
-                    process_[idx].state_ == Process::S_IDLE) ||
-                   process_[idx].state_ == Process::S_FINISHED);
-            assert(last_left_ != last_entered_ ||
-                   process_[indexof(last_left_)].state_ == Process::S_IDLE);
+            const wsrep_seqno_t last_left(last_left_());
 
-            if ((last_left_ >= obj_seqno) ||  // - occupied window shrinked
-                (last_left_ >= drain_seqno_)) // - this is to notify drain that
-                                              //   we reached drain_seqno_
+            if ((last_left >= obj_seqno) ||     // - occupied window shrinked
+                (last_left >= drain_seqno_()))  // - this is to notify drain
+                                                //   that we reached
+                                                //   drain_seqno_
             {
                 cond_.broadcast();
             }
@@ -426,18 +881,20 @@ namespace galera
 
             drain_seqno_ = seqno;
 
-            if (last_left_ > drain_seqno_)
+            if (last_left_() > seqno)
             {
                 log_debug << "last left greater than drain seqno";
-                for (wsrep_seqno_t i = drain_seqno_; i <= last_left_; ++i)
+                for (wsrep_seqno_t i = seqno; i <= last_left_(); ++i)
                 {
-                    const Process& a(process_[indexof(i)]);
+                    const Process& a(slot(i));
                     log_debug << "applier " << i
-                              << " in state " << a.state_;
+                              << " in state " << a.state_();
                 }
             }
 
-            while (last_left_ < drain_seqno_) lock.wait(cond_);
+            Waiter waiter(waiters_);
+
+            while (last_left_() < seqno) lock.wait(cond_);
         }
 
         Monitor(const Monitor&);
@@ -450,17 +907,26 @@ namespace galera
         gu::Mutex mutex_;
         gu::Cond  cond_;
 #endif /* HAVE_PSI_INTERFACE */
-        wsrep_seqno_t last_entered_;
-        wsrep_seqno_t last_left_;
-        wsrep_seqno_t drain_seqno_;
-        Process*      process_;
-        long entered_;  // entered
-        long oooe_;     // out of order entered
-        long oool_;     // out of order left
-        long win_size_; // window between last_left_ and last_entered_
+        gu::Atomic<wsrep_seqno_t> last_entered_;
+        gu::Atomic<wsrep_seqno_t> last_left_;
+        gu::Atomic<wsrep_seqno_t> drain_seqno_;
+        std::vector<Process*>     process_; // chunks of slots
+        gu::Atomic<ssize_t>       size_;    // process window size
+        gu::Atomic<ssize_t>       max_size_;
+        // lock-free paths in progress and resize in progress flag
+        gu::Atomic<long>          fast_;
+        gu::Atomic<int>           resizing_;
+        // threads waiting for last_left_ to advance
+        gu::Atomic<long>          waiters_;
+        gu::Atomic<long> entered_;  // entered
+        gu::Atomic<long> oooe_;     // out of order entered
+        gu::Atomic<long> oool_;     // out of order left
+        gu::Atomic<long> win_size_; // window between last_left_ and
+                                    // last_entered_
         // Total number of waits in the monitor. Incremented before
         // entering into waiting state.
         long long waits_;
+        bool      wake_up_ooo_;
     };
 }
 
@@ -97,6 +97,15 @@ namespace galera
 
         // action source interface
         virtual void process_trx(void* recv_ctx, TrxHandle* trx) = 0;
+        // certifies a run of received trxs with consecutive local seqnos,
+        // returns false if they must be ignored, otherwise every retval
+        // is to be passed to process_trx_result() with its trx
+        virtual bool cert_trxs(TrxHandle* const* trxs, size_t n,
+                               wsrep_status_t* retvals) = 0;
+        virtual void process_trx_result(void* recv_ctx, TrxHandle* trx,
+                                        wsrep_status_t retval) = 0;
+        // max number of received trxs to be passed to cert_trxs()
+        virtual size_t max_cert_batch() const = 0;
         virtual void process_commit_cut(wsrep_seqno_t seq,
                                         wsrep_seqno_t seqno_l) = 0;
         virtual void process_conf_change(void*                    recv_ctx,
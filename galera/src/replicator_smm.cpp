@@ -142,6 +142,8 @@ galera::ReplicatorSMM::ReplicatorSMM(const struct wsrep_init_args* args)
                          TrxHandle::Defaults.record_set_ver_,
                          gu::from_string<int>(config_.get(
                              Param::max_write_set_size))),
+    ws_compression_threshold_(gu::from_string<size_t>(config_.get(
+                                  Param::ws_compression_threshold))),
     uuid_               (WSREP_UUID_UNDEFINED),
     state_uuid_         (WSREP_UUID_UNDEFINED),
     state_uuid_str_     (),
@@ -174,7 +176,7 @@ galera::ReplicatorSMM::ReplicatorSMM(const struct wsrep_init_args* args)
     slave_pool_         (sizeof(TrxHandle), 1024, "SlaveTrxHandle"),
     as_                 (0),
     gcs_as_             (slave_pool_, gcs_, *this, gcache_),
-    ist_receiver_       (config_, slave_pool_, args->node_address),
+    ist_receiver_       (config_, gcache_, slave_pool_, args->node_address),
     ist_prepared_       (false),
     ist_senders_        (gcs_, gcache_),
     wsdb_               (),
@@ -192,6 +194,8 @@ galera::ReplicatorSMM::ReplicatorSMM(const struct wsrep_init_args* args)
     commit_monitor_     (),
 #endif /* HAVE_PSI_INTERFACE */
     causal_read_timeout_(config_.get(Param::causal_read_timeout)),
+    max_cert_batch_     (cert_batch_size(config_.get(Param::max_cert_batch))),
+    pa_graph_           (config_.get<bool>(Param::pa_graph)),
     receivers_          (),
     replicated_         (),
     replicated_bytes_   (),
@@ -257,6 +261,8 @@ galera::ReplicatorSMM::ReplicatorSMM(const struct wsrep_init_args* args)
     state_.add_transition(Transition(S_DONOR, S_JOINED));
 
     local_monitor_.set_initial_position(0);
+    apply_monitor_.set_wake_up_out_of_order(pa_graph_);
+    set_monitor_window(monitor_window(config_.get(Param::max_monitor_window)));
 
     wsrep_uuid_t  uuid;
     wsrep_seqno_t seqno;
@@ -483,7 +489,7 @@ void galera::ReplicatorSMM::apply_trx(void* recv_ctx, TrxHandle* trx)
     assert(trx->global_seqno() > STATE_SEQNO());
     assert(trx->is_local() == false);
 
-    ApplyOrder ao(*trx);
+    ApplyOrder ao(*trx, pa_graph_ ? &apply_monitor_ : 0);
     CommitOrder co(*trx, co_mode_);
 
     gu_trace(apply_monitor_.enter(ao));
@@ -1271,7 +1277,8 @@ writeset_from_handle (wsrep_po_handle_t& handle,
                 KeySet::version(trx_params.key_format_), NULL, 0, 0,
                 trx_params.record_set_ver_,
                 WriteSetNG::MAX_VERSION, DataSet::MAX_VERSION, DataSet::MAX_VERSION,
-                trx_params.max_write_set_size_);
+                trx_params.max_write_set_size_,
+                trx_params.compress_threshold_);
 
             handle.opaque = ret;
         }
@@ -1418,6 +1425,55 @@ void galera::ReplicatorSMM::process_trx(void* recv_ctx, TrxHandle* trx)
 
     wsrep_status_t const retval(cert_and_catch(trx));
 
+    process_trx_result(recv_ctx, trx, retval);
+}
+
+
+bool galera::ReplicatorSMM::cert_trxs(TrxHandle* const*     trxs,
+                                      size_t const          n,
+                                      wsrep_status_t* const retvals)
+{
+    assert(n > 0);
+    assert(n <= GcsActionSource::MAX_CERT_BATCH);
+
+    for (size_t i(0); i < n; ++i)
+    {
+        assert(trxs[i]->local_seqno() > 0);
+        assert(trxs[i]->global_seqno() > 0);
+        assert(trxs[i]->depends_seqno() == -1);
+        assert(trxs[i]->state() == TrxHandle::S_REPLICATING);
+    }
+
+    if (sst_state_ == SST_CANCELED)
+    {
+        log_info << "Ignorng trxs(" << trxs[0]->global_seqno() << " - "
+                 << trxs[n - 1]->global_seqno() << ") due to SST failure";
+        return false;
+    }
+
+    if (1 == n)
+    {
+        retvals[0] = cert_and_catch(trxs[0]);
+    }
+    else
+    {
+        cert_batch_and_catch(trxs, n, retvals);
+    }
+
+    return true;
+}
+
+
+size_t galera::ReplicatorSMM::max_cert_batch() const
+{
+    return max_cert_batch_;
+}
+
+
+void galera::ReplicatorSMM::process_trx_result(void*                recv_ctx,
+                                               TrxHandle*           trx,
+                                               wsrep_status_t const retval)
+{
     switch (retval)
     {
     case WSREP_OK:
@@ -1476,6 +1532,7 @@ void galera::ReplicatorSMM::process_commit_cut(wsrep_seqno_t seq,
 void galera::ReplicatorSMM::establish_protocol_versions (int proto_ver)
 {
     trx_params_.record_set_ver_ = gu::RecordSet::VER1;
+    trx_params_.compress_threshold_ = 0;
 
     switch (proto_ver)
     {
@@ -1519,6 +1576,13 @@ void galera::ReplicatorSMM::establish_protocol_versions (int proto_ver)
         trx_params_.record_set_ver_ = gu::RecordSet::VER2;
         str_proto_ver_ = 2;
         break;
+    case 10:
+        // Protocol upgrade to enable compressed data sets.
+        trx_params_.version_ = 4;
+        trx_params_.record_set_ver_ = gu::RecordSet::VER2;
+        trx_params_.compress_threshold_ = ws_compression_threshold_;
+        str_proto_ver_ = 2;
+        break;
     default:
         log_fatal << "Configuration change resulted in an unsupported protocol "
             "version: " << proto_ver << ". Can't continue.";
@@ -1977,6 +2041,92 @@ void galera::ReplicatorSMM::resync()
 //////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////
 
+/* handles trx which global seqno is already covered by state transfer,
+ * must be called in local monitor */
+void galera::ReplicatorSMM::cert_not_applicable(TrxHandle* trx)
+{
+    // this can happen after state transfer position has been submitted
+    // but not all actions preceding it have been processed.
+    //
+    // Cert index preload after SST:
+    // ----------------------------
+    // If the trx global seqno is in the half open range
+    // (cc_seqno_ , sst_seqno_], the write set was contained in the SST.
+    // In this case do the certification for trx to populate the index,
+    // but ignore the result. Always set state as S_MUST_ABORT and
+    // return WSREP_TRX_FAIL to make calling code to discard this trx.
+    if (last_st_type_ == ST_TYPE_SST &&
+        cc_seqno_ < trx->global_seqno() &&
+        trx->global_seqno() <= sst_seqno_)
+    {
+        (void)cert_.append_trx(trx);
+        trx->verify_checksum();
+        gcache_.seqno_assign (trx->action(),
+                              trx->global_seqno(),
+                              trx->depends_seqno());
+        cert_.set_trx_committed(trx);
+    }
+    else
+    {
+        gcache_.free(const_cast<void*>(trx->action()));
+    }
+    trx->set_state(TrxHandle::S_MUST_ABORT);
+}
+
+/* converts certification result to wsrep status and finalizes trx
+ * certification, must be called in local monitor */
+wsrep_status_t
+galera::ReplicatorSMM::cert_result(TrxHandle* trx,
+                                   Certification::TestResult const res)
+{
+    wsrep_status_t retval(WSREP_OK);
+
+    switch (res)
+    {
+    case Certification::TEST_OK:
+        if (trx->state() == TrxHandle::S_CERTIFYING)
+        {
+            retval = WSREP_OK;
+        }
+        else
+        {
+            assert(trx->state() == TrxHandle::S_MUST_ABORT);
+            trx->set_state(TrxHandle::S_MUST_REPLAY_AM);
+            retval = WSREP_BF_ABORT;
+        }
+        break;
+    case Certification::TEST_FAILED:
+        if (gu_unlikely(trx->is_toi())) // small sanity check
+            log_info << "Certification failed for TO isolated action: "
+                      << *trx;
+        else
+            log_debug << "Certification failed for replicated action: "
+                      << *trx;
+
+        local_cert_failures_ += trx->is_local();
+        trx->set_state(TrxHandle::S_MUST_ABORT);
+        retval = WSREP_TRX_FAIL;
+        break;
+    }
+
+    if (gu_unlikely(WSREP_TRX_FAIL == retval))
+    {
+        report_last_committed(cert_.set_trx_committed(trx));
+    }
+
+    // at this point we are about to leave local_monitor_. Make sure
+    // trx checksum was alright before that.
+    trx->verify_checksum();
+
+    // we must do it 'in order' for std::map reasons, so keeping
+    // it inside the monitor
+    gcache_.seqno_assign (trx->action(),
+                          trx->global_seqno(),
+                          trx->depends_seqno());
+
+    return retval;
+}
+
 /* don't use this directly, use cert_and_catch() instead */
 inline
 wsrep_status_t galera::ReplicatorSMM::cert(TrxHandle* trx)
@@ -2013,32 +2163,7 @@ wsrep_status_t galera::ReplicatorSMM::cert(TrxHandle* trx)
 
     if (!applicable)
     {
-        // this can happen after state transfer position has been submitted
-        // but not all actions preceding it have been processed.
-        //
-        // Cert index preload after SST:
-        // ----------------------------
-        // If the trx global seqno is in the half open range
-        // (cc_seqno_ , sst_seqno_], the write set was contained in the SST.
-        // In this case do the certification for trx to populate the index,
-        // but ignore the result. Always set state as S_MUST_ABORT and
-        // return WSREP_TRX_FAIL to make calling code to discard this trx.
-        if (last_st_type_ == ST_TYPE_SST &&
-            cc_seqno_ < trx->global_seqno() &&
-            trx->global_seqno() <= sst_seqno_)
-        {
-            (void)cert_.append_trx(trx);
-            trx->verify_checksum();
-            gcache_.seqno_assign (trx->action(),
-                                  trx->global_seqno(),
-                                  trx->depends_seqno());
-            cert_.set_trx_committed(trx);
-        }
-        else
-        {
-            gcache_.free(const_cast<void*>(trx->action()));
-        }
-        trx->set_state(TrxHandle::S_MUST_ABORT);
+        cert_not_applicable(trx);
         if (interrupted)
             local_monitor_.self_cancel(lo);
         else
@@ -2048,48 +2173,7 @@ wsrep_status_t galera::ReplicatorSMM::cert(TrxHandle* trx)
 
     if (gu_likely (!interrupted))
     {
-        switch (cert_.append_trx(trx))
-        {
-        case Certification::TEST_OK:
-            if (trx->state() == TrxHandle::S_CERTIFYING)
-            {
-                retval = WSREP_OK;
-            }
-            else
-            {
-                assert(trx->state() == TrxHandle::S_MUST_ABORT);
-                trx->set_state(TrxHandle::S_MUST_REPLAY_AM);
-                retval = WSREP_BF_ABORT;
-            }
-            break;
-        case Certification::TEST_FAILED:
-            if (gu_unlikely(trx->is_toi())) // small sanity check
-                log_info << "Certification failed for TO isolated action: "
-                          << *trx;
-            else
-                log_debug << "Certification failed for replicated action: "
-                          << *trx;
-
-            local_cert_failures_ += trx->is_local();
-            trx->set_state(TrxHandle::S_MUST_ABORT);
-            retval = WSREP_TRX_FAIL;
-            break;
-        }
-
-        if (gu_unlikely(WSREP_TRX_FAIL == retval))
-        {
-            report_last_committed(cert_.set_trx_committed(trx));
-        }
-
-        // at this point we are about to leave local_monitor_. Make sure
-        // trx checksum was alright before that.
-        trx->verify_checksum();
-
-        // we must do it 'in order' for std::map reasons, so keeping
-        // it inside the monitor
-        gcache_.seqno_assign (trx->action(),
-                              trx->global_seqno(),
-                              trx->depends_seqno());
+        retval = cert_result(trx, cert_.append_trx(trx));
 
         local_monitor_.leave(lo);
     }
@@ -2137,6 +2221,99 @@ wsrep_status_t galera::ReplicatorSMM::cert_and_catch(TrxHandle* trx)
     abort();
 }
 
+/* Certifies a run of received trxs with consecutive local seqnos.
+ * Local monitor is entered only once for the whole run and certification
+ * index is updated in one critical section.
+ * Don't use this directly, use cert_batch_and_catch() instead */
+inline
+void galera::ReplicatorSMM::cert_batch(TrxHandle* const* trxs, size_t const n,
+                                       wsrep_status_t* const retvals)
+{
+    assert(n > 1);
+
+    for (size_t i(0); i < n; ++i)
+    {
+        TrxHandle* const trx(trxs[i]);
+
+        assert(trx->state() == TrxHandle::S_REPLICATING);
+        assert(!trx->is_local());
+        assert(trx->last_seen_seqno() >= 0);
+        assert(trx->last_seen_seqno() < trx->global_seqno());
+        assert(0 == i || trx->local_seqno() == trxs[i - 1]->local_seqno() + 1);
+
+        trx->set_state(TrxHandle::S_CERTIFYING);
+    }
+
+    // remote trxs can't be interrupted in local monitor
+    LocalOrder lo(*trxs[0]);
+    gu_trace(local_monitor_.enter(lo));
+
+    // IST should have drained the monitors, so STATE_SEQNO() should be current
+    size_t first(0);
+    while (first < n && trxs[first]->global_seqno() <= STATE_SEQNO())
+    {
+        cert_not_applicable(trxs[first]);
+        retvals[first] = WSREP_TRX_FAIL;
+        ++first;
+    }
+
+    if (first < n)
+    {
+        Certification::TestResult res[GcsActionSource::MAX_CERT_BATCH];
+
+        cert_.append_trxs(trxs + first, n - first, res);
+
+        for (size_t i(first); i < n; ++i)
+        {
+            retvals[i] = cert_result(trxs[i], res[i - first]);
+        }
+    }
+
+    local_monitor_.leave(lo);
+
+    // the rest of local seqnos are owned by this thread and follow lo
+    for (size_t i(1); i < n; ++i)
+    {
+        LocalOrder lo_i(*trxs[i]);
+        local_monitor_.enter(lo_i);
+        local_monitor_.leave(lo_i);
+    }
+
+    for (size_t i(first); i < n; ++i)
+    {
+        if (gu_unlikely(WSREP_TRX_FAIL == retvals[i]))
+        {
+            // applicable but failed certification: self-cancel monitors
+            ApplyOrder  ao(*trxs[i]);
+            CommitOrder co(*trxs[i], co_mode_);
+
+            apply_monitor_.self_cancel(ao);
+            if (co_mode_ != CommitOrder::BYPASS) commit_monitor_.self_cancel(co);
+        }
+    }
+}
+
+/* same as cert_and_catch() for a batch of trxs */
+void galera::ReplicatorSMM::cert_batch_and_catch(TrxHandle* const* trxs,
+                                                 size_t const      n,
+                                                 wsrep_status_t*   retvals)
+{
+    try
+    {
+        cert_batch(trxs, n, retvals);
+        return;
+    }
+    catch (std::exception& e)
+    {
+        log_fatal << "Certification exception: " << e.what();
+    }
+    catch (...)
+    {
+        log_fatal << "Unknown certification exception";
+    }
+    abort();
+}
+
 /* This must be called BEFORE local_monitor_.self_cancel() due to
  * gcache_.seqno_assign() */
 wsrep_status_t galera::ReplicatorSMM::cert_for_aborted(TrxHandle* trx)
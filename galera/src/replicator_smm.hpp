@@ -151,6 +151,11 @@ namespace galera
                                     int                 rcode);
 
         void process_trx(void* recv_ctx, TrxHandle* trx);
+        bool cert_trxs(TrxHandle* const* trxs, size_t n,
+                       wsrep_status_t* retvals);
+        void process_trx_result(void* recv_ctx, TrxHandle* trx,
+                                wsrep_status_t retval);
+        size_t max_cert_batch() const;
         void process_commit_cut(wsrep_seqno_t seq, wsrep_seqno_t seqno_l);
         void process_conf_change(void* recv_ctx,
                                  const wsrep_view_info_t& view,
@@ -206,6 +211,10 @@ namespace galera
             static const std::string commit_order;
             static const std::string causal_read_timeout;
             static const std::string max_write_set_size;
+            static const std::string max_cert_batch;
+            static const std::string pa_graph;
+            static const std::string max_monitor_window;
+            static const std::string ws_compression_threshold;
         };
 
         typedef std::pair<std::string, std::string> Default;
@@ -235,6 +244,17 @@ namespace galera
 
         wsrep_status_t cert(TrxHandle* trx);
         wsrep_status_t cert_and_catch(TrxHandle* trx);
+        void           cert_batch(TrxHandle* const* trxs, size_t n,
+                                  wsrep_status_t* retvals);
+        void           cert_batch_and_catch(TrxHandle* const* trxs, size_t n,
+                                            wsrep_status_t* retvals);
+        void           cert_not_applicable(TrxHandle* trx);
+        wsrep_status_t cert_result(TrxHandle* trx,
+                                   Certification::TestResult res);
+
+        static size_t cert_batch_size(const std::string& value);
+        static ssize_t monitor_window(const std::string& value);
+        void set_monitor_window(ssize_t size);
         wsrep_status_t cert_for_aborted(TrxHandle* trx);
 
         void update_state_uuid (const wsrep_uuid_t& u,
@@ -271,6 +291,8 @@ namespace galera
                 return (last_left + 1 == seqno_);
             }
 
+            wsrep_seqno_t blocked_by() const { return WSREP_SEQNO_UNDEFINED; }
+
 #ifdef GU_DBUG_ON
 #ifdef HAVE_PSI_INTERFACE
             void debug_sync(gu::MutexWithPFS& mutex)
@@ -298,7 +320,11 @@ namespace galera
         {
         public:
 
-            ApplyOrder(TrxHandle& trx) : trx_(trx) { }
+            /* if graph is given, trx may enter as soon as the trxs it
+             * depends on according to certification have left it */
+            ApplyOrder(TrxHandle& trx,
+                       const Monitor<ApplyOrder>* graph = 0)
+                : trx_(trx), graph_(graph) { }
 
             void lock()   { trx_.lock();   }
             void unlock() { trx_.unlock(); }
@@ -308,8 +334,36 @@ namespace galera
             bool condition(wsrep_seqno_t last_entered,
                            wsrep_seqno_t last_left) const
             {
-                return (trx_.is_local() == true ||
-                        last_left >= trx_.depends_seqno());
+                if (trx_.is_local() == true ||
+                    last_left >= trx_.depends_seqno())
+                {
+                    return true;
+                }
+
+                if (graph_ == 0 || trx_.pa_deps_num() < 0 ||
+                    last_left < trx_.pa_base_seqno())
+                {
+                    return false;
+                }
+
+                for (int i(0); i < trx_.pa_deps_num(); ++i)
+                {
+                    if (!graph_->has_left(trx_.pa_dep(i))) return false;
+                }
+
+                return true;
+            }
+
+            // explicit dependency which has not left yet, if any
+            wsrep_seqno_t blocked_by() const
+            {
+                for (int i(0); graph_ != 0 && i < trx_.pa_deps_num(); ++i)
+                {
+                    if (!graph_->has_left(trx_.pa_dep(i)))
+                        return trx_.pa_dep(i);
+                }
+
+                return WSREP_SEQNO_UNDEFINED;
             }
 
 #ifdef GU_DBUG_ON
@@ -340,7 +394,8 @@ namespace galera
 
         private:
             ApplyOrder(const ApplyOrder&);
-            TrxHandle& trx_;
+            TrxHandle&                 trx_;
+            const Monitor<ApplyOrder>* graph_;
         };
 
     public:
@@ -403,6 +458,8 @@ namespace galera
                 gu_throw_fatal << "invalid commit mode value " << mode_;
             }
 
+            wsrep_seqno_t blocked_by() const { return WSREP_SEQNO_UNDEFINED; }
+
 #ifdef GU_DBUG_ON
 #ifdef HAVE_PSI_INTERFACE
             void debug_sync(gu::MutexWithPFS& mutex)
@@ -593,6 +650,10 @@ namespace galera
         // currently installed trx parameters
         TrxHandle::Params     trx_params_;
 
+        // configured data set compression threshold, effective only
+        // with protocol version 10 and up
+        size_t                ws_compression_threshold_;
+
         // identifiers
         wsrep_uuid_t          uuid_;
         wsrep_uuid_t const    state_uuid_;
@@ -651,6 +712,8 @@ namespace galera
         Monitor<ApplyOrder>  apply_monitor_;
         Monitor<CommitOrder> commit_monitor_;
         gu::datetime::Period causal_read_timeout_;
+        size_t               max_cert_batch_;
+        bool const           pa_graph_;
 
         // counters
         gu::Atomic<size_t>    receivers_;
@@ -24,8 +24,58 @@ const std::string galera::ReplicatorSMM::Param::key_format =
     common_prefix + "key_format";
 const std::string galera::ReplicatorSMM::Param::max_write_set_size =
     common_prefix + "max_ws_size";
+const std::string galera::ReplicatorSMM::Param::max_cert_batch =
+    common_prefix + "max_cert_batch";
+const std::string galera::ReplicatorSMM::Param::pa_graph =
+    common_prefix + "pa_graph";
+const std::string galera::ReplicatorSMM::Param::max_monitor_window =
+    common_prefix + "max_monitor_window";
+const std::string galera::ReplicatorSMM::Param::ws_compression_threshold =
+    common_prefix + "ws_compression_threshold";
+
+int const galera::ReplicatorSMM::MAX_PROTO_VER(10);
+
+size_t
+galera::ReplicatorSMM::cert_batch_size(const std::string& value)
+{
+    size_t const ret(gu::from_string<size_t>(value));
+
+    if (ret < 1 || ret > GcsActionSource::MAX_CERT_BATCH)
+    {
+        gu_throw_error(EINVAL) << "'" << Param::max_cert_batch << "' value "
+                               << ret << " is out of range [1, "
+                               << GcsActionSource::MAX_CERT_BATCH << "]";
+    }
 
-int const galera::ReplicatorSMM::MAX_PROTO_VER(9);
+    return ret;
+}
+
+ssize_t
+galera::ReplicatorSMM::monitor_window(const std::string& value)
+{
+    static ssize_t const max_window(1 << 24);
+
+    ssize_t const ret(gu::from_string<ssize_t>(value));
+
+    if (!Monitor<LocalOrder>::valid_max_size(ret) || ret > max_window)
+    {
+        gu_throw_error(EINVAL) << "'" << Param::max_monitor_window
+                               << "' value " << ret
+                               << " must be a power of 2 in range ["
+                               << Monitor<LocalOrder>::min_size()
+                               << ", " << max_window << "]";
+    }
+
+    return ret;
+}
+
+void
+galera::ReplicatorSMM::set_monitor_window(ssize_t const size)
+{
+    local_monitor_.set_max_size(size);
+    apply_monitor_.set_max_size(size);
+    commit_monitor_.set_max_size(size);
+}
 
 galera::ReplicatorSMM::Defaults::Defaults() : map_()
 {
@@ -38,6 +88,12 @@ galera::ReplicatorSMM::Defaults::Defaults() : map_()
     const int max_write_set_size(galera::WriteSetNG::MAX_SIZE);
     map_.insert(Default(Param::max_write_set_size,
                         gu::to_string(max_write_set_size)));
+    map_.insert(Default(Param::max_cert_batch, "16"));
+    map_.insert(Default(Param::pa_graph, "no"));
+    ssize_t const max_monitor_window(Monitor<LocalOrder>::DEFAULT_MAX_SIZE);
+    map_.insert(Default(Param::max_monitor_window,
+                        gu::to_string(max_monitor_window)));
+    map_.insert(Default(Param::ws_compression_threshold, "0"));
 }
 
 const galera::ReplicatorSMM::Defaults galera::ReplicatorSMM::defaults;
@@ -161,7 +217,7 @@ void
 galera::ReplicatorSMM::set_param (const std::string& key,
                                   const std::string& value)
 {
-    if (key == Param::commit_order)
+    if (key == Param::commit_order || key == Param::pa_graph)
     {
         log_error << "setting '" << key << "' during runtime not allowed";
         gu_throw_error(EPERM)
@@ -187,6 +243,22 @@ galera::ReplicatorSMM::set_param (const std::string& key,
     {
         trx_params_.max_write_set_size_ = gu::from_string<int>(value);
     }
+    else if (key == Param::max_cert_batch)
+    {
+        max_cert_batch_ = cert_batch_size(value);
+    }
+    else if (key == Param::max_monitor_window)
+    {
+        set_monitor_window(monitor_window(value));
+    }
+    else if (key == Param::ws_compression_threshold)
+    {
+        ws_compression_threshold_ = gu::from_string<size_t>(value);
+        if (protocol_version_ >= 10)
+        {
+            trx_params_.compress_threshold_ = ws_compression_threshold_;
+        }
+    }
     else
     {
         log_warn << "parameter '" << key << "' not found";
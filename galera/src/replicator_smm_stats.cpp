@@ -122,6 +122,7 @@ typedef enum status_vars
     STATS_CERT_INDEX_SIZE,
     STATS_CERT_BUCKET_COUNT,
     STATS_GCACHE_POOL_SIZE,
+    STATS_GCACHE_HUGE_PAGES_SIZE,
     STATS_CAUSAL_READS,
     STATS_CERT_INTERVAL,
     STATS_OPEN_TRX,
@@ -184,6 +185,7 @@ static const struct wsrep_stats_var wsrep_stats[STATS_MAX + 1] =
     { "cert_index_size",          WSREP_VAR_INT64,  { 0 }  },
     { "cert_bucket_count",        WSREP_VAR_INT64,  { 0 }  },
     { "gcache_pool_size",         WSREP_VAR_INT64,  { 0 }  },
+    { "gcache_huge_pages_size",   WSREP_VAR_INT64,  { 0 }  },
     { "causal_reads",             WSREP_VAR_INT64,  { 0 }  },
     { "cert_interval",            WSREP_VAR_DOUBLE, { 0 }  },
     { "open_transactions",        WSREP_VAR_INT64,  { 0 }  },
@@ -278,6 +280,7 @@ galera::ReplicatorSMM::stats_get()
     sv[STATS_CERT_BUCKET_COUNT   ].value._int64 = cert_.bucket_count();
 
     sv[STATS_GCACHE_POOL_SIZE    ].value._int64 = gcache_.allocated_pool_size();
+    sv[STATS_GCACHE_HUGE_PAGES_SIZE].value._int64 = gcache_.huge_pages_size();
 
     double oooe;
     double oool;
@@ -50,18 +50,21 @@ namespace galera
             KeySet::Version        key_format_;
             gu::RecordSet::Version record_set_ver_;
             int                    max_write_set_size_;
+            size_t                 compress_threshold_; // 0 - don't compress
 
             Params (const std::string& wdir,
                     int                ver,
                     KeySet::Version    kformat,
                     gu::RecordSet::Version rsv = gu::RecordSet::VER2,
-                    int                max_write_set_size = WriteSetNG::MAX_SIZE)
+                    int                max_write_set_size = WriteSetNG::MAX_SIZE,
+                    size_t             compress_threshold = 0)
                 :
                 working_dir_       (wdir),
                 version_           (ver),
                 key_format_        (kformat),
                 record_set_ver_    (rsv),
-                max_write_set_size_(max_write_set_size)
+                max_write_set_size_(max_write_set_size),
+                compress_threshold_(compress_threshold)
             {}
         };
 
@@ -309,10 +312,10 @@ namespace galera
         }
 
         /* obtain global and depends seqno from the writeset (IST) */
-        void set_received_from_ws()
+        void set_received_from_ws(const void* action = 0)
         {
             wsrep_seqno_t const seqno_g(write_set_in_.seqno());
-            set_received(0, -1, seqno_g);
+            set_received(action, -1, seqno_g);
             wsrep_seqno_t const seqno_d
                 (std::max<wsrep_seqno_t>
                     (global_seqno_ - write_set_in_.pa_range(),
@@ -334,6 +337,72 @@ namespace galera
             depends_seqno_ = seqno_lt;
         }
 
+        /*
+         * Dependency graph for parallel applying: trx may be applied once
+         * every trx up to pa_base_seqno() and every explicit dependency
+         * has been applied. Explicit dependencies are kept in a small
+         * fixed array, when it is full the lowest one is folded into the
+         * base. depends_seqno() stays the scalar upper bound of all these.
+         */
+        static int const MAX_PA_DEPS = 8;
+
+        void init_pa_deps(wsrep_seqno_t const base)
+        {
+            pa_base_seqno_ = base;
+            pa_deps_num_   = 0;
+        }
+
+        /* all trxs up to seqno must be applied */
+        void set_pa_base_seqno(wsrep_seqno_t const seqno)
+        {
+            if (seqno <= pa_base_seqno_) return;
+
+            pa_base_seqno_ = seqno;
+
+            int n(0);
+            for (int i(0); i < pa_deps_num_; ++i)
+            {
+                if (pa_deps_[i] > seqno) pa_deps_[n++] = pa_deps_[i];
+            }
+            pa_deps_num_ = n;
+        }
+
+        /* trx with this seqno must be applied */
+        void add_pa_dep(wsrep_seqno_t const seqno)
+        {
+            assert(pa_deps_num_ >= 0);
+
+            if (seqno <= pa_base_seqno_) return;
+
+            int lowest(0);
+            for (int i(0); i < pa_deps_num_; ++i)
+            {
+                if (pa_deps_[i] == seqno) return;
+                if (pa_deps_[i] < pa_deps_[lowest]) lowest = i;
+            }
+
+            if (gu_likely(pa_deps_num_ < MAX_PA_DEPS))
+            {
+                pa_deps_[pa_deps_num_++] = seqno;
+            }
+            else if (seqno > pa_deps_[lowest])
+            {
+                wsrep_seqno_t const base(pa_deps_[lowest]);
+                pa_deps_[lowest] = seqno;
+                set_pa_base_seqno(base);
+            }
+            else
+            {
+                set_pa_base_seqno(seqno);
+            }
+        }
+
+        /* -1 if no dependency graph was built, then depends_seqno()
+         * is the only dependency */
+        int           pa_deps_num()         const { return pa_deps_num_;   }
+        wsrep_seqno_t pa_dep(int const i)   const { return pa_deps_[i];    }
+        wsrep_seqno_t pa_base_seqno()       const { return pa_base_seqno_; }
+
         State state() const { return state_(); }
         void set_state(State state) { state_.shift_to(state); }
 
@@ -664,6 +733,9 @@ namespace galera
             global_seqno_      (WSREP_SEQNO_UNDEFINED),
             last_seen_seqno_   (WSREP_SEQNO_UNDEFINED),
             depends_seqno_     (WSREP_SEQNO_UNDEFINED),
+            pa_base_seqno_     (WSREP_SEQNO_UNDEFINED),
+            pa_deps_           (),
+            pa_deps_num_       (-1),
             timestamp_         (),
             write_set_         (Defaults.version_),
             write_set_in_      (),
@@ -708,6 +780,9 @@ namespace galera
             global_seqno_      (WSREP_SEQNO_UNDEFINED),
             last_seen_seqno_   (WSREP_SEQNO_UNDEFINED),
             depends_seqno_     (WSREP_SEQNO_UNDEFINED),
+            pa_base_seqno_     (WSREP_SEQNO_UNDEFINED),
+            pa_deps_           (),
+            pa_deps_num_       (-1),
             timestamp_         (gu_time_calendar()),
             write_set_         (params.version_),
             write_set_in_      (),
@@ -758,7 +833,8 @@ namespace galera
                                        WriteSetNG::Version(params.version_),
                                        DataSet::MAX_VERSION,
                                        DataSet::MAX_VERSION,
-                                       params.max_write_set_size_);
+                                       params.max_write_set_size_,
+                                       params.compress_threshold_);
             }
         }
 
@@ -779,6 +855,9 @@ namespace galera
         wsrep_seqno_t          global_seqno_;
         wsrep_seqno_t          last_seen_seqno_;
         wsrep_seqno_t          depends_seqno_;
+        wsrep_seqno_t          pa_base_seqno_;
+        wsrep_seqno_t          pa_deps_[MAX_PA_DEPS];
+        int                    pa_deps_num_;
         int64_t                timestamp_;
         WriteSet               write_set_;
         WriteSetIn             write_set_in_;
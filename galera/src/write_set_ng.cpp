@@ -64,11 +64,11 @@ WriteSetNG::Header::gather (KeySet::Version const  kver,
 {
     GU_COMPILE_ASSERT(MAX_VERSION         <= 15, header_version_too_big);
     GU_COMPILE_ASSERT(KeySet::MAX_VERSION <= 15, keyset_version_too_big);
-    GU_COMPILE_ASSERT(DataSet::MAX_VERSION <= 3, dataset_version_too_big);
+    GU_COMPILE_ASSERT(DataSet::MAX_IN_VERSION <= 3, dataset_version_too_big);
 
     assert (uint(ver_) <= MAX_VERSION);
     assert (uint(kver) <= KeySet::MAX_VERSION);
-    assert (uint(dver) <= DataSet::MAX_VERSION);
+    assert (uint(dver) <= DataSet::MAX_IN_VERSION);
 
     local_[V3_MAGIC_OFF]       = MAGIC_BYTE;
     local_[V3_HEADER_VERS_OFF] = (version() << 4) | VER3;
@@ -188,6 +188,29 @@ const char WriteSetOut::keys_suffix[] = "_keys";
 const char WriteSetOut::data_suffix[] = "_data";
 const char WriteSetOut::unrd_suffix[] = "_unrd";
 const char WriteSetOut::annt_suffix[] = "_annt";
+const char WriteSetOut::zdat_suffix[] = "_zdat";
+
+
+size_t
+WriteSetOut::gather_data (WriteSetNG::GatherVector& out)
+{
+    if (zdata_) return zdata_->gather(out);
+
+    size_t const size(data_.gather(out));
+
+    if (zthr_ > 0 && size >= zthr_ &&
+        DataSetOut::compress(out, size, zbuf_))
+    {
+        zdata_ = new DataSetOut(NULL, 0, zbn_, DataSet::VER2,
+                                data_.gu::RecordSet::version());
+        zdata_->append(&zbuf_[0], zbuf_.size(), false);
+
+        out->clear();
+        return zdata_->gather(out);
+    }
+
+    return size;
+}
 
 
 void
@@ -270,7 +293,7 @@ WriteSetIn::checksum()
 
             if (header_.has_unrd())
             {
-                gu_trace(unrd_.init(dver, pptr, psize));
+                gu_trace(unrd_.init(header_.unrdset_ver(), pptr, psize));
                 gu_trace(unrd_.checksum());
                 size_t const tmpsize(unrd_.serial_size());
                 psize -= tmpsize;
@@ -281,7 +304,7 @@ WriteSetIn::checksum()
             if (header_.has_annt())
             {
                 annt_ = new DataSetIn();
-                gu_trace(annt_->init(dver, pptr, psize));
+                gu_trace(annt_->init(header_.anntset_ver(), pptr, psize));
                 // we don't care for annotation checksum - it is not a reason
                 // to throw an exception and abort execution
                 // gu_trace(annt_->checksum());
@@ -233,14 +233,15 @@ namespace galera
                 return DataSet::version((ptr_[V3_SETS_OFF] & 0x0c) >> 2);
             }
 
+            /* unordered and annotation sets are never compressed */
             DataSet::Version unrdset_ver() const
             {
-                return has_unrd() ? dataset_ver() : DataSet::EMPTY;
+                return has_unrd() ? aux_ver() : DataSet::EMPTY;
             }
 
             DataSet::Version anntset_ver() const
             {
-                return has_annt() ? dataset_ver() : DataSet::EMPTY;
+                return has_annt() ? aux_ver() : DataSet::EMPTY;
             }
 
             uint16_t         flags() const
@@ -308,6 +309,12 @@ namespace galera
 
         private:
 
+            DataSet::Version aux_ver() const
+            {
+                DataSet::Version const ver(dataset_ver());
+                return (DataSet::VER2 == ver ? DataSet::VER1 : ver);
+            }
+
             static ssize_t
             check_size (Version const           ver,
                         const gu::byte_t* const buf,
@@ -492,7 +499,8 @@ namespace galera
                      WriteSetNG::Version     ver      = WriteSetNG::MAX_VERSION,
                      DataSet::Version        dver     = DataSet::MAX_VERSION,
                      DataSet::Version        uver     = DataSet::MAX_VERSION,
-                     size_t                  max_size = WriteSetNG::MAX_SIZE)
+                     size_t                  max_size = WriteSetNG::MAX_SIZE,
+                     size_t                  zthr     = 0)
             :
             header_(ver),
             base_name_(dir_name, id),
@@ -510,6 +518,11 @@ namespace galera
             /* annotation set is not allocated unless requested */
             abn_   (base_name_),
             annt_  (NULL),
+            /* compressed data set is created on gather() if needed */
+            zbn_   (base_name_),
+            zdata_ (NULL),
+            zbuf_  (),
+            zthr_  (zthr),
             left_  (max_size - keys_.size() - data_.size() - unrd_.size()
                     - header_.size()),
             flags_ (flags)
@@ -517,7 +530,7 @@ namespace galera
             assert ((uintptr_t(reserved) % GU_WORD_BYTES) == 0);
         }
 
-        ~WriteSetOut() { delete annt_; }
+        ~WriteSetOut() { delete annt_; delete zdata_; }
 
         void append_key(const KeyData& k)
         {
@@ -572,15 +585,20 @@ namespace galera
                           + unrd_.page_count() + 1 /* global header */);
 
 
+            WriteSetNG::GatherVector dout;
+            size_t const dsize(gather_data(dout));
+            DataSetOut& data(zdata_ ? *zdata_ : data_);
+
             size_t out_size (header_.gather (keys_.version(),
-                                             data_.version(),
+                                             data.version(),
                                              unrd_.version() != DataSet::EMPTY,
                                              NULL != annt_,
                                              flags_, source, conn, trx,
                                              out));
 
             out_size += keys_.gather(out);
-            out_size += data_.gather(out);
+            out->insert(out->end(), dout->begin(), dout->end());
+            out_size += dsize;
             out_size += unrd_.gather(out);
 
             if (NULL != annt_) out_size += annt_->gather(out);
@@ -644,6 +662,7 @@ namespace galera
         static const char data_suffix[];
         static const char unrd_suffix[];
         static const char annt_suffix[];
+        static const char zdat_suffix[];
 
         WriteSetNG::Header  header_;
         BaseNameCommon      base_name_;
@@ -655,9 +674,16 @@ namespace galera
         DataSetOut          unrd_;
         BaseNameImpl<annt_suffix> abn_;
         DataSetOut*         annt_;
+        BaseNameImpl<zdat_suffix> zbn_;
+        DataSetOut*         zdata_;
+        std::vector<gu::byte_t> zbuf_;
+        size_t const        zthr_;  // data set compression threshold
         ssize_t             left_;
         uint16_t            flags_;
 
+        /* Gathers data set, compressing it if it is larger than zthr_ */
+        size_t gather_data(WriteSetNG::GatherVector& out);
+
         void check_size()
         {
             if (gu_unlikely(left_ < 0))
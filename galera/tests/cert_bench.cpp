@@ -0,0 +1,306 @@
+/*
+ * Copyright (C) 2020 Codership Oy <info@codership.com>
+ */
+
+/**
+ * This is to benchmark certification throughput (certs/sec) against the
+ * number of certification index shards (cert.index_shards).
+ *
+ * One thread certifies write sets in seqno order while a number of committer
+ * threads mark them committed and purge the index concurrently, like
+ * parallel appliers do.
+ *
+ * Write sets can be certified in batches of consecutive seqnos like the
+ * receive path does when recv queue is not empty.
+ *
+ * Usage: cert_bench [trxs] [keys per trx] [committers] [max shards] [batch]
+ */
+
+#include "certification.hpp"
+#include "replicator_smm.hpp"
+#include "galera_service_thd.hpp"
+#include "galera_gcs.hpp"
+
+#include "gu_lock.hpp"
+
+#include <sys/time.h>
+#include <iostream>
+#include <sstream>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+static double time_diff(const struct timeval& l,
+                        const struct timeval& r)
+{
+    double const left(double(l.tv_usec)*1.0e-06 + l.tv_sec);
+    double const right(double(r.tv_usec)*1.0e-06 + r.tv_sec);
+    return left - right;
+}
+
+using galera::TrxHandle;
+using galera::Certification;
+
+static TrxHandle::LocalPool
+lp(TrxHandle::LOCAL_STORAGE_SIZE(), 4, "cert_bench_local_pool");
+
+static TrxHandle::SlavePool
+sp(sizeof(TrxHandle), 1024, "cert_bench_slave_pool");
+
+namespace
+{
+    /* the same environment as in write_set_check.cpp */
+    class BenchEnv
+    {
+    public:
+
+        BenchEnv(const std::string& shards) :
+            conf_   (),
+            init_   (conf_, NULL, NULL),
+            name_   (set_gcache(conf_)),
+            gcache_ (conf_, "."),
+            gcs_    (conf_, gcache_),
+            thd_    (gcs_,  gcache_)
+        {
+            conf_.set("cert.index_shards", shards);
+        }
+
+        ~BenchEnv() { ::unlink(name_.c_str()); }
+
+        gu::Config&         conf()   { return conf_;   }
+        galera::ServiceThd& thd()    { return thd_;    }
+        gcache::GCache&     gcache() { return gcache_; }
+
+    private:
+
+        static std::string set_gcache(gu::Config& conf)
+        {
+            std::string const name("cert_bench.gcache");
+            conf.set("gcache.name", name);
+            conf.set("gcache.size", "1M");
+            return name;
+        }
+
+        gu::Config         conf_;
+        galera::ReplicatorSMM::InitConfig init_;
+        std::string const  name_;
+        gcache::GCache     gcache_;
+        galera::DummyGcs   gcs_;
+        galera::ServiceThd thd_;
+    };
+
+    /* certified trxs on their way to committers */
+    class CommitQueue
+    {
+    public:
+
+        CommitQueue() : mtx_(), cond_(), queue_(), done_(false) {}
+
+        void push(TrxHandle* trx)
+        {
+            gu::Lock lock(mtx_);
+            queue_.push_back(trx);
+            cond_.signal();
+        }
+
+        void close()
+        {
+            gu::Lock lock(mtx_);
+            done_ = true;
+            cond_.broadcast();
+        }
+
+        /* returns NULL when the queue is closed and drained */
+        TrxHandle* pop()
+        {
+            gu::Lock lock(mtx_);
+            while (queue_.empty() && !done_) lock.wait(cond_);
+            if (queue_.empty()) return NULL;
+            TrxHandle* const trx(queue_.front());
+            queue_.pop_front();
+            return trx;
+        }
+
+    private:
+
+        gu::Mutex              mtx_;
+        gu::Cond               cond_;
+        std::deque<TrxHandle*> queue_;
+        bool                   done_;
+    };
+
+    struct CommitterArgs
+    {
+        Certification& cert;
+        CommitQueue&   queue;
+    };
+}
+
+static void*
+committer_thd(void* arg)
+{
+    CommitterArgs* const args(static_cast<CommitterArgs*>(arg));
+    TrxHandle* trx;
+
+    while ((trx = args->queue.pop()) != NULL)
+    {
+        wsrep_seqno_t const purge_seqno(args->cert.set_trx_committed(trx));
+
+        if (purge_seqno >= 0) args->cert.purge_trxs_upto(purge_seqno, false);
+
+        trx->unref();
+    }
+
+    return NULL;
+}
+
+/* generates serialized write sets with random exclusive keys */
+static void
+generate(std::vector<gu::Buffer>& bufs, size_t const keys)
+{
+    int const version(3);
+    TrxHandle::Params const params("", version, galera::KeySet::MAX_VERSION);
+    wsrep_uuid_t const uuid = {{1, }};
+
+    for (size_t i(0); i < bufs.size(); ++i)
+    {
+        TrxHandle* trx(TrxHandle::New(lp, params, uuid, 1, i + 1));
+
+        for (size_t k(0); k < keys; ++k)
+        {
+            long const val(::random());
+            wsrep_buf_t const key = { &val, sizeof(val) };
+            trx->append_key(galera::KeyData(version, &key, 1,
+                                            WSREP_KEY_EXCLUSIVE, true));
+        }
+
+        galera::WriteSetNG::GatherVector out;
+        size_t const size(trx->write_set_out().gather(trx->source_id(),
+                                                      trx->conn_id(),
+                                                      trx->trx_id(),
+                                                      out));
+        /* last seen seqno is always the previous one: no conflicts */
+        trx->set_last_seen_seqno(i);
+
+        bufs[i].resize(size);
+        gu::byte_t* p(&bufs[i][0]);
+        for (size_t b(0); b < out->size(); ++b)
+        {
+            ::memcpy(p, out[b].ptr, out[b].size); p += out[b].size;
+        }
+
+        trx->unref();
+    }
+}
+
+static double
+run_bench(const std::vector<gu::Buffer>& bufs, size_t const shards,
+          size_t const committers, size_t const batch)
+{
+    std::ostringstream os;
+    os << shards;
+    BenchEnv env(os.str());
+    Certification cert(env.conf(), env.thd(), env.gcache());
+    cert.assign_initial_position(0, 3);
+
+    CommitQueue queue;
+    CommitterArgs args = { cert, queue };
+    std::vector<gu_thread_t> threads(committers);
+
+    for (size_t i(0); i < threads.size(); ++i)
+    {
+        gu_thread_create(&threads[i], NULL, committer_thd, &args);
+    }
+
+    struct timeval tv_begin, tv_end;
+    gettimeofday(&tv_begin, NULL);
+
+    std::vector<TrxHandle*> trxs(batch);
+    std::vector<Certification::TestResult> res(batch);
+
+    for (size_t i(0); i < bufs.size(); i += batch)
+    {
+        size_t const n(std::min(batch, bufs.size() - i));
+
+        for (size_t j(0); j < n; ++j)
+        {
+            trxs[j] = TrxHandle::New(sp);
+            trxs[j]->unserialize(&bufs[i + j][0], bufs[i + j].size(), 0);
+            trxs[j]->set_received(0, i + j + 1, i + j + 1);
+        }
+
+        cert.append_trxs(&trxs[0], n, &res[0]);
+
+        for (size_t j(0); j < n; ++j)
+        {
+            if (res[j] != Certification::TEST_OK)
+            {
+                std::cerr << "Unexpected certification failure" << std::endl;
+                ::abort();
+            }
+
+            queue.push(trxs[j]);
+        }
+    }
+
+    queue.close();
+
+    for (size_t i(0); i < threads.size(); ++i)
+    {
+        gu_thread_join(threads[i], NULL);
+    }
+
+    gettimeofday(&tv_end, NULL);
+
+    cert.purge_trxs_upto(bufs.size(), false);
+
+    return bufs.size() / time_diff(tv_end, tv_begin);
+}
+
+template <typename T> static void
+read_arg(char* argv[], int position, T& var)
+{
+    std::string arg(argv[position]);
+    std::istringstream is(arg);
+    is >> var;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t trxs(100000);
+    size_t keys(8);
+    size_t committers(4);
+    size_t max_shards(32);
+    size_t batch(1);
+
+    if (argc >= 2) read_arg(argv, 1, trxs);
+    if (argc >= 3) read_arg(argv, 2, keys);
+    if (argc >= 4) read_arg(argv, 3, committers);
+    if (argc >= 5) read_arg(argv, 4, max_shards);
+    if (argc >= 6) read_arg(argv, 5, batch);
+    if (batch < 1) batch = 1;
+
+    std::cout << "Running with parameters: trxs = " << trxs
+              << ", keys per trx = " << keys
+              << ", committers = " << committers
+              << ", max shards = " << max_shards
+              << ", batch = " << batch << '\n';
+
+    std::vector<gu::Buffer> bufs(trxs);
+    generate(bufs, keys);
+
+    for (size_t shards(1); shards <= max_shards; shards *= 2)
+    {
+        /* slave write sets are modified in place when received,
+         * so every run needs a fresh copy */
+        std::vector<gu::Buffer> copy(bufs);
+        double const rate(run_bench(copy, shards, committers, batch));
+        std::cout << "shards: " << shards << ", certs/sec: " << rate
+                  << std::endl;
+    }
+
+    return 0;
+}
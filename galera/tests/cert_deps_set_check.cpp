@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2020 Codership Oy <info@codership.com>
+ */
+
+#undef NDEBUG
+
+#include "../src/cert_deps_set.hpp"
+
+#include "gu_logger.hpp"
+
+#include <set>
+#include <iterator>
+#include <cstdlib>
+#include <check.h>
+
+using namespace galera;
+
+/* compares CertDepsSet against std::multiset under random
+ * insertions and removals */
+static void
+check_against_multiset(wsrep_seqno_t const spread, size_t const ops)
+{
+    CertDepsSet                  set;
+    std::multiset<wsrep_seqno_t> ref;
+    wsrep_seqno_t                base(1000000);
+
+    for (size_t i(0); i < ops; ++i)
+    {
+        if (ref.empty() || ::random() % 3)
+        {
+            /* mostly increasing with some far outliers */
+            wsrep_seqno_t const seqno(::random() % 100 ?
+                                      base + ::random() % spread :
+                                      ::random() % base);
+            set.insert(seqno);
+            ref.insert(seqno);
+            ++base;
+        }
+        else
+        {
+            std::multiset<wsrep_seqno_t>::iterator it(ref.begin());
+            std::advance(it, ::random() % ref.size());
+            set.erase(*it);
+            ref.erase(it);
+        }
+
+        ck_assert_msg(set.size() == ref.size(), "size: %zu, expected %zu",
+                      set.size(), ref.size());
+
+        if (!ref.empty())
+        {
+            ck_assert_msg(set.min() == *ref.begin(),
+                          "min: %lld, expected %lld",
+                          (long long)set.min(), (long long)*ref.begin());
+        }
+    }
+
+    while (!ref.empty())
+    {
+        set.erase(*ref.rbegin());
+        ref.erase(--ref.end());
+        if (!ref.empty()) ck_assert(set.min() == *ref.begin());
+    }
+
+    ck_assert(set.empty());
+}
+
+START_TEST(test_cert_deps_set_basic)
+{
+    CertDepsSet set;
+
+    ck_assert(set.empty());
+
+    set.insert(10);
+    set.insert(12);
+    set.insert(10);
+    set.insert(11);
+
+    ck_assert(set.size() == 4);
+    ck_assert(set.min() == 10);
+
+    set.erase(10);
+    ck_assert(set.min() == 10);
+    set.erase(10);
+    ck_assert(set.min() == 11);
+    set.erase(12);
+    ck_assert(set.min() == 11);
+
+    /* far below the ring */
+    set.insert(1);
+    ck_assert(set.min() == 1);
+    set.erase(11);
+    ck_assert(set.min() == 1);
+    ck_assert(set.size() == 1);
+    set.erase(1);
+    ck_assert(set.empty());
+
+    set.insert(5);
+    set.clear();
+    ck_assert(set.empty());
+}
+END_TEST
+
+START_TEST(test_cert_deps_set_random)
+{
+    check_against_multiset(16,    10000);
+    check_against_multiset(1024,  10000);
+}
+END_TEST
+
+Suite* cert_deps_set_suite()
+{
+    Suite* s = suite_create("cert_deps_set");
+    TCase* tc;
+
+    tc = tcase_create("test_cert_deps_set_basic");
+    tcase_add_test(tc, test_cert_deps_set_basic);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_cert_deps_set_random");
+    tcase_add_test(tc, test_cert_deps_set_random);
+    suite_add_tcase(s, tc);
+
+    return s;
+}
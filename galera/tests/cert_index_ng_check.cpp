@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2020 Codership Oy <info@codership.com>
+ */
+
+#undef NDEBUG
+
+#include "../src/cert_index_ng.hpp"
+
+#include "gu_logger.hpp"
+
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <check.h>
+
+using namespace galera;
+
+/* serialized FLAT16 key parts stored contiguously */
+class TestKeys
+{
+public:
+
+    static size_t const KEY_SIZE = 16;
+
+    TestKeys(size_t const n) : buf_(n * KEY_SIZE / sizeof(uint64_t)) {}
+
+    size_t size() const { return buf_.size() * sizeof(uint64_t) / KEY_SIZE; }
+
+    /* creates a key from two hash words */
+    void set(size_t const i, uint64_t const h0, uint64_t const h1)
+    {
+        KeySet::KeyPart::HashData hd;
+        ::memcpy(hd.buf, &h0, sizeof(h0));
+        ::memcpy(hd.buf + sizeof(h0), &h1, sizeof(h1));
+
+        KeySet::KeyPart const kp(tmp_, hd, NULL, KeySet::FLAT16,
+                                 0 /* shared */, 0, 8);
+        ::memcpy(&buf_[i * 2], tmp_.buf, KEY_SIZE);
+    }
+
+    KeySet::KeyPart operator[] (size_t const i) const
+    {
+        return KeySet::KeyPart
+            (reinterpret_cast<const gu::byte_t*>(&buf_[i * 2]), KEY_SIZE);
+    }
+
+private:
+
+    std::vector<uint64_t>     buf_;
+    KeySet::KeyPart::TmpStore tmp_;
+};
+
+START_TEST(test_cert_index_ng_basic)
+{
+    size_t const n(10000);
+    TestKeys keys(n);
+
+    for (size_t i(0); i < n; ++i)
+    {
+        keys.set(i, (uint64_t(::random()) << 32) + ::random(), i);
+    }
+
+    CertIndexNG index;
+    size_t const initial_buckets(index.bucket_count());
+
+    for (size_t i(0); i < n; ++i)
+    {
+        ck_assert(NULL == index.find(keys[i]));
+        KeyEntryNG* const ke(index.insert(keys[i]));
+        ck_assert(ke != NULL);
+        ck_assert(ke->key().matches(keys[i]));
+        ck_assert(ke->referenced() == false);
+    }
+
+    ck_assert_msg(index.size() == n, "size: %zu, expected %zu",
+                  index.size(), n);
+    ck_assert(index.bucket_count() > n);
+
+    for (size_t i(0); i < n; ++i)
+    {
+        KeyEntryNG* const ke(index.find(keys[i]));
+        ck_assert_msg(ke != NULL, "key %zu not found", i);
+        ck_assert(ke->key().matches(keys[i]));
+    }
+
+    /* erase every other key */
+    for (size_t i(0); i < n; i += 2)
+    {
+        index.erase(index.find(keys[i]));
+    }
+
+    ck_assert(index.size() == n / 2);
+
+    for (size_t i(0); i < n; ++i)
+    {
+        KeyEntryNG* const ke(index.find(keys[i]));
+
+        if (i % 2)
+        {
+            ck_assert_msg(ke != NULL, "key %zu not found", i);
+            ck_assert(ke->key().matches(keys[i]));
+        }
+        else
+        {
+            ck_assert_msg(ke == NULL, "erased key %zu found", i);
+        }
+    }
+
+    index.clear();
+    ck_assert(index.size() == 0);
+    ck_assert(index.bucket_count() == initial_buckets);
+    ck_assert(NULL == index.find(keys[1]));
+}
+END_TEST
+
+/* keys with the same hash but different second hash word are different */
+START_TEST(test_cert_index_ng_collisions)
+{
+    size_t const n(100);
+    TestKeys keys(n);
+
+    for (size_t i(0); i < n; ++i)
+    {
+        keys.set(i, GU_ULONG_LONG(0x5555555555555555), i);
+    }
+
+    CertIndexNG index;
+
+    for (size_t i(0); i < n; ++i)
+    {
+        ck_assert(NULL == index.find(keys[i]));
+        index.insert(keys[i]);
+    }
+
+    ck_assert(index.size() == n);
+
+    /* erase from the middle of the probe sequence */
+    for (size_t i(n/4); i < n/2; ++i)
+    {
+        index.erase(index.find(keys[i]));
+    }
+
+    ck_assert(index.size() == n - n/4);
+
+    for (size_t i(0); i < n; ++i)
+    {
+        KeyEntryNG* const ke(index.find(keys[i]));
+
+        if (i >= n/4 && i < n/2)
+        {
+            ck_assert_msg(ke == NULL, "erased key %zu found", i);
+        }
+        else
+        {
+            ck_assert_msg(ke != NULL, "key %zu not found", i);
+            ck_assert(ke->key().matches(keys[i]));
+        }
+    }
+}
+END_TEST
+
+Suite* cert_index_ng_suite()
+{
+    Suite* s = suite_create("cert_index_ng");
+    TCase* tc;
+
+    tc = tcase_create("test_cert_index_ng_basic");
+    tcase_add_test(tc, test_cert_index_ng_basic);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_cert_index_ng_collisions");
+    tcase_add_test(tc, test_cert_index_ng_collisions);
+    suite_add_tcase(s, tc);
+
+    return s;
+}
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2020 Codership Oy <info@codership.com>
+ */
+
+/**
+ * This is to benchmark certification trx map and deps set maintenance
+ * with std::map/std::multiset (before) against gu::DeqMap/CertDepsSet
+ * (after).
+ *
+ * For every trx it is appended to trx map and its last seen seqno to deps
+ * set, then trxs are committed slightly out of order, as parallel appliers
+ * do, with safe-to-discard seqno lookup on every commit, and trx map is
+ * purged every 128 trxs. Results are reported as trxs/sec and as a fraction
+ * of a CPU core needed to sustain 100K trx/s.
+ *
+ * Usage: cert_map_bench [trxs] [commit window] [cert interval]
+ */
+
+#define NDEBUG 1
+
+#include "cert_deps_set.hpp"
+
+#include "gu_deqmap.hpp"
+
+#include <sys/time.h>
+#include <iostream>
+#include <sstream>
+#include <map>
+#include <set>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+static double time_diff(const struct timeval& l,
+                        const struct timeval& r)
+{
+    double const left(double(l.tv_usec)*1.0e-06 + l.tv_sec);
+    double const right(double(r.tv_usec)*1.0e-06 + r.tv_sec);
+    return left - right;
+}
+
+typedef wsrep_seqno_t Seqno;
+
+/* a stand-in for TrxHandle* which is never dereferenced */
+typedef const void* Trx;
+
+class StdMaps
+{
+public:
+
+    static const char* name() { return "std::map/std::multiset"; }
+
+    StdMaps() : trx_map_(), deps_set_(), safe_(-1) {}
+
+    void append(Seqno const seqno, Seqno const last_seen)
+    {
+        trx_map_.insert(std::make_pair(seqno, Trx(&trx_map_)));
+        deps_set_.insert(last_seen);
+    }
+
+    Seqno commit(Seqno const last_seen)
+    {
+        deps_set_.erase(deps_set_.find(last_seen));
+        if (deps_set_.empty()) safe_ = last_seen;
+        return deps_set_.empty() ? safe_ : *deps_set_.begin() - 1;
+    }
+
+    void purge(Seqno const seqno)
+    {
+        trx_map_.erase(trx_map_.begin(), trx_map_.upper_bound(seqno));
+    }
+
+    size_t size() const { return trx_map_.size(); }
+
+private:
+
+    std::map<Seqno, Trx>    trx_map_;
+    std::multiset<Seqno>    deps_set_;
+    Seqno                   safe_;
+};
+
+class RingMaps
+{
+public:
+
+    static const char* name() { return "gu::DeqMap/CertDepsSet"; }
+
+    RingMaps() : trx_map_(0), deps_set_(), safe_(-1) {}
+
+    void append(Seqno const seqno, Seqno const last_seen)
+    {
+        trx_map_.insert(seqno, Trx(&trx_map_));
+        deps_set_.insert(last_seen);
+    }
+
+    Seqno commit(Seqno const last_seen)
+    {
+        deps_set_.erase(last_seen);
+        if (deps_set_.empty()) safe_ = last_seen;
+        return deps_set_.empty() ? safe_ : deps_set_.min() - 1;
+    }
+
+    void purge(Seqno const seqno)
+    {
+        trx_map_.erase(trx_map_.begin(),
+                       trx_map_.begin() + (trx_map_.upper_bound(seqno) -
+                                           trx_map_.index_begin()));
+    }
+
+    size_t size() const { return trx_map_.size(); }
+
+private:
+
+    gu::DeqMap<Seqno, Trx> trx_map_;
+    galera::CertDepsSet    deps_set_;
+    Seqno                  safe_;
+};
+
+template <class Maps> static double
+run_bench(const std::vector<Seqno>& last_seen,
+          const std::vector<size_t>& commit_order)
+{
+    Maps  maps;
+    Seqno safe(-1);
+    size_t const window(commit_order.size());
+
+    struct timeval tv_begin, tv_end;
+    gettimeofday(&tv_begin, NULL);
+
+    for (size_t i(0); i < last_seen.size(); ++i)
+    {
+        Seqno const seqno(i + 1);
+
+        maps.append(seqno, last_seen[i]);
+
+        /* commit a window of trxs in shuffled order once it is full */
+        if (0 == seqno % window)
+        {
+            for (size_t c(0); c < window; ++c)
+            {
+                size_t const idx(i + 1 - window + commit_order[c]);
+                safe = maps.commit(last_seen[idx]);
+            }
+        }
+
+        if (0 == seqno % 128 && safe > 0) maps.purge(safe);
+    }
+
+    gettimeofday(&tv_end, NULL);
+
+    double const rate(last_seen.size() / time_diff(tv_end, tv_begin));
+
+    std::cout << Maps::name() << ": trxs/sec: " << rate
+              << ", CPU share at 100K trx/s: " << 100000.0 / rate
+              << " (trx map size " << maps.size() << ")" << std::endl;
+
+    return rate;
+}
+
+template <typename T> static void
+read_arg(char* argv[], int position, T& var)
+{
+    std::string arg(argv[position]);
+    std::istringstream is(arg);
+    is >> var;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t trxs(1000000);
+    size_t window(8);
+    size_t interval(16);
+
+    if (argc >= 2) read_arg(argv, 1, trxs);
+    if (argc >= 3) read_arg(argv, 2, window);
+    if (argc >= 4) read_arg(argv, 3, interval);
+
+    if (window   < 1) window   = 1;
+    if (interval < 1) interval = 1;
+    trxs -= trxs % window;
+
+    std::cout << "Running with parameters: trxs = " << trxs
+              << ", commit window = " << window
+              << ", cert interval = " << interval << '\n';
+
+    std::vector<Seqno> last_seen(trxs);
+    for (size_t i(0); i < trxs; ++i)
+    {
+        Seqno const seqno(i + 1);
+        last_seen[i] = std::max<Seqno>(0, seqno - 1 - ::random() % interval);
+    }
+
+    std::vector<size_t> commit_order(window);
+    for (size_t c(0); c < window; ++c) commit_order[c] = c;
+    std::random_shuffle(commit_order.begin(), commit_order.end());
+
+    double const before(run_bench<StdMaps>(last_seen, commit_order));
+    double const after (run_bench<RingMaps>(last_seen, commit_order));
+
+    std::cout << "speedup: " << after / before << std::endl;
+
+    return 0;
+}
@@ -28,8 +28,13 @@ static const char* Defaults[] =
 {
     "base_dir",                    ".",
     "base_port",                   "4567",
+    "cert.index_shards",           "8",
     "cert.log_conflicts",          "no",
     "cert.optimistic_pa",          "yes",
+    "cert.purge_bytes_threshold",  "128M",
+    "cert.purge_keys_threshold",   "1024",
+    "cert.purge_slice",            "PT0.001S",
+    "cert.purge_trxs_threshold",   "127",
     "debug",                       "no",
 #ifdef GU_DBUG_ON
     "dbug",                        "",
@@ -58,12 +63,15 @@ static const char* Defaults[] =
 #endif
     "gcache.dir",                  ".",
     "gcache.freeze_purge_at_seqno","-1",
+    "gcache.huge_pages",           "no",
     "gcache.keep_pages_size",      "0",
     "gcache.keep_pages_count",     "0",
     "gcache.mem_size",             "0",
     "gcache.name",                 "./galera.cache",
+    "gcache.numa_node",            "-1",
     "gcache.page_size",            "128M",
     "gcache.recover",              "no",
+    "gcache.seqno_index",          "no",
     "gcache.size",                 "128M",
     "gcomm.thread_prio",           "",
     "gcs.fc_debug",                "0",
@@ -99,12 +107,17 @@ static const char* Defaults[] =
     "pc.wait_prim_timeout",        "PT30S",
     "pc.weight",                   "1",
     "protonet.backend",            "asio",
+    "protonet.threads",            "1",
     "protonet.version",            "0",
     "repl.causal_read_timeout",    "PT30S",
     "repl.commit_order",           "3",
     "repl.key_format",             "FLAT8",
+    "repl.max_cert_batch",         "16",
+    "repl.max_monitor_window",     "65536",
     "repl.max_ws_size",            "2147483647",
-    "repl.proto_max",              "9",
+    "repl.pa_graph",               "no",
+    "repl.proto_max",              "10",
+    "repl.ws_compression_threshold", "0",
 #ifdef GU_DBUG_ON
     "signal",                      "",
 #endif
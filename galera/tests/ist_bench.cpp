@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2020 Codership Oy <info@codership.com>
+ */
+
+/**
+ * This is to benchmark IST throughput over loopback against the number of
+ * sender connections (ist.send_streams), with and without SSL.
+ *
+ * Sender gcache is populated with write sets of the given payload size,
+ * then the whole range is transferred to a receiver which has the given
+ * number of applier threads taking write sets from it. Results are reported
+ * as write sets/sec and MB/sec.
+ *
+ * SSL runs are done only if a directory with galera_key.pem,
+ * galera_cert.pem and galera_ca.pem (like tests/conf) is given.
+ *
+ * Usage: ist_bench [trxs] [payload size] [max streams] [appliers] [ssl dir]
+ */
+
+#include "ist.hpp"
+#include "replicator_smm.hpp"
+#include "write_set_ng.hpp"
+
+#include "GCache.hpp"
+#include "gu_asio.hpp"
+
+#include <sys/time.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <cstring>
+#include <unistd.h>
+
+static double time_diff(const struct timeval& l,
+                        const struct timeval& r)
+{
+    double const left(double(l.tv_usec)*1.0e-06 + l.tv_sec);
+    double const right(double(r.tv_usec)*1.0e-06 + r.tv_sec);
+    return left - right;
+}
+
+using galera::TrxHandle;
+
+/* IST protocol version and corresponding write set version */
+static int const ist_version(5);
+static int const trx_version(3);
+
+static TrxHandle::LocalPool
+lp(TrxHandle::LOCAL_STORAGE_SIZE(), 4, "ist_bench_local_pool");
+
+static TrxHandle::SlavePool
+sp(sizeof(TrxHandle), 1024, "ist_bench_slave_pool");
+
+namespace
+{
+    class BenchConfig
+    {
+    public:
+
+        BenchConfig(const std::string& gcache_name, size_t gcache_size,
+                    const std::string& ssl_dir)
+            :
+            conf_(),
+            init_(conf_, NULL, NULL)
+        {
+            std::ostringstream os;
+            os << gcache_size;
+            conf_.set("gcache.name", gcache_name);
+            conf_.set("gcache.size", os.str());
+
+            if (!ssl_dir.empty())
+            {
+                conf_.set(gu::conf::ssl_key,  ssl_dir + "/galera_key.pem");
+                conf_.set(gu::conf::ssl_cert, ssl_dir + "/galera_cert.pem");
+                conf_.set(gu::conf::ssl_ca,   ssl_dir + "/galera_ca.pem");
+                gu::ssl_init_options(conf_);
+            }
+        }
+
+        gu::Config& operator()() { return conf_; }
+
+    private:
+
+        gu::Config                        conf_;
+        galera::ReplicatorSMM::InitConfig init_;
+    };
+
+    struct SenderArgs
+    {
+        gu::Config&     conf;
+        gcache::GCache& gcache;
+        std::string     peer;
+        wsrep_seqno_t   last;
+    };
+
+    struct ApplierArgs
+    {
+        galera::ist::Receiver& receiver;
+    };
+}
+
+static void*
+sender_thd(void* arg)
+{
+    SenderArgs* const args(static_cast<SenderArgs*>(arg));
+
+    try
+    {
+        args->gcache.seqno_lock(1); // unlocked in sender dtor
+        galera::ist::Sender sender(args->conf, args->gcache, args->peer,
+                                   ist_version);
+        sender.send(1, args->last);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "IST sender failed: " << e.what() << std::endl;
+        ::abort();
+    }
+
+    return NULL;
+}
+
+static void*
+applier_thd(void* arg)
+{
+    ApplierArgs* const args(static_cast<ApplierArgs*>(arg));
+    TrxHandle* trx;
+
+    while (args->receiver.recv(&trx) == 0)
+    {
+        trx->unref();
+    }
+
+    return NULL;
+}
+
+/* populates gcache with the given number of write sets */
+static void
+populate(gcache::GCache& gcache, wsrep_seqno_t const trxs,
+         size_t const payload)
+{
+    TrxHandle::Params const params("", trx_version,
+                                   galera::KeySet::MAX_VERSION);
+    wsrep_uuid_t const uuid = {{1, }};
+    std::vector<char> data(payload, 'x');
+
+    for (wsrep_seqno_t i(1); i <= trxs; ++i)
+    {
+        TrxHandle* trx(TrxHandle::New(lp, params, uuid, 1, i));
+
+        wsrep_buf_t const key = { &i, sizeof(i) };
+        trx->append_key(galera::KeyData(trx_version, &key, 1,
+                                        WSREP_KEY_EXCLUSIVE, true));
+        trx->append_data(&data[0], data.size(), WSREP_DATA_ORDERED, true);
+
+        galera::WriteSetNG::GatherVector out;
+        ssize_t const size(trx->write_set_out().gather(trx->source_id(),
+                                                       trx->conn_id(),
+                                                       trx->trx_id(),
+                                                       out));
+        trx->set_last_seen_seqno(i - 1);
+
+        gu::byte_t* const ptr(static_cast<gu::byte_t*>(gcache.malloc(size)));
+        gu::byte_t* p(ptr);
+        for (size_t b(0); b < out->size(); ++b)
+        {
+            ::memcpy(p, out[b].ptr, out[b].size); p += out[b].size;
+        }
+
+        gu::Buf ws_buf = { ptr, size };
+        galera::WriteSetIn wsi(ws_buf);
+        wsi.set_seqno(i, 1);
+
+        gcache.seqno_assign(ptr, i, i - 1);
+        trx->unref();
+    }
+}
+
+static double
+run_bench(gcache::GCache& gcache, wsrep_seqno_t const trxs,
+          size_t const gcache_size, int const streams, size_t const appliers,
+          const std::string& ssl_dir)
+{
+    std::string const recv_name("ist_bench_recv.gcache");
+
+    BenchConfig recv_conf(recv_name, gcache_size, ssl_dir);
+    recv_conf().set(galera::ist::Receiver::RECV_ADDR,
+                    ssl_dir.empty() ? "tcp://127.0.0.1:0" :
+                    "ssl://127.0.0.1:0");
+
+    gcache::GCache recv_gcache(recv_conf(), ".");
+    galera::ist::Receiver receiver(recv_conf(), recv_gcache, sp, NULL);
+
+    BenchConfig send_conf("", 0, ssl_dir);
+    std::ostringstream os;
+    os << streams;
+    send_conf().set("ist.send_streams", os.str());
+
+    struct timeval tv_begin, tv_end;
+    gettimeofday(&tv_begin, NULL);
+
+    SenderArgs sargs = { send_conf(), gcache,
+                         receiver.prepare(1, trxs, ist_version), trxs };
+    receiver.ready();
+
+    ApplierArgs aargs = { receiver };
+    std::vector<gu_thread_t> threads(appliers);
+    for (size_t i(0); i < threads.size(); ++i)
+    {
+        gu_thread_create(&threads[i], NULL, applier_thd, &aargs);
+    }
+
+    gu_thread_t sender;
+    gu_thread_create(&sender, NULL, sender_thd, &sargs);
+
+    for (size_t i(0); i < threads.size(); ++i)
+    {
+        gu_thread_join(threads[i], NULL);
+    }
+
+    gettimeofday(&tv_end, NULL);
+
+    gu_thread_join(sender, NULL);
+
+    if (receiver.finished() != trxs)
+    {
+        std::cerr << "IST receiver did not get all write sets" << std::endl;
+        ::abort();
+    }
+
+    ::unlink(recv_name.c_str());
+
+    return trxs / time_diff(tv_end, tv_begin);
+}
+
+template <typename T> static void
+read_arg(char* argv[], int position, T& var)
+{
+    std::string arg(argv[position]);
+    std::istringstream is(arg);
+    is >> var;
+}
+
+int main(int argc, char* argv[])
+{
+    wsrep_seqno_t trxs(50000);
+    size_t        payload(1024);
+    int           max_streams(4);
+    size_t        appliers(4);
+    std::string   ssl_dir;
+
+    if (argc >= 2) read_arg(argv, 1, trxs);
+    if (argc >= 3) read_arg(argv, 2, payload);
+    if (argc >= 4) read_arg(argv, 3, max_streams);
+    if (argc >= 5) read_arg(argv, 4, appliers);
+    if (argc >= 6) ssl_dir = argv[5];
+    if (appliers < 1) appliers = 1;
+
+    std::cout << "Running with parameters: trxs = " << trxs
+              << ", payload size = " << payload
+              << ", max streams = " << max_streams
+              << ", appliers = " << appliers
+              << ", ssl dir = " << (ssl_dir.empty() ? "none" : ssl_dir)
+              << '\n';
+
+    /* room for all write sets in the ring buffer on both sides */
+    size_t const gcache_size((payload + 256) * trxs * 2 + (1 << 20));
+    std::string const send_name("ist_bench.gcache");
+
+    BenchConfig conf(send_name, gcache_size, "");
+    gcache::GCache gcache(conf(), ".");
+    populate(gcache, trxs, payload);
+
+    for (int ssl(0); ssl <= (ssl_dir.empty() ? 0 : 1); ++ssl)
+    {
+        for (int streams(1); streams <= max_streams; streams *= 2)
+        {
+            double const rate(run_bench(gcache, trxs, gcache_size, streams,
+                                        appliers, ssl ? ssl_dir : ""));
+            std::cout << (ssl ? "ssl" : "tcp") << ", streams: " << streams
+                      << ", trxs/sec: " << rate
+                      << ", MB/sec: " << rate * payload / (1 << 20)
+                      << std::endl;
+        }
+    }
+
+    ::unlink(send_name.c_str());
+
+    return 0;
+}
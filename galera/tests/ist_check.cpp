@@ -78,6 +78,8 @@ public:
     {
         return (last_left >= trx_.depends_seqno());
     }
+
+    wsrep_seqno_t blocked_by() const { return WSREP_SEQNO_UNDEFINED; }
 #ifdef GU_DBUG_ON
     void debug_sync(gu::Mutex&) { }
 #ifdef HAVE_PSI_INTERFACE
@@ -95,16 +97,20 @@ struct sender_args
     wsrep_seqno_t first_;
     wsrep_seqno_t last_;
     int version_;
+    int streams_;
+    bool compress_;
     sender_args(gcache::GCache& gcache,
                 const std::string& peer,
                 wsrep_seqno_t first, wsrep_seqno_t last,
-                int version)
+                int version, int streams, bool compress)
         :
         gcache_(gcache),
         peer_  (peer),
         first_ (first),
         last_  (last),
-        version_(version)
+        version_(version),
+        streams_(streams),
+        compress_(compress)
     { }
 };
 
@@ -115,17 +121,20 @@ struct receiver_args
     wsrep_seqno_t first_;
     wsrep_seqno_t last_;
     size_t        n_receivers_;
+    gcache::GCache&       gcache_;
     TrxHandle::SlavePool& trx_pool_;
     int           version_;
 
     receiver_args(const std::string listen_addr,
                   wsrep_seqno_t first, wsrep_seqno_t last,
-                  size_t n_receivers, TrxHandle::SlavePool& sp, int version)
+                  size_t n_receivers, gcache::GCache& gcache,
+                  TrxHandle::SlavePool& sp, int version)
         :
         listen_addr_(listen_addr),
         first_      (first),
         last_       (last),
         n_receivers_(n_receivers),
+        gcache_     (gcache),
         trx_pool_   (sp),
         version_    (version)
     { }
@@ -155,6 +164,8 @@ extern "C" void* sender_thd(void* arg)
 
     gu::Config conf;
     galera::ReplicatorSMM::InitConfig(conf, NULL, NULL);
+    conf.set("ist.send_streams", sargs->streams_);
+    conf.set("ist.compression", sargs->compress_);
     gu_barrier_wait(&start_barrier);
     sargs->gcache_.seqno_lock(sargs->first_); // unlocked in sender dtor
     galera::ist::Sender sender(conf, sargs->gcache_, sargs->peer_,
@@ -200,7 +211,7 @@ extern "C" void* receiver_thd(void* arg)
     mark_point();
 
     conf.set(galera::ist::Receiver::RECV_ADDR, rargs->listen_addr_);
-    galera::ist::Receiver receiver(conf, rargs->trx_pool_, 0);
+    galera::ist::Receiver receiver(conf, rargs->gcache_, rargs->trx_pool_, 0);
     rargs->listen_addr_ = receiver.prepare(rargs->first_, rargs->last_,
                                            rargs->version_);
 
@@ -248,7 +259,9 @@ static int select_trx_version(int protocol_version)
 }
 
 
-static void test_ist_common(int const version)
+static void test_ist_common(int const version, int const streams = 1,
+                            wsrep_seqno_t const n_trx = 10,
+                            bool const compress = false)
 {
     using galera::KeyData;
     using galera::TrxHandle;
@@ -272,10 +285,14 @@ static void test_ist_common(int const version)
 
     gcache::GCache* gcache = new gcache::GCache(conf, dir);
 
+    std::string recv_gcache_file("ist_check_recv.cache");
+    conf.set("gcache.name", recv_gcache_file);
+    gcache::GCache* recv_gcache = new gcache::GCache(conf, dir);
+
     mark_point();
 
     // populate gcache
-    for (size_t i(1); i <= 10; ++i)
+    for (wsrep_seqno_t i(1); i <= n_trx; ++i)
     {
         TrxHandle* trx(TrxHandle::New(lp, trx_params, uuid, 1234+i, 5678+i));
 
@@ -332,8 +349,10 @@ static void test_ist_common(int const version)
 
     mark_point();
 
-    receiver_args rargs(receiver_addr, 1, 10, 1, sp, version);
-    sender_args sargs(*gcache, rargs.listen_addr_, 1, 10, version);
+    receiver_args rargs(receiver_addr, 1, n_trx, 1, *recv_gcache, sp,
+                        version);
+    sender_args sargs(*gcache, rargs.listen_addr_, 1, n_trx, version, streams,
+                      compress);
 
     gu_barrier_init(&start_barrier, 0, 1 + 1 + rargs.n_receivers_);
 
@@ -350,9 +369,24 @@ static void test_ist_common(int const version)
 
     mark_point();
 
+    // received write sets must have been stored in receiver gcache
+    ck_assert(recv_gcache->seqno_min()  == 1);
+    ck_assert(recv_gcache->seqno_last() == n_trx);
+    for (wsrep_seqno_t i(1); i <= n_trx; ++i)
+    {
+        gcache::seqno_t seqno_d, orig_seqno_d;
+        ssize_t         size, orig_size;
+        (void)recv_gcache->seqno_get_ptr(i, seqno_d, size);
+        (void)gcache->seqno_get_ptr(i, orig_seqno_d, orig_size);
+        ck_assert(seqno_d == orig_seqno_d);
+        ck_assert(size == orig_size);
+    }
+
+    delete recv_gcache;
     delete gcache;
 
     mark_point();
+    unlink(recv_gcache_file.c_str());
     unlink(gcache_file.c_str());
 }
 
@@ -390,6 +424,22 @@ START_TEST(test_ist_v5)
 }
 END_TEST
 
+START_TEST(test_ist_streams)
+{
+    // enough write sets for several chunks per connection
+    test_ist_common(5, 3, 1000);
+}
+END_TEST
+
+START_TEST(test_ist_compression)
+{
+    test_ist_common(5, 1, 100, true);
+    test_ist_common(5, 2, 1000, true);
+    // receiver does not support compression in v3, must fall back
+    test_ist_common(3, 1, 10, true);
+}
+END_TEST
+
 Suite* ist_suite()
 {
     Suite* s  = suite_create("ist");
@@ -424,5 +474,15 @@ Suite* ist_suite()
     tcase_add_test(tc, test_ist_v5);
     suite_add_tcase(s, tc);
 
+    tc = tcase_create("test_ist_streams");
+    tcase_set_timeout(tc, 60);
+    tcase_add_test(tc, test_ist_streams);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_ist_compression");
+    tcase_set_timeout(tc, 60);
+    tcase_add_test(tc, test_ist_compression);
+    suite_add_tcase(s, tc);
+
     return s;
 }
@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2020 Codership Oy <info@codership.com>
+ */
+
+/**
+ * This is to benchmark IST sender write path with small write sets:
+ * one write per write set against write sets gathered into batches of
+ * ist.send_batch_size bytes.
+ *
+ * Write sets from gcache are sent over loopback TCP connection to a thread
+ * which discards them. Socket write calls (each is a single sendmsg()) are
+ * counted and reported per write set together with write sets/sec.
+ *
+ * Usage: ist_send_bench [trxs] [payload size] [batch size]
+ */
+
+#include "gu_asio.hpp" // must come before ist_proto.hpp
+
+#include "ist_proto.hpp"
+#include "write_set_ng.hpp"
+#include "replicator_smm.hpp"
+
+#include "GCache.hpp"
+
+#include <sys/time.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <cstring>
+#include <unistd.h>
+
+static double time_diff(const struct timeval& l,
+                        const struct timeval& r)
+{
+    double const left(double(l.tv_usec)*1.0e-06 + l.tv_sec);
+    double const right(double(r.tv_usec)*1.0e-06 + r.tv_sec);
+    return left - right;
+}
+
+using galera::TrxHandle;
+
+static int const ist_version(5);
+static int const trx_version(3);
+
+static TrxHandle::LocalPool
+lp(TrxHandle::LOCAL_STORAGE_SIZE(), 4, "ist_send_bench_local_pool");
+
+namespace
+{
+    /* counts write_some() calls of the underlying stream */
+    template <class ST>
+    class CountingStream
+    {
+    public:
+
+        explicit CountingStream(ST& stream) : stream_(stream), calls_(0) {}
+
+        template <class CB>
+        size_t write_some(const CB& bufs)
+        {
+            ++calls_;
+            return stream_.write_some(bufs);
+        }
+
+        template <class CB>
+        size_t write_some(const CB& bufs, asio::error_code& ec)
+        {
+            ++calls_;
+            return stream_.write_some(bufs, ec);
+        }
+
+        long long calls() const { return calls_; }
+
+    private:
+
+        ST&       stream_;
+        long long calls_;
+    };
+
+    struct Drain
+    {
+        asio::ip::tcp::socket* socket;
+        long long              bytes;
+    };
+}
+
+static void*
+drain_thd(void* arg)
+{
+    Drain* const d(static_cast<Drain*>(arg));
+    std::vector<char> buf(1 << 20);
+
+    try
+    {
+        for (;;)
+        {
+            d->bytes += d->socket->read_some(asio::buffer(&buf[0],
+                                                          buf.size()));
+        }
+    }
+    catch (asio::system_error&) { } // EOF
+
+    return NULL;
+}
+
+/* populates gcache with the given number of write sets */
+static void
+populate(gcache::GCache& gcache, wsrep_seqno_t const trxs,
+         size_t const payload)
+{
+    TrxHandle::Params const params("", trx_version,
+                                   galera::KeySet::MAX_VERSION);
+    wsrep_uuid_t const uuid = {{1, }};
+    std::vector<char> data(payload, 'x');
+
+    for (wsrep_seqno_t i(1); i <= trxs; ++i)
+    {
+        TrxHandle* trx(TrxHandle::New(lp, params, uuid, 1, i));
+
+        wsrep_buf_t const key = { &i, sizeof(i) };
+        trx->append_key(galera::KeyData(trx_version, &key, 1,
+                                        WSREP_KEY_EXCLUSIVE, true));
+        trx->append_data(&data[0], data.size(), WSREP_DATA_ORDERED, true);
+
+        galera::WriteSetNG::GatherVector out;
+        ssize_t const size(trx->write_set_out().gather(trx->source_id(),
+                                                       trx->conn_id(),
+                                                       trx->trx_id(),
+                                                       out));
+        trx->set_last_seen_seqno(i - 1);
+
+        gu::byte_t* const ptr(static_cast<gu::byte_t*>(gcache.malloc(size)));
+        gu::byte_t* p(ptr);
+        for (size_t b(0); b < out->size(); ++b)
+        {
+            ::memcpy(p, out[b].ptr, out[b].size); p += out[b].size;
+        }
+
+        gu::Buf ws_buf = { ptr, size };
+        galera::WriteSetIn wsi(ws_buf);
+        wsi.set_seqno(i, 1);
+
+        gcache.seqno_assign(ptr, i, i - 1);
+        trx->unref();
+    }
+}
+
+static void
+run_bench(gcache::GCache& gcache, wsrep_seqno_t const trxs,
+          size_t const batch_max)
+{
+    asio::io_service        io_service;
+    asio::ip::tcp::acceptor acceptor(io_service,
+        asio::ip::tcp::endpoint(asio::ip::address::from_string("127.0.0.1"),
+                                0));
+    asio::ip::tcp::socket   sender(io_service);
+    asio::ip::tcp::socket   receiver(io_service);
+
+    sender.connect(acceptor.local_endpoint());
+    acceptor.accept(receiver);
+
+    Drain drain = { &receiver, 0 };
+    gu_thread_t thd;
+    gu_thread_create(&thd, NULL, drain_thd, &drain);
+
+    TrxHandle::SlavePool unused(1, 0, "");
+    galera::ist::Proto p(unused, ist_version, true);
+    CountingStream<asio::ip::tcp::socket> stream(sender);
+    std::vector<gcache::GCache::Buffer> buf_vec(1024);
+
+    struct timeval tv_begin, tv_end;
+    gettimeofday(&tv_begin, NULL);
+
+    /* same as ist::Sender::send_range() */
+    for (wsrep_seqno_t seqno(1); seqno <= trxs; )
+    {
+        ssize_t const n_read(gcache.seqno_get_buffers(buf_vec, seqno));
+
+        for (ssize_t i(0); i < n_read; ++i)
+        {
+            p.add_trx(buf_vec[i]);
+            if (p.batch_size() >= batch_max) p.send_batch(stream);
+        }
+
+        seqno += n_read;
+    }
+
+    p.send_batch(stream);
+
+    sender.shutdown(asio::ip::tcp::socket::shutdown_send);
+    gu_thread_join(thd, NULL);
+
+    gettimeofday(&tv_end, NULL);
+
+    std::cout << "batch size: " << batch_max
+              << ", trxs/sec: " << trxs / time_diff(tv_end, tv_begin)
+              << ", writes/trx: " << double(stream.calls()) / trxs
+              << ", bytes received: " << drain.bytes
+              << std::endl;
+}
+
+template <typename T> static void
+read_arg(char* argv[], int position, T& var)
+{
+    std::string arg(argv[position]);
+    std::istringstream is(arg);
+    is >> var;
+}
+
+int main(int argc, char* argv[])
+{
+    wsrep_seqno_t trxs(200000);
+    size_t        payload(200);
+    size_t        batch(256 << 10);
+
+    if (argc >= 2) read_arg(argv, 1, trxs);
+    if (argc >= 3) read_arg(argv, 2, payload);
+    if (argc >= 4) read_arg(argv, 3, batch);
+
+    std::cout << "Running with parameters: trxs = " << trxs
+              << ", payload size = " << payload
+              << ", batch size = " << batch << '\n';
+
+    std::string const name("ist_send_bench.gcache");
+    std::ostringstream size;
+    size << (payload + 256) * trxs + (1 << 20);
+
+    gu::Config conf;
+    galera::ReplicatorSMM::InitConfig(conf, NULL, NULL);
+    conf.set("gcache.name", name);
+    conf.set("gcache.size", size.str());
+
+    gcache::GCache gcache(conf, ".");
+    populate(gcache, trxs, payload);
+    gcache.seqno_lock(1);
+
+    run_bench(gcache, trxs, 0);     // write per write set
+    run_bench(gcache, trxs, batch); // gathered writes
+
+    gcache.seqno_unlock();
+    ::unlink(name.c_str());
+
+    return 0;
+}
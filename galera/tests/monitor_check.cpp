@@ -0,0 +1,689 @@
+/*
+ * Copyright (C) 2020 Codership Oy <info@codership.com>
+ */
+
+#undef NDEBUG
+
+#include "../src/monitor.hpp"
+
+#include "gu_atomic.hpp"
+#include "gu_threads.h"
+
+#include <set>
+#include <vector>
+#include <cstdlib>
+#include <unistd.h>
+#include <check.h>
+
+using namespace galera;
+
+namespace
+{
+
+/* strictly ordered by default, may enter out of order if depends is lower */
+class TestOrder
+{
+public:
+
+    TestOrder(wsrep_seqno_t const seqno, wsrep_seqno_t const depends)
+        : seqno_(seqno), depends_(depends)
+    { }
+
+    explicit TestOrder(wsrep_seqno_t const seqno)
+        : seqno_(seqno), depends_(seqno - 1)
+    { }
+
+    void lock()   { }
+    void unlock() { }
+
+    wsrep_seqno_t seqno()   const { return seqno_;   }
+    wsrep_seqno_t depends() const { return depends_; }
+
+    bool condition(wsrep_seqno_t last_entered,
+                   wsrep_seqno_t last_left) const
+    {
+        return (last_left >= depends_);
+    }
+
+    wsrep_seqno_t blocked_by() const { return WSREP_SEQNO_UNDEFINED; }
+
+#ifdef GU_DBUG_ON
+#ifdef HAVE_PSI_INTERFACE
+    void debug_sync(gu::MutexWithPFS&) { }
+#else
+    void debug_sync(gu::Mutex&) { }
+#endif /* HAVE_PSI_INTERFACE */
+#endif // GU_DBUG_ON
+
+private:
+
+    wsrep_seqno_t const seqno_;
+    wsrep_seqno_t const depends_;
+};
+
+class TestMonitor : public Monitor<TestOrder>
+{
+public:
+#ifdef HAVE_PSI_INTERFACE
+    TestMonitor() : Monitor<TestOrder>(WSREP_PFS_INSTR_TAG_APPLY_MONITOR_MUTEX,
+                                       WSREP_PFS_INSTR_TAG_APPLY_MONITOR_CONDVAR)
+    { }
+#else
+    TestMonitor() : Monitor<TestOrder>() { }
+#endif /* HAVE_PSI_INTERFACE */
+};
+
+/* may enter once all up to base and a specific dependency have left */
+class GraphOrder
+{
+public:
+
+    GraphOrder(wsrep_seqno_t const seqno, wsrep_seqno_t const base,
+               wsrep_seqno_t const dep, const Monitor<GraphOrder>& mon)
+        : seqno_(seqno), base_(base), dep_(dep), mon_(mon)
+    { }
+
+    void lock()   { }
+    void unlock() { }
+
+    wsrep_seqno_t seqno() const { return seqno_; }
+
+    bool condition(wsrep_seqno_t last_entered,
+                   wsrep_seqno_t last_left) const
+    {
+        return (last_left >= base_ && mon_.has_left(dep_));
+    }
+
+    wsrep_seqno_t blocked_by() const
+    {
+        return (mon_.has_left(dep_) ? WSREP_SEQNO_UNDEFINED : dep_);
+    }
+
+#ifdef GU_DBUG_ON
+#ifdef HAVE_PSI_INTERFACE
+    void debug_sync(gu::MutexWithPFS&) { }
+#else
+    void debug_sync(gu::Mutex&) { }
+#endif /* HAVE_PSI_INTERFACE */
+#endif // GU_DBUG_ON
+
+private:
+
+    wsrep_seqno_t const        seqno_;
+    wsrep_seqno_t const        base_;
+    wsrep_seqno_t const        dep_;
+    const Monitor<GraphOrder>& mon_;
+};
+
+class GraphMonitor : public Monitor<GraphOrder>
+{
+public:
+#ifdef HAVE_PSI_INTERFACE
+    GraphMonitor()
+        : Monitor<GraphOrder>(WSREP_PFS_INSTR_TAG_APPLY_MONITOR_MUTEX,
+                              WSREP_PFS_INSTR_TAG_APPLY_MONITOR_CONDVAR)
+    { }
+#else
+    GraphMonitor() : Monitor<GraphOrder>() { }
+#endif /* HAVE_PSI_INTERFACE */
+};
+
+} // namespace
+
+START_TEST(test_monitor_sequential)
+{
+    TestMonitor mon;
+    mon.set_initial_position(0);
+
+    /* go around the process window a few times */
+    wsrep_seqno_t const n(mon.size() * 3 + 5);
+
+    for (wsrep_seqno_t s(1); s <= n; ++s)
+    {
+        TestOrder o(s);
+        mon.enter(o);
+        ck_assert(mon.last_left() == s - 1);
+        mon.leave(o);
+        ck_assert(mon.last_left() == s);
+    }
+
+    /* interrupting what has already left must be a no-op */
+    mon.interrupt(TestOrder(n));
+
+    /* interrupted before entering */
+    TestOrder o1(n + 1);
+    mon.interrupt(o1);
+    try
+    {
+        mon.enter(o1);
+        ck_abort_msg("interrupted enter succeeded");
+    }
+    catch (gu::Exception& e)
+    {
+        ck_assert(e.get_errno() == EINTR);
+    }
+    mon.self_cancel(o1);
+    ck_assert(mon.last_left() == n + 1);
+
+    /* out of order leave is swept by the in-order one */
+    TestOrder o2(n + 2, n);
+    TestOrder o3(n + 3, n);
+    mon.enter(o2);
+    mon.enter(o3);
+    mon.leave(o3);
+    ck_assert(mon.last_left() == n + 1);
+    mon.leave(o2);
+    ck_assert(mon.last_left() == n + 3);
+
+    mon.wait(n + 3); // must not block
+
+    double oooe, oool, win;
+    long long waits;
+    mon.get_stats(&oooe, &oool, &win, &waits);
+    ck_assert(oooe > 0);
+    ck_assert(oool > 0);
+    ck_assert(waits == 0);
+}
+END_TEST
+
+struct ConcurrentArgs
+{
+    ConcurrentArgs(TestMonitor& mon, wsrep_seqno_t const total)
+        : mon_(mon), total_(total), next_(0), done_(0), errors_(0),
+          canceled_(0), interrupted_(), mtx_()
+    {
+        gu_mutex_init(&mtx_, NULL);
+    }
+
+    ~ConcurrentArgs() { gu_mutex_destroy(&mtx_); }
+
+    void interrupted(wsrep_seqno_t const s)
+    {
+        gu_mutex_lock(&mtx_);
+        interrupted_.insert(s);
+        gu_mutex_unlock(&mtx_);
+    }
+
+    bool was_interrupted(wsrep_seqno_t const s)
+    {
+        gu_mutex_lock(&mtx_);
+        bool const ret(interrupted_.find(s) != interrupted_.end());
+        gu_mutex_unlock(&mtx_);
+        return ret;
+    }
+
+    TestMonitor&               mon_;
+    wsrep_seqno_t const        total_;
+    gu::Atomic<wsrep_seqno_t>  next_;
+    gu::Atomic<int>            done_;
+    gu::Atomic<long>           errors_;
+    gu::Atomic<long>           canceled_;
+    std::set<wsrep_seqno_t>    interrupted_;
+    gu_mutex_t                 mtx_;
+};
+
+static void* worker_thd(void* arg)
+{
+    ConcurrentArgs& args(*static_cast<ConcurrentArgs*>(arg));
+
+    for (;;)
+    {
+        wsrep_seqno_t const s(args.next_.add_and_fetch(1));
+        if (s > args.total_) break;
+
+        /* every 4th is strictly ordered, others may overtake up to 3 */
+        TestOrder o(s, s % 4 ? s - 1 - s % 4 : s - 1);
+
+        try
+        {
+            args.mon_.enter(o);
+        }
+        catch (gu::Exception& e)
+        {
+            if (e.get_errno() != EINTR || !args.was_interrupted(s))
+                ++args.errors_;
+
+            ++args.canceled_;
+            args.mon_.self_cancel(o);
+            continue;
+        }
+
+        if (args.mon_.last_left() < o.depends()) ++args.errors_;
+
+        args.mon_.leave(o);
+    }
+
+    return NULL;
+}
+
+/* interrupts seqnos around last left, some of them have just left */
+static void* interrupter_thd(void* arg)
+{
+    ConcurrentArgs& args(*static_cast<ConcurrentArgs*>(arg));
+
+    while (args.done_() == 0)
+    {
+        wsrep_seqno_t const s(args.mon_.last_left() + ::random() % 3);
+        if (s < 1 || s > args.total_) continue;
+
+        args.interrupted(s);
+        args.mon_.interrupt(TestOrder(s));
+    }
+
+    return NULL;
+}
+
+/* waits and drains ahead of last left */
+static void* waiter_thd(void* arg)
+{
+    ConcurrentArgs& args(*static_cast<ConcurrentArgs*>(arg));
+
+    for (int i(0);; ++i)
+    {
+        wsrep_seqno_t const s(args.mon_.last_left() + 1 + ::random() % 64);
+        if (s > args.total_) break;
+
+        if (i % 8)
+        {
+            while (args.mon_.last_left() < s) args.mon_.wait(s);
+        }
+        else
+        {
+            args.mon_.drain(s);
+        }
+
+        if (args.mon_.last_left() < s) ++args.errors_;
+    }
+
+    return NULL;
+}
+
+START_TEST(test_monitor_concurrent)
+{
+    TestMonitor mon;
+    mon.set_initial_position(0);
+
+    ConcurrentArgs args(mon, mon.size() * 2 + 1000);
+
+    size_t const n_workers(8);
+    gu_thread_t workers[n_workers];
+    gu_thread_t interrupter, waiter;
+
+    for (size_t i(0); i < n_workers; ++i)
+    {
+        gu_thread_create(&workers[i], NULL, worker_thd, &args);
+    }
+    gu_thread_create(&interrupter, NULL, interrupter_thd, &args);
+    gu_thread_create(&waiter, NULL, waiter_thd, &args);
+
+    for (size_t i(0); i < n_workers; ++i) gu_thread_join(workers[i], NULL);
+    gu_thread_join(waiter, NULL);
+    args.done_ = 1;
+    gu_thread_join(interrupter, NULL);
+
+    ck_assert_msg(args.errors_() == 0, "errors: %ld", args.errors_());
+    ck_assert_msg(mon.last_left() == args.total_, "last left: %lld",
+                  (long long)mon.last_left());
+
+    log_info << "monitor concurrent: canceled " << args.canceled_()
+             << " of " << args.total_;
+}
+END_TEST
+
+static void* waiter_until_thd(void* arg)
+{
+    ConcurrentArgs& args(*static_cast<ConcurrentArgs*>(arg));
+
+    args.mon_.wait(args.total_);
+    if (args.mon_.last_left() < args.total_) ++args.errors_;
+    args.done_ = 1;
+
+    return NULL;
+}
+
+/* enters and leaves seqnos which do not depend on each other */
+static void* independent_thd(void* arg)
+{
+    ConcurrentArgs& args(*static_cast<ConcurrentArgs*>(arg));
+
+    for (;;)
+    {
+        wsrep_seqno_t const s(args.next_.add_and_fetch(1));
+        if (s > args.total_) break;
+
+        TestOrder o(s, 0);
+        args.mon_.enter(o);
+        args.mon_.leave(o);
+    }
+
+    return NULL;
+}
+
+START_TEST(test_monitor_resize)
+{
+    TestMonitor mon;
+    mon.set_initial_position(0);
+
+    ssize_t const initial(mon.size());
+    ck_assert(initial < mon.max_size());
+
+    /* move the window off zero so that slots get remapped */
+    wsrep_seqno_t const base(initial + initial / 2);
+    for (wsrep_seqno_t s(1); s <= base; ++s)
+    {
+        TestOrder o(s);
+        mon.enter(o);
+        mon.leave(o);
+    }
+
+    TestOrder head(base + 1);
+    mon.enter(head);
+
+    /* canceled ahead of the entered ones */
+    TestOrder canceled(base + initial / 2, base);
+    mon.interrupt(canceled);
+
+    ConcurrentArgs args(mon, base + 3 * initial);
+    gu_thread_t    waiter;
+    gu_thread_create(&waiter, NULL, waiter_until_thd, &args);
+
+    std::vector<TestOrder*> entered;
+    for (wsrep_seqno_t s(base + 2); s <= args.total_; ++s)
+    {
+        if (s == canceled.seqno()) continue;
+        entered.push_back(new TestOrder(s, base));
+        mon.enter(*entered.back());
+    }
+
+    ck_assert_msg(mon.size() == 4 * initial, "size: %zd", mon.size());
+
+    try
+    {
+        mon.enter(canceled);
+        ck_abort_msg("interrupted enter succeeded");
+    }
+    catch (gu::Exception& e)
+    {
+        ck_assert(e.get_errno() == EINTR);
+    }
+    mon.self_cancel(canceled);
+
+    while (!entered.empty())
+    {
+        mon.leave(*entered.back());
+        delete entered.back();
+        entered.pop_back();
+    }
+    ck_assert(mon.last_left() == base);
+    ck_assert(args.done_() == 0);
+
+    mon.leave(head);
+    ck_assert(mon.last_left() == args.total_);
+
+    gu_thread_join(waiter, NULL);
+    ck_assert(args.errors_() == 0);
+
+    /* can't grow past max size */
+    TestOrder far(args.total_ + mon.max_size());
+    ck_assert(mon.would_block(far.seqno()));
+}
+END_TEST
+
+START_TEST(test_monitor_resize_concurrent)
+{
+    TestMonitor mon;
+    mon.set_initial_position(0);
+
+    ssize_t const initial(mon.size());
+
+    /* 1 holds the window, others may enter past it and resize it */
+    TestOrder head(1);
+    mon.enter(head);
+
+    ConcurrentArgs args(mon, 8 * initial - 1);
+    args.next_ = 1;
+
+    size_t const n_workers(8);
+    gu_thread_t workers[n_workers];
+
+    for (size_t i(0); i < n_workers; ++i)
+    {
+        gu_thread_create(&workers[i], NULL, independent_thd, &args);
+    }
+    for (size_t i(0); i < n_workers; ++i) gu_thread_join(workers[i], NULL);
+
+    ck_assert(mon.last_left() == 0);
+    ck_assert(mon.size() == 8 * initial);
+
+    mon.leave(head);
+    ck_assert_msg(mon.last_left() == args.total_, "last left: %lld",
+                  (long long)mon.last_left());
+}
+END_TEST
+
+/* enters and leaves independent seqnos, every 2048th stays in until the
+ * others have entered far enough past it to grow the window */
+static void* stalling_thd(void* arg)
+{
+    ConcurrentArgs& args(*static_cast<ConcurrentArgs*>(arg));
+
+    for (;;)
+    {
+        wsrep_seqno_t const s(args.next_.add_and_fetch(1));
+        if (s > args.total_) break;
+
+        TestOrder o(s, 0);
+
+        try
+        {
+            args.mon_.enter(o);
+        }
+        catch (gu::Exception& e)
+        {
+            if (e.get_errno() != EINTR || !args.was_interrupted(s))
+                ++args.errors_;
+
+            ++args.canceled_;
+            args.mon_.self_cancel(o);
+            continue;
+        }
+
+        if (s % 2048 == 0)
+        {
+            wsrep_seqno_t const until(
+                std::min<wsrep_seqno_t>(s + TestMonitor::min_size(),
+                                        args.total_));
+
+            while (args.next_() <= until) usleep(1000);
+        }
+
+        args.mon_.leave(o);
+    }
+
+    return NULL;
+}
+
+START_TEST(test_monitor_resize_mixed)
+{
+    TestMonitor mon;
+    mon.set_initial_position(0);
+
+    ssize_t const initial(mon.size());
+
+    /* resizes happen while others enter and leave lock-free, in and out
+     * of order, and get interrupted */
+    ConcurrentArgs args(mon, 16 * initial);
+
+    size_t const n_workers(8);
+    gu_thread_t workers[n_workers];
+    gu_thread_t interrupter, waiter;
+
+    for (size_t i(0); i < n_workers; ++i)
+    {
+        gu_thread_create(&workers[i], NULL, stalling_thd, &args);
+    }
+    gu_thread_create(&interrupter, NULL, interrupter_thd, &args);
+    gu_thread_create(&waiter, NULL, waiter_until_thd, &args);
+
+    for (size_t i(0); i < n_workers; ++i) gu_thread_join(workers[i], NULL);
+    gu_thread_join(waiter, NULL);
+    args.done_ = 1;
+    gu_thread_join(interrupter, NULL);
+
+    ck_assert_msg(args.errors_() == 0, "errors: %ld", args.errors_());
+    ck_assert_msg(mon.last_left() == args.total_, "last left: %lld",
+                  (long long)mon.last_left());
+    ck_assert_msg(mon.size() > initial, "size: %zd", mon.size());
+}
+END_TEST
+
+struct GraphArgs
+{
+    GraphArgs(GraphMonitor& mon, GraphOrder& order)
+        : mon_(mon), order_(order), entered_(0)
+    { }
+
+    GraphMonitor&   mon_;
+    GraphOrder&     order_;
+    gu::Atomic<int> entered_;
+};
+
+static void* graph_thd(void* arg)
+{
+    GraphArgs& args(*static_cast<GraphArgs*>(arg));
+
+    args.mon_.enter(args.order_);
+    args.entered_ = 1;
+
+    return NULL;
+}
+
+START_TEST(test_monitor_graph)
+{
+    GraphMonitor mon;
+    mon.set_initial_position(0);
+    mon.set_wake_up_out_of_order(true);
+
+    /* 2 does not depend on 1, 3 depends on 2 only */
+    GraphOrder o1(1, 0, 0, mon);
+    GraphOrder o2(2, 0, 0, mon);
+    GraphOrder o3(3, 0, 2, mon);
+
+    mon.enter(o1);
+    mon.enter(o2);
+    ck_assert(!mon.has_left(2));
+
+    GraphArgs   args(mon, o3);
+    gu_thread_t thd;
+    gu_thread_create(&thd, NULL, graph_thd, &args);
+
+    usleep(10000);
+    ck_assert(args.entered_() == 0);
+
+    /* 2 leaves out of order and lets 3 in while 1 is still there */
+    mon.leave(o2);
+    ck_assert(mon.has_left(2));
+    gu_thread_join(thd, NULL);
+    ck_assert(args.entered_() == 1);
+    ck_assert(mon.last_left() == 0);
+
+    mon.leave(o3);
+    ck_assert(mon.last_left() == 0);
+    mon.leave(o1);
+    ck_assert(mon.last_left() == 3);
+    ck_assert(mon.has_left(3));
+    ck_assert(!mon.has_left(4));
+}
+END_TEST
+
+START_TEST(test_monitor_graph_chain)
+{
+    GraphMonitor mon;
+    mon.set_initial_position(0);
+    mon.set_wake_up_out_of_order(true);
+
+    /* 3 depends on 2, 4 on 3 and 5 on 4 and everything up to 1 */
+    GraphOrder o1(1, 0, 0, mon);
+    GraphOrder o2(2, 0, 0, mon);
+    GraphOrder o3(3, 0, 2, mon);
+    GraphOrder o4(4, 0, 3, mon);
+    GraphOrder o5(5, 1, 4, mon);
+
+    mon.enter(o1);
+    mon.enter(o2);
+
+    GraphArgs   args3(mon, o3), args4(mon, o4), args5(mon, o5);
+    gu_thread_t thd3, thd4, thd5;
+    gu_thread_create(&thd5, NULL, graph_thd, &args5);
+    gu_thread_create(&thd4, NULL, graph_thd, &args4);
+    gu_thread_create(&thd3, NULL, graph_thd, &args3);
+
+    usleep(10000);
+    ck_assert(args3.entered_() == 0);
+    ck_assert(args4.entered_() == 0);
+    ck_assert(args5.entered_() == 0);
+
+    /* each out of order leave lets in the one that depends on it */
+    mon.leave(o2);
+    gu_thread_join(thd3, NULL);
+    ck_assert(args3.entered_() == 1);
+    usleep(10000);
+    ck_assert(args4.entered_() == 0);
+
+    mon.leave(o3);
+    gu_thread_join(thd4, NULL);
+    ck_assert(args4.entered_() == 1);
+
+    /* 5 still waits for 1 */
+    mon.leave(o4);
+    usleep(10000);
+    ck_assert(args5.entered_() == 0);
+    ck_assert(mon.last_left() == 0);
+
+    mon.leave(o1);
+    gu_thread_join(thd5, NULL);
+    ck_assert(args5.entered_() == 1);
+    ck_assert(mon.last_left() == 4);
+
+    mon.leave(o5);
+    ck_assert(mon.last_left() == 5);
+}
+END_TEST
+
+Suite* monitor_suite()
+{
+    Suite* s = suite_create("monitor");
+    TCase* tc;
+
+    tc = tcase_create("test_monitor_sequential");
+    tcase_add_test(tc, test_monitor_sequential);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_monitor_resize");
+    tcase_add_test(tc, test_monitor_resize);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_monitor_resize_concurrent");
+    tcase_add_test(tc, test_monitor_resize_concurrent);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_monitor_resize_mixed");
+    tcase_add_test(tc, test_monitor_resize_mixed);
+    tcase_set_timeout(tc, 120);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_monitor_graph");
+    tcase_add_test(tc, test_monitor_graph);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_monitor_graph_chain");
+    tcase_add_test(tc, test_monitor_graph_chain);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_monitor_concurrent");
+    tcase_add_test(tc, test_monitor_concurrent);
+    tcase_set_timeout(tc, 120);
+    suite_add_tcase(s, tc);
+
+    return s;
+}
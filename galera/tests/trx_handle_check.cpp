@@ -190,6 +190,45 @@ START_TEST(test_serialization)
 }
 END_TEST
 
+START_TEST(test_pa_deps)
+{
+    TrxHandle::SlavePool sp(sizeof(TrxHandle), 16, "pa_deps_sp");
+    TrxHandle* trx(TrxHandle::New(sp));
+
+    ck_assert(trx->pa_deps_num() == -1);
+
+    trx->init_pa_deps(10);
+    ck_assert(trx->pa_deps_num() == 0);
+
+    trx->add_pa_dep(5);  // below base
+    trx->add_pa_dep(12);
+    trx->add_pa_dep(12); // duplicate
+    ck_assert(trx->pa_deps_num() == 1);
+    ck_assert(trx->pa_dep(0) == 12);
+
+    /* overflow folds the lowest dependency into the base */
+    for (int i(0); i < TrxHandle::MAX_PA_DEPS; ++i) trx->add_pa_dep(20 + i);
+    ck_assert(trx->pa_base_seqno() == 12);
+    ck_assert(trx->pa_deps_num() == TrxHandle::MAX_PA_DEPS);
+    for (int i(0); i < trx->pa_deps_num(); ++i)
+    {
+        ck_assert(trx->pa_dep(i) > trx->pa_base_seqno());
+    }
+
+    /* dependency below all explicit ones goes to the base right away */
+    trx->add_pa_dep(15);
+    ck_assert(trx->pa_base_seqno() == 15);
+    ck_assert(trx->pa_deps_num() == TrxHandle::MAX_PA_DEPS);
+
+    /* raising the base drops dependencies it covers */
+    trx->set_pa_base_seqno(23);
+    ck_assert(trx->pa_base_seqno() == 23);
+    ck_assert(trx->pa_deps_num() == TrxHandle::MAX_PA_DEPS - 4);
+
+    trx->unref();
+}
+END_TEST
+
 Suite* trx_handle_suite()
 {
     Suite* s = suite_create("trx_handle");
@@ -204,5 +243,9 @@ Suite* trx_handle_suite()
     tcase_add_test(tc, test_serialization);
     suite_add_tcase(s, tc);
 
+    tc = tcase_create("test_pa_deps");
+    tcase_add_test(tc, test_pa_deps);
+    suite_add_tcase(s, tc);
+
     return s;
 }
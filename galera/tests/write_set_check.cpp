@@ -651,6 +651,322 @@ START_TEST(test_trac_726)
 END_TEST
 #endif // GALERA_WITH_ASAN
 
+/* creates slave trx of version 3 from a set of single part keys,
+ * the write set is stored in buf which must outlive the trx */
+static TrxHandle*
+make_trx_v3(const TrxHandle::Params& params, const wsrep_uuid_t& source,
+            const char* const keys[], const bool shared[], size_t n_keys,
+            wsrep_seqno_t last_seen, wsrep_seqno_t seqno, gu::Buffer& buf)
+{
+    TrxHandle* trx(TrxHandle::New(lp, params, source, 1, seqno));
+
+    for (size_t k(0); k < n_keys; ++k)
+    {
+        wsrep_buf_t const key = { keys[k], strlen(keys[k]) };
+        trx->append_key(KeyData(params.version_, &key, 1,
+                                shared[k] ? WSREP_KEY_SHARED :
+                                WSREP_KEY_EXCLUSIVE, true));
+    }
+
+    galera::WriteSetNG::GatherVector bufs;
+    size_t const size(trx->write_set_out().gather(trx->source_id(),
+                                                  trx->conn_id(),
+                                                  trx->trx_id(),
+                                                  bufs));
+    trx->set_last_seen_seqno(last_seen);
+
+    buf.resize(size);
+    gu::byte_t* p(&buf[0]);
+    for (size_t k(0); k < bufs->size(); ++k)
+    {
+        ::memcpy(p, bufs[k].ptr, bufs[k].size); p += bufs[k].size;
+    }
+    trx->unref();
+
+    trx = TrxHandle::New(sp);
+    trx->unserialize(&buf[0], buf.size(), 0);
+    trx->set_received(0, seqno, seqno);
+
+    return trx;
+}
+
+/* if batch is true, all write sets are certified with one append_trxs()
+ * call */
+static void
+test_cert_v3_shards(const char* const shards, bool const batch)
+{
+    const int version(3);
+    wsrep_uuid_t const uuid1 = {{1, }};
+    wsrep_uuid_t const uuid2 = {{2, }};
+
+    TestEnv env;
+    env.conf().set("cert.index_shards", shards);
+    galera::Certification cert(env.conf(), env.thd(), env.gcache());
+    galera::TrxHandle::Params const trx_params("", version,KeySet::MAX_VERSION);
+
+    cert.assign_initial_position(0, version);
+
+    mark_point();
+
+    const char* const keys1[] = {
+        "k0", "k1", "k2",  "k3",  "k4",  "k5",  "k6",  "k7",
+        "k8", "k9", "k10", "k11", "k12", "k13", "k14", "k15"
+    };
+    const bool shared1[] = {
+        false, false, false, false, false, false, false, false,
+        false, false, false, false, false, false, false, false
+    };
+    const char* const keys2[] = { "k20", "k7" };
+    const bool shared2[] = { true, false };
+    const char* const keys3[] = { "k3", "k20" };
+    const bool shared3[] = { true, true };
+    const char* const keys4[] = { "k20" };
+    const bool shared4[] = { false };
+
+    struct
+    {
+        const wsrep_uuid_t*       uuid;
+        const char* const*        keys;
+        const bool*               shared;
+        size_t                    n_keys;
+        wsrep_seqno_t             last_seen;
+        wsrep_seqno_t             expected_depends_seqno;
+        Certification::TestResult result;
+    } wsi[] = {
+        // 1: keys spread over all shards, no dependencies
+        { &uuid1, keys1, shared1, 16, 0, 0, Certification::TEST_OK },
+        // 2: conflicts with 1, shared key inserted to the index must be
+        //    cleaned up from its shard
+        { &uuid2, keys2, shared2, 2, 0, -1, Certification::TEST_FAILED },
+        // 3: depends on 1
+        { &uuid2, keys3, shared3, 2, 1, 1, Certification::TEST_OK },
+        // 4: exclusive after shared, depends on 3
+        { &uuid1, keys4, shared4, 1, 3, 3, Certification::TEST_OK }
+    };
+
+    size_t const nws(sizeof(wsi)/sizeof(wsi[0]));
+    std::vector<gu::Buffer> bufs(nws);
+    std::vector<TrxHandle*> trxs(nws);
+    std::vector<Certification::TestResult> results(nws);
+
+    for (size_t i(0); i < nws; ++i)
+    {
+        trxs[i] = make_trx_v3(trx_params, *wsi[i].uuid, wsi[i].keys,
+                              wsi[i].shared, wsi[i].n_keys,
+                              wsi[i].last_seen, i + 1, bufs[i]);
+    }
+
+    if (batch) cert.append_trxs(&trxs[0], nws, &results[0]);
+
+    for (size_t i(0); i < nws; ++i)
+    {
+        TrxHandle* const trx(trxs[i]);
+
+        if (!batch) results[i] = cert.append_trx(trx);
+
+        Certification::TestResult const result(results[i]);
+        ck_assert_msg(result == wsi[i].result,
+                      "shards: %s batch: %d g: %" PRId64 " res: %d exp: %d",
+                      shards, batch, trx->global_seqno(), result,
+                      wsi[i].result);
+        ck_assert_msg(trx->depends_seqno() == wsi[i].expected_depends_seqno,
+                      "shards: %s g: %" PRId64 " ld: %" PRId64 " eld: %" PRId64,
+                      shards, trx->global_seqno(), trx->depends_seqno(),
+                      wsi[i].expected_depends_seqno);
+        cert.set_trx_committed(trx);
+        trx->unref();
+    }
+
+    cert.purge_trxs_upto(nws, false);
+}
+
+START_TEST(test_cert_v3_sharded)
+{
+    log_info << "test_cert_v3_sharded";
+
+    test_cert_v3_shards("1",  false);
+    test_cert_v3_shards("5",  false);
+    test_cert_v3_shards("64", false);
+}
+END_TEST
+
+START_TEST(test_cert_v3_batch)
+{
+    log_info << "test_cert_v3_batch";
+
+    test_cert_v3_shards("1",  true);
+    test_cert_v3_shards("5",  true);
+    test_cert_v3_shards("64", true);
+}
+END_TEST
+
+/* index is purged in background slices of one trx, while certification
+ * goes on */
+START_TEST(test_cert_v3_background_purge)
+{
+    log_info << "test_cert_v3_background_purge";
+
+    const int version(3);
+    wsrep_uuid_t const uuid = {{1, }};
+
+    TestEnv env;
+    env.conf().set("cert.purge_slice", "PT0.000000001S");
+    galera::Certification cert(env.conf(), env.thd(), env.gcache());
+    galera::TrxHandle::Params const trx_params("", version,KeySet::MAX_VERSION);
+
+    cert.assign_initial_position(0, version);
+
+    const char* const keys[] = { "k0" };
+    const bool shared[] = { false };
+
+    size_t const nws(100);
+    std::vector<gu::Buffer> bufs(nws);
+
+    for (size_t i(0); i < nws; ++i)
+    {
+        wsrep_seqno_t const seqno(i + 1);
+        TrxHandle* trx(make_trx_v3(trx_params, uuid, keys, shared, 1,
+                                   seqno - 1, seqno, bufs[i]));
+
+        Certification::TestResult const result(cert.append_trx(trx));
+        ck_assert_msg(result == Certification::TEST_OK,
+                      "g: %" PRId64 " res: %d", seqno, result);
+        ck_assert_msg(trx->depends_seqno() == seqno - 1,
+                      "g: %" PRId64 " ld: %" PRId64,
+                      seqno, trx->depends_seqno());
+
+        cert.set_trx_committed(trx);
+        trx->unref();
+
+        if (0 == seqno % 10) cert.purge_trxs_upto(seqno - 1, false);
+    }
+
+    cert.purge_trxs_upto(nws, false);
+    env.thd().flush();
+
+    try
+    {
+        cert.param_set("cert.purge_slice", "PT0S");
+        ck_abort_msg("zero purge slice accepted");
+    }
+    catch (gu::Exception& e)
+    {
+        ck_assert(e.get_errno() == EINVAL);
+    }
+
+    cert.param_set("cert.purge_trxs_threshold", "1000");
+    ck_assert(env.conf().get("cert.purge_trxs_threshold") == "1000");
+}
+END_TEST
+
+/* blocks service thread in set_last_applied() to hold background purge */
+class BlockingGcs : public galera::DummyGcs
+{
+public:
+
+    BlockingGcs(gu::Config& conf, gcache::GCache& cache)
+        : DummyGcs(conf, cache), mtx_(), cond_(), blocked_(false),
+          waiting_(false)
+    {}
+
+    void block() { gu::Lock lock(mtx_); blocked_ = true; }
+
+    void wait_blocked()
+    {
+        gu::Lock lock(mtx_);
+        while (!waiting_) lock.wait(cond_);
+    }
+
+    void unblock()
+    {
+        gu::Lock lock(mtx_);
+        blocked_ = false;
+        cond_.broadcast();
+    }
+
+    ssize_t set_last_applied(gcs_seqno_t const seqno)
+    {
+        {
+            gu::Lock lock(mtx_);
+            waiting_ = true;
+            cond_.broadcast();
+            while (blocked_) lock.wait(cond_);
+            waiting_ = false;
+        }
+
+        return DummyGcs::set_last_applied(seqno);
+    }
+
+private:
+
+    gu::Mutex mtx_;
+    gu::Cond  cond_;
+    bool      blocked_;
+    bool      waiting_;
+};
+
+/* keys of a purged trx must not affect certification whether they are
+ * still in the index or not */
+START_TEST(test_cert_v3_purge_determinism)
+{
+    log_info << "test_cert_v3_purge_determinism";
+
+    const int version(3);
+    wsrep_uuid_t const uuid1 = {{1, }};
+    wsrep_uuid_t const uuid2 = {{2, }};
+
+    TestEnv env;
+    BlockingGcs gcs(env.conf(), env.gcache());
+    galera::ServiceThd thd(gcs, env.gcache());
+    galera::Certification cert(env.conf(), thd, env.gcache());
+    galera::TrxHandle::Params const trx_params("", version,KeySet::MAX_VERSION);
+
+    cert.assign_initial_position(0, version);
+
+    const char* const keys1[] = { "k0" };
+    const char* const keys2[] = { "k1" };
+    const bool shared[] = { false };
+
+    gu::Buffer bufs[4];
+
+    TrxHandle* trx(make_trx_v3(trx_params, uuid1, keys1, shared, 1,
+                               0, 1, bufs[0]));
+    ck_assert(cert.append_trx(trx) == Certification::TEST_OK);
+    cert.set_trx_committed(trx);
+    trx->unref();
+
+    trx = make_trx_v3(trx_params, uuid1, keys2, shared, 1, 1, 2, bufs[1]);
+    ck_assert(cert.append_trx(trx) == Certification::TEST_OK);
+    cert.set_trx_committed(trx);
+    trx->unref();
+
+    // trx 1 leaves trx map, its key stays in the index
+    gcs.block();
+    thd.report_last_committed(1);
+    gcs.wait_blocked();
+    cert.purge_trxs_upto(1, false);
+
+    // last seen seqno is below the purge point, see #733
+    trx = make_trx_v3(trx_params, uuid2, keys1, shared, 1, 0, 3, bufs[2]);
+    Certification::TestResult const before(cert.test(trx, false));
+    trx->unref();
+
+    gcs.unblock();
+    thd.flush();
+
+    trx = make_trx_v3(trx_params, uuid2, keys1, shared, 1, 0, 3, bufs[3]);
+    Certification::TestResult const after(cert.test(trx, false));
+    trx->unref();
+
+    ck_assert_msg(before == after, "before purge: %d, after: %d",
+                  before, after);
+    ck_assert(after == Certification::TEST_OK);
+
+    cert.purge_trxs_upto(2, false);
+    thd.flush();
+}
+END_TEST
+
 Suite* write_set_suite()
 {
     Suite* s = suite_create("write_set");
@@ -686,6 +1002,26 @@ Suite* write_set_suite()
     tcase_set_timeout(tc, 120);
     suite_add_tcase(s, tc);
 
+    tc = tcase_create("test_cert_v3_sharded");
+    tcase_add_test(tc, test_cert_v3_sharded);
+    tcase_set_timeout(tc, 20);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_cert_v3_batch");
+    tcase_add_test(tc, test_cert_v3_batch);
+    tcase_set_timeout(tc, 20);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_cert_v3_background_purge");
+    tcase_add_test(tc, test_cert_v3_background_purge);
+    tcase_set_timeout(tc, 20);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_cert_v3_purge_determinism");
+    tcase_add_test(tc, test_cert_v3_purge_determinism);
+    tcase_set_timeout(tc, 20);
+    suite_add_tcase(s, tc);
+
 #ifndef GALERA_WITH_ASAN
     tc = tcase_create("test_trac_726");
     tcase_add_test(tc, test_trac_726);
@@ -15,6 +15,9 @@
 
 #include <check.h>
 
+#include <cstdlib>
+#include <cstring>
+
 using namespace galera;
 
 static void ver3_basic(gu::RecordSet::Version const rsv,
@@ -395,6 +398,116 @@ START_TEST (ver3_annotation_rsv2)
 }
 END_TEST
 
+/* gathers write set with the data set compressed if it is above threshold
+ * and checks that it reads back the same */
+static void ver4_compression(gu::RecordSet::Version const rsv,
+                             size_t const data_size, bool const random,
+                             DataSet::Version const expected_ver)
+{
+    union {
+        wsrep_uuid_t source;
+        size_t alignment;
+    } s;
+    wsrep_uuid_t& source(s.source);
+    int const alignment(rsv >= gu::RecordSet::VER2 ? GU_MIN_ALIGNMENT : 1);
+    gu_uuid_generate (reinterpret_cast<gu_uuid_t*>(&source), NULL, 0);
+    wsrep_conn_id_t const conn(652653);
+    wsrep_trx_id_t const  trx(99994952);
+
+    std::string const dir(".");
+    wsrep_trx_id_t trx_id(1);
+    size_t const threshold(1024);
+
+    WriteSetOut wso (dir, trx_id, KeySet::FLAT16, 0, 0, 0, rsv,
+                     WriteSetNG::VER4, DataSet::MAX_VERSION,
+                     DataSet::MAX_VERSION, WriteSetNG::MAX_SIZE, threshold);
+
+    TestKey tk0(KeySet::MAX_VERSION, WSREP_KEY_EXCLUSIVE, true, "key0");
+    wso.append_key(tk0());
+
+    std::vector<gu::byte_t> data(data_size);
+    for (size_t i(0); i < data.size(); ++i)
+    {
+        data[i] = random ? ::rand() : 'a' + (i % 13);
+    }
+
+    /* several appends end up in a single record */
+    size_t const half(data.size() / 2);
+    wso.append_data (&data[0], half, true);
+    wso.append_data (&data[half], data.size() - half, false);
+
+    std::string const unrd("unordered");
+    std::string const annotation("annotation");
+    wso.append_unordered (unrd.c_str(), unrd.size(), true);
+    wso.append_annotation (annotation.c_str(), annotation.size(), true);
+
+    WriteSetNG::GatherVector out;
+    size_t const out_size(wso.gather(source, conn, trx, out));
+    ck_assert((out_size % alignment) == 0);
+    wso.set_last_seen(1);
+
+    std::vector<gu::byte_t> in;
+    in.reserve(out_size);
+    for (size_t i(0); i < out->size(); ++i)
+    {
+        const gu::byte_t* ptr(static_cast<const gu::byte_t*>(out[i].ptr));
+        in.insert (in.end(), ptr, ptr + out[i].size);
+    }
+    ck_assert(in.size() == out_size);
+
+    log_info << "Data size: " << data.size() << ", write set size: "
+             << out_size;
+
+    gu::Buf const in_buf = { in.data(), static_cast<ssize_t>(in.size()) };
+
+    WriteSetIn wsi(in_buf);
+    wsi.verify_checksum();
+
+    ck_assert_msg(wsi.dataset().version() == expected_ver,
+                  "Data set version %d, expected %d",
+                  wsi.dataset().version(), expected_ver);
+    if (DataSet::VER2 == expected_ver) ck_assert(out_size < data.size());
+
+    ck_assert(wsi.keyset().count()  == 1);
+    ck_assert(wsi.dataset().count() == 1);
+
+    /* read twice to check rewind */
+    for (int pass(0); pass < 2; ++pass)
+    {
+        wsi.dataset().rewind();
+        gu::Buf const d(wsi.dataset().next());
+        ck_assert(size_t(d.size) == data.size());
+        ck_assert(0 == ::memcmp(d.ptr, &data[0], data.size()));
+    }
+
+    ck_assert(wsi.unrdset().count() == 1);
+    gu::Buf const u(wsi.unrdset().next());
+    ck_assert(std::string(static_cast<const char*>(u.ptr), u.size) == unrd);
+
+    std::ostringstream os;
+    wsi.write_annotation(os);
+    ck_assert(os.str() == annotation);
+}
+
+START_TEST (ver4_compression_rsv2)
+{
+    /* compressible, above threshold */
+    ver4_compression(gu::RecordSet::VER2, 1 << 16, false, DataSet::VER2);
+    /* below threshold */
+    ver4_compression(gu::RecordSet::VER2, 512, false, DataSet::VER1);
+    /* incompressible */
+    ver4_compression(gu::RecordSet::VER2, 1 << 16, true, DataSet::VER1);
+}
+END_TEST
+
+#ifndef GALERA_ONLY_ALIGNED
+START_TEST (ver4_compression_rsv1)
+{
+    ver4_compression(gu::RecordSet::VER1, 1 << 16, false, DataSet::VER2);
+}
+END_TEST
+#endif /* GALERA_ONLY_ALIGNED */
+
 Suite* write_set_ng_suite ()
 {
     Suite* s = suite_create ("WriteSet");
@@ -416,5 +529,13 @@ Suite* write_set_ng_suite ()
     tcase_set_timeout(t, 60);
     suite_add_tcase (s, t);
 
+    t = tcase_create ("WriteSet compression");
+#ifndef GALERA_ONLY_ALIGNED
+    tcase_add_test (t, ver4_compression_rsv1);
+#endif
+    tcase_add_test (t, ver4_compression_rsv2);
+    tcase_set_timeout(t, 60);
+    suite_add_tcase (s, t);
+
     return s;
 }
@@ -64,6 +64,13 @@ extern "C" {
 #define gu_atomic_get_n(ptr)                            \
     __atomic_load_n(ptr, GU_ATOMIC_SYNC_DEFAULT)
 
+// stores val into ptr if ptr contains oldval, returns true on success
+#define gu_atomic_bool_compare_and_swap(ptr, oldval, val)               \
+    ({ __typeof__(*(ptr)) _gu_old = (oldval);                           \
+        __atomic_compare_exchange_n(ptr, &_gu_old, val, false,          \
+                                    GU_ATOMIC_SYNC_DEFAULT,             \
+                                    GU_ATOMIC_SYNC_DEFAULT); })
+
 #elif defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8) // use __sync_XXX builtins
 
 #define GU_ATOMIC_SYNC_NONE    0
@@ -89,6 +96,8 @@ extern "C" {
 
 #define gu_atomic_get(ptr, vptr) *vptr = __sync_fetch_and_or(ptr, 0)
 
+#define gu_atomic_bool_compare_and_swap __sync_bool_compare_and_swap
+
 #else
 #error "This GCC version does not support 8-byte atomics on this platform. Use GCC >= 4.7.x."
 #endif /* __ATOMIC_RELAXED */
@@ -54,6 +54,12 @@ namespace gu
             return gu_atomic_sub_and_fetch(&i_, i);
         }
 
+        // sets value to i if it is equal to expected, returns true on success
+        bool compare_and_swap(I expected, I i)
+        {
+            return gu_atomic_bool_compare_and_swap(&i_, expected, i);
+        }
+
         Atomic<I>& operator++()
         {
             gu_atomic_fetch_and_add(&i_, 1);
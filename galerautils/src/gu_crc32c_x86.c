@@ -65,6 +65,115 @@ gu_crc32c_x86(gu_crc32c_t state, const void* data, size_t len)
 }
 
 #if defined(GU_CRC32C_X86_64)
+
+#ifdef __LP64__
+/*
+ * crc32 instruction has a latency of 3 cycles but can be issued every cycle,
+ * so on long buffers three independent streams are computed over adjacent
+ * blocks and then combined. CRC state is linear, so the state of block A
+ * followed by block B is the state of A shifted over len(B) zero bytes XOR
+ * the state of B computed from zero. Shift over a fixed number of zeros is
+ * a linear operator which is precomputed into byte-wise lookup tables.
+ */
+#define CRC32C_X86_64_LONG  8192
+#define CRC32C_X86_64_SHORT 256
+
+static uint32_t crc32c_x86_64_long_shift [4][256];
+static uint32_t crc32c_x86_64_short_shift[4][256];
+static bool     crc32c_x86_64_shift_ready = false;
+
+static void
+crc32c_x86_64_compute_shift(uint32_t table[4][256], size_t const len)
+{
+    uint32_t basis[32];
+    int      i, b, k;
+
+    /* shift every single bit of state over len zero bytes */
+    for (i = 0; i < 32; i++)
+    {
+        uint64_t state = (uint32_t)1 << i;
+        size_t   n;
+
+        for (n = 0; n < len; n += sizeof(uint64_t))
+            state = __builtin_ia32_crc32di(state, 0);
+
+        basis[i] = (uint32_t)state;
+    }
+
+    for (k = 0; k < 4; k++)
+    {
+        for (b = 0; b < 256; b++)
+        {
+            uint32_t val = 0;
+
+            for (i = 0; i < 8; i++)
+                if (b & (1 << i)) val ^= basis[k*8 + i];
+
+            table[k][b] = val;
+        }
+    }
+}
+
+static void
+crc32c_x86_64_configure()
+{
+    if (!crc32c_x86_64_shift_ready)
+    {
+        crc32c_x86_64_compute_shift(crc32c_x86_64_long_shift,
+                                    CRC32C_X86_64_LONG);
+        crc32c_x86_64_compute_shift(crc32c_x86_64_short_shift,
+                                    CRC32C_X86_64_SHORT);
+        crc32c_x86_64_shift_ready = true;
+    }
+}
+
+static inline uint32_t
+crc32c_x86_64_shift(const uint32_t table[4][256], uint32_t const state)
+{
+    return table[0][state & 0xff]         ^ table[1][(state >> 8) & 0xff] ^
+           table[2][(state >> 16) & 0xff] ^ table[3][state >> 24];
+}
+
+/* processes len bytes in blocks of 3*block_len, returns the rest of len */
+static inline size_t
+crc32c_x86_64_3way(uint64_t* const       state,
+                   const uint8_t** const data,
+                   size_t                len,
+                   size_t const          block_len,
+                   const uint32_t        shift[4][256])
+{
+    const uint8_t* ptr = *data;
+
+    while (len >= 3 * block_len)
+    {
+        const uint8_t* const end = ptr + block_len;
+        uint64_t crc0 = *state;
+        uint64_t crc1 = 0;
+        uint64_t crc2 = 0;
+
+        do
+        {
+            crc0 = __builtin_ia32_crc32di(crc0, *(uint64_t*)ptr);
+            crc1 = __builtin_ia32_crc32di(crc1,
+                                          *(uint64_t*)(ptr + block_len));
+            crc2 = __builtin_ia32_crc32di(crc2,
+                                          *(uint64_t*)(ptr + 2 * block_len));
+            ptr += sizeof(uint64_t);
+        }
+        while (ptr < end);
+
+        crc0 = crc32c_x86_64_shift(shift, (uint32_t)crc0) ^ crc1;
+        *state = crc32c_x86_64_shift(shift, (uint32_t)crc0) ^ crc2;
+
+        ptr += 2 * block_len;
+        len -= 3 * block_len;
+    }
+
+    *data = ptr;
+    return len;
+}
+#endif /* __LP64__ */
+
 gu_crc32c_t
 gu_crc32c_x86_64(gu_crc32c_t state, const void* data, size_t len)
 {
@@ -74,6 +183,14 @@ gu_crc32c_x86_64(gu_crc32c_t state, const void* data, size_t len)
     static size_t const arg_size = sizeof(uint64_t);
     uint64_t state64 = state;
 
+    if (crc32c_x86_64_shift_ready && len >= 3 * CRC32C_X86_64_SHORT)
+    {
+        len = crc32c_x86_64_3way(&state64, &ptr, len, CRC32C_X86_64_LONG,
+                                 crc32c_x86_64_long_shift);
+        len = crc32c_x86_64_3way(&state64, &ptr, len, CRC32C_X86_64_SHORT,
+                                 crc32c_x86_64_short_shift);
+    }
+
     while (len >= arg_size)
     {
         state64 = __builtin_ia32_crc32di(state64, *(uint64_t*)ptr);
@@ -110,6 +227,9 @@ gu_crc32c_hardware()
     if (SSE42_present)
     {
 #if defined(GU_CRC32C_X86_64)
+#ifdef __LP64__
+        crc32c_x86_64_configure();
+#endif
         gu_info ("CRC-32C: using 64-bit x86 acceleration.");
         return gu_crc32c_x86_64;
 #else
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2020 Codership Oy <info@codership.com>
+ */
+
+#include "gu_deflate.hpp"
+#include "gu_throw.hpp"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+gu::Deflate::Deflate(int const level)
+    :
+    strm_(new z_stream),
+    out_ (),
+    size_(0)
+{
+    ::memset(strm_, 0, sizeof(*strm_));
+
+    int const err(deflateInit(strm_, level));
+
+    if (err != Z_OK)
+    {
+        delete strm_;
+        gu_throw_error(EINVAL) << "deflateInit() failed: " << err
+                               << ", level " << level;
+    }
+}
+
+gu::Deflate::~Deflate()
+{
+    deflateEnd(strm_);
+    delete strm_;
+}
+
+void
+gu::Deflate::deflate(int const flush)
+{
+    for (;;)
+    {
+        if (out_.size() - size_ < 64)
+        {
+            out_.resize(std::max<size_t>(out_.size() * 2, 1 << 16));
+        }
+
+        strm_->next_out  = &out_[size_];
+        strm_->avail_out = out_.size() - size_;
+
+        int const err(::deflate(strm_, flush));
+
+        size_ = out_.size() - strm_->avail_out;
+
+        if (err != Z_OK && err != Z_BUF_ERROR)
+        {
+            gu_throw_fatal << "deflate() failed: " << err;
+        }
+
+        /* all input consumed and, for flush, all output produced */
+        if (strm_->avail_in == 0 && strm_->avail_out > 0) break;
+    }
+}
+
+void
+gu::Deflate::append(const void* const ptr, size_t const size)
+{
+    strm_->next_in  = static_cast<Bytef*>(const_cast<void*>(ptr));
+    strm_->avail_in = size;
+
+    deflate(Z_NO_FLUSH);
+}
+
+void
+gu::Deflate::flush()
+{
+    strm_->next_in  = 0;
+    strm_->avail_in = 0;
+
+    deflate(Z_SYNC_FLUSH);
+}
+
+gu::Inflate::Inflate()
+    :
+    strm_   (new z_stream),
+    pending_(false)
+{
+    ::memset(strm_, 0, sizeof(*strm_));
+
+    int const err(inflateInit(strm_));
+
+    if (err != Z_OK)
+    {
+        delete strm_;
+        gu_throw_error(ENOMEM) << "inflateInit() failed: " << err;
+    }
+}
+
+gu::Inflate::~Inflate()
+{
+    inflateEnd(strm_);
+    delete strm_;
+}
+
+void
+gu::Inflate::input(const void* const ptr, size_t const size)
+{
+    assert(0 == strm_->avail_in);
+
+    strm_->next_in  = static_cast<Bytef*>(const_cast<void*>(ptr));
+    strm_->avail_in = size;
+}
+
+size_t
+gu::Inflate::avail() const
+{
+    return strm_->avail_in;
+}
+
+size_t
+gu::Inflate::output(void* const ptr, size_t const size)
+{
+    if ((0 == strm_->avail_in && !pending_) || 0 == size) return 0;
+
+    strm_->next_out  = static_cast<Bytef*>(ptr);
+    strm_->avail_out = size;
+
+    int const err(::inflate(strm_, Z_SYNC_FLUSH));
+
+    switch (err)
+    {
+    case Z_OK:
+    case Z_BUF_ERROR: // no progress possible, needs more input
+        break;
+    case Z_STREAM_END:
+        gu_throw_error(EPROTO) << "unexpected end of compressed stream";
+    default:
+        gu_throw_error(EPROTO) << "inflate() failed: " << err << " ("
+                               << (strm_->msg ? strm_->msg : "") << ')';
+    }
+
+    /* zlib may have more output for a full buffer without more input */
+    pending_ = (0 == strm_->avail_out);
+
+    return size - strm_->avail_out;
+}
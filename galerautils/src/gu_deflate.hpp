@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2020 Codership Oy <info@codership.com>
+ */
+
+/*!
+ * @file Streaming zlib compression wrappers
+ *
+ * Deflate compresses a stream of data chunk by chunk, flush() makes
+ * everything compressed so far decodable by the peer Inflate without
+ * ending the stream, so the same compression context (and dictionary) is
+ * reused for the whole connection.
+ */
+
+#ifndef _GU_DEFLATE_HPP_
+#define _GU_DEFLATE_HPP_
+
+#include "gu_types.hpp"
+
+#include <vector>
+
+struct z_stream_s;
+
+namespace gu
+{
+    class Deflate
+    {
+    public:
+
+        /* zlib compression level 1..9 */
+        explicit Deflate(int level);
+        ~Deflate();
+
+        /* compresses data appending the result to the output buffer */
+        void append(const void* ptr, size_t size);
+
+        /* flushes pending output to the buffer on byte boundary */
+        void flush();
+
+        const byte_t* data() const { return out_.empty() ? 0 : &out_[0]; }
+        size_t        size() const { return size_; }
+
+        /* discards the output buffer, compression context is kept */
+        void clear() { size_ = 0; }
+
+    private:
+
+        void deflate(int flush);
+
+        z_stream_s*         strm_;
+        std::vector<byte_t> out_;
+        size_t              size_;
+
+        Deflate(const Deflate&);
+        Deflate& operator=(const Deflate&);
+    };
+
+    class Inflate
+    {
+    public:
+
+        Inflate();
+        ~Inflate();
+
+        /* Sets the next chunk of compressed data. The chunk must stay
+         * valid until avail() returns 0. */
+        void   input(const void* ptr, size_t size);
+
+        /* amount of compressed input not consumed yet */
+        size_t avail() const;
+
+        /* Decompresses into the buffer. Output pending from the previous
+         * call is produced even if all input has been consumed.
+         * @return number of bytes produced, 0 if more input is needed */
+        size_t output(void* ptr, size_t size);
+
+    private:
+
+        z_stream_s* strm_;
+        bool        pending_; // previous output() filled the buffer
+
+        Inflate(const Inflate&);
+        Inflate& operator=(const Inflate&);
+    };
+}
+
+#endif /* _GU_DEFLATE_HPP_ */
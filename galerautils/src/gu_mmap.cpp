@@ -20,6 +20,15 @@
 #include <unistd.h>
 #include "gu_limits.h"
 
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
 #if defined(__FreeBSD__) && defined(MAP_NORESERVE)
 /* FreeBSD has never implemented this flags and will deprecate it. */
 #undef MAP_NORESERVE
@@ -84,8 +93,137 @@ namespace gu
         }
     }
 
+    bool
+    MMap::huge_pages() const
+    {
+#if defined(MADV_HUGEPAGE)
+        if (::madvise(ptr, size, MADV_HUGEPAGE))
+        {
+            int const err(errno);
+            log_warn << "Failed to set MADV_HUGEPAGE on " << ptr << ": "
+                     << err << " (" << strerror(err) << ')';
+            return false;
+        }
+
+        return true;
+#else
+        log_warn << "Transparent huge pages are not supported on this system";
+        return false;
+#endif /* MADV_HUGEPAGE */
+    }
+
+    bool
+    MMap::bind_node(int const node) const
+    {
+#if defined(__linux__) && defined(SYS_mbind)
+        /* from <numaif.h>, to avoid dependency on libnuma */
+        static int      const MPOL_BIND_   (2);
+        static unsigned const MPOL_MF_MOVE_(1 << 1);
+        static int      const MAX_NODES    (1024);
+        static int      const MASK_BITS    (sizeof(unsigned long) * 8);
+
+        if (node < 0 || node >= MAX_NODES)
+        {
+            log_warn << "Invalid NUMA node " << node << ", must be in [0, "
+                     << MAX_NODES << ')';
+            return false;
+        }
+
+        unsigned long mask[MAX_NODES / MASK_BITS] = { 0, };
+        mask[node / MASK_BITS] = 1UL << (node % MASK_BITS);
+
+        /* maxnode is the number of mask bits plus one */
+        if (::syscall(SYS_mbind, ptr, size, MPOL_BIND_, mask,
+                      static_cast<unsigned long>(MAX_NODES) + 1,
+                      MPOL_MF_MOVE_))
+        {
+            int const err(errno);
+            log_warn << "Failed to bind " << ptr << " to NUMA node " << node
+                     << ": " << err << " (" << strerror(err) << ')';
+            return false;
+        }
+
+        return true;
+#else
+        log_warn << "NUMA memory binding is not supported on this system";
+        return false;
+#endif /* __linux__ && SYS_mbind */
+    }
+
+    size_t
+    MMap::huge_pages_size() const
+    {
+        return huge_pages_size(Ranges(1, range()));
+    }
+
+    /* whether [begin, end) overlaps any of the ranges */
+    static bool
+    overlaps(const MMap::Ranges& ranges,
+             unsigned long const begin, unsigned long const end)
+    {
+        for (MMap::Ranges::const_iterator i(ranges.begin());
+             i != ranges.end(); ++i)
+        {
+            unsigned long const b(reinterpret_cast<uintptr_t>(i->first));
+
+            if (b < end && b + i->second > begin) return true;
+        }
+
+        return false;
+    }
+
+    size_t
+    MMap::huge_pages_size(const Ranges& ranges)
+    {
+        if (ranges.empty()) return 0;
+
+        std::ifstream smaps("/proc/self/smaps");
+        if (!smaps) return 0;
+
+        static const char* const fields[] =
+        {
+            "AnonHugePages:", "ShmemPmdMapped:", "FilePmdMapped:",
+            "Shared_Hugetlb:", "Private_Hugetlb:", NULL
+        };
+
+        size_t     ret(0);
+        bool       in_range(false);
+        std::string line;
+
+        while (std::getline(smaps, line))
+        {
+            unsigned long vma_begin, vma_end;
+
+            /* VMA header: "begin-end perms offset dev inode path" */
+            if (2 == sscanf(line.c_str(), "%lx-%lx", &vma_begin, &vma_end))
+            {
+                in_range = overlaps(ranges, vma_begin, vma_end);
+                continue;
+            }
+
+            if (!in_range) continue;
+
+            for (int i(0); fields[i] != NULL; ++i)
+            {
+                size_t const len(strlen(fields[i]));
+
+                if (0 == line.compare(0, len, fields[i]))
+                {
+                    unsigned long kb(0);
+                    if (1 == sscanf(line.c_str() + len, "%lu", &kb))
+                    {
+                        ret += kb << 10;
+                    }
+                    break;
+                }
+            }
+        }
+
+        return ret;
+    }
+
     void
-    MMap::sync(void* const addr, size_t const length) const
+    MMap::sync(void* const addr, size_t const length, bool const async) const
     {
         /* libc msync() only accepts addresses multiple of page size,
          * rounding down */
@@ -96,7 +234,7 @@ namespace gu
         size_t   const sync_length
             (length + (static_cast<uint8_t*>(addr) - sync_addr));
 
-        if (::msync(sync_addr, sync_length, MS_SYNC) < 0)
+        if (::msync(sync_addr, sync_length, async ? MS_ASYNC : MS_SYNC) < 0)
         {
             gu_throw_error(errno) << "msync(" << sync_addr << ", "
                                   << sync_length << ") failed";
@@ -9,6 +9,9 @@
 
 #include "gu_fdesc.hpp"
 
+#include <utility>
+#include <vector>
+
 namespace gu
 {
 
@@ -17,6 +20,10 @@ class MMap
 
 public:
 
+    /* address range of a mapping: (ptr, size) */
+    typedef std::pair<const void*, size_t> Range;
+    typedef std::vector<Range>             Ranges;
+
     size_t const size;
     void*  const ptr;
 
@@ -25,7 +32,26 @@ public:
     ~MMap ();
 
     void dont_need() const;
-    void sync(void *addr, size_t length) const;
+
+    /* Advises the kernel to back the mapping with transparent huge pages.
+     * @return false if not supported or failed */
+    bool huge_pages() const;
+
+    /* Binds the mapping memory to NUMA node, moves pages already there.
+     * @return false if not supported or failed */
+    bool bind_node(int node) const;
+
+    /* @return number of bytes of the mapping backed by huge pages */
+    size_t huge_pages_size() const;
+
+    /* @return number of bytes of all ranges backed by huge pages,
+     *         /proc/self/smaps is parsed once for all of them */
+    static size_t huge_pages_size(const Ranges& ranges);
+
+    Range range() const { return Range(ptr, size); }
+
+    /* @param async only schedule writeback of the range (MS_ASYNC) */
+    void sync(void *addr, size_t length, bool async = false) const;
     void sync() const;
     void unmap();
 
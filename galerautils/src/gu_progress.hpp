@@ -9,6 +9,7 @@
 #include "gu_datetime.hpp"
 
 #include <string>
+#include <sstream>
 #include <iomanip>
 #include <cmath>
 
@@ -26,18 +27,48 @@ namespace gu
         T const total_;
         T       current_;
         T       last_size_;
+        T       last_reported_;
+        unsigned long long bytes_;
+        unsigned long long last_bytes_;
+        gu::datetime::Date const start_time_;
         gu::datetime::Date last_time_;
         unsigned char const total_digits_;
 
-        void report(gu::datetime::Date const now)
+        /* logs progress and the rate since the given point */
+        void report(gu::datetime::Date const now,
+                    T const                  since_units,
+                    unsigned long long const since_bytes,
+                    gu::datetime::Date const since_time)
         {
+            double const secs(double((now - since_time).get_nsecs()) /
+                              gu::datetime::Sec);
+
+            std::ostringstream rate;
+            if (secs > 0)
+            {
+                rate << std::fixed << std::setprecision(1) << ", "
+                     << (current_ - since_units)/secs << units_ << "/s";
+                if (bytes_ > 0)
+                {
+                    rate << ", " << (bytes_ - since_bytes)/secs/(1 << 20)
+                         << " MB/s";
+                }
+            }
+
             log_info << prefix_ << "..."
                      << std::fixed << std::setprecision(1) << std::setw(5)
                      << (double(current_)/total_ * 100) << "% ("
                      << std::setw(total_digits_) << current_ << '/' << total_
-                     << units_ << ") complete.";
+                     << units_ << ") complete" << rate.str() << '.';
 
-            last_time_ = now;
+            last_time_     = now;
+            last_reported_ = current_;
+            last_bytes_    = bytes_;
+        }
+
+        void report(gu::datetime::Date const now)
+        {
+            report(now, last_reported_, last_bytes_, last_time_);
         }
 
         static std::string const DEFAULT_INTERVAL; // see definition below
@@ -68,17 +99,23 @@ namespace gu
             total_        (t),
             current_      (0),
             last_size_    (current_),
-            last_time_    (),
+            last_reported_(current_),
+            bytes_        (0),
+            last_bytes_   (0),
+            start_time_   (gu::datetime::Date::monotonic()),
+            last_time_    (start_time_),
             total_digits_ (::ceil(::log10(total_ + 1)))
         {
-            report(gu::datetime::Date::monotonic());
+            report(start_time_);
         }
 
-        /* Increments progress by @increment.
+        /* Increments progress by @increment and, optionally, the amount of
+         * processed data by @bytes to report throughput in MB/s.
          * If time limit is reached, logs the total progress */
-        void update(T const increment)
+        void update(T const increment, unsigned long long const bytes = 0)
         {
             current_ += increment;
+            bytes_   += bytes;
 
             if (current_ - last_size_ >= unit_interval_
                 /* don't log too close to the end */
@@ -93,11 +130,11 @@ namespace gu
             }
         }
 
-        /* Logs the end of the progress (100%) */
+        /* Logs the end of the progress (100%) with the average rate */
         void finish()
         {
             current_ = total_;
-            report(gu::datetime::Date::monotonic());
+            report(gu::datetime::Date::monotonic(), 0, 0, start_time_);
         }
     }; /* class Progress */
 
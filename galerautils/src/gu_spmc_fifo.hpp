@@ -0,0 +1,632 @@
+// Copyright (C) 2020 Codership Oy <info@codership.com>
+
+/**
+ * @file Bounded single producer/multiple consumers FIFO queue.
+ *
+ * A replacement for gu_fifo_t for the case when there is exactly one thread
+ * adding items (e.g. GCS receive thread) and many threads fetching them
+ * (e.g. slave threads). Producer and consumers synchronize only via atomic
+ * head and tail positions: the producer publishes an item by advancing the
+ * tail, consumers claim items by CAS on the head. Mutex and condition
+ * variables are used only to park threads that have nothing to do, and only
+ * after an adaptive spin.
+ *
+ * Like in gu_fifo_t memory is allocated lazily in rows, so the maximum queue
+ * length can be made large at little cost. A row is freed by the producer
+ * when all its items have been fetched. Items are copied out on fetch, so T
+ * should be a small POD type.
+ *
+ * gu_fifo_t close/open and cancel/resume gets semantics are preserved with
+ * one addition: an item can be pushed as a "barrier", fetching it atomically
+ * cancels further gets until resume_gets() is called. This is what
+ * gu_fifo_cancel_gets() under gu_fifo_t lock was used for.
+ */
+
+#ifndef GU_SPMC_FIFO_HPP
+#define GU_SPMC_FIFO_HPP
+
+#include "gu_atomic.hpp"
+#include "gu_logger.hpp"
+#include "gu_mutex.hpp"
+#include "gu_cond.hpp"
+#include "gu_lock.hpp"
+#include "gu_throw.hpp"
+#include "gu_limits.h"
+#include "gu_mem.h"
+
+#include <unistd.h> // sysconf()
+#include <deque>
+#include <cerrno>
+#include <cstring> // strerror()
+#include <cassert>
+
+namespace gu
+{
+
+/* a hint to CPU that we are in a spin loop */
+static inline void spin_pause()
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__ ("yield");
+#endif
+}
+
+template <typename T>
+class SpmcFifo
+{
+public:
+
+    /*! @param length minimum number of items the queue must be able to hold
+     *  @throws gu::Exception if length is zero or would not fit in memory */
+    explicit SpmcFifo(size_t length);
+
+    /*! closes the queue and blocks until all items are fetched */
+    ~SpmcFifo();
+
+    /* Producer interface, must be called from a single thread */
+
+    /*! Returns a pointer to the tail slot, blocks if the queue is full.
+     *  Returns NULL if the queue is closed. */
+    T*   get_tail();
+
+    /*! Publishes the tail slot. If barrier is true, fetching this item
+     *  cancels further gets until resume_gets(). */
+    void push_tail(bool barrier = false);
+
+    /*! Drops all items currently in the queue */
+    void clear();
+
+    /* Consumer interface */
+
+    /*! Copies the head item to item and removes it from the queue,
+     *  blocks if the queue is empty. Returns false and sets err to
+     *  -ENODATA if the queue is closed and empty or -ECANCELED
+     *  if gets were canceled. */
+    bool get_head    (T& item, int& err) { return get(item, err, true);  }
+
+    /*! Same as get_head(), but sets err to -EAGAIN instead of blocking */
+    bool try_get_head(T& item, int& err) { return get(item, err, false); }
+
+    /*! Cancels gets until resume_gets() */
+    int  cancel_gets();
+
+    /*! Resumes canceled gets */
+    int  resume_gets();
+
+    void open();
+    void close();
+
+    /*! returns how many items are in the queue */
+    long length() const
+    {
+        pos_t const head(head_() >> 1); // head first: tail never lags it
+        return tail_() - head;
+    }
+
+    /*! Returns the number of items the queue is guaranteed to hold */
+    long max_length() const { return length_ - row_len_; }
+
+    void stats_get  (int* q_len, int* q_len_max, int* q_len_min,
+                     double* q_len_avg) const;
+    void stats_flush();
+
+private:
+
+    typedef unsigned long long pos_t;
+
+    /* Don't make rows less than 1K */
+    static int   const MIN_ROW_POWER = 10;
+    /* head_ low bit: gets are canceled */
+    static pos_t const CANCELED      = 1;
+    /* barrier_ value when there is no barrier item in the queue */
+    static pos_t const NO_BARRIER    = ~pos_t(0);
+    /* upper bound on spin iterations before parking */
+    static int   const MAX_SPIN      = 1 << 12;
+
+    size_t row(pos_t const pos) const { return (pos >> col_shift_) & row_mask_;}
+    size_t col(pos_t const pos) const { return pos & col_mask_; }
+
+    T* slot(pos_t const pos) const { return rows_[row(pos)] + col(pos); }
+
+    bool get         (T& item, int& err, bool block);
+    void fetched     (pos_t pos);
+    void next_barrier();
+    void park_get    ();
+    void wake_gets   ();
+    bool start_row   (pos_t pos);
+    void reclaim     ();
+
+    size_t const       col_shift_;
+    pos_t  const       col_mask_;
+    size_t const       row_len_;
+    size_t const       row_mask_;
+    size_t const       row_size_;
+    pos_t  const       length_;
+
+    T**                rows_;
+    gu::Atomic<long>*  done_;     // items fetched per row
+    pos_t              reclaim_;  // producer private: oldest allocated row
+
+    gu::Atomic<pos_t>  head_;     // (position << 1) | CANCELED
+    gu::Atomic<pos_t>  tail_;
+    gu::Atomic<pos_t>  barrier_;  // position of the next barrier item
+    std::deque<pos_t>  barriers_; // positions of the following ones
+    gu::Atomic<int>    closed_;
+
+    gu::Atomic<int>    get_wait_;
+    gu::Atomic<int>    get_woken_; // signaled getters not yet awake
+    gu::Atomic<int>    put_wait_;
+    gu::Atomic<int>    spin_;      // current adaptive spin budget
+    int const          max_spin_;
+
+    gu::Mutex          mtx_;
+    gu::Cond           get_cond_;
+    gu::Cond           put_cond_;
+
+    /* updated only by producer, so can be read unprotected */
+    long               used_max_;
+    gu::Atomic<long>   used_min_;
+    long long          q_len_;
+    long long          q_len_samples_;
+
+    SpmcFifo(const SpmcFifo&);
+    SpmcFifo& operator=(const SpmcFifo&);
+
+    /* find the best ratio of width and height: the size of a row array must
+     * be equal to that of the row, like in gu_fifo_create() */
+    static int row_power(size_t length)
+    {
+        if (0 == length) gu_throw_error(EINVAL) << "Zero FIFO length";
+
+        int   row_pwr  (MIN_ROW_POWER);
+        pos_t row_len  (1 << row_pwr);
+        pos_t array_len(2); // need at least 2 rows for alteration
+
+        /* since rows are reused as a whole one row is kept in reserve */
+        while (array_len * row_len < length + row_len)
+        {
+            if (array_len * sizeof(T*) < row_len * sizeof(T))
+                array_len <<= 1;
+            else
+                row_len = pos_t(1) << ++row_pwr;
+        }
+
+        return row_pwr;
+    }
+
+    static size_t rows_num(size_t length)
+    {
+        pos_t const row_len(pos_t(1) << row_power(length));
+        pos_t rows(2);
+        while (rows * row_len < length + row_len) rows <<= 1;
+
+        pos_t const max_size(rows * (row_len * sizeof(T) + sizeof(T*) +
+                                     sizeof(long)));
+
+        if (max_size > gu_avphys_bytes())
+        {
+            gu_throw_error(ENOMEM) << "Maximum FIFO size " << max_size
+                                   << " exceeds available memory limit "
+                                   << gu_avphys_bytes();
+        }
+
+        if (rows * row_len > pos_t(GU_LONG_MAX))
+        {
+            gu_throw_error(EINVAL) << "Resulting queue length "
+                                   << rows * row_len
+                                   << " exceeds max allowed " << GU_LONG_MAX;
+        }
+
+        return rows;
+    }
+};
+
+template <typename T>
+SpmcFifo<T>::SpmcFifo(size_t const length)
+    :
+    col_shift_    (row_power(length)),
+    col_mask_     ((pos_t(1) << col_shift_) - 1),
+    row_len_      (col_mask_ + 1),
+    row_mask_     (rows_num(length) - 1),
+    row_size_     (row_len_ * sizeof(T)),
+    length_       ((row_mask_ + 1) * row_len_),
+    rows_         (new T*[row_mask_ + 1]),
+    done_         (new gu::Atomic<long>[row_mask_ + 1]),
+    reclaim_      (0),
+    head_         (0),
+    tail_         (0),
+    barrier_      (NO_BARRIER),
+    barriers_     (),
+    closed_       (0),
+    get_wait_     (0),
+    get_woken_    (0),
+    put_wait_     (0),
+    spin_         (0),
+    max_spin_     (sysconf(_SC_NPROCESSORS_ONLN) > 1 ? MAX_SPIN : 0),
+    mtx_          (),
+    get_cond_     (),
+    put_cond_     (),
+    used_max_     (0),
+    used_min_     (0),
+    q_len_        (0),
+    q_len_samples_(0)
+{
+    for (size_t i(0); i <= row_mask_; ++i) rows_[i] = NULL;
+
+    log_debug << "Creating SPMC FIFO of " << length_ << " elements of size "
+              << sizeof(T) << ", memory max used: "
+              << (row_mask_ + 1) * row_size_;
+}
+
+template <typename T>
+SpmcFifo<T>::~SpmcFifo()
+{
+    close();
+
+    {
+        gu::Lock lock(mtx_);
+        while (length() > 0)
+        {
+            /* will make getters to signal every time item is removed */
+            log_warn << "Waiting for " << length() << " items to be fetched.";
+            put_wait_ = 1;
+            lock.wait(put_cond_);
+        }
+        put_wait_ = 0;
+    }
+
+    for (size_t i(0); i <= row_mask_; ++i) gu_free(rows_[i]);
+
+    delete[] done_;
+    delete[] rows_;
+}
+
+template <typename T> bool
+SpmcFifo<T>::start_row(pos_t const pos)
+{
+    size_t const r(row(pos));
+
+    reclaim();
+
+    if (gu_unlikely(NULL != rows_[r]))
+    {
+        /* the previous lap of this row is still being fetched: queue is full */
+        assert(reclaim_ + length_ == pos);
+
+        gu::Lock lock(mtx_);
+        put_wait_ = 1;
+        while (done_[r]() < long(row_len_) && !closed_())
+        {
+            lock.wait(put_cond_);
+        }
+        put_wait_ = 0;
+
+        if (closed_()) return false;
+
+        /* reuse the row */
+        done_[r] = 0;
+        reclaim_ += row_len_;
+        return true;
+    }
+
+    rows_[r] = static_cast<T*>(gu_malloc(row_size_));
+
+    return (rows_[r] != NULL);
+}
+
+/* frees rows whose items have all been fetched */
+template <typename T> void
+SpmcFifo<T>::reclaim()
+{
+    pos_t const tail(tail_());
+
+    while (reclaim_ + row_len_ <= tail)
+    {
+        size_t const r(row(reclaim_));
+
+        if (done_[r]() < long(row_len_)) break;
+
+        gu_free(rows_[r]);
+        rows_[r] = NULL;
+        done_[r] = 0;
+        reclaim_ += row_len_;
+    }
+}
+
+template <typename T> T*
+SpmcFifo<T>::get_tail()
+{
+    if (gu_unlikely(closed_())) return NULL; // stop adding items when closed
+
+    pos_t const tail(tail_());
+
+    if (0 == col(tail) && !start_row(tail)) return NULL;
+
+    return slot(tail);
+}
+
+template <typename T> void
+SpmcFifo<T>::push_tail(bool const barrier)
+{
+    pos_t const tail(tail_());
+    long  const used(tail - (head_() >> 1));
+
+    if (gu_unlikely(barrier))
+    {
+        gu::Lock lock(mtx_);
+        if (NO_BARRIER == barrier_()) barrier_ = tail;
+        else barriers_.push_back(tail);
+    }
+
+    q_len_ += used;
+    q_len_samples_++;
+    if (gu_unlikely(used + 1 > used_max_)) used_max_ = used + 1;
+
+    tail_ = tail + 1;
+
+    /* don't signal again until the signaled getter has woken up */
+    if (get_wait_() > get_woken_())
+    {
+        gu::Lock lock(mtx_);
+        if (get_wait_() > get_woken_())
+        {
+            get_woken_ += 1;
+            get_cond_.signal();
+        }
+    }
+}
+
+template <typename T> void
+SpmcFifo<T>::fetched(pos_t const pos)
+{
+    long const used(tail_() - pos - 1);
+
+    for (long min(used_min_()); used < min; min = used_min_())
+    {
+        if (used_min_.compare_and_swap(min, used)) break;
+    }
+
+    done_[row(pos)] += 1;
+
+    if (put_wait_() > 0)
+    {
+        gu::Lock lock(mtx_);
+        put_cond_.signal();
+    }
+}
+
+/* Called by the consumer that fetched the barrier item. Since gets are
+ * canceled at that point, nobody can get past the next barrier meanwhile. */
+template <typename T> void
+SpmcFifo<T>::next_barrier()
+{
+    gu::Lock lock(mtx_);
+
+    if (barriers_.empty())
+    {
+        barrier_ = NO_BARRIER;
+    }
+    else
+    {
+        barrier_ = barriers_.front();
+        barriers_.pop_front();
+    }
+}
+
+template <typename T> bool
+SpmcFifo<T>::get(T& item, int& err, bool const block)
+{
+    int const budget(block ? spin_() : 0);
+    int spins(0);
+
+    for (;;)
+    {
+        pos_t const head(head_());
+
+        if (gu_unlikely(head & CANCELED))
+        {
+            err = -ECANCELED;
+            return false;
+        }
+
+        pos_t const pos(head >> 1);
+
+        if (pos < tail_())
+        {
+            bool const barrier(pos == barrier_());
+
+            if (head_.compare_and_swap(head, ((pos + 1) << 1) |
+                                       (barrier ? CANCELED : 0)))
+            {
+                item = *slot(pos);
+
+                if (gu_unlikely(barrier))
+                {
+                    next_barrier();
+                    /* force other getters to quit with specific error */
+                    wake_gets();
+                }
+
+                fetched(pos);
+
+                if (spins > 0 && budget < max_spin_)
+                {
+                    spin_ = budget + budget / 2 + 1; // spinning paid off
+                }
+
+                err = 0;
+                return true;
+            }
+
+            continue; // another consumer got it, retry
+        }
+
+        if (closed_())
+        {
+            err = -ENODATA;
+            return false;
+        }
+
+        if (!block)
+        {
+            err = -EAGAIN;
+            return false;
+        }
+
+        if (spins < budget)
+        {
+            ++spins;
+            spin_pause();
+            continue;
+        }
+
+        park_get();
+        if (budget > 0) spin_ = budget / 2; // spinning was in vain
+        spins = 0;
+    }
+}
+
+template <typename T> void
+SpmcFifo<T>::park_get()
+{
+    gu::Lock lock(mtx_);
+
+    get_wait_ += 1;
+
+    while (0 == length() && !(head_() & CANCELED) && !closed_())
+    {
+        lock.wait(get_cond_);
+        if (get_woken_() > 0) get_woken_ += -1;
+    }
+
+    get_wait_ += -1;
+}
+
+template <typename T> void
+SpmcFifo<T>::wake_gets()
+{
+    if (get_wait_() > 0)
+    {
+        gu::Lock lock(mtx_);
+        get_woken_ = get_wait_();
+        get_cond_.broadcast();
+    }
+}
+
+template <typename T> void
+SpmcFifo<T>::clear()
+{
+    for (pos_t head(head_()); (head >> 1) < tail_(); head = head_())
+    {
+        pos_t const pos(head >> 1);
+
+        if (head_.compare_and_swap(head, ((pos + 1) << 1) | (head & CANCELED)))
+        {
+            if (gu_unlikely(pos == barrier_())) next_barrier();
+            fetched(pos);
+        }
+    }
+}
+
+template <typename T> int
+SpmcFifo<T>::cancel_gets()
+{
+    for (pos_t head(head_()); !(head & CANCELED); head = head_())
+    {
+        if (head_.compare_and_swap(head, head | CANCELED))
+        {
+            wake_gets();
+            return 0;
+        }
+    }
+
+    log_error << "Attempt to cancel FIFO gets in state: " << -ECANCELED
+              << " (" << strerror(ECANCELED) << ")";
+    return -EBADFD;
+}
+
+template <typename T> int
+SpmcFifo<T>::resume_gets()
+{
+    for (pos_t head(head_()); head & CANCELED; head = head_())
+    {
+        if (head_.compare_and_swap(head, head & ~CANCELED))
+        {
+            /* items might have been pushed while gets were canceled */
+            wake_gets();
+            return 0;
+        }
+    }
+
+    int const err(closed_() ? -ENODATA : 0);
+    log_error << "Attempt to resume FIFO gets in state: " << err
+              << " (" << strerror(-err) << ")";
+    return -EBADFD;
+}
+
+template <typename T> void
+SpmcFifo<T>::open()
+{
+    gu::Lock lock(mtx_);
+
+    closed_ = 0;
+
+    for (pos_t head(head_()); head & CANCELED; head = head_())
+    {
+        if (head_.compare_and_swap(head, head & ~CANCELED)) break;
+    }
+}
+
+template <typename T> void
+SpmcFifo<T>::close()
+{
+    gu::Lock lock(mtx_);
+
+    if (!closed_())
+    {
+        closed_ = 1; /* force putters to quit */
+
+        // signal all the idle waiting threads
+        put_cond_.broadcast();
+        get_woken_ = get_wait_();
+        get_cond_.broadcast();
+    }
+}
+
+template <typename T> void
+SpmcFifo<T>::stats_get(int* const q_len, int* const q_len_max,
+                       int* const q_len_min, double* const q_len_avg) const
+{
+    *q_len     = length();
+    *q_len_max = used_max_;
+    *q_len_min = used_min_();
+
+    long long const len    (q_len_);
+    long long const samples(q_len_samples_);
+
+    if (len >= 0 && samples >= 0)
+    {
+        *q_len_avg = samples > 0 ? double(len) / samples : 0.0;
+    }
+    else
+    {
+        *q_len_avg = -1.0;
+    }
+}
+
+template <typename T> void
+SpmcFifo<T>::stats_flush()
+{
+    long const used(length());
+
+    used_max_      = used;
+    used_min_      = used;
+    q_len_         = 0;
+    q_len_samples_ = 0;
+}
+
+} /* namespace gu */
+
+#endif /* GU_SPMC_FIFO_HPP */
@@ -126,5 +126,6 @@ int main()
     one_length(31,  1<<21 /* 2M   */);
     one_length(64,  1<<20 /* 1M   */);
     one_length(512, 1<<17 /* 128K */);
+    one_length(1<<13, 1<<13 /* 8K  */);
     one_length(1<<20,  64 /* 1M   */);
 }
@@ -30,6 +30,9 @@ START_TEST(test_sanity_c)
     j = gu_atomic_and_and_fetch (&i, 13); ck_assert(j ==  5); ck_assert(i ==  5);
     j = gu_atomic_xor_and_fetch (&i, 15); ck_assert(j == 10); ck_assert(i == 10);
     j = gu_atomic_nand_and_fetch(&i,  7); ck_assert(j == -3); ck_assert(i == -3);
+
+    ck_assert(!gu_atomic_bool_compare_and_swap(&i, 3, 4)); ck_assert(i == -3);
+    ck_assert( gu_atomic_bool_compare_and_swap(&i,-3, 4)); ck_assert(i ==  4);
 }
 END_TEST
 
@@ -49,6 +52,9 @@ START_TEST(test_sanity_cxx)
     ck_assert((++i)() == 9); ck_assert(i() == 9);
     ck_assert((--i)() == 8); ck_assert(i() == 8);
     i += 3; ck_assert(i() == 11);
+
+    ck_assert(!i.compare_and_swap(10, 12)); ck_assert(i() == 11);
+    ck_assert( i.compare_and_swap(11, 12)); ck_assert(i() == 12);
 }
 END_TEST
 
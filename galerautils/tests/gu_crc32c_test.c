@@ -8,6 +8,7 @@
 
 #include "gu_crc32c_test.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 #define long_input                     \
@@ -138,6 +139,39 @@ START_TEST(test_gu_crc32c_x86_64)
     test_function();
 }
 END_TEST
+
+/* long buffers are split into interleaved streams, compare to SW result */
+START_TEST(test_gu_crc32c_x86_64_long)
+{
+    static size_t const lengths[] =
+        { 767, 768, 769, 3*256*5 + 13, 24575, 24576, 24577, 3*8192*4 + 771 };
+    static size_t const max_len = 3*8192*4 + 771 + 8;
+
+    uint8_t* const buf = (uint8_t*)malloc(max_len);
+    ck_assert(NULL != buf);
+
+    size_t i;
+    for (i = 0; i < max_len; i++) buf[i] = (uint8_t)(i * 7 + (i >> 8));
+
+    for (i = 0; i < sizeof(lengths)/sizeof(lengths[0]); i++)
+    {
+        size_t off;
+        for (off = 0; off < 8; off++)
+        {
+            uint32_t const sw =
+                ~gu_crc32c_slicing_by_8(GU_CRC32C_INIT, buf + off, lengths[i]);
+            uint32_t const hw =
+                ~gu_crc32c_x86_64(GU_CRC32C_INIT, buf + off, lengths[i]);
+
+            ck_assert_msg(sw == hw, "Length %zu, offset %zu: "
+                          "generated %#08x, expected %#08x\n",
+                          lengths[i], off, hw, sw);
+        }
+    }
+
+    free(buf);
+}
+END_TEST
 #endif /* GU_CRC32C_X86_64 */
 #endif /* GU_CRC32C_X86 */
 
@@ -174,6 +208,7 @@ Suite *gu_crc32c_suite(void)
     tcase_add_test  (t, test_gu_crc32c_x86);
 #if defined(GU_CRC32C_X86_64)
     tcase_add_test  (t, test_gu_crc32c_x86_64);
+    tcase_add_test  (t, test_gu_crc32c_x86_64_long);
 #endif /* GU_CRC32C_X86_64 */
 #endif /* GU_CRC32C_X86 */
 
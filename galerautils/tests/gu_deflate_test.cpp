@@ -0,0 +1,180 @@
+// Copyright (C) 2020 Codership Oy <info@codership.com>
+
+#include "../src/gu_deflate.hpp"
+#include "../src/gu_exception.hpp"
+
+#include "gu_deflate_test.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+/* semi-compressible data: repeating text with a varying counter */
+static void
+fill(std::vector<gu::byte_t>& buf, int seed)
+{
+    for (size_t i(0); i < buf.size(); ++i)
+    {
+        buf[i] = (i % 64 < 48) ? 'a' + (i % 26) : (seed + i / 64) & 0xff;
+    }
+}
+
+/* inflates everything available into out */
+static void
+drain(gu::Inflate& inf, std::vector<gu::byte_t>& out)
+{
+    gu::byte_t buf[1000]; // odd size to make output span calls
+    size_t n;
+    while ((n = inf.output(buf, sizeof(buf))) > 0)
+    {
+        out.insert(out.end(), buf, buf + n);
+    }
+    ck_assert(0 == inf.avail());
+}
+
+START_TEST(stream)
+{
+    gu::Deflate def(1);
+    gu::Inflate inf;
+
+    std::vector<gu::byte_t> orig;
+    std::vector<gu::byte_t> out;
+
+    for (int chunk(0); chunk < 20; ++chunk)
+    {
+        std::vector<gu::byte_t> data(1 + chunk * 7919);
+        fill(data, chunk);
+        orig.insert(orig.end(), data.begin(), data.end());
+
+        /* several appends followed by flush, like IST message batch */
+        size_t const half(data.size() / 2);
+        def.append(&data[0], half);
+        def.append(&data[half], data.size() - half);
+        def.flush();
+
+        ck_assert(def.size() > 0);
+        ck_assert(def.size() < data.size() + 64);
+
+        /* after flush everything appended so far must be decodable */
+        size_t const expected(out.size() + data.size());
+
+        /* feed compressed data in pieces */
+        const gu::byte_t* const z(def.data());
+        size_t const piece(def.size() / 3 + 1);
+        for (size_t off(0); off < def.size(); off += piece)
+        {
+            inf.input(z + off, std::min(piece, def.size() - off));
+            drain(inf, out);
+        }
+        def.clear();
+
+        ck_assert_msg(out.size() == expected, "got %zu bytes, expected %zu",
+                      out.size(), expected);
+    }
+
+    ck_assert(out == orig);
+}
+END_TEST
+
+START_TEST(ratio)
+{
+    gu::Deflate def(1);
+    std::vector<gu::byte_t> data(1 << 20);
+    fill(data, 0);
+
+    def.append(&data[0], data.size());
+    def.flush();
+    ck_assert_msg(def.size() * 3 < data.size(), "compressed %zu to %zu",
+                  data.size(), def.size());
+
+    /* empty flush must not fail */
+    def.clear();
+    def.flush();
+}
+END_TEST
+
+START_TEST(pending)
+{
+    /* long matches give much more output than input */
+    std::vector<gu::byte_t> data(1 << 16, 'a');
+
+    gu::Deflate def(1);
+    def.append(&data[0], data.size());
+    def.flush();
+
+    gu::Inflate inf;
+    gu::Inflate ref; // inflates into a buffer large enough for everything
+    std::vector<gu::byte_t> out;
+    std::vector<gu::byte_t> ref_out;
+    std::vector<gu::byte_t> ref_buf(data.size());
+
+    /* one byte of input at a time, output must not wait for more */
+    for (size_t i(0); i < def.size(); ++i)
+    {
+        inf.input(def.data() + i, 1);
+
+        gu::byte_t buf[100]; // smaller than a match
+        size_t n;
+        while ((n = inf.output(buf, sizeof(buf))) > 0)
+        {
+            out.insert(out.end(), buf, buf + n);
+        }
+
+        ref.input(def.data() + i, 1);
+        n = ref.output(&ref_buf[0], ref_buf.size());
+        ref_out.insert(ref_out.end(), ref_buf.begin(), ref_buf.begin() + n);
+
+        ck_assert_msg(out.size() == ref_out.size(),
+                      "input %zu: got %zu bytes, expected %zu",
+                      i + 1, out.size(), ref_out.size());
+    }
+
+    ck_assert(out == data);
+}
+END_TEST
+
+START_TEST(corrupt)
+{
+    gu::Inflate inf;
+    gu::byte_t junk[64];
+    ::memset(junk, 0xff, sizeof(junk));
+    gu::byte_t buf[256];
+
+    inf.input(junk, sizeof(junk));
+
+    try
+    {
+        inf.output(buf, sizeof(buf));
+        ck_abort_msg("corrupted stream was not detected");
+    }
+    catch (gu::Exception& e)
+    {
+        ck_assert(e.get_errno() == EPROTO);
+    }
+}
+END_TEST
+
+Suite*
+gu_deflate_suite()
+{
+    Suite* s(suite_create("gu::Deflate"));
+    TCase* t;
+
+    t = tcase_create("stream");
+    tcase_add_test(t, stream);
+    suite_add_tcase(s, t);
+
+    t = tcase_create("ratio");
+    tcase_add_test(t, ratio);
+    suite_add_tcase(s, t);
+
+    t = tcase_create("pending");
+    tcase_add_test(t, pending);
+    suite_add_tcase(s, t);
+
+    t = tcase_create("corrupt");
+    tcase_add_test(t, corrupt);
+    suite_add_tcase(s, t);
+
+    return s;
+}
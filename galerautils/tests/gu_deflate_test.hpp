@@ -0,0 +1,10 @@
+// Copyright (C) 2020 Codership Oy <info@codership.com>
+
+#ifndef __gu_deflate_test__
+#define __gu_deflate_test__
+
+#include <check.h>
+
+extern Suite *gu_deflate_suite(void);
+
+#endif /* __gu_deflate_test__ */
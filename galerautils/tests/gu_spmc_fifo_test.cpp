@@ -0,0 +1,260 @@
+// Copyright (C) 2020 Codership Oy <info@codership.com>
+
+#include "../src/gu_spmc_fifo.hpp"
+
+#include "gu_spmc_fifo_test.hpp"
+
+#include <pthread.h>
+#include <vector>
+
+typedef gu::SpmcFifo<long> Fifo;
+
+static void
+push(Fifo& fifo, long const val, bool const barrier = false)
+{
+    long* const item(fifo.get_tail());
+    ck_assert_msg(item != NULL, "could not get tail for item %ld", val);
+    *item = val;
+    fifo.push_tail(barrier);
+}
+
+START_TEST(ctor)
+{
+    try
+    {
+        Fifo f(0);
+        ck_abort_msg("zero length FIFO created");
+    }
+    catch (gu::Exception& e)
+    {
+        ck_assert(e.get_errno() == EINVAL);
+    }
+
+    Fifo f(1);
+    ck_assert(f.length() == 0);
+    ck_assert(f.max_length() >= 1);
+    f.close();
+}
+END_TEST
+
+START_TEST(fill_fetch)
+{
+    long const len(10000);
+    Fifo f(len);
+    long item;
+    int  err;
+
+    ck_assert(f.max_length() >= len);
+
+    f.clear(); // clear empty fifo
+    ck_assert(f.length() == 0);
+
+    for (long i(0); i < len; ++i) push(f, i);
+    ck_assert_msg(f.length() == len, "length is %ld, expected %ld",
+                  f.length(), len);
+
+    f.clear(); // clear filled fifo
+    ck_assert(f.length() == 0);
+
+    /* several laps over the ring to exercise row reuse and freeing */
+    long next(0);
+    for (long lap(0); lap < 5; ++lap)
+    {
+        for (long i(0); i < len; ++i) push(f, next + i);
+
+        for (long i(0); i < len; ++i)
+        {
+            ck_assert(f.try_get_head(item, err));
+            ck_assert(0 == err);
+            ck_assert_msg(item == next + i, "got %ld, expected %ld",
+                          item, next + i);
+        }
+
+        next += len;
+    }
+
+    ck_assert(f.length() == 0);
+    ck_assert(!f.try_get_head(item, err));
+    ck_assert(-EAGAIN == err);
+
+    int    q_len, q_len_max, q_len_min;
+    double q_len_avg;
+    f.stats_get(&q_len, &q_len_max, &q_len_min, &q_len_avg);
+    ck_assert(0 == q_len);
+    ck_assert(len == q_len_max);
+    ck_assert(0 == q_len_min);
+    ck_assert(q_len_avg > 0.0);
+
+    f.stats_flush();
+    f.stats_get(&q_len, &q_len_max, &q_len_min, &q_len_avg);
+    ck_assert(0 == q_len_max);
+    ck_assert(0.0 == q_len_avg);
+
+    f.close();
+    ck_assert(f.get_tail() == NULL);
+    ck_assert(!f.get_head(item, err));
+    ck_assert(-ENODATA == err);
+}
+END_TEST
+
+START_TEST(cancel_resume)
+{
+    Fifo f(16);
+    long item;
+    int  err;
+
+    push(f, 1);
+    push(f, 2, true); // barrier
+    push(f, 3);
+
+    ck_assert(f.get_head(item, err) && 1 == item);
+    ck_assert(f.get_head(item, err) && 2 == item);
+
+    /* fetching barrier must have canceled gets */
+    ck_assert(!f.get_head(item, err));
+    ck_assert(-ECANCELED == err);
+    ck_assert(f.length() == 1);
+    ck_assert(-EBADFD == f.cancel_gets());
+
+    ck_assert(0 == f.resume_gets());
+    ck_assert(-EBADFD == f.resume_gets());
+    ck_assert(f.get_head(item, err) && 3 == item);
+
+    ck_assert(0 == f.cancel_gets());
+    push(f, 4);
+    ck_assert(!f.try_get_head(item, err));
+    ck_assert(-ECANCELED == err);
+
+    /* closed queue still returns remaining items after resume */
+    f.close();
+    ck_assert(!f.get_head(item, err));
+    ck_assert(-ECANCELED == err);
+    ck_assert(0 == f.resume_gets());
+    ck_assert(f.get_head(item, err) && 4 == item);
+    ck_assert(!f.get_head(item, err));
+    ck_assert(-ENODATA == err);
+
+    /* open() clears both closed and canceled states */
+    ck_assert(0 == f.cancel_gets());
+    f.open();
+    push(f, 5);
+    ck_assert(f.get_head(item, err) && 5 == item);
+    f.close();
+}
+END_TEST
+
+struct Consumer
+{
+    Fifo*     fifo;
+    long      count;
+    long long sum;
+    long      last;
+    bool      ordered;
+    int       canceled;
+};
+
+static void*
+consumer_thd(void* arg)
+{
+    Consumer* const c(static_cast<Consumer*>(arg));
+    long item;
+    int  err;
+
+    for (;;)
+    {
+        if (c->fifo->get_head(item, err))
+        {
+            if (item < 0) // barrier, resume other consumers
+            {
+                c->canceled++;
+                c->fifo->resume_gets();
+                continue;
+            }
+            if (item <= c->last) c->ordered = false;
+            c->last = item;
+            c->count++;
+            c->sum += item;
+        }
+        else if (-ECANCELED != err)
+        {
+            ck_assert(-ENODATA == err);
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+START_TEST(concurrent)
+{
+    long const items(200000);
+    long const consumers(4);
+    /* small queue to make producer block on full queue */
+    Fifo f(2048);
+
+    std::vector<Consumer>  c(consumers);
+    std::vector<pthread_t> t(consumers);
+
+    for (long i(0); i < consumers; ++i)
+    {
+        Consumer const init = { &f, 0, 0, -1, true, 0 };
+        c[i] = init;
+        ck_assert(0 == pthread_create(&t[i], NULL, consumer_thd, &c[i]));
+    }
+
+    long barriers(0);
+    for (long i(0); i < items; ++i)
+    {
+        push(f, i);
+        if (0 == i % 10000) { push(f, -1, true); ++barriers; }
+    }
+
+    f.close();
+
+    long      count(0);
+    long long sum(0);
+    long      canceled(0);
+
+    for (long i(0); i < consumers; ++i)
+    {
+        pthread_join(t[i], NULL);
+        count    += c[i].count;
+        sum      += c[i].sum;
+        canceled += c[i].canceled;
+        /* every consumer must see items in queue order */
+        ck_assert(c[i].ordered);
+    }
+
+    ck_assert_msg(count == items, "fetched %ld items, expected %ld",
+                  count, items);
+    ck_assert(sum == (long long)items * (items - 1) / 2);
+    ck_assert(canceled == barriers);
+    ck_assert(f.length() == 0);
+}
+END_TEST
+
+Suite*
+gu_spmc_fifo_suite()
+{
+    Suite* s(suite_create("gu::SpmcFifo"));
+    TCase* t;
+
+    t = tcase_create("ctor");
+    tcase_add_test(t, ctor);
+    suite_add_tcase(s, t);
+
+    t = tcase_create("fill_fetch");
+    tcase_add_test(t, fill_fetch);
+    suite_add_tcase(s, t);
+
+    t = tcase_create("cancel_resume");
+    tcase_add_test(t, cancel_resume);
+    suite_add_tcase(s, t);
+
+    t = tcase_create("concurrent");
+    tcase_add_test(t, concurrent);
+    tcase_set_timeout(t, 120);
+    suite_add_tcase(s, t);
+
+    return s;
+}
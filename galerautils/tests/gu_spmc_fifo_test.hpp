@@ -0,0 +1,10 @@
+// Copyright (C) 2020 Codership Oy <info@codership.com>
+
+#ifndef __gu_spmc_fifo_test__
+#define __gu_spmc_fifo_test__
+
+#include <check.h>
+
+extern Suite *gu_spmc_fifo_suite(void);
+
+#endif /* __gu_spmc_fifo_test__ */
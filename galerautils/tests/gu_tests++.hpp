@@ -28,6 +28,8 @@
 #include "gu_thread_test.hpp"
 #include "gu_asio_test.hpp"
 #include "gu_deqmap_test.hpp"
+#include "gu_spmc_fifo_test.hpp"
+#include "gu_deflate_test.hpp"
 
 typedef Suite *(*suite_creator_t)(void);
 
@@ -51,6 +53,8 @@ static suite_creator_t suites[] =
     gu_thread_suite,
     gu_asio_suite,
     gu_deqmap_suite,
+    gu_spmc_fifo_suite,
+    gu_deflate_suite,
     0
 };
 
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2020 Codership Oy <info@codership.com>
+ */
+
+/**
+ * This is to benchmark single producer/multiple consumers throughput of
+ * gu::SpmcFifo against gu_fifo_t.
+ *
+ * One thread pushes items of the size of GCS receive queue action, the given
+ * number of consumer threads fetch them. Results are reported as items/sec.
+ *
+ * Usage: spmc_fifo_bench [items] [consumers] [queue length]
+ */
+
+#define NDEBUG 1
+
+#include "../src/gu_spmc_fifo.hpp"
+#include "../src/galerautils.h" // gu_fifo_t
+
+#include <pthread.h>
+#include <sys/time.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+static double time_diff(const struct timeval& l,
+                        const struct timeval& r)
+{
+    double const left(double(l.tv_usec)*1.0e-06 + l.tv_sec);
+    double const right(double(r.tv_usec)*1.0e-06 + r.tv_sec);
+    return left - right;
+}
+
+/* roughly the size of struct gcs_recv_act */
+struct Item
+{
+    long long seqno;
+    char      pad[88];
+};
+
+class GuFifo
+{
+public:
+
+    static const char* name() { return "gu_fifo_t"; }
+
+    explicit GuFifo(size_t len) : q_(gu_fifo_create(len, sizeof(Item))) {}
+    ~GuFifo() { gu_fifo_destroy(q_); }
+
+    void push(long long const seqno)
+    {
+        Item* const item(static_cast<Item*>(gu_fifo_get_tail(q_)));
+        item->seqno = seqno;
+        gu_fifo_push_tail(q_);
+    }
+
+    bool pop(Item& item)
+    {
+        int err;
+        const Item* const head(static_cast<Item*>(gu_fifo_get_head(q_, &err)));
+        if (NULL == head) return false;
+        item = *head;
+        gu_fifo_pop_head(q_);
+        return true;
+    }
+
+    void close() { gu_fifo_close(q_); }
+
+private:
+
+    gu_fifo_t* const q_;
+};
+
+class SpmcFifo
+{
+public:
+
+    static const char* name() { return "gu::SpmcFifo"; }
+
+    explicit SpmcFifo(size_t len) : q_(len) {}
+
+    void push(long long const seqno)
+    {
+        q_.get_tail()->seqno = seqno;
+        q_.push_tail();
+    }
+
+    bool pop(Item& item)
+    {
+        int err;
+        return q_.get_head(item, err);
+    }
+
+    void close() { q_.close(); }
+
+private:
+
+    gu::SpmcFifo<Item> q_;
+};
+
+template <class Fifo>
+struct Consumer
+{
+    Fifo*     fifo;
+    long long sum;
+};
+
+template <class Fifo> static void*
+consumer_thd(void* arg)
+{
+    Consumer<Fifo>* const c(static_cast<Consumer<Fifo>*>(arg));
+    Item item;
+
+    while (c->fifo->pop(item)) c->sum += item.seqno;
+
+    return NULL;
+}
+
+template <class Fifo> static double
+run_bench(long long const items, size_t const consumers, size_t const len)
+{
+    Fifo fifo(len);
+
+    std::vector<Consumer<Fifo> > c(consumers);
+    std::vector<pthread_t>       t(consumers);
+
+    struct timeval tv_begin, tv_end;
+    gettimeofday(&tv_begin, NULL);
+
+    for (size_t i(0); i < consumers; ++i)
+    {
+        c[i].fifo = &fifo;
+        c[i].sum  = 0;
+        pthread_create(&t[i], NULL, consumer_thd<Fifo>, &c[i]);
+    }
+
+    for (long long i(0); i < items; ++i) fifo.push(i);
+
+    fifo.close();
+
+    long long sum(0);
+    for (size_t i(0); i < consumers; ++i)
+    {
+        pthread_join(t[i], NULL);
+        sum += c[i].sum;
+    }
+
+    gettimeofday(&tv_end, NULL);
+
+    double const rate(items / time_diff(tv_end, tv_begin));
+
+    std::cout << Fifo::name() << ": items/sec: " << rate
+              << (sum == items * (items - 1) / 2 ? "" : " (checksum FAILED)")
+              << std::endl;
+
+    return rate;
+}
+
+template <typename T> static void
+read_arg(char* argv[], int position, T& var)
+{
+    std::string arg(argv[position]);
+    std::istringstream is(arg);
+    is >> var;
+}
+
+int main(int argc, char* argv[])
+{
+    long long items(4000000);
+    size_t    consumers(4);
+    size_t    len(1 << 16);
+
+    if (argc >= 2) read_arg(argv, 1, items);
+    if (argc >= 3) read_arg(argv, 2, consumers);
+    if (argc >= 4) read_arg(argv, 3, len);
+
+    if (consumers < 1) consumers = 1;
+
+    std::cout << "Running with parameters: items = " << items
+              << ", consumers = " << consumers
+              << ", queue length = " << len << '\n';
+
+    double const before(run_bench<GuFifo>  (items, consumers, len));
+    double const after (run_bench<SpmcFifo>(items, consumers, len));
+
+    std::cout << "speedup: " << after / before << std::endl;
+
+    return 0;
+}
@@ -49,7 +49,9 @@ namespace gcache
         gid       (),
         mem       (params.mem_size(), seqno2ptr, params.debug()),
         rb        (params.rb_name(), params.rb_size(), seqno2ptr, gid,
-                   params.debug(), params.recover()),
+                   params.debug(), params.recover(),
+                   params.seqno_index(),
+                   params.huge_pages(), params.numa_node()),
         ps        (params.dir_name(),
                    params.keep_pages_size(),
                    params.page_size(),
@@ -57,7 +59,8 @@ namespace gcache
                    /* keep last page if PS is the only storage */
                    params.keep_pages_count() ?
                    params.keep_pages_count() :
-                   !((params.mem_size() + params.rb_size()) > 0)),
+                   !((params.mem_size() + params.rb_size()) > 0),
+                   params.huge_pages(), params.numa_node()),
         mallocs   (0),
         reallocs  (0),
         frees     (0),
@@ -87,6 +90,23 @@ namespace gcache
                ps.allocated_pool_size();
     }
 
+    size_t GCache::huge_pages_size ()
+    {
+        /* walking /proc/self/smaps is not free, don't do it for nothing */
+        if (!params.huge_pages()) return 0;
+
+        gu::MMap::Ranges ranges;
+
+        {
+            /* smaps is parsed without the lock, only addresses are taken */
+            gu::Lock lock(mtx);
+            ranges.push_back(rb.mapping());
+            ps.mappings(ranges);
+        }
+
+        return gu::MMap::huge_pages_size(ranges);
+    }
+
     /*! prints object properties */
     void print (std::ostream& os) {}
 }
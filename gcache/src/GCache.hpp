@@ -84,6 +84,18 @@ namespace gcache
                 return SEQNO_ILL;
         }
 
+        /*!
+         * Returns greatest seqno present in history
+         */
+        seqno_t seqno_last() const
+        {
+            gu::Lock lock(mtx);
+            if (gu_likely(!seqno2ptr.empty()))
+                return seqno2ptr.index_back();
+            else
+                return SEQNO_ILL;
+        }
+
         /*!
          * Move lock to a given seqno.
          * @throws gu::NotFound if seqno is not in the cache.
@@ -104,6 +116,12 @@ namespace gcache
          */
         size_t allocated_pool_size ();
 
+        /*!
+         * Returns size of gcache memory backed by huge pages (in bytes),
+         * 0 unless gcache.huge_pages is enabled.
+         */
+        size_t huge_pages_size ();
+
 
         /*!
          * Implements the cleanup policy test.
@@ -211,6 +229,9 @@ namespace gcache
             size_t keep_pages_count()    const { return keep_pages_count_; }
             int    debug()               const { return debug_;           }
             bool   recover()             const { return recover_;         }
+            bool   seqno_index()         const { return seqno_index_;     }
+            bool   huge_pages()          const { return huge_pages_;      }
+            int    numa_node()           const { return numa_node_;       }
 
             bool skip_purge(seqno_t seqno)
             {
@@ -238,6 +259,9 @@ namespace gcache
             size_t            keep_pages_count_;
             int               debug_;
             bool        const recover_;
+            bool        const seqno_index_;
+            bool        const huge_pages_;
+            int         const numa_node_;
             seqno_t           freeze_purge_at_seqno_;
         }
             params;
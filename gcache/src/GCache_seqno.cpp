@@ -5,10 +5,13 @@
 #include "gcache_bh.hpp"
 #include "GCache.hpp"
 
+#include <gu_limits.h> // GU_PAGE_SIZE
+
 #include <cerrno>
 #include <cassert>
 
 #include <sched.h> // sched_yeild()
+#include <sys/mman.h> // posix_madvise()
 
 namespace gcache
 {
@@ -94,6 +97,8 @@ namespace gcache
 
         bh->seqno_g = seqno_g;
         bh->seqno_d = seqno_d;
+
+        if (BUFFER_IN_RB == bh->store) rb.seqno_assigned(bh);
     }
 
     void
@@ -274,6 +279,42 @@ namespace gcache
         return ptr;
     }
 
+    /*!
+     * Starts asynchronous read-in of the memory holding the buffers so that
+     * the following accesses don't fault on each buffer one by one.
+     * Buffers allocated one after another are coalesced into one range,
+     * only the beginning of the last buffer in a range is covered.
+     */
+    static void
+    prefetch_buffers (const std::vector<const void*>& ptrs)
+    {
+        static uintptr_t const MAX_GAP(1 << 20);
+        uintptr_t const page_size(GU_PAGE_SIZE);
+
+        for (size_t i(0); i < ptrs.size(); )
+        {
+            uintptr_t const begin
+                (reinterpret_cast<uintptr_t>(ptr2BH(ptrs[i])) &
+                 ~(page_size - 1));
+            uintptr_t end(reinterpret_cast<uintptr_t>(ptrs[i]));
+
+            for (++i; i < ptrs.size(); ++i)
+            {
+                uintptr_t const next(reinterpret_cast<uintptr_t>(ptrs[i]));
+
+                if (next <= end || next - end > MAX_GAP) break;
+
+                end = next;
+            }
+
+            /* failure here is harmless: the range may cross an unmapped
+             * area between stores or a heap gap */
+            (void)posix_madvise(reinterpret_cast<void*>(begin),
+                                end - begin + page_size,
+                                POSIX_MADV_WILLNEED);
+        }
+    }
+
     size_t
     GCache::seqno_get_buffers (std::vector<Buffer>& v,
                                seqno_t const start)
@@ -284,6 +325,11 @@ namespace gcache
 
         size_t found(0);
 
+        /* buffers of this and the next call, the latter to be read in while
+         * the caller is busy with the former */
+        std::vector<const void*> ahead;
+        ahead.reserve(2 * max);
+
         {
             gu::Lock lock(mtx);
 
@@ -298,12 +344,25 @@ namespace gcache
                     assert(seqno2ptr.index(p) == seqno_t(start + found));
                     assert(*p);
                     v[found].set_ptr(*p);
+                    ahead.push_back(*p);
                 }
                 while (++found < max && ++p != seqno2ptr.end() && *p);
                 /* the last condition ensures seqno continuty, #643 */
+
+                /* everything past start is protected by the seqno lock */
+                if (found == max)
+                {
+                    while (++p != seqno2ptr.end() && *p &&
+                           ahead.size() < ahead.capacity())
+                    {
+                        ahead.push_back(*p);
+                    }
+                }
             }
         }
 
+        if (found > 0) prefetch_buffers(ahead);
+
         // the following may cause IO
         for (size_t i(0); i < found; ++i)
         {
@@ -48,7 +48,8 @@ gcache::Page::drop_fs_cache() const
 #endif
 }
 
-gcache::Page::Page (void* ps, const std::string& name, size_t size, int dbg)
+gcache::Page::Page (void* ps, const std::string& name, size_t size, int dbg,
+                    bool const huge_pages, int const numa_node)
     :
 #ifdef HAVE_PSI_INTERFACE
     fd_   (name, WSREP_PFS_INSTR_TAG_GCACHE_PAGE_FILE, size, true, false),
@@ -64,6 +65,9 @@ gcache::Page::Page (void* ps, const std::string& name, size_t size, int dbg)
     min_space_ (space_),
     debug_(dbg)
 {
+    if (huge_pages)     mmap_.huge_pages();
+    if (numa_node >= 0) mmap_.bind_node(numa_node);
+
     log_info << "Created page " << name << " of size " << space_
              << " bytes";
     BH_clear (reinterpret_cast<BufferHeader*>(next_));
@@ -23,7 +23,8 @@ namespace gcache
     {
     public:
 
-        Page (void* ps, const std::string& name, size_t size, int dbg);
+        Page (void* ps, const std::string& name, size_t size, int dbg,
+              bool huge_pages = false, int numa_node = -1);
         ~Page () {}
 
         void* malloc  (size_type size);
@@ -65,6 +66,8 @@ namespace gcache
 
         size_t allocated_pool_size ();
 
+        gu::MMap::Range mapping () const { return mmap_.range(); }
+
         void print(std::ostream& os) const;
 
         void set_debug(int const dbg) { debug_ = dbg; }
@@ -177,7 +177,8 @@ inline void
 gcache::PageStore::new_page (size_type size)
 {
     Page* const page(new Page
-                     (this, make_page_name (base_name_, count_), size, debug_));
+                     (this, make_page_name (base_name_, count_), size, debug_,
+                      huge_pages_, numa_node_));
 
     pages_.push_back (page);
     total_size_ += page->size();
@@ -189,7 +190,9 @@ gcache::PageStore::PageStore (const std::string& dir_name,
                               size_t             keep_size,
                               size_t             page_size,
                               int                dbg,
-                              bool               keep_page)
+                              bool               keep_page,
+                              bool               huge_pages,
+                              int                numa_node)
     :
     base_name_ (make_base_name(dir_name)),
     keep_size_ (keep_size),
@@ -200,7 +203,9 @@ gcache::PageStore::PageStore (const std::string& dir_name,
     current_   (0),
     total_size_(0),
     delete_page_attr_(),
-    debug_     (dbg & DEBUG)
+    debug_     (dbg & DEBUG),
+    huge_pages_(huge_pages),
+    numa_node_ (numa_node)
 #ifndef GCACHE_DETACH_THREAD
     , delete_thr_(pthread_t(-1))
 #endif /* GCACHE_DETACH_THREAD */
@@ -333,6 +338,15 @@ size_t gcache::PageStore::allocated_pool_size ()
   return size;
 }
 
+void
+gcache::PageStore::mappings (gu::MMap::Ranges& ranges) const
+{
+    for (PageQueue::const_iterator i(pages_.begin()); i != pages_.end(); ++i)
+    {
+        ranges.push_back((*i)->mapping());
+    }
+}
+
 void
 gcache::PageStore::set_debug(int const dbg)
 {
@@ -24,7 +24,9 @@ namespace gcache
                    size_t             keep_size,
                    size_t             page_size,
                    int                dbg,
-                   bool               keep_page);
+                   bool               keep_page,
+                   bool               huge_pages = false,
+                   int                numa_node  = -1);
 
         ~PageStore ();
 
@@ -57,6 +59,9 @@ namespace gcache
 
         size_t allocated_pool_size ();
 
+        /* appends address ranges of all pages */
+        void mappings (gu::MMap::Ranges& ranges) const;
+
         void  set_debug(int dbg);
 
         /* for unit tests */
@@ -79,6 +84,8 @@ namespace gcache
         size_t            total_size_;
         pthread_attr_t    delete_page_attr_;
         int               debug_;
+        bool        const huge_pages_; /* advise huge pages on new pages */
+        int         const numa_node_;  /* NUMA node to bind new pages to */
 #ifndef GCACHE_DETACH_THREAD
         pthread_t         delete_thr_;
 #endif /* GCACHE_DETACH_THREAD */
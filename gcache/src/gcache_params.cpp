@@ -24,6 +24,12 @@ static const std::string GCACHE_DEFAULT_DEBUG     ("0");
 #endif
 static const std::string GCACHE_PARAMS_RECOVER    ("gcache.recover");
 static const std::string GCACHE_DEFAULT_RECOVER   ("no");
+static const std::string GCACHE_PARAMS_SEQNO_INDEX("gcache.seqno_index");
+static const std::string GCACHE_DEFAULT_SEQNO_INDEX("no");
+static const std::string GCACHE_PARAMS_HUGE_PAGES("gcache.huge_pages");
+static const std::string GCACHE_DEFAULT_HUGE_PAGES("no");
+static const std::string GCACHE_PARAMS_NUMA_NODE ("gcache.numa_node");
+static const std::string GCACHE_DEFAULT_NUMA_NODE("-1");
 static const std::string GCACHE_PARAMS_FREEZE_PURGE_SEQNO("gcache.freeze_purge_at_seqno");
 static const std::string GCACHE_DEFAULT_FREEZE_PURGE_SEQNO("-1");
 
@@ -41,6 +47,9 @@ gcache::GCache::Params::register_params(gu::Config& cfg)
     cfg.add(GCACHE_PARAMS_DEBUG,           GCACHE_DEFAULT_DEBUG);
 #endif
     cfg.add(GCACHE_PARAMS_RECOVER,         GCACHE_DEFAULT_RECOVER);
+    cfg.add(GCACHE_PARAMS_SEQNO_INDEX,     GCACHE_DEFAULT_SEQNO_INDEX);
+    cfg.add(GCACHE_PARAMS_HUGE_PAGES,      GCACHE_DEFAULT_HUGE_PAGES);
+    cfg.add(GCACHE_PARAMS_NUMA_NODE,       GCACHE_DEFAULT_NUMA_NODE);
     cfg.add(GCACHE_PARAMS_FREEZE_PURGE_SEQNO, GCACHE_DEFAULT_FREEZE_PURGE_SEQNO);
 }
 
@@ -84,6 +93,9 @@ gcache::GCache::Params::Params (gu::Config& cfg, const std::string& data_dir)
     debug_    (0),
 #endif
     recover_  (cfg.get<bool>(GCACHE_PARAMS_RECOVER)),
+    seqno_index_(cfg.get<bool>(GCACHE_PARAMS_SEQNO_INDEX)),
+    huge_pages_(cfg.get<bool>(GCACHE_PARAMS_HUGE_PAGES)),
+    numa_node_(cfg.get<int>(GCACHE_PARAMS_NUMA_NODE)),
     freeze_purge_at_seqno_(cfg.get<seqno_t>(GCACHE_PARAMS_FREEZE_PURGE_SEQNO))
 {}
 
@@ -160,7 +172,10 @@ gcache::GCache::param_set (const std::string& key, const std::string& val)
                           params.keep_pages_count() :
                           !((params.mem_size() + params.rb_size()) > 0));
     }
-    else if (key == GCACHE_PARAMS_RECOVER)
+    else if (key == GCACHE_PARAMS_RECOVER ||
+             key == GCACHE_PARAMS_SEQNO_INDEX ||
+             key == GCACHE_PARAMS_HUGE_PAGES ||
+             key == GCACHE_PARAMS_NUMA_NODE)
     {
         gu_throw_error(EINVAL) << "'" << key
                                << "' has a meaning only on startup.";
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2020 Codership Oy <info@codership.com>
+ */
+
+#include "gcache_rb_index.hpp"
+
+#include <gu_hash.h>
+#include <gu_logger.hpp>
+#include <gu_macros.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace gcache
+{
+    static char const INDEX_MAGIC[8] = { 'G','C','A','C','H','E','I','2' };
+
+    size_t
+    RingBufferIndex::slots (size_t const cache_size)
+    {
+        static size_t const min_slots(1024);
+        return std::min(std::max(cache_size / BYTES_PER_SLOT, min_slots),
+                        MAX_SLOTS);
+    }
+
+    uint64_t
+    RingBufferIndex::checksum (const Slot& s) const
+    {
+        uint64_t const buf[3] = { uint64_t(s.seqno), s.offset, gen_ };
+        return gu_fast_hash64(buf, sizeof(buf));
+    }
+
+    uint64_t
+    RingBufferIndex::checksum (const Header& h)
+    {
+        return gu_fast_hash64(&h, offsetof(Header, check));
+    }
+
+    RingBufferIndex::RingBufferIndex (const std::string& name,
+                                      size_t const       cache_size)
+        :
+        cache_size_(cache_size),
+        nslots_    (slots(cache_size)),
+#ifdef HAVE_PSI_INTERFACE
+        fd_        (name, WSREP_PFS_INSTR_TAG_RINGBUFFER_FILE,
+                    sizeof(Header) + nslots_ * sizeof(Slot)),
+#else
+        fd_        (name, sizeof(Header) + nslots_ * sizeof(Slot)),
+#endif /* HAVE_PSI_INTERFACE */
+        mmap_      (fd_),
+        header_    (static_cast<Header*>(mmap_.ptr)),
+        slots_     (reinterpret_cast<Slot*>(header_ + 1)),
+        gen_       (header_->gen),
+        unsynced_  (0)
+    {
+        GU_COMPILE_ASSERT(sizeof(Header) == 64, header_size);
+        GU_COMPILE_ASSERT(sizeof(Slot)   == 24, slot_size);
+    }
+
+    RingBufferIndex::~RingBufferIndex ()
+    {
+        try { sync(); }
+        catch (std::exception& e)
+        {
+            log_warn << "Failed to sync GCache seqno index: " << e.what();
+        }
+    }
+
+    bool
+    RingBufferIndex::valid (const gu::UUID& gid) const
+    {
+        return (0 == ::memcmp(header_->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC))
+                && header_->check      == checksum(*header_)
+                && header_->cache_size == cache_size_
+                && header_->slots      == nslots_
+                && gu::UUID(header_->gid) == gid);
+    }
+
+    void
+    RingBufferIndex::reset (const gu::UUID& gid)
+    {
+        /* slots of previous generations become invalid, no need to clear
+         * them, and the new header goes to disk before any new slot does */
+        gen_ += 1;
+        unsynced_ = 0;
+
+        ::memset(header_, 0, sizeof(Header));
+        ::memcpy(header_->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        header_->gid        = *gid.uuid_ptr();
+        header_->cache_size = cache_size_;
+        header_->slots      = nslots_;
+        header_->gen        = gen_;
+        header_->check      = checksum(*header_);
+
+        mmap_.sync(header_, sizeof(Header));
+    }
+
+    void
+    RingBufferIndex::sync_recent (seqno_t const seqno)
+    {
+        size_t const last (seqno % nslots_);
+        size_t const count(std::min(unsynced_, nslots_));
+
+        unsynced_ = 0;
+
+        try
+        {
+            if (count <= last + 1)
+            {
+                mmap_.sync(slots_ + last + 1 - count, count * sizeof(Slot),
+                           true);
+            }
+            else
+            {
+                size_t const tail(count - (last + 1));
+
+                mmap_.sync(slots_, (last + 1) * sizeof(Slot), true);
+                mmap_.sync(slots_ + nslots_ - tail, tail * sizeof(Slot), true);
+            }
+        }
+        catch (std::exception& e)
+        {
+            log_warn << "Failed to schedule GCache seqno index writeback: "
+                     << e.what();
+        }
+    }
+}
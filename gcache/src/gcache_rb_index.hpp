@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2020 Codership Oy <info@codership.com>
+ */
+
+/*! @file persistent seqno index of the ring buffer */
+
+#ifndef _gcache_rb_index_hpp_
+#define _gcache_rb_index_hpp_
+
+#include "gcache_seqno.hpp"
+
+#include <gu_fdesc.hpp>
+#include <gu_macros.h>
+#include <gu_mmap.hpp>
+#include <gu_uuid.hpp>
+
+#include <cstring>
+#include <string>
+
+namespace gcache
+{
+    /*!
+     * Maps seqno to the offset of the buffer in the ring buffer file.
+     *
+     * The index is a ring of the most recent seqnos: a file of fixed number
+     * of slots, slot is selected by seqno modulo the number of slots. Slot
+     * checksum covers the generation stored in the header, so reset only
+     * bumps the generation to invalidate all slots. Slots are written through
+     * memory map, writeback of recently added ones is scheduled every
+     * SYNC_INTERVAL additions and the whole index is synced on close. Each
+     * slot must be validated against the buffer header it points at.
+     */
+    class RingBufferIndex
+    {
+    public:
+
+        struct Entry
+        {
+            seqno_t  seqno;
+            uint64_t offset;
+        };
+
+        /* The index can recover the last MAX_SLOTS seqnos, but no more than
+         * one per BYTES_PER_SLOT of small caches. Recovery falls back to
+         * full scan if there are more seqnos in the cache. */
+        static size_t const MAX_SLOTS      = 1 << 20;
+        static size_t const BYTES_PER_SLOT = 512;
+
+        /* number of additions between scheduled writebacks */
+        static size_t const SYNC_INTERVAL  = 1 << 12;
+
+        /* @param cache_size ring buffer data area size */
+        RingBufferIndex (const std::string& name, size_t cache_size);
+
+        ~RingBufferIndex ();
+
+        /* true if the index was written for this history and cache size */
+        bool valid (const gu::UUID& gid) const;
+
+        /* drops all entries and binds the index to the given history */
+        void reset (const gu::UUID& gid);
+
+        void add (seqno_t const seqno, uint64_t const offset)
+        {
+            Slot& s(slots_[seqno % nslots_]);
+            s.seqno  = seqno;
+            s.offset = offset;
+            s.check  = checksum(s);
+
+            if (gu_unlikely(++unsynced_ >= SYNC_INTERVAL)) sync_recent(seqno);
+        }
+
+        /* same as add(), but does not touch the slot if it is there already
+         * so that clean pages stay clean */
+        void update (seqno_t const seqno, uint64_t const offset)
+        {
+            const Slot& s(slots_[seqno % nslots_]);
+
+            if (s.seqno != seqno || s.offset != offset ||
+                s.check != checksum(s))
+            {
+                add(seqno, offset);
+            }
+        }
+
+        /* @return false if the slot is empty, stale or corrupt */
+        bool get (size_t const i, Entry& e) const
+        {
+            const Slot& s(slots_[i]);
+
+            if (s.seqno <= 0 || s.check != checksum(s)) return false;
+
+            e.seqno  = s.seqno;
+            e.offset = s.offset;
+            return true;
+        }
+
+        /* empties the slot */
+        void clear (size_t const i)
+        {
+            ::memset(&slots_[i], 0, sizeof(Slot));
+        }
+
+        size_t size () const { return nslots_; }
+
+        const std::string& name () const { return fd_.name(); }
+
+        void sync () const { mmap_.sync(); }
+
+    private:
+
+        struct Header
+        {
+            char      magic[8];
+            gu_uuid_t gid;
+            uint64_t  cache_size;
+            uint64_t  slots;
+            uint64_t  gen;
+            uint64_t  check;
+            uint8_t   pad[8];
+        };
+
+        struct Slot
+        {
+            int64_t  seqno;
+            uint64_t offset;
+            uint64_t check;
+        };
+
+        uint64_t checksum (const Slot& s) const;
+        static uint64_t checksum (const Header& h);
+
+        static size_t slots (size_t cache_size);
+
+        /* schedules writeback of slots added since the last one,
+         * assuming they were added in seqno order up to seqno */
+        void sync_recent (seqno_t seqno);
+
+        uint64_t    const cache_size_;
+        size_t      const nslots_;
+        gu::FileDescriptor fd_;
+        gu::MMap    mmap_;
+        Header*     const header_;
+        Slot*       const slots_;
+        uint64_t          gen_;
+        size_t            unsynced_; // slots added since the last writeback
+
+        RingBufferIndex (const RingBufferIndex&);
+        RingBufferIndex& operator= (const RingBufferIndex&);
+    };
+}
+
+#endif /* _gcache_rb_index_hpp_ */
@@ -12,9 +12,14 @@
 #include <gu_progress.hpp>
 #include <gu_hexdump.hpp>
 #include <gu_hash.h>
+#include <gu_limits.h> // GU_PAGE_SIZE
 
 #include <cassert>
 #include <iostream> // std::cerr
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <sys/mman.h> // posix_madvise()
 
 namespace gcache
 {
@@ -28,6 +33,8 @@ namespace gcache
     {
         write_preamble(false);
 
+        if (index_) index_->reset(gid_);
+
         for (seqno2ptr_iter_t i = seqno2ptr_.begin(); i != seqno2ptr_.end(); ++i)
         {
             if (ptr2BH(*i)->ctx == this) {
@@ -56,7 +63,10 @@ namespace gcache
                             seqno2ptr_t&       seqno2ptr,
                             gu::UUID&          gid,
                             int const          dbg,
-                            bool const         recover)
+                            bool const         recover,
+                            bool const         seqno_index,
+                            bool const         huge_pages,
+                            int const          numa_node)
     :
 #ifdef HAVE_PSI_INTERFACE
         fd_        (name, WSREP_PFS_INSTR_TAG_RINGBUFFER_FILE, check_size(size)),
@@ -82,11 +92,32 @@ namespace gcache
 //        mallocs_   (0),
 //        reallocs_  (0),
         debug_     (dbg & DEBUG),
-        open_      (true)
+        open_      (true),
+        index_     (NULL),
+        index_recovered_(false)
     {
         assert((uintptr_t(start_) % MemOps::ALIGNMENT) == 0);
         constructor_common ();
-        open_preamble(recover);
+
+        /* before recovery scan pages the buffer in */
+        if (huge_pages)     mmap_.huge_pages();
+        if (numa_node >= 0) mmap_.bind_node(numa_node);
+
+        if (seqno_index)
+        {
+            index_ = new RingBufferIndex(name + ".idx", size_cache_);
+        }
+
+        try
+        {
+            open_preamble(recover);
+        }
+        catch (...)
+        {
+            delete index_;
+            throw;
+        }
+
         BH_clear (BH_cast(next_));
     }
 
@@ -95,6 +126,7 @@ namespace gcache
         close_preamble();
         open_ = false;
         mmap_.sync();
+        delete index_;
     }
 
     static inline void
@@ -434,6 +466,8 @@ namespace gcache
     {
         write_preamble(false);
 
+        if (index_) index_->reset(gid_);
+
         if (size_cache_ == size_free_) return;
 
         /* Invalidate seqnos for all ordered buffers (so that they can't be
@@ -632,6 +666,7 @@ namespace gcache
         long long seqno_min(SEQNO_ILL);
         off_t offset(-1);
         bool  synced(false);
+        bool  scanned(false); // recovered by full scan
 
         {
             std::istringstream iss(preamble_);
@@ -682,7 +717,16 @@ namespace gcache
 
                 try
                 {
-                    recover(offset - (start_ - preamble), version);
+                    /* index has offsets of aligned buffers only */
+                    index_recovered_ = (index_ && version >= 2 &&
+                                        index_->valid(gid_) &&
+                                        recover_index());
+
+                    if (!index_recovered_)
+                    {
+                        recover(offset - (start_ - preamble), version);
+                        scanned = true;
+                    }
                 }
                 catch (gu::Exception& e)
                 {
@@ -698,6 +742,9 @@ namespace gcache
             }
         }
 
+        /* index recovered seqnos are there already */
+        if (index_ && !index_recovered_) rebuild_index(scanned);
+
         write_preamble(false);
     }
 
@@ -707,6 +754,94 @@ namespace gcache
         write_preamble(true);
     }
 
+    /* scan() follows the buffer header chain sequentially and marks buffers
+     * in place as it goes, segment boundaries and collisions are resolved
+     * from what was seen before. On a cold start it is bound by faulting in
+     * mmapped file pages one at a time rather than by following the chain.
+     * This asks the kernel to read the buffer in ahead of the scan, in scan
+     * order, staying at most WINDOW bytes ahead so that read pages are not
+     * evicted before use. With seqno index enabled the scan is not needed
+     * unless the index fails. */
+    class ScanPrefetch
+    {
+    public:
+
+        /* @param from where the scan starts, it wraps around to start at end */
+        ScanPrefetch(uint8_t* const start, uint8_t* const end,
+                     uint8_t* const from)
+            :
+            start_  (start),
+            end_    (end),
+            from_   (from),
+            total_  (end - start),
+            scanned_(0),
+            advised_(0)
+        {
+            advise_ahead();
+        }
+
+        /* called by scan as it progresses */
+        void advance(ptrdiff_t const amount)
+        {
+            scanned_ += amount;
+
+            if (advised_ < total_ && scanned_ + WINDOW - advised_ >= CHUNK)
+            {
+                advise_ahead();
+            }
+        }
+
+    private:
+
+        static ptrdiff_t const CHUNK  = 1 << 25; /* 32Mb */
+        static ptrdiff_t const WINDOW = 1 << 30; /* 1Gb  */
+
+        void advise_ahead()
+        {
+            ptrdiff_t const until(std::min(scanned_ + WINDOW, total_));
+
+            while (advised_ < until)
+            {
+                ptrdiff_t const next(std::min(advised_ + CHUNK, until));
+                advise(advised_, next);
+                advised_ = next;
+            }
+        }
+
+        /* offsets are in scan order, the range may wrap around */
+        void advise(ptrdiff_t begin, ptrdiff_t const end)
+        {
+            ptrdiff_t const tail(end_ - from_);
+
+            if (begin < tail && end > tail)
+            {
+                advise(begin, tail);
+                begin = tail;
+            }
+
+            uintptr_t const page_size(GU_PAGE_SIZE);
+            uintptr_t const ptr(reinterpret_cast<uintptr_t>(
+                                    begin < tail ? from_ + begin :
+                                    start_ + (begin - tail)));
+            uintptr_t const aligned(ptr & ~(page_size - 1));
+
+            /* failure here is harmless, the scan just faults pages in */
+            (void)posix_madvise(reinterpret_cast<void*>(aligned),
+                                ptr - aligned + (end - begin),
+                                POSIX_MADV_WILLNEED);
+        }
+
+        uint8_t* const  start_;
+        uint8_t* const  end_;
+        uint8_t* const  from_;
+        ptrdiff_t const total_;
+        ptrdiff_t       scanned_; // offset reached by scan
+        ptrdiff_t       advised_; // offset advised to read in up to
+
+        ScanPrefetch(const ScanPrefetch&);
+        ScanPrefetch& operator=(const ScanPrefetch&);
+    };
+
     seqno_t
     RingBuffer::scan(off_t const offset, int const scan_step)
     {
@@ -735,6 +870,8 @@ namespace gcache
         gu::Progress<ptrdiff_t> progress("GCache::RingBuffer initial scan",
                                          " bytes", end_ - start_, 1<<22 /*4Mb*/);
 
+        ScanPrefetch prefetch(start_, end_, segment_start);
+
         while (segment_scans < 2)
         {
             segment_scans++;
@@ -750,6 +887,7 @@ namespace gcache
 #define GCACHE_SCAN_ADVANCE(amount)             \
             ptr += amount;                      \
             progress.update(amount);            \
+            prefetch.advance(amount);           \
             bh = BH_cast(ptr);
 
 
@@ -1198,6 +1336,302 @@ namespace gcache
         }
     }
 
+    namespace
+    {
+        enum WalkResult
+        {
+            WALK_REACHED, // reached the target
+            WALK_CLEAR,   // stopped at segment end (clear header)
+            WALK_BAD      // found something that is not a buffer
+        };
+
+        /* follows buffer headers from ptr to target, collecting them */
+        WalkResult
+        walk(uint8_t*& ptr, const uint8_t* const target,
+             std::vector<BufferHeader*>& bufs)
+        {
+            if (ptr > target) return WALK_BAD; // overlapping buffers
+
+            while (ptr != target)
+            {
+                BufferHeader* const bh(BH_cast(ptr));
+
+                if (BH_is_clear(bh)) return WALK_CLEAR;
+
+                if (!BH_test(bh) || bh->size % MemOps::ALIGNMENT ||
+                    bh->size > size_t(target - ptr))
+                {
+                    return WALK_BAD;
+                }
+
+                bufs.push_back(bh);
+                ptr += bh->size;
+            }
+
+            return WALK_REACHED;
+        }
+
+        bool
+        seqno_less(const BufferHeader* const a, const BufferHeader* const b)
+        {
+            return a->seqno_g < b->seqno_g;
+        }
+    }
+
+    bool
+    RingBuffer::recover_index()
+    {
+        static const char* const diag_prefix ="Recovering GCache ring buffer "
+            "from index: ";
+
+        typedef std::vector<BufferHeader*> BufVector;
+
+        uint8_t* const limit(end_ - sizeof(BufferHeader));
+
+        /* collect buffers whose headers agree with the index */
+        BufVector bufs;
+        for (size_t i(0); i < index_->size(); ++i)
+        {
+            RingBufferIndex::Entry e;
+
+            if (!index_->get(i, e)) continue;
+
+            if (e.offset % MemOps::ALIGNMENT ||
+                e.offset >= uint64_t(limit - start_)) continue;
+
+            BufferHeader* const bh(BH_cast(start_ + e.offset));
+
+            if (BH_is_clear(bh) || !BH_test(bh) ||
+                bh->seqno_g != e.seqno ||
+                bh->size % MemOps::ALIGNMENT ||
+                bh->size > size_t(limit - start_) - e.offset) continue;
+
+            bufs.push_back(bh);
+        }
+
+        if (bufs.empty())
+        {
+            log_info << diag_prefix << "no valid entries";
+            return false;
+        }
+
+        /* keep only the last gapless seqno sequence */
+        std::sort(bufs.begin(), bufs.end(), seqno_less);
+        BufVector::iterator low(bufs.end() - 1);
+        while (low != bufs.begin() &&
+               (*(low - 1))->seqno_g + 1 == (*low)->seqno_g) --low;
+        BufVector seqnos(low, bufs.end());
+        bufs.clear();
+
+        /* The index holds only the last size() seqnos. If they all are
+         * there, older ones may still be in the buffer, only a full scan
+         * can find them. */
+        if (seqnos.size() >= index_->size())
+        {
+            log_info << diag_prefix << "index overflow, " << seqnos.size()
+                     << " seqnos in " << index_->size() << " slots";
+            return false;
+        }
+
+        /* Now walk the buffers in the order of addresses. Gaps between them
+         * must be unordered buffers, except for the end of the used space
+         * (next_) and the trailing space at the end of the ring buffer. */
+        BufVector ordered(seqnos);
+        std::sort(ordered.begin(), ordered.end());
+
+        size_t const n(ordered.size());
+        BufVector gap;      // unordered buffers within used space
+        size_t    next_gap(n); // index of the buffer followed by next_
+
+        for (size_t i(0); i < n; ++i)
+        {
+            uint8_t* ptr(reinterpret_cast<uint8_t*>(BH_next(ordered[i])));
+            BufVector tmp;
+            WalkResult res;
+
+            if (i + 1 < n)
+            {
+                res = walk(ptr, reinterpret_cast<uint8_t*>(ordered[i + 1]),
+                           tmp);
+            }
+            else
+            {
+                res = walk(ptr, limit, tmp);
+                if (WALK_REACHED == res) res = WALK_CLEAR;
+            }
+
+            if (WALK_BAD == res)
+            {
+                log_info << diag_prefix << "unexpected buffer after "
+                         << ordered[i];
+                return false;
+            }
+
+            if (WALK_CLEAR == res && i + 1 < n)
+            {
+                if (next_gap < n)
+                {
+                    log_info << diag_prefix << "more than one segment end";
+                    return false;
+                }
+                next_gap = i;
+                /* buffers between the last ordered buffer and next_ will be
+                 * discarded anyways */
+            }
+            else if (i + 1 < n)
+            {
+                gap.insert(gap.end(), tmp.begin(), tmp.end());
+            }
+            else
+            {
+                /* the last segment end, trailing space starts at ptr */
+                if (next_gap < n)
+                {
+                    /* ring buffer is wrapped, unordered buffers before
+                     * the trailing space are in use */
+                    gap.insert(gap.end(), tmp.begin(), tmp.end());
+                    size_trail_ = end_ - ptr;
+                }
+            }
+        }
+
+        if (next_gap < n)
+        {
+            /* wrapped: the second segment must start at start_ */
+            uint8_t* ptr(start_);
+            if (WALK_REACHED != walk(ptr, reinterpret_cast<uint8_t*>(ordered[0]),
+                                     gap))
+            {
+                log_info << diag_prefix << "could not find segment start";
+                size_trail_ = 0;
+                return false;
+            }
+        }
+
+        /* ordered buffers between the indexed ones were lost by the index */
+        for (size_t i(0); i < gap.size(); ++i)
+        {
+            if (gap[i]->seqno_g > SEQNO_NONE)
+            {
+                log_info << diag_prefix << "seqno " << gap[i]->seqno_g
+                         << " is not indexed";
+                size_trail_ = 0;
+                return false;
+            }
+        }
+
+        if (next_gap < n)
+        {
+            first_ = reinterpret_cast<uint8_t*>(ordered[next_gap + 1]);
+            next_  = reinterpret_cast<uint8_t*>(BH_next(ordered[next_gap]));
+        }
+        else
+        {
+            first_ = reinterpret_cast<uint8_t*>(ordered[0]);
+            next_  = reinterpret_cast<uint8_t*>(BH_next(ordered[n - 1]));
+            size_trail_ = 0;
+        }
+
+        /* everything is checked, now recover */
+
+        for (size_t i(0); i < gap.size(); ++i)
+        {
+            BufferHeader* const bh(gap[i]);
+            empty_buffer(bh);
+            bh->flags |= BUFFER_RELEASED;
+            bh->ctx    = this;
+        }
+
+        for (size_t i(0); i < seqnos.size(); ++i)
+        {
+            BufferHeader* const bh(seqnos[i]);
+            bh->flags |= BUFFER_RELEASED;
+            bh->ctx    = this;
+            seqno2ptr_.insert(bh->seqno_g, bh + 1);
+        }
+
+        BH_clear(BH_cast(next_));
+        estimate_space();
+
+        /* no buffers are in use on recovery */
+        for (size_t i(0); i < seqnos.size(); ++i) size_used_ -= seqnos[i]->size;
+        for (size_t i(0); i < gap.size(); ++i)
+        {
+            size_used_ -= gap[i]->size;
+            discard(gap[i]);
+        }
+
+        assert(0 == size_used_);
+
+        log_info << diag_prefix << "found gapless sequence "
+                 << seqno2ptr_.index_front() << '-' << seqno2ptr_.index_back()
+                 << ", " << gap.size() << " unordered buffers";
+        log_info << diag_prefix << "free space: "
+                 << size_free_ << '/' << size_cache_;
+
+        assert_sizes();
+
+        if (debug_)
+        {
+            log_info << *this;
+            dump_map();
+        }
+
+        return true;
+    }
+
+    /* true if the index entry is the offset of the recovered seqno */
+    bool
+    RingBuffer::index_entry_valid(const RingBufferIndex::Entry& e) const
+    {
+        if (e.seqno < seqno2ptr_.index_begin() ||
+            e.seqno >= seqno2ptr_.index_end()) return false;
+
+        const void* const ptr(seqno2ptr_[e.seqno]);
+        if (!ptr) return false;
+
+        const BufferHeader* const bh(ptr2BH(ptr));
+        return (BUFFER_IN_RB == bh->store &&
+                reinterpret_cast<const uint8_t*>(bh) - start_ ==
+                ptrdiff_t(e.offset));
+    }
+
+    void
+    RingBuffer::rebuild_index(bool const repair)
+    {
+        if (repair && index_->valid(gid_))
+        {
+            /* after full scan most of the index is usually up to date,
+             * drop only the entries the scan did not recover */
+            for (size_t i(0); i < index_->size(); ++i)
+            {
+                RingBufferIndex::Entry e;
+
+                if (index_->get(i, e) && !index_entry_valid(e))
+                {
+                    index_->clear(i);
+                }
+            }
+        }
+        else
+        {
+            index_->reset(gid_);
+        }
+
+        for (seqno2ptr_t::iterator i(seqno2ptr_.begin());
+             i != seqno2ptr_.end(); ++i)
+        {
+            if (!*i) continue;
+
+            const BufferHeader* const bh(ptr2BH(*i));
+            if (BUFFER_IN_RB == bh->store)
+            {
+                index_->update(bh->seqno_g,
+                               reinterpret_cast<const uint8_t*>(bh) - start_);
+            }
+        }
+    }
+
     static void
     print_chain(const uint8_t* const rb_start, const uint8_t* const chain_start,
                 const uint8_t* const chain_end, size_t const count,
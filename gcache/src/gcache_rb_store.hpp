@@ -10,6 +10,7 @@
 #include "gcache_memops.hpp"
 #include "gcache_bh.hpp"
 #include "gcache_types.hpp"
+#include "gcache_rb_index.hpp"
 
 #include <gu_fdesc.hpp>
 #include <gu_mmap.hpp>
@@ -28,7 +29,10 @@ namespace gcache
                     seqno2ptr_t&       seqno2ptr,
                     gu::UUID&          gid,
                     int                dbg,
-                    bool               recover);
+                    bool               recover,
+                    bool               seqno_index  = false,
+                    bool               huge_pages   = false,
+                    int                numa_node    = -1);
 
         ~RingBuffer ();
 
@@ -56,6 +60,16 @@ namespace gcache
 
         void  seqno_reset();
 
+        /* to be called when buffer is assigned a seqno */
+        void  seqno_assigned(const BufferHeader* const bh)
+        {
+            if (index_)
+            {
+                index_->add(bh->seqno_g,
+                            reinterpret_cast<const uint8_t*>(bh) - start_);
+            }
+        }
+
         /* returns true when successfully discards all seqnos in range */
         bool  discard_seqnos(seqno2ptr_t::iterator i_begin,
                              seqno2ptr_t::iterator i_end);
@@ -114,6 +128,10 @@ namespace gcache
 
         size_t allocated_pool_size ();
 
+        size_t huge_pages_size () const { return mmap_.huge_pages_size(); }
+
+        gu::MMap::Range mapping () const { return mmap_.range(); }
+
         void set_freeze_purge_at_seqno(seqno_t seqno)
         {
             freeze_purge_at_seqno_ = seqno;
@@ -172,6 +190,10 @@ namespace gcache
 
         bool               open_;
 
+
+        RingBufferIndex*   index_;   // persistent seqno index, optional
+        bool               index_recovered_;
+
         BufferHeader* get_new_buffer (size_type size);
 
         void          constructor_common();
@@ -191,6 +213,10 @@ namespace gcache
         // returns lower bound (not inclusive) of valid seqno range
         seqno_t       scan(off_t offset, int scan_step);
         void          recover(off_t offset, int version);
+        bool          recover_index();
+        bool          index_entry_valid(const RingBufferIndex::Entry& e) const;
+        /* @param repair keep the entries that agree with recovered seqnos */
+        void          rebuild_index(bool repair);
 
         void          estimate_space();
 
@@ -200,6 +226,7 @@ namespace gcache
 #ifdef GCACHE_RB_UNIT_TEST
     public:
         uint8_t* start() const { return start_; }
+        bool     index_recovered() const { return index_recovered_; }
 #endif
     };
 
@@ -12,6 +12,9 @@
 
 #include <gu_logger.hpp>
 #include <gu_throw.hpp>
+#include <gu_inttypes.hpp>
+
+#include <cstring>
 
 using namespace gcache;
 
@@ -506,6 +509,373 @@ START_TEST(recovery)
 }
 END_TEST
 
+/* recovery of a buffer large enough to be prefetched in several chunks */
+START_TEST(recovery_prefetch)
+{
+    ::unlink(RB_NAME.c_str());
+
+    size_t const    rb_size(96 << 20);
+    size_type const buf_size(ALLOC_SIZE((64 << 10) - 1));
+    seqno_t const   seqno_max(rb_size / buf_size - 2);
+
+    {
+        seqno2ptr_t s2p(SEQNO_NONE);
+        gu::UUID    gid(GID);
+        RingBuffer  rb(RB_NAME, rb_size, s2p, gid, 0, false);
+
+        for (seqno_t g(1); g <= seqno_max; ++g)
+        {
+            void* const ptr(rb.malloc(buf_size));
+            ck_assert_msg(NULL != ptr, "malloc() failed at seqno %" PRId64, g);
+            ::memset(ptr, int(g), buf_size - BH_SIZE);
+
+            BufferHeader* const bh(ptr2BH(ptr));
+            s2p.insert(g, ptr);
+            bh->seqno_g = g;
+            bh->seqno_d = g - 1;
+            BH_release(bh);
+            rb.free(bh);
+        }
+    }
+
+    {
+        seqno2ptr_t s2p(SEQNO_NONE);
+        gu::UUID    gid(GID);
+        RingBuffer  rb(RB_NAME, rb_size, s2p, gid, 0, true);
+
+        ck_assert(!s2p.empty());
+        ck_assert_msg(s2p.index_front() == 1 &&
+                      s2p.index_back()  == seqno_max,
+                      "Expected 1-%" PRId64 ", got %" PRId64 "-%" PRId64,
+                      seqno_max, s2p.index_front(), s2p.index_back());
+
+        for (seqno_t g(1); g <= seqno_max; ++g)
+        {
+            const uint8_t* const ptr(static_cast<const uint8_t*>(s2p[g]));
+            ck_assert(NULL != ptr);
+            ck_assert(ptr2BH(ptr)->seqno_g == g);
+            ck_assert(ptr[0] == uint8_t(g) &&
+                      ptr[buf_size - BH_SIZE - 1] == uint8_t(g));
+        }
+    }
+
+    ::unlink(RB_NAME.c_str());
+}
+END_TEST
+
+/* fills the buffer with ordered buffers interleaved with unordered ones,
+ * so that it wraps around several times */
+static void
+fill_indexed(RingBuffer& rb, seqno2ptr_t& s2p, seqno_t& seqno, int const count)
+{
+    for (int i(0); i < count; ++i)
+    {
+        size_type const size(ALLOC_SIZE(1000 + (i * 337) % 3000));
+        void* const ptr(rb.malloc(size));
+        ck_assert_msg(NULL != ptr, "malloc() failed at %d", i);
+
+        BufferHeader* const bh(ptr2BH(ptr));
+
+        if (i % 7 != 3)
+        {
+            ++seqno;
+            ::memset(ptr, int(seqno), size - BH_SIZE);
+            s2p.insert(seqno, ptr);
+            bh->seqno_g = seqno;
+            bh->seqno_d = seqno - 1;
+            rb.seqno_assigned(bh);
+        }
+
+        BH_release(bh);
+        rb.free(bh);
+    }
+}
+
+static void
+check_indexed(const seqno2ptr_t& s2p, seqno_t const front, seqno_t const back)
+{
+    ck_assert(!s2p.empty());
+    ck_assert_msg(s2p.index_front() == front && s2p.index_back() == back,
+                  "Expected %" PRId64 "-%" PRId64 ", got %" PRId64 "-%" PRId64,
+                  front, back, s2p.index_front(), s2p.index_back());
+
+    for (seqno_t g(front); g <= back; ++g)
+    {
+        const uint8_t* const ptr(static_cast<const uint8_t*>(s2p[g]));
+        ck_assert(NULL != ptr);
+        const BufferHeader* const bh(ptr2BH(ptr));
+        ck_assert(bh->seqno_g == g);
+        ck_assert(ptr[0] == uint8_t(g) &&
+                  ptr[bh->size - BH_SIZE - 1] == uint8_t(g));
+    }
+}
+
+/* recovery from seqno index must give the same result as a full scan */
+START_TEST(recovery_index)
+{
+    std::string const idx_name(RB_NAME + ".idx");
+    ::unlink(RB_NAME.c_str());
+    ::unlink(idx_name.c_str());
+
+    size_t const rb_size(1 << 20);
+    seqno_t      seqno(0);
+    seqno_t      front, back;
+
+    /* single segment */
+    {
+        seqno2ptr_t s2p(SEQNO_NONE);
+        gu::UUID    gid(GID);
+        RingBuffer  rb(RB_NAME, rb_size, s2p, gid, 0, false, true);
+        rb.seqno_reset();
+
+        fill_indexed(rb, s2p, seqno, 200);
+    }
+
+    {
+        seqno2ptr_t s2p(SEQNO_NONE);
+        gu::UUID    gid(GID);
+        RingBuffer  rb(RB_NAME, rb_size, s2p, gid, 0, true, true);
+
+        ck_assert(rb.index_recovered());
+        check_indexed(s2p, 1, seqno);
+        rb.seqno_reset();
+        s2p.clear(SEQNO_NONE);
+    }
+
+    seqno = 0;
+
+    /* wrapped around */
+    {
+        seqno2ptr_t s2p(SEQNO_NONE);
+        gu::UUID    gid(GID);
+        RingBuffer  rb(RB_NAME, rb_size, s2p, gid, 0, false, true);
+
+        fill_indexed(rb, s2p, seqno, 1500);
+
+        /* a buffer which was in use at the time of crash */
+        ck_assert(NULL != rb.malloc(ALLOC_SIZE(100)));
+
+        front = s2p.index_front();
+        back  = s2p.index_back();
+        ck_assert(front > 1); // wrapped around
+    }
+
+    for (int i(0); i < 2; ++i)
+    {
+        seqno2ptr_t s2p(SEQNO_NONE);
+        gu::UUID    gid(GID);
+        RingBuffer  rb(RB_NAME, rb_size, s2p, gid, 0, true, true);
+
+        ck_assert(rb.index_recovered());
+        check_indexed(s2p, front, back);
+
+        /* must be able to allocate after recovery */
+        fill_indexed(rb, s2p, seqno, 700);
+        front = s2p.index_front();
+        back  = s2p.index_back();
+    }
+
+    {
+        /* without index */
+        seqno2ptr_t s2p(SEQNO_NONE);
+        gu::UUID    gid(GID);
+        RingBuffer  rb(RB_NAME, rb_size, s2p, gid, 0, true);
+
+        check_indexed(s2p, front, back);
+    }
+
+    {
+        /* index is stale now */
+        seqno2ptr_t s2p(SEQNO_NONE);
+        gu::UUID    gid(GID);
+        RingBuffer  rb(RB_NAME, rb_size, s2p, gid, 0, true, true);
+
+        check_indexed(s2p, front, back);
+    }
+
+    ::unlink(RB_NAME.c_str());
+    ::unlink(idx_name.c_str());
+}
+END_TEST
+
+/* more seqnos than index slots: recovery must fall back to full scan */
+START_TEST(recovery_index_overflow)
+{
+    std::string const idx_name(RB_NAME + ".idx");
+    ::unlink(RB_NAME.c_str());
+    ::unlink(idx_name.c_str());
+
+    size_t const    rb_size(1 << 20);
+    size_type const buf_size(ALLOC_SIZE(64));
+    seqno_t         front, back;
+
+    {
+        seqno2ptr_t s2p(SEQNO_NONE);
+        gu::UUID    gid(GID);
+        RingBuffer  rb(RB_NAME, rb_size, s2p, gid, 0, false, true);
+        rb.seqno_reset();
+
+        for (seqno_t g(1); g <= seqno_t(2 * rb_size / buf_size); ++g)
+        {
+            void* const ptr(rb.malloc(buf_size));
+            ck_assert_msg(NULL != ptr, "malloc() failed at seqno %" PRId64, g);
+            ::memset(ptr, int(g), buf_size - BH_SIZE);
+
+            BufferHeader* const bh(ptr2BH(ptr));
+            s2p.insert(g, ptr);
+            bh->seqno_g = g;
+            bh->seqno_d = g - 1;
+            rb.seqno_assigned(bh);
+            BH_release(bh);
+            rb.free(bh);
+        }
+
+        front = s2p.index_front();
+        back  = s2p.index_back();
+        ck_assert(size_t(back - front + 1) > rb_size / 512);
+    }
+
+    {
+        seqno2ptr_t s2p(SEQNO_NONE);
+        gu::UUID    gid(GID);
+        RingBuffer  rb(RB_NAME, rb_size, s2p, gid, 0, true, true);
+
+        ck_assert(!rb.index_recovered());
+        check_indexed(s2p, front, back);
+    }
+
+    ::unlink(RB_NAME.c_str());
+    ::unlink(idx_name.c_str());
+}
+END_TEST
+
+/* reset must invalidate all slots without clearing them, update() must
+ * write only the slots that differ */
+START_TEST(index_reset)
+{
+    std::string const idx_name(RB_NAME + ".idx");
+    ::unlink(idx_name.c_str());
+
+    size_t const cache_size(1 << 20);
+    size_t       nslots;
+
+    {
+        RingBufferIndex idx(idx_name, cache_size);
+        nslots = idx.size();
+        ck_assert(nslots == cache_size / RingBufferIndex::BYTES_PER_SLOT);
+        ck_assert(!idx.valid(GID));
+
+        idx.reset(GID);
+        ck_assert(idx.valid(GID));
+
+        /* more than one ring turn */
+        for (seqno_t g(1); g <= seqno_t(nslots + nslots / 2); ++g)
+        {
+            idx.add(g, g * 8);
+        }
+    }
+
+    {
+        RingBufferIndex idx(idx_name, cache_size);
+        ck_assert(idx.valid(GID));
+
+        for (size_t i(0); i < nslots; ++i)
+        {
+            RingBufferIndex::Entry e;
+            ck_assert(idx.get(i, e));
+            ck_assert(size_t(e.seqno) % nslots == i);
+            ck_assert(e.seqno > seqno_t(nslots / 2));
+            ck_assert(e.offset == uint64_t(e.seqno) * 8);
+        }
+
+        idx.reset(GID);
+
+        for (size_t i(0); i < nslots; ++i)
+        {
+            RingBufferIndex::Entry e;
+            ck_assert(!idx.get(i, e));
+        }
+
+        idx.update(5, 40);
+        idx.update(5, 40);
+        idx.update(6, 48);
+        idx.update(6, 56);
+        idx.clear(6);
+    }
+
+    {
+        RingBufferIndex idx(idx_name, cache_size);
+        ck_assert(idx.valid(GID));
+
+        for (size_t i(0); i < nslots; ++i)
+        {
+            RingBufferIndex::Entry e;
+            ck_assert(idx.get(i, e) == (5 == i));
+            if (5 == i) ck_assert(e.seqno == 5 && e.offset == 40);
+        }
+    }
+
+    {
+        /* different cache size, different index */
+        RingBufferIndex idx(idx_name, cache_size * 2);
+        ck_assert(!idx.valid(GID));
+    }
+
+    ::unlink(idx_name.c_str());
+}
+END_TEST
+
+/* memory policy hints must not affect contents, whether supported or not */
+START_TEST(memory_policy)
+{
+    ::unlink(RB_NAME.c_str());
+
+    size_t const    rb_size(8 << 20);
+    size_type const buf_size(ALLOC_SIZE(4000));
+    seqno_t const   seqno_max(rb_size / buf_size - 2);
+
+    {
+        seqno2ptr_t s2p(SEQNO_NONE);
+        gu::UUID    gid(GID);
+        RingBuffer  rb(RB_NAME, rb_size, s2p, gid, 0, false, false,
+                       true, 0);
+
+        for (seqno_t g(1); g <= seqno_max; ++g)
+        {
+            void* const ptr(rb.malloc(buf_size));
+            ck_assert_msg(NULL != ptr, "malloc() failed at seqno %" PRId64, g);
+            ::memset(ptr, int(g), buf_size - BH_SIZE);
+
+            BufferHeader* const bh(ptr2BH(ptr));
+            s2p.insert(g, ptr);
+            bh->seqno_g = g;
+            bh->seqno_d = g - 1;
+            BH_release(bh);
+            rb.free(bh);
+        }
+
+        ck_assert(rb.huge_pages_size() <= rb_size);
+    }
+
+    {
+        seqno2ptr_t s2p(SEQNO_NONE);
+        gu::UUID    gid(GID);
+        RingBuffer  rb(RB_NAME, rb_size, s2p, gid, 0, true, false,
+                       true, 0);
+
+        ck_assert(!s2p.empty());
+        ck_assert(s2p.index_front() == 1 && s2p.index_back() == seqno_max);
+
+        const uint8_t* const ptr
+            (static_cast<const uint8_t*>(s2p[seqno_max]));
+        ck_assert(ptr[0] == uint8_t(seqno_max) &&
+                  ptr[buf_size - BH_SIZE - 1] == uint8_t(seqno_max));
+        ck_assert(rb.huge_pages_size() <= rb_size);
+    }
+
+    ::unlink(RB_NAME.c_str());
+}
+END_TEST
 
 Suite* gcache_rb_suite()
 {
@@ -520,6 +890,16 @@ Suite* gcache_rb_suite()
 
     tcase_set_timeout(tc, 60);
     tcase_add_test(tc, recovery);
+    tcase_add_test(tc, recovery_prefetch);
+    tcase_add_test(tc, recovery_index);
+    tcase_add_test(tc, recovery_index_overflow);
+    tcase_add_test(tc, index_reset);
+    suite_add_tcase(ts, tc);
+
+    tc = tcase_create("memory_policy");
+
+    tcase_set_timeout(tc, 60);
+    tcase_add_test(tc, memory_policy);
     suite_add_tcase(ts, tc);
 
     return ts;
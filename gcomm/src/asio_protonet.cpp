@@ -17,9 +17,30 @@
 
 #include <boost/bind.hpp>
 
+#include <algorithm>
 #include <fstream>
 
 
+static size_t threads_param(gu::Config& conf, const std::string& key,
+                            int const def, int const min)
+{
+    int const ret(conf.get<int>(key, def));
+
+    if (ret < min)
+    {
+        gu_throw_error(EINVAL) << "Invalid value for " << key << ": " << ret;
+    }
+
+    return ret;
+}
+
+static long long thread_cpu_nsecs()
+{
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0;
+    return ts.tv_sec * gu::datetime::Sec + ts.tv_nsec;
+}
+
 gcomm::AsioProtonet::AsioProtonet(gu::Config& conf, int version)
     :
     gcomm::Protonet(conf, "asio", version),
@@ -31,7 +52,16 @@ gcomm::AsioProtonet::AsioProtonet(gu::Config& conf, int version)
     mtu_(1 << 15),
     checksum_(NetHeader::checksum_type(
                   conf.get<int>(gcomm::Conf::SocketChecksum,
-                                NetHeader::CS_CRC32C)))
+                                NetHeader::CS_CRC32C))),
+    loop_mtx_(),
+    loop_cond_(),
+    loop_done_cond_(),
+    loop_gen_(0),
+    loop_done_(0),
+    loop_stop_(false),
+    loop_error_(0),
+    loop_error_msg_(),
+    io_threads_(threads_param(conf, gcomm::Conf::ProtonetThreads, 1, 1))
 {
     conf.set(gcomm::Conf::SocketChecksum, checksum_);
     // use ssl if either private key or cert file is specified
@@ -50,11 +80,145 @@ gcomm::AsioProtonet::AsioProtonet(gu::Config& conf, int version)
         log_info << "initializing ssl context";
         gu::ssl_prepare_context(conf_, ssl_context_);
     }
+
+    for (size_t i(0); i < io_threads_.size(); ++i)
+    {
+        io_threads_[i].net = this;
+
+        if (i == 0) continue; // event_loop() caller
+
+        int const err(gu_thread_create(&io_threads_[i].thd, 0,
+                                       io_thread_fn, &io_threads_[i]));
+        if (err != 0)
+        {
+            io_threads_.resize(i);
+            stop_io_threads();
+            gu_throw_error(err) << "Failed to create protonet thread";
+        }
+    }
+
+    if (io_threads_.size() > 1)
+    {
+        log_info << "Running protonet event loop in " << io_threads_.size()
+                 << " threads.";
+    }
 }
 
 gcomm::AsioProtonet::~AsioProtonet()
 {
+    stop_io_threads();
+}
+
+void gcomm::AsioProtonet::stop_io_threads()
+{
+    {
+        gu::Lock lock(loop_mtx_);
+        loop_stop_ = true;
+        loop_cond_.broadcast();
+    }
+
+    for (size_t i(1); i < io_threads_.size(); ++i)
+    {
+        gu_thread_join(io_threads_[i].thd, 0);
+    }
+
+    // the rest of event loop runs in the caller thread only
+    gu::Lock lock(loop_mtx_);
+    io_threads_.resize(1);
+}
+
+void gcomm::AsioProtonet::set_loop_error(int const err, const char* const msg)
+{
+    // passed to event_loop() caller
+    io_service_.stop();
+
+    gu::Lock lock(loop_mtx_);
+    if (loop_error_ == 0)
+    {
+        loop_error_     = err;
+        loop_error_msg_ = msg;
+    }
+}
+
+void* gcomm::AsioProtonet::io_thread_fn(void* arg)
+{
+    IoThread* const t(static_cast<IoThread*>(arg));
+    t->net->run_io_thread(*t);
+    return 0;
+}
+
+void gcomm::AsioProtonet::run_io_thread(IoThread& t)
+{
+    gu::Lock lock(loop_mtx_);
+    // generation the thread was created in, event_loop() may have been
+    // called already before the thread got here
+    unsigned long long gen(0);
+
+    while (loop_stop_ == false)
+    {
+        if (loop_gen_ == gen)
+        {
+            lock.wait(loop_cond_);
+            continue;
+        }
+
+        gen = loop_gen_;
+        loop_mtx_.unlock();
+
+        try
+        {
+            run_io_service(t);
+        }
+        catch (gu::Exception& e)
+        {
+            set_loop_error(e.get_errno() ? e.get_errno() : EPROTO, e.what());
+        }
+        catch (std::exception& e)
+        {
+            set_loop_error(EPROTO, e.what());
+        }
+        catch (...)
+        {
+            set_loop_error(EPROTO, "unknown exception in protonet thread");
+        }
+
+        loop_mtx_.lock();
+        ++loop_done_;
+        loop_done_cond_.signal();
+    }
+}
+
+void gcomm::AsioProtonet::run_io_service(IoThread& t)
+{
+    gu::datetime::Date const start(gu::datetime::Date::monotonic());
+    long long const cpu_start(thread_cpu_nsecs());
+
+    io_service_.run();
+
+    long long const busy(thread_cpu_nsecs() - cpu_start);
+    long long const run((gu::datetime::Date::monotonic() - start).get_nsecs());
+
+    gu::Lock lock(loop_mtx_);
+    t.busy_nsecs += busy;
+    t.run_nsecs  += run;
+}
+
+void gcomm::AsioProtonet::get_status(gu::Status& status) const
+{
+    gu::Lock lock(loop_mtx_);
+
+    status.insert("protonet_threads", gu::to_string(io_threads_.size()));
 
+    for (size_t i(0); i < io_threads_.size(); ++i)
+    {
+        std::string const prefix("protonet_thread_" + gu::to_string(i));
+        status.insert(prefix + "_busy_time",
+                      gu::to_string(double(io_threads_[i].busy_nsecs)
+                                    / gu::datetime::Sec));
+        status.insert(prefix + "_run_time",
+                      gu::to_string(double(io_threads_[i].run_nsecs)
+                                    / gu::datetime::Sec));
+    }
 }
 
 void gcomm::AsioProtonet::enter()
@@ -113,7 +277,54 @@ void gcomm::AsioProtonet::event_loop(const gu::datetime::Period& period)
     timer_.expires_from_now(boost::posix_time::nanosec(p.get_nsecs()));
     timer_.async_wait(boost::bind(&AsioProtonet::handle_wait, this,
                                   asio::placeholders::error));
-    io_service_.run();
+
+    if (io_threads_.size() == 1)
+    {
+        run_io_service(io_threads_[0]);
+        return;
+    }
+
+    {
+        gu::Lock lock(loop_mtx_);
+        ++loop_gen_;
+        loop_done_ = 0;
+        loop_cond_.broadcast();
+    }
+
+    try
+    {
+        run_io_service(io_threads_[0]);
+    }
+    catch (...)
+    {
+        io_service_.stop();
+        wait_io_threads();
+        stop_io_threads();
+        throw;
+    }
+
+    // io_service_ may be reset only after all threads have left run()
+    wait_io_threads();
+
+    std::string msg;
+    int         err(0);
+    {
+        gu::Lock lock(loop_mtx_);
+        std::swap(err, loop_error_);
+        msg = loop_error_msg_;
+    }
+
+    if (err != 0)
+    {
+        stop_io_threads();
+        gu_throw_error(err) << msg;
+    }
+}
+
+void gcomm::AsioProtonet::wait_io_threads()
+{
+    gu::Lock lock(loop_mtx_);
+    while (loop_done_ < io_threads_.size() - 1) lock.wait(loop_done_cond_);
 }
 
 
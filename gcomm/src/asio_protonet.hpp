@@ -36,6 +36,8 @@ public:
     void enter();
     void leave();
     size_t mtu() const { return mtu_; }
+    void get_status(gu::Status& status) const;
+    size_t threads() const { return io_threads_.size(); }
 
     std::string get_ssl_password() const;
 
@@ -48,6 +50,29 @@ private:
 
     void handle_wait(const asio::error_code& ec);
 
+    // Event loop thread, io_threads_[0] is the caller of event_loop(),
+    // the rest are helper threads which run io_service_ together with it.
+    struct IoThread
+    {
+        IoThread() : thd(), net(0), busy_nsecs(0), run_nsecs(0) { }
+
+        gu_thread_t   thd;
+        AsioProtonet* net;
+        long long     busy_nsecs; // thread CPU time spent in event loop
+        long long     run_nsecs;  // wall clock time spent in event loop
+    };
+
+    static void* io_thread_fn(void* arg);
+    void run_io_thread(IoThread& t);
+    void run_io_service(IoThread& t);
+    // waits for helper threads to leave run_io_service()
+    void wait_io_threads();
+    // stops and joins helper threads, event loop keeps running in the
+    // caller of event_loop()
+    void stop_io_threads();
+    // stops io_service_ and records the first error of helper threads
+    void set_loop_error(int err, const char* msg);
+
     gu::RecursiveMutex          mutex_;
     gu::datetime::Date          poll_until_;
     asio::io_service            io_service_;
@@ -56,6 +81,17 @@ private:
     size_t                      mtu_;
 
     NetHeader::checksum_t       checksum_;
+
+    // Synchronizes helper threads with event_loop() calls
+    gu::Mutex                   loop_mtx_;
+    gu::Cond                    loop_cond_;
+    gu::Cond                    loop_done_cond_;
+    unsigned long long          loop_gen_;
+    size_t                      loop_done_;
+    bool                        loop_stop_;
+    int                         loop_error_;
+    std::string                 loop_error_msg_;
+    std::vector<IoThread>       io_threads_;
 };
 
 #endif // GCOMM_ASIO_PROTONET_HPP
@@ -69,10 +69,13 @@ gcomm::AsioTcpSocket::AsioTcpSocket(AsioProtonet& net, const gu::URI& uri)
     net_         (net),
     socket_      (net.io_service_),
     ssl_socket_  (0),
+    strand_      (net.io_service_),
     send_q_      (),
     last_queued_tstamp_(),
-    recv_buf_    (net_.mtu() + NetHeader::serial_size_),
-    recv_offset_ (0),
+    recv_hdr_offset_(0),
+    recv_hdr_    (),
+    recv_buf_    (),
+    recv_pool_   (recv_pool_size),
     last_delivered_tstamp_(),
     state_       (S_CLOSED),
     local_addr_  (),
@@ -119,6 +122,8 @@ void gcomm::AsioTcpSocket::failed_handler(const asio::error_code& ec,
 
 void gcomm::AsioTcpSocket::handshake_handler(const asio::error_code& ec)
 {
+    Critical<AsioProtonet> crit(net_);
+
     if (ec)
     {
         if (ec.category() == asio::error::get_ssl_category() &&
@@ -181,9 +186,10 @@ void gcomm::AsioTcpSocket::connect_handler(const asio::error_code& ec)
                           << local_addr();
                 ssl_socket_->async_handshake(
                     asio::ssl::stream<asio::ip::tcp::socket>::client,
-                    boost::bind(&AsioTcpSocket::handshake_handler,
-                                shared_from_this(),
-                                asio::placeholders::error)
+                    strand_.wrap(
+                        boost::bind(&AsioTcpSocket::handshake_handler,
+                                    shared_from_this(),
+                                    asio::placeholders::error))
                     );
             }
             else
@@ -229,9 +235,10 @@ void gcomm::AsioTcpSocket::connect(const gu::URI& uri)
             ssl_socket_->lowest_layer().open(i->endpoint().protocol());
             set_buf_sizes(); // Must be done before connect
             ssl_socket_->lowest_layer().async_connect(
-                *i, boost::bind(&AsioTcpSocket::connect_handler,
+                *i, strand_.wrap(
+                    boost::bind(&AsioTcpSocket::connect_handler,
                                 shared_from_this(),
-                                asio::placeholders::error)
+                                asio::placeholders::error))
             );
         }
         else
@@ -245,9 +252,11 @@ void gcomm::AsioTcpSocket::connect(const gu::URI& uri)
                 socket_.bind(ep);
             }
             set_buf_sizes(); // Must be done before connect
-            socket_.async_connect(*i, boost::bind(&AsioTcpSocket::connect_handler,
-                                                  shared_from_this(),
-                                                  asio::placeholders::error));
+            socket_.async_connect(*i, strand_.wrap(
+                                      boost::bind(
+                                          &AsioTcpSocket::connect_handler,
+                                          shared_from_this(),
+                                          asio::placeholders::error)));
         }
         state_ = S_CONNECTING;
     }
@@ -273,7 +282,16 @@ void gcomm::AsioTcpSocket::close()
 
     if (send_q_.empty() == true || state() != S_CONNECTED)
     {
-        close_socket();
+        if (net_.threads() > 1)
+        {
+            // handlers of this socket may be running in other thread
+            strand_.dispatch(boost::bind(&AsioTcpSocket::close_socket,
+                                         shared_from_this()));
+        }
+        else
+        {
+            close_socket();
+        }
         state_ = S_CLOSED;
     }
     else
@@ -440,6 +458,15 @@ namespace gcomm
 
 int gcomm::AsioTcpSocket::send(int segment, const Datagram& dg)
 {
+    // Checksum type and protonet version don't change after construction,
+    // compute checksum before entering critical section.
+    NetHeader hdr(static_cast<uint32_t>(dg.len()), net_.version_);
+
+    if (net_.checksum_ != NetHeader::CS_NONE)
+    {
+        hdr.set_crc32(crc32(net_.checksum_, dg), net_.checksum_);
+    }
+
     Critical<AsioProtonet> crit(net_);
 
     if (state() != S_CONNECTED)
@@ -452,13 +479,6 @@ int gcomm::AsioTcpSocket::send(int segment, const Datagram& dg)
         return ENOBUFS;
     }
 
-    NetHeader hdr(static_cast<uint32_t>(dg.len()), net_.version_);
-
-    if (net_.checksum_ != NetHeader::CS_NONE)
-    {
-        hdr.set_crc32(crc32(net_.checksum_, dg), net_.checksum_);
-    }
-
     last_queued_tstamp_ = gu::datetime::Date::monotonic();
     // Make copy of datagram to be able to adjust the header
     Datagram priv_dg(dg);
@@ -471,7 +491,7 @@ int gcomm::AsioTcpSocket::send(int segment, const Datagram& dg)
     send_q_.push_back(segment, priv_dg);
     if (send_q_.size() == 1)
     {
-        net_.io_service_.post(AsioPostForSendHandler(shared_from_this()));
+        strand_.post(AsioPostForSendHandler(shared_from_this()));
     }
     return 0;
 }
@@ -480,6 +500,10 @@ int gcomm::AsioTcpSocket::send(int segment, const Datagram& dg)
 void gcomm::AsioTcpSocket::read_handler(const asio::error_code& ec,
                                         const size_t bytes_transferred)
 {
+    // Message is accessed only from this handler, so its checksum is
+    // verified before entering critical section.
+    bool const cs_failed(!ec && recv_buf_ && verify_checksum() == false);
+
     Critical<AsioProtonet> crit(net_);
 
     if (ec)
@@ -503,121 +527,103 @@ void gcomm::AsioTcpSocket::read_handler(const asio::error_code& ec,
         return;
     }
 
-    recv_offset_ += bytes_transferred;
-
-    while (recv_offset_ >= NetHeader::serial_size_)
+    if (recv_buf_)
     {
-        NetHeader hdr;
-        try
-        {
-            unserialize(&recv_buf_[0], recv_buf_.size(), 0, hdr);
-        }
-        catch (gu::Exception& e)
+        assert(bytes_transferred >= recv_buf_->size());
+
+        if (cs_failed)
         {
-            FAILED_HANDLER(asio::error_code(e.get_errno(),
+            log_warn << "checksum failed, hdr: len=" << recv_hdr_.len()
+                     << " has_crc32="  << recv_hdr_.has_crc32()
+                     << " has_crc32c=" << recv_hdr_.has_crc32c()
+                     << " crc32=" << recv_hdr_.crc32();
+            FAILED_HANDLER(asio::error_code(EPROTO,
                                             asio::error::system_category));
             return;
         }
-        if (recv_offset_ >= hdr.len() + NetHeader::serial_size_)
-        {
-            Datagram dg(
-                gu::SharedBuffer(
-                    new gu::Buffer(&recv_buf_[0] + NetHeader::serial_size_,
-                                   &recv_buf_[0] + NetHeader::serial_size_
-                                   + hdr.len())));
-            if (net_.checksum_ != NetHeader::CS_NONE)
-            {
-#ifdef TEST_NET_CHECKSUM_ERROR
-                long rnd(rand());
-                if (rnd % 10000 == 0)
-                {
-                    hdr.set_crc32(net_.checksum_, static_cast<uint32_t>(rnd));
-                }
-#endif /* TEST_NET_CHECKSUM_ERROR */
 
-                if (check_cs (hdr, dg))
-                {
-                    log_warn << "checksum failed, hdr: len=" << hdr.len()
-                             << " has_crc32="  << hdr.has_crc32()
-                             << " has_crc32c=" << hdr.has_crc32c()
-                             << " crc32=" << hdr.crc32();
-                    FAILED_HANDLER(asio::error_code(
-                                       EPROTO,
-                                       asio::error::system_category));
-                    return;
-                }
-            }
-            ProtoUpMeta um;
-            last_delivered_tstamp_ = gu::datetime::Date::monotonic();
-            net_.dispatch(id(), dg, um);
-            recv_offset_ -= NetHeader::serial_size_ + hdr.len();
+        // the rest was read ahead into the next header
+        recv_hdr_offset_ = bytes_transferred - recv_buf_->size();
 
-            if (recv_offset_ > 0)
-            {
-                memmove(&recv_buf_[0],
-                        &recv_buf_[0] + NetHeader::serial_size_ + hdr.len(),
-                        recv_offset_);
-            }
-        }
-        else
-        {
-            break;
-        }
+        // pooled buffer goes to upper layers without copying
+        Datagram dg(recv_buf_);
+        recv_buf_.reset();
+
+        ProtoUpMeta um;
+        last_delivered_tstamp_ = gu::datetime::Date::monotonic();
+        net_.dispatch(id(), dg, um);
+    }
+    else
+    {
+        recv_hdr_offset_ += bytes_transferred;
     }
 
-    gu::array<asio::mutable_buffer, 1>::type mbs;
-    mbs[0] = asio::mutable_buffer(&recv_buf_[0] + recv_offset_,
-                                  recv_buf_.size() - recv_offset_);
-    read_one(mbs);
+    read_next();
 }
 
-size_t gcomm::AsioTcpSocket::read_completion_condition(
-    const asio::error_code& ec,
-    const size_t bytes_transferred)
+
+bool gcomm::AsioTcpSocket::verify_checksum() const
 {
-    Critical<AsioProtonet> crit(net_);
-    if (ec)
+    if (net_.checksum_ == NetHeader::CS_NONE) return true;
+
+#ifdef TEST_NET_CHECKSUM_ERROR
+    long rnd(rand());
+    if (rnd % 10000 == 0)
     {
-#ifdef HAVE_ASIO_SSL_HPP
-        if (ec.category() == asio::error::get_ssl_category() &&
-            gu::exclude_ssl_error(ec) == false)
-        {
-            log_warn << "read_completion_condition(): " << ec.message() << " ("
-                     << gu::extra_error_info(ec) << ")";
-        }
-#endif
-        FAILED_HANDLER(ec);
-        return 0;
+        NetHeader hdr(recv_hdr_);
+        hdr.set_crc32(net_.checksum_, static_cast<uint32_t>(rnd));
+        return (check_cs(hdr, recv_buf_->data()) == false);
     }
+#endif /* TEST_NET_CHECKSUM_ERROR */
 
-    if (state() != S_CONNECTED && state() != S_CLOSING)
+    return (check_cs(recv_hdr_, recv_buf_->data()) == false);
+}
+
+
+void gcomm::AsioTcpSocket::read_next()
+{
+    gu::array<asio::mutable_buffer, 2>::type mbs;
+
+    if (recv_hdr_offset_ < NetHeader::serial_size_)
     {
-        log_debug << "read completion condition for " << id()
-                  << " state " << state();
-        return 0;
+        mbs[0] = asio::mutable_buffer(recv_hdr_buf_ + recv_hdr_offset_,
+                                      NetHeader::serial_size_
+                                      - recv_hdr_offset_);
+        mbs[1] = asio::mutable_buffer();
+        read_one(mbs);
+        return;
     }
 
-    if (recv_offset_ + bytes_transferred >= NetHeader::serial_size_)
+    try
     {
-        NetHeader hdr;
-        try
-        {
-            unserialize(&recv_buf_[0], NetHeader::serial_size_, 0, hdr);
-        }
-        catch (gu::Exception& e)
-        {
-            log_warn << "unserialize error " << e.what();
-            FAILED_HANDLER(asio::error_code(e.get_errno(),
-                                            asio::error::system_category));
-            return 0;
-        }
-        if (recv_offset_ + bytes_transferred >= NetHeader::serial_size_ + hdr.len())
-        {
-            return 0;
-        }
+        unserialize(recv_hdr_buf_, NetHeader::serial_size_, 0, recv_hdr_);
+    }
+    catch (gu::Exception& e)
+    {
+        log_warn << "unserialize error " << e.what();
+        FAILED_HANDLER(asio::error_code(e.get_errno(),
+                                        asio::error::system_category));
+        return;
     }
 
-    return (recv_buf_.size() - recv_offset_);
+    if (recv_hdr_.len() > net_.mtu())
+    {
+        log_warn << "message length " << recv_hdr_.len()
+                 << " exceeds mtu " << net_.mtu();
+        FAILED_HANDLER(asio::error_code(EPROTO,
+                                        asio::error::system_category));
+        return;
+    }
+
+    // Read the message into a pooled buffer, the next header may come
+    // with the same read.
+    recv_buf_ = recv_pool_.get(recv_hdr_.len());
+    recv_hdr_offset_ = 0;
+
+    mbs[0] = asio::mutable_buffer(recv_buf_->empty() ? 0 : &(*recv_buf_)[0],
+                                  recv_buf_->size());
+    mbs[1] = asio::mutable_buffer(recv_hdr_buf_, NetHeader::serial_size_);
+    read_one(mbs);
 }
 
 
@@ -627,10 +633,9 @@ void gcomm::AsioTcpSocket::async_receive()
 
     gcomm_assert(state() == S_CONNECTED);
 
-    gu::array<asio::mutable_buffer, 1>::type mbs;
-
-    mbs[0] = asio::mutable_buffer(&recv_buf_[0], recv_buf_.size());
-    read_one(mbs);
+    recv_buf_.reset();
+    recv_hdr_offset_ = 0;
+    read_next();
 }
 
 size_t gcomm::AsioTcpSocket::mtu() const
@@ -664,31 +669,28 @@ void gcomm::AsioTcpSocket::set_buf_sizes()
 }
 
 void gcomm::AsioTcpSocket::read_one(
-    gu::array<asio::mutable_buffer, 1>::type& mbs)
+    const gu::array<asio::mutable_buffer, 2>::type& mbs)
 {
+    // reading completes when the first buffer is full
+    size_t const min(asio::buffer_size(mbs[0]));
+
     if (ssl_socket_ != 0)
     {
-        async_read(*ssl_socket_, mbs,
-                   boost::bind(&AsioTcpSocket::read_completion_condition,
-                               shared_from_this(),
-                               asio::placeholders::error,
-                               asio::placeholders::bytes_transferred),
-                   boost::bind(&AsioTcpSocket::read_handler,
-                               shared_from_this(),
-                               asio::placeholders::error,
-                               asio::placeholders::bytes_transferred));
+        async_read(*ssl_socket_, mbs, asio::transfer_at_least(min),
+                   strand_.wrap(
+                       boost::bind(&AsioTcpSocket::read_handler,
+                                   shared_from_this(),
+                                   asio::placeholders::error,
+                                   asio::placeholders::bytes_transferred)));
     }
     else
     {
-        async_read(socket_, mbs,
-                   boost::bind(&AsioTcpSocket::read_completion_condition,
-                               shared_from_this(),
-                               asio::placeholders::error,
-                               asio::placeholders::bytes_transferred),
-                   boost::bind(&AsioTcpSocket::read_handler,
-                               shared_from_this(),
-                               asio::placeholders::error,
-                               asio::placeholders::bytes_transferred));
+        async_read(socket_, mbs, asio::transfer_at_least(min),
+                   strand_.wrap(
+                       boost::bind(&AsioTcpSocket::read_handler,
+                                   shared_from_this(),
+                                   asio::placeholders::error,
+                                   asio::placeholders::bytes_transferred)));
     }
 }
 
@@ -699,18 +701,20 @@ void gcomm::AsioTcpSocket::write_one(
     if (ssl_socket_ != 0)
     {
         async_write(*ssl_socket_, cbs,
-                    boost::bind(&AsioTcpSocket::write_handler,
-                                shared_from_this(),
-                                asio::placeholders::error,
-                                asio::placeholders::bytes_transferred));
+                    strand_.wrap(
+                        boost::bind(&AsioTcpSocket::write_handler,
+                                    shared_from_this(),
+                                    asio::placeholders::error,
+                                    asio::placeholders::bytes_transferred)));
     }
     else
     {
         async_write(socket_, cbs,
-                    boost::bind(&AsioTcpSocket::write_handler,
-                                shared_from_this(),
-                                asio::placeholders::error,
-                                asio::placeholders::bytes_transferred));
+                    strand_.wrap(
+                        boost::bind(&AsioTcpSocket::write_handler,
+                                    shared_from_this(),
+                                    asio::placeholders::error,
+                                    asio::placeholders::bytes_transferred)));
     }
 }
 
@@ -837,6 +841,8 @@ void gcomm::AsioTcpAcceptor::accept_handler(
     SocketPtr socket,
     const asio::error_code& error)
 {
+    Critical<AsioProtonet> crit(net_);
+
     if (!error)
     {
         AsioTcpSocket* s(static_cast<AsioTcpSocket*>(socket.get()));
@@ -853,9 +859,10 @@ void gcomm::AsioTcpAcceptor::accept_handler(
                           << s->local_addr();
                 s->ssl_socket_->async_handshake(
                     asio::ssl::stream<asio::ip::tcp::socket>::server,
-                    boost::bind(&AsioTcpSocket::handshake_handler,
-                                s->shared_from_this(),
-                                asio::placeholders::error));
+                    s->strand_.wrap(
+                        boost::bind(&AsioTcpSocket::handshake_handler,
+                                    s->shared_from_this(),
+                                    asio::placeholders::error)));
                 s->state_ = Socket::S_CONNECTING;
             }
             else
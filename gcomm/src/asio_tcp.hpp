@@ -8,6 +8,7 @@
 #include "socket.hpp"
 #include "asio_protonet.hpp"
 #include "fair_send_queue.hpp"
+#include "buffer_pool.hpp"
 
 #include "gu_array.hpp"
 #include "gu_shared_ptr.hpp"
@@ -59,9 +60,6 @@ public:
                        size_t bytes_transferred);
     void set_option(const std::string& key, const std::string& val);
     int send(int segment, const Datagram& dg);
-    size_t read_completion_condition(
-        const asio::error_code& ec,
-        const size_t bytes_transferred);
     void read_handler(const asio::error_code& ec,
                       const size_t bytes_transferred);
     void async_receive();
@@ -85,7 +83,13 @@ private:
         gu::datetime::Date now(gu::datetime::Date::monotonic());
         last_queued_tstamp_ = last_delivered_tstamp_ = now;
     }
-    void read_one(gu::array<asio::mutable_buffer, 1>::type& mbs);
+    // reads until mbs[0] is full, mbs[1] takes what comes along
+    void read_one(const gu::array<asio::mutable_buffer, 2>::type& mbs);
+    // reads the rest of the message header or, if it is complete,
+    // the message itself
+    void read_next();
+    // returns false if the message in recv_buf_ fails checksum
+    bool verify_checksum() const;
     void write_one(const gu::array<asio::const_buffer, 2>::type& cbs);
     void close_socket();
 
@@ -104,16 +108,29 @@ private:
     AsioProtonet&                             net_;
     asio::ip::tcp::socket                     socket_;
     asio::ssl::stream<asio::ip::tcp::socket>* ssl_socket_;
+    // Serializes handlers of this socket when protonet event loop
+    // runs in several threads.
+    asio::io_service::strand                  strand_;
     // Limit the number of queued bytes. This workaround to avoid queue
     // pile up due to frequent retransmissions by the upper layers (evs).
     // It is a responsibility of upper layers (evs) to request resending
     // of dropped messaes. Upper limit (32MB) is enough to hold 1024
     // datagrams with default gcomm MTU 32kB.
     static const size_t                       max_send_q_bytes = (1 << 25);
+    // Number of recycled buffers for received messages.
+    static const size_t                       recv_pool_size = 16;
     gcomm::FairSendQueue                      send_q_;
     gu::datetime::Date                        last_queued_tstamp_;
-    std::vector<gu::byte_t>                   recv_buf_;
-    size_t                                    recv_offset_;
+    // Message header is read into recv_hdr_buf_ first, then the message
+    // itself is read into recv_buf_ taken from recv_pool_, which is passed
+    // to upper layers as is. The same read brings in the following header,
+    // as much of it as is there. recv_buf_ is empty while reading the
+    // header, recv_hdr_offset_ is the number of header bytes read.
+    gu::byte_t                                recv_hdr_buf_[NetHeader::serial_size_];
+    size_t                                    recv_hdr_offset_;
+    NetHeader                                 recv_hdr_;
+    gu::SharedBuffer                          recv_buf_;
+    gcomm::BufferPool                         recv_pool_;
     gu::datetime::Date                        last_delivered_tstamp_;
     State                                     state_;
     // Querying addresses from failed socket does not work,
@@ -0,0 +1,59 @@
+//
+// Copyright (C) 2020 Codership Oy <info@codership.com>
+//
+
+/**
+ * Pool of recycled payload buffers for received datagrams.
+ *
+ * Buffers are kept in a ring of shared pointers. A buffer is reused when
+ * the pool holds the only reference to it, so it keeps its capacity and
+ * reading a message into it does not allocate memory. A buffer still
+ * referenced by upper layers is left to them and its ring slot gets a
+ * new buffer.
+ */
+
+#ifndef GCOMM_BUFFER_POOL_HPP
+#define GCOMM_BUFFER_POOL_HPP
+
+#include "gu_buffer.hpp"
+
+#include <cassert>
+#include <vector>
+
+namespace gcomm
+{
+    class BufferPool
+    {
+    public:
+        explicit BufferPool(size_t size)
+            : bufs_(size)
+            , next_(0)
+        {
+            assert(size > 0);
+        }
+
+        /* Return buffer of given size to read a message into. */
+        gu::SharedBuffer get(size_t const size)
+        {
+            gu::SharedBuffer& buf(bufs_[next_]);
+            next_ = (next_ + 1) % bufs_.size();
+
+            if (buf.get() == 0 || buf.use_count() > 1)
+            {
+                buf = gu::SharedBuffer(new gu::Buffer());
+            }
+
+            buf->resize(size);
+
+            return buf;
+        }
+
+        size_t size() const { return bufs_.size(); }
+
+    private:
+        std::vector<gu::SharedBuffer> bufs_;
+        size_t                        next_;
+    };
+}
+
+#endif // GCOMM_BUFFER_POOL_HPP
@@ -13,6 +13,7 @@ static std::string const Delim = ".";
 // Protonet
 std::string const gcomm::Conf::ProtonetBackend("protonet.backend");
 std::string const gcomm::Conf::ProtonetVersion("protonet.version");
+std::string const gcomm::Conf::ProtonetThreads("protonet.threads");
 
 // TCP
 static std::string const SocketPrefix("socket" + Delim);
@@ -128,6 +129,7 @@ gcomm::Conf::register_params(gu::Config& cnf)
 
     GCOMM_CONF_ADD_DEFAULT(ProtonetBackend);
     GCOMM_CONF_ADD_DEFAULT(ProtonetVersion);
+    GCOMM_CONF_ADD_DEFAULT(ProtonetThreads);
 
     GCOMM_CONF_ADD        (TcpNonBlocking);
     GCOMM_CONF_ADD_DEFAULT(SocketChecksum);
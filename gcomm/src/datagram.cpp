@@ -120,3 +120,32 @@ gcomm::crc32(gcomm::NetHeader::checksum_t const type,
     gu_throw_error(EINVAL) << "Unsupported checksum algorithm: " << type;
 }
 
+uint32_t
+gcomm::crc32(gcomm::NetHeader::checksum_t const type,
+             const gu::byte_t* const buf, size_t const len)
+{
+    gu::byte_t lenb[4];
+
+    gu::serialize4(static_cast<int32_t>(len), lenb, sizeof(lenb), 0);
+
+    if (NetHeader::CS_CRC32 == type)
+    {
+        boost::crc_32_type crc;
+
+        crc.process_block(lenb, lenb + sizeof(lenb));
+        crc.process_block(buf, buf + len);
+
+        return crc.checksum();
+    }
+    else if (NetHeader::CS_CRC32C == type)
+    {
+        gu::CRC32C crc;
+
+        crc.append (lenb, sizeof(lenb));
+        crc.append (buf, len);
+
+        return crc();
+    }
+
+    gu_throw_error(EINVAL) << "Unsupported checksum algorithm: " << type;
+}
@@ -16,6 +16,7 @@ namespace gcomm
 #endif /* HAVE_ASIO_HPP */
 
     std::string const Defaults::ProtonetVersion         = "0";
+    std::string const Defaults::ProtonetThreads         = "1";
     std::string const Defaults::SocketChecksum          = "2";
     std::string const Defaults::SocketRecvBufSize       =
         GCOMM_ASIO_AUTO_BUF_SIZE;
@@ -13,6 +13,7 @@ namespace gcomm
     {
         static std::string const ProtonetBackend          ;
         static std::string const ProtonetVersion          ;
+        static std::string const ProtonetThreads          ;
         static std::string const SocketChecksum           ;
         static std::string const SocketRecvBufSize        ;
         static std::string const SocketSendBufSize        ;
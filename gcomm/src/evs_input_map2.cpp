@@ -10,6 +10,8 @@
 #include "gu_buffer.hpp"
 #include <stdexcept>
 #include <numeric>
+#include <limits>
+#include <new>
 
 
 //////////////////////////////////////////////////////////////////////////
@@ -90,6 +92,18 @@ std::ostream& gcomm::evs::operator<<(std::ostream& os, const InputMapMsg& m)
 }
 
 
+std::ostream& gcomm::evs::operator<<(std::ostream& os,
+                                     const InputMapMsgIndex& mi)
+{
+    for (InputMapMsgIndex::iterator i(mi.begin()); i != mi.end(); ++i)
+    {
+        os << "\t" << InputMapMsgIndex::key(i) << ","
+           << InputMapMsgIndex::value(i) << "\n";
+    }
+    return os;
+}
+
+
 std::ostream& gcomm::evs::operator<<(std::ostream& os, const InputMap& im)
 {
     return (os << "evs::input_map: {"
@@ -106,6 +120,272 @@ std::ostream& gcomm::evs::operator<<(std::ostream& os, const InputMap& im)
 
 
 
+//////////////////////////////////////////////////////////////////////////
+//
+// Message index
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+// Initial number of slots in node ring buffer, must be power of two
+static size_t const InputMapRingInitialSize(64);
+
+
+void gcomm::evs::InputMapMsgIndex::Ring::reserve(size_t const n)
+{
+    if (n <= slots_.size()) return;
+
+    size_t size(slots_.empty() ? InputMapRingInitialSize : slots_.size());
+    while (size < n) size *= 2;
+
+    std::vector<InputMapMsg*> slots(size, 0);
+    for (seqno_t seq(begin_); seq < end_; ++seq)
+    {
+        slots[static_cast<size_t>(seq) & (size - 1)] = slots_[slot(seq)];
+    }
+    slots_.swap(slots);
+}
+
+
+bool gcomm::evs::InputMapMsgIndex::Ring::insert(seqno_t const seq,
+                                                InputMapMsg* const msg)
+{
+    if (get(seq) != 0) return false;
+
+    if (empty())
+    {
+        reserve(1);
+        begin_ = seq;
+        end_   = seq + 1;
+    }
+    else
+    {
+        seqno_t const b(std::min(begin_, seq));
+        seqno_t const e(std::max(end_, seq + 1));
+        reserve(static_cast<size_t>(e - b));
+        begin_ = b;
+        end_   = e;
+    }
+
+    slots_[slot(seq)] = msg;
+    return true;
+}
+
+
+gcomm::evs::InputMapMsg*
+gcomm::evs::InputMapMsgIndex::Ring::release(seqno_t const seq)
+{
+    InputMapMsg* const ret(get(seq));
+    if (ret == 0) return 0;
+
+    slots_[slot(seq)] = 0;
+
+    // keep both ends of the window occupied
+    while (begin_ < end_ && slots_[slot(begin_)] == 0) ++begin_;
+    while (begin_ < end_ && slots_[slot(end_ - 1)] == 0) --end_;
+
+    return ret;
+}
+
+
+gcomm::evs::InputMapMsgIndex::InputMapMsgIndex(Pool& pool) :
+    pool_  (pool),
+    nodes_ (),
+    size_  (0)
+{ }
+
+
+gcomm::evs::InputMapMsgIndex::~InputMapMsgIndex()
+{
+    clear();
+}
+
+
+void gcomm::evs::InputMapMsgIndex::reset(size_t const nodes)
+{
+    gcomm_assert(empty() == true);
+    nodes_.resize(nodes);
+    for (size_t i(0); i < nodes_.size(); ++i)
+    {
+        nodes_[i].reserve(InputMapRingInitialSize);
+    }
+}
+
+
+gcomm::evs::InputMapMsgIndex::iterator
+gcomm::evs::InputMapMsgIndex::begin() const
+{
+    // lowest seqno wins, lowest node index on tie
+    iterator ret(end());
+    for (size_t i(0); i < nodes_.size(); ++i)
+    {
+        if (nodes_[i].empty() == false &&
+            (ret.seq_ == -1 || nodes_[i].front() < ret.seq_))
+        {
+            ret = iterator(this, i, nodes_[i].front());
+        }
+    }
+    return ret;
+}
+
+
+void gcomm::evs::InputMapMsgIndex::next(iterator& i) const
+{
+    for (size_t n(i.node_ + 1); n < nodes_.size(); ++n)
+    {
+        if (nodes_[n].get(i.seq_) != 0)
+        {
+            i.node_ = n;
+            return;
+        }
+    }
+
+    seqno_t last(-1);
+    for (size_t n(0); n < nodes_.size(); ++n)
+    {
+        if (nodes_[n].empty() == false)
+        {
+            last = std::max(last, nodes_[n].back());
+        }
+    }
+
+    for (seqno_t seq(i.seq_ + 1); seq <= last; ++seq)
+    {
+        for (size_t n(0); n < nodes_.size(); ++n)
+        {
+            if (nodes_[n].get(seq) != 0)
+            {
+                i = iterator(this, n, seq);
+                return;
+            }
+        }
+    }
+
+    i = end();
+}
+
+
+gcomm::evs::InputMapMsgIndex::iterator
+gcomm::evs::InputMapMsgIndex::find(const InputMapMsgKey& key) const
+{
+    if (key.index() < nodes_.size() &&
+        nodes_[key.index()].get(key.seq()) != 0)
+    {
+        return iterator(this, key.index(), key.seq());
+    }
+    return end();
+}
+
+
+gcomm::evs::InputMapMsgIndex::iterator
+gcomm::evs::InputMapMsgIndex::find_checked(const InputMapMsgKey& key) const
+{
+    iterator ret(find(key));
+    if (ret == end())
+    {
+        gu_throw_fatal << "element " << key << " not found";
+    }
+    return ret;
+}
+
+
+gcomm::evs::InputMapMsgIndex::iterator
+gcomm::evs::InputMapMsgIndex::insert_unique(const InputMapMsgKey& key,
+                                            const UserMessage&    msg,
+                                            const Datagram&       rb)
+{
+    InputMapMsg* const m(new (pool_.acquire()) InputMapMsg(msg, rb));
+    try
+    {
+        insert(key, m);
+    }
+    catch (...)
+    {
+        destroy(m);
+        throw;
+    }
+    return iterator(this, key.index(), key.seq());
+}
+
+
+void gcomm::evs::InputMapMsgIndex::insert(const InputMapMsgKey& key,
+                                          InputMapMsg* const    msg)
+{
+    gcomm_assert(key.index() < nodes_.size())
+        << "node index " << key.index() << " out of range";
+    if (nodes_[key.index()].insert(key.seq(), msg) == false)
+    {
+        gu_throw_fatal << "duplicate entry key=" << key;
+    }
+    ++size_;
+}
+
+
+gcomm::evs::InputMapMsg*
+gcomm::evs::InputMapMsgIndex::release(const InputMapMsgKey& key)
+{
+    gcomm_assert(key.index() < nodes_.size());
+    InputMapMsg* const ret(nodes_[key.index()].release(key.seq()));
+    if (ret == 0)
+    {
+        gu_throw_fatal << "element " << key << " not found";
+    }
+    --size_;
+    return ret;
+}
+
+
+void gcomm::evs::InputMapMsgIndex::erase(iterator i)
+{
+    destroy(release(key(i)));
+}
+
+
+void gcomm::evs::InputMapMsgIndex::erase_up_to(seqno_t const seq)
+{
+    for (size_t i(0); i < nodes_.size(); ++i)
+    {
+        Ring& ring(nodes_[i]);
+        while (ring.empty() == false && ring.front() <= seq)
+        {
+            destroy(ring.release(ring.front()));
+            --size_;
+        }
+    }
+}
+
+
+void gcomm::evs::InputMapMsgIndex::transfer(iterator i, InputMapMsgIndex& to)
+{
+    assert(&pool_ == &to.pool_);
+    InputMapMsg* const msg(release(key(i)));
+    try
+    {
+        to.insert(key(i), msg);
+    }
+    catch (...)
+    {
+        destroy(msg);
+        throw;
+    }
+}
+
+
+void gcomm::evs::InputMapMsgIndex::clear()
+{
+    erase_up_to(std::numeric_limits<seqno_t>::max());
+    assert(size_ == 0);
+}
+
+
+void gcomm::evs::InputMapMsgIndex::destroy(InputMapMsg* const msg)
+{
+    msg->~InputMapMsg();
+    pool_.recycle(msg);
+}
+
+
+
 //////////////////////////////////////////////////////////////////////////
 //
 // Constructors/destructors
@@ -116,9 +396,11 @@ std::ostream& gcomm::evs::operator<<(std::ostream& os, const InputMap& im)
 gcomm::evs::InputMap::InputMap() :
     safe_seq_       (-1),
     aru_seq_        (-1),
+    msg_pool_       (new InputMapMsgIndex::Pool(sizeof(InputMapMsg), 1024,
+                                                "evs_input_map")),
     node_index_     (new InputMapNodeIndex()),
-    msg_index_      (new InputMapMsgIndex()),
-    recovery_index_ (new InputMapMsgIndex())
+    msg_index_      (new InputMapMsgIndex(*msg_pool_)),
+    recovery_index_ (new InputMapMsgIndex(*msg_pool_))
 { }
 
 
@@ -128,6 +410,7 @@ gcomm::evs::InputMap::~InputMap()
     delete node_index_;
     delete msg_index_;
     delete recovery_index_;
+    delete msg_pool_;
 }
 
 
@@ -147,6 +430,8 @@ void gcomm::evs::InputMap::reset(const size_t nodes)
 
     log_debug << " size " << node_index_->size();
     gu_trace(node_index_->resize(nodes, InputMapNode()));
+    gu_trace(msg_index_->reset(nodes));
+    gu_trace(recovery_index_->reset(nodes));
     for (size_t i = 0; i < nodes; ++i)
     {
         node_index_->at(i).set_index(i);
@@ -283,22 +568,24 @@ gcomm::evs::InputMap::insert(const size_t uuid,
 
         if (msg_i == msg_index_->end())
         {
-            Datagram ins_dg(s == msg.seq() ?
-                                Datagram(rb)   :
-                                Datagram());
-            gu_trace((void)msg_index_->insert_unique(
-                         std::make_pair(
-                             InputMapMsgKey(node.index(), s),
-                             InputMapMsg(
-                                 (s == msg.seq() ?
-                                  msg :
-                                  UserMessage(msg.version(),
-                                              msg.source(),
-                                              msg.source_view_id(),
-                                              s,
-                                              msg.aru_seq(),
-                                              0,
-                                              O_DROP)), ins_dg))));
+            const InputMapMsgKey key(node.index(), s);
+            if (s == msg.seq())
+            {
+                gu_trace((void)msg_index_->insert_unique(key, msg, rb));
+            }
+            else
+            {
+                gu_trace((void)msg_index_->insert_unique(
+                             key,
+                             UserMessage(msg.version(),
+                                         msg.source(),
+                                         msg.source_view_id(),
+                                         s,
+                                         msg.aru_seq(),
+                                         0,
+                                         O_DROP),
+                             Datagram()));
+            }
         }
 
         // Update highest seen
@@ -333,8 +620,7 @@ gcomm::evs::InputMap::insert(const size_t uuid,
 
 void gcomm::evs::InputMap::erase(iterator i)
 {
-    gu_trace(recovery_index_->insert_unique(*i));
-    gu_trace(msg_index_->erase(i));
+    gu_trace(msg_index_->transfer(i, *recovery_index_));
 }
 
 
@@ -425,7 +711,5 @@ inline void gcomm::evs::InputMap::update_aru()
 void gcomm::evs::InputMap::cleanup_recovery_index()
 {
     gcomm_assert(node_index_->size() > 0);
-    InputMapMsgIndex::iterator i = recovery_index_->lower_bound(
-        InputMapMsgKey(0, safe_seq_ + 1));
-    recovery_index_->erase(recovery_index_->begin(), i);
+    recovery_index_->erase_up_to(safe_seq_);
 }
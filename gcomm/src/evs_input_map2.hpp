@@ -20,9 +20,10 @@
 #define EVS_INPUT_MAP2_HPP
 
 #include "evs_message2.hpp"
-#include "gcomm/map.hpp"
 #include "gcomm/datagram.hpp"
 
+#include "gu_mem_pool.hpp"
+
 #include <vector>
 
 
@@ -36,6 +37,7 @@ namespace gcomm
         class InputMapMsg;
         std::ostream& operator<<(std::ostream&, const InputMapMsg&);
         class InputMapMsgIndex;
+        std::ostream& operator<<(std::ostream&, const InputMapMsgIndex&);
         class InputMapNode;
         std::ostream& operator<<(std::ostream&, const InputMapNode&);
         typedef std::vector<InputMapNode> InputMapNodeIndex;
@@ -92,31 +94,150 @@ private:
 };
 
 
-#if defined(GALERA_USE_BOOST_POOL_ALLOC)
+/*!
+ * Index of messages keyed by (node index, seqno).
+ *
+ * Sequence numbers of each node are dense, so messages are kept in
+ * per node ring buffers addressed by seqno, which makes insert, find
+ * and erase O(1). Message objects are allocated from a memory pool
+ * shared between indexes of the same input map, so that they can be
+ * moved from one index to another without copying. Iteration order
+ * is the same as ordering by InputMapMsgKey: by seqno, then by node
+ * index. Iterators stay valid when other messages are inserted or
+ * erased.
+ */
+class gcomm::evs::InputMapMsgIndex
+{
+public:
+
+    typedef gu::MemPoolUnsafe Pool;
+
+    class iterator
+    {
+    public:
+        iterator() : index_(0), node_(0), seq_(-1) { }
+
+        iterator& operator++() { index_->next(*this); return *this; }
+
+        bool operator==(const iterator& cmp) const
+        {
+            return (seq_ == cmp.seq_ && node_ == cmp.node_);
+        }
+
+        bool operator!=(const iterator& cmp) const
+        {
+            return !(*this == cmp);
+        }
+
+    private:
+        friend class InputMapMsgIndex;
+
+        iterator(const InputMapMsgIndex* index, size_t node, seqno_t seq)
+            : index_(index), node_(node), seq_(seq)
+        { }
+
+        const InputMapMsgIndex* index_;
+        size_t                  node_;
+        seqno_t                 seq_;
+    };
+
+    typedef iterator const_iterator;
+
+    explicit InputMapMsgIndex(Pool& pool);
+
+    ~InputMapMsgIndex();
+
+    static InputMapMsgKey key(const iterator& i)
+    {
+        return InputMapMsgKey(i.node_, i.seq_);
+    }
+
+    static const InputMapMsg& value(const iterator& i)
+    {
+        return *i.index_->nodes_[i.node_].get(i.seq_);
+    }
+
+    /*! Set the number of nodes, index must be empty. */
+    void reset(size_t nodes);
+
+    iterator begin() const;
+    iterator end  () const { return iterator(this, 0, -1); }
+
+    iterator find        (const InputMapMsgKey& key) const;
+    iterator find_checked(const InputMapMsgKey& key) const;
 
-#include <boost/pool/pool_alloc.hpp>
+    /*!
+     * Insert new message.
+     *
+     * @throws FatalException if message with the same key already exists
+     */
+    iterator insert_unique(const InputMapMsgKey& key,
+                           const UserMessage&    msg,
+                           const Datagram&       rb);
+
+    void erase(iterator i);
 
-class gcomm::evs::InputMapMsgIndex :
-    public Map<InputMapMsgKey, InputMapMsg,
-               std::map<InputMapMsgKey,
-                        InputMapMsg,
-                        std::less<InputMapMsgKey>,
-                        boost::fast_pool_allocator<
-                            std::pair<const InputMapMsgKey, InputMapMsg>,
-                            boost::default_user_allocator_new_delete,
-                            boost::details::pool::null_mutex
-                            >
-                        >
-               >
-{};
+    /*! Erase all messages with seqno less than or equal to seq. */
+    void erase_up_to(seqno_t seq);
+
+    /*! Move message pointed by i to index to without copying it. */
+    void transfer(iterator i, InputMapMsgIndex& to);
+
+    size_t size () const { return size_; }
+    bool   empty() const { return size_ == 0; }
+
+    void clear();
+
+private:
 
-#else /* GALERA_USE_BOOST_POOL_ALLOC */
+    InputMapMsgIndex(const InputMapMsgIndex&);
+    void operator=(const InputMapMsgIndex&);
 
-class gcomm::evs::InputMapMsgIndex :
-    public Map<InputMapMsgKey, InputMapMsg>
-{};
+    /* Ring buffer of messages of a single node. Holds messages
+     * in window [begin_, end_), slots at both ends of non-empty
+     * window are always occupied. */
+    class Ring
+    {
+    public:
+        Ring() : slots_(), begin_(0), end_(0) { }
+
+        InputMapMsg* get(seqno_t seq) const
+        {
+            return (seq >= begin_ && seq < end_ ? slots_[slot(seq)] : 0);
+        }
+
+        bool    empty() const { return begin_ == end_; }
+        seqno_t front() const { return begin_;         }
+        seqno_t back () const { return end_ - 1;       }
+
+        void reserve(size_t n);
+        bool insert (seqno_t seq, InputMapMsg* msg);
+        InputMapMsg* release(seqno_t seq);
+
+    private:
+        size_t slot(seqno_t seq) const
+        {
+            return (static_cast<size_t>(seq) & (slots_.size() - 1));
+        }
+
+        std::vector<InputMapMsg*> slots_;
+        seqno_t                   begin_;
+        seqno_t                   end_;
+    };
+
+    void next(iterator& i) const;
+
+    void insert(const InputMapMsgKey& key, InputMapMsg* msg);
+
+    InputMapMsg* release(const InputMapMsgKey& key);
+
+    void destroy(InputMapMsg* msg);
+
+    Pool&             pool_;
+    std::vector<Ring> nodes_;
+    size_t            size_;
+};
 
-#endif /* GALERA_USE_BOOST_POOL_ALLOC */
 
 /* Internal node representation */
 class gcomm::evs::InputMapNode
@@ -360,6 +481,7 @@ private:
 
     seqno_t            safe_seq_;       /*!< Safe seqno               */
     seqno_t            aru_seq_;        /*!< All received up to seqno */
+    InputMapMsgIndex::Pool* msg_pool_;  /*!< Message memory pool      */
     InputMapNodeIndex* node_index_;     /*!< Index of nodes           */
     InputMapMsgIndex*  msg_index_;      /*!< Index of messages        */
     InputMapMsgIndex*  recovery_index_; /*!< Recovery index           */
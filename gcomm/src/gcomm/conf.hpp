@@ -47,6 +47,15 @@ namespace gcomm
         static std::string const ProtonetBackend;
         static std::string const ProtonetVersion;
 
+        /*!
+         * @brief Number of threads running protonet event loop
+         *        ("protonet.threads")
+         *
+         * Socket I/O and message checksums are processed in parallel
+         * for different connections, protocol processing is serialized.
+         */
+        static std::string const ProtonetThreads;
+
         /*!
          * @brief TCP non-blocking flag ("socket.non_blocking")
          *
@@ -297,6 +297,25 @@ namespace gcomm
 
         return (hdr.crc32() != 0);
     }
+
+    /* checksum of serialized message of len bytes following NetHeader,
+     * same as crc32() of the datagram received from it */
+    uint32_t crc32(NetHeader::checksum_t type, const gu::byte_t* buf,
+                   size_t len);
+
+    /* returns true if checksum fails */
+    inline bool check_cs (const NetHeader& hdr, const gu::byte_t* buf)
+    {
+        if (hdr.has_crc32c())
+            return (crc32(NetHeader::CS_CRC32C, buf, hdr.len())
+                    != hdr.crc32());
+
+        if (hdr.has_crc32())
+            return (crc32(NetHeader::CS_CRC32, buf, hdr.len())
+                    != hdr.crc32());
+
+        return (hdr.crc32() != 0);
+    }
 } /* namespace gcomm */
 
 #endif // GCOMM_DATAGRAM_HPP
@@ -16,6 +16,7 @@
 #include "gu_datetime.hpp"
 #include "protostack.hpp"
 #include "gu_config.hpp"
+#include "gu_status.hpp"
 
 #include "socket.hpp"
 
@@ -125,6 +126,11 @@ public:
 
     virtual size_t mtu() const = 0;
 
+    //!
+    // Add event loop thread statistics to status
+    //
+    virtual void get_status(gu::Status& status) const = 0;
+
 protected:
 
     std::deque<Protostack*> protos_;
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2020 Codership Oy <info@codership.com>
+ */
+
+/**
+ * This is to benchmark gcomm TCP transport throughput over loopback.
+ *
+ * The main thread sends messages of the given size through a gcomm socket
+ * connected to 127.0.0.1, protonet event loop runs in a separate thread
+ * like in gcs gcomm backend and counts received messages.
+ * Results are reported as messages/sec and MB/sec.
+ *
+ * Usage: asio_loopback_bench [messages] [message size] [protonet threads]
+ */
+
+#include "gcomm/protonet.hpp"
+#include "gcomm/protostack.hpp"
+#include "gcomm/datagram.hpp"
+#include "gcomm/conf.hpp"
+
+#include "gu_asio.hpp"
+#include "gu_crc32c.h" // gu_crc32c_configure()
+#include "gu_lock.hpp"
+#include "gu_logger.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/time.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+static double time_diff(const struct timeval& l,
+                        const struct timeval& r)
+{
+    double const left(double(l.tv_usec)*1.0e-06 + l.tv_sec);
+    double const right(double(r.tv_usec)*1.0e-06 + r.tv_sec);
+    return left - right;
+}
+
+class Receiver : public gcomm::Toplay
+{
+public:
+
+    Receiver(gu::Config& conf)
+        : gcomm::Toplay(conf), mtx_(), cond_(), msgs_(0), bytes_(0)
+    { }
+
+    void handle_up(const void*, const gcomm::Datagram& dg,
+                   const gcomm::ProtoUpMeta&)
+    {
+        gu::Lock lock(mtx_);
+        ++msgs_;
+        bytes_ += dg.len() - dg.offset();
+        cond_.signal();
+    }
+
+    void wait(size_t const msgs)
+    {
+        gu::Lock lock(mtx_);
+        while (msgs_ < msgs) lock.wait(cond_);
+    }
+
+    size_t bytes() const { return bytes_; }
+
+private:
+
+    gu::Mutex mtx_;
+    gu::Cond  cond_;
+    size_t    msgs_;
+    size_t    bytes_;
+};
+
+static volatile bool running(true);
+
+extern "C" void* event_loop(void* arg)
+{
+    gcomm::Protonet* const pn(static_cast<gcomm::Protonet*>(arg));
+
+    while (running) pn->event_loop(gu::datetime::Sec/10);
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t msgs(1000000);
+    size_t size(200);
+    int    threads(1);
+
+    if (argc > 1) { std::istringstream is(argv[1]); is >> msgs; }
+    if (argc > 2) { std::istringstream is(argv[2]); is >> size; }
+    if (argc > 3) { std::istringstream is(argv[3]); is >> threads; }
+
+    gu_conf_self_tstamp_on();
+    gu_crc32c_configure();
+
+    gu::Config conf;
+    gu::ssl_register_params(conf);
+    gcomm::Conf::register_params(conf);
+    conf.set(gcomm::Conf::ProtonetThreads, threads);
+
+    gcomm::Protonet* const pn(gcomm::Protonet::create(conf));
+
+    std::string uri_str("tcp://127.0.0.1:0");
+    gcomm::Acceptor* const acc(pn->acceptor(uri_str));
+    acc->listen(uri_str);
+    uri_str = acc->listen_addr();
+
+    gcomm::SocketPtr cl(pn->socket(uri_str));
+    cl->connect(uri_str);
+    pn->event_loop(gu::datetime::Sec);
+    gcomm::SocketPtr sr(acc->accept());
+
+    if (size > cl->mtu())
+    {
+        std::cerr << "Message size " << size << " exceeds MTU " << cl->mtu()
+                  << std::endl;
+        return 1;
+    }
+
+    Receiver          recv(conf);
+    gcomm::Protostack pstack;
+    pstack.push_proto(&recv);
+    pn->insert(&pstack);
+
+    pthread_t thd;
+    pthread_create(&thd, NULL, event_loop, pn);
+
+    gu::SharedBuffer const payload(new gu::Buffer(size));
+
+    struct timeval start, stop;
+    gettimeofday(&start, NULL);
+
+    for (size_t i(0); i < msgs; )
+    {
+        gcomm::Datagram dg(payload);
+        int const err(cl->send(0, dg));
+
+        if (0 == err)
+        {
+            ++i;
+        }
+        else if (ENOBUFS == err)
+        {
+            sched_yield(); // let the event loop drain send queue
+        }
+        else
+        {
+            std::cerr << "Send failed: " << err << std::endl;
+            return 1;
+        }
+    }
+
+    recv.wait(msgs);
+
+    gettimeofday(&stop, NULL);
+    double const secs(time_diff(stop, start));
+
+    running = false;
+    pthread_join(thd, NULL);
+
+    std::cout << msgs << " messages of " << size << " bytes in " << secs
+              << " sec: " << msgs/secs << " msgs/sec, "
+              << recv.bytes()/secs/(1 << 20) << " MB/sec" << std::endl;
+
+    pn->erase(&pstack);
+    pstack.pop_proto(&recv);
+    cl->close();
+    sr->close();
+    delete acc;
+    delete pn;
+
+    return 0;
+}
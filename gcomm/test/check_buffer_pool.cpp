@@ -0,0 +1,73 @@
+//
+// Copyright (C) 2020 Codership Oy <info@codership.com>
+//
+
+#include "check_gcomm.hpp"
+#include "buffer_pool.hpp"
+
+#include <check.h>
+
+// Buffer returned by get() has the requested size.
+START_TEST(test_get)
+{
+    gcomm::BufferPool pool(2);
+    gu::SharedBuffer buf(pool.get(8));
+    ck_assert(buf->size() == 8);
+    ck_assert(pool.get(0)->size() == 0);
+}
+END_TEST
+
+// Buffer released by its users is reused.
+START_TEST(test_reuse)
+{
+    gcomm::BufferPool pool(2);
+    const gu::Buffer* first;
+    {
+        gu::SharedBuffer buf(pool.get(8));
+        first = buf.get();
+    }
+    pool.get(1);
+    gu::SharedBuffer buf(pool.get(2));
+    ck_assert(buf.get() == first);
+    ck_assert(buf->size() == 2);
+}
+END_TEST
+
+// Buffer still in use is never overwritten.
+START_TEST(test_in_use)
+{
+    gcomm::BufferPool pool(2);
+    gu::SharedBuffer held(pool.get(8));
+    (*held)[0] = 1;
+
+    for (size_t i(0); i < 3 * pool.size(); ++i)
+    {
+        gu::SharedBuffer buf(pool.get(4));
+        ck_assert(buf.get() != held.get());
+        (*buf)[0] = 2;
+    }
+
+    ck_assert(held->size() == 8);
+    ck_assert((*held)[0] == 1);
+}
+END_TEST
+
+Suite* buffer_pool_suite()
+{
+    Suite* ret(suite_create("gcomm::BufferPool"));
+    TCase* tc;
+
+    tc = tcase_create("test_get");
+    tcase_add_test(tc, test_get);
+    suite_add_tcase(ret, tc);
+
+    tc = tcase_create("test_reuse");
+    tcase_add_test(tc, test_reuse);
+    suite_add_tcase(ret, tc);
+
+    tc = tcase_create("test_in_use");
+    tcase_add_test(tc, test_in_use);
+    suite_add_tcase(ret, tc);
+
+    return ret;
+}
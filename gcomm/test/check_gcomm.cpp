@@ -4,6 +4,7 @@
 
 #include "check_gcomm.hpp"
 
+#include "gu_crc32c.h"         // gu_crc32c_configure()
 #include "gu_string_utils.hpp" // strsplit()
 #include "gu_exception.hpp"
 #include "gu_logger.hpp"
@@ -31,6 +32,7 @@ struct GCommSuite
 
 static GCommSuite suites[] = {
     {"fair_send_queue", fair_send_queue_suite},
+    {"buffer_pool", buffer_pool_suite},
     {"util", util_suite},
     {"types", types_suite},
     {"evs2", evs2_suite},
@@ -71,6 +73,8 @@ int main(int argc, char* argv[])
         //gu::Logger::enable_debug(true);
     }
 
+    gu_crc32c_configure();
+
     log_info << "check_gcomm, start tests";
     if (::getenv("CHECK_GCOMM_SUITES"))
     {
@@ -20,6 +20,7 @@
 #include <fstream>
 #include <limits>
 #include <cstdlib>
+#include <stdexcept>
 #include <check.h>
 
 using std::vector;
@@ -68,6 +69,157 @@ START_TEST(test_asio)
 
 }
 END_TEST
+
+class CountingToplay : public Toplay
+{
+public:
+    CountingToplay(gu::Config& conf) : Toplay(conf), msgs_(0), bytes_(0) { }
+
+    void handle_up(const void*, const Datagram& dg, const ProtoUpMeta& um)
+    {
+        if (um.err_no() == 0 && dg.len() > 0)
+        {
+            ++msgs_;
+            bytes_ += dg.len() - dg.offset();
+        }
+    }
+
+    size_t msgs_;
+    size_t bytes_;
+};
+
+START_TEST(test_asio_threads)
+{
+    gu::Config conf;
+    gu::ssl_register_params(conf);
+    gcomm::Conf::register_params(conf);
+    conf.set(gcomm::Conf::ProtonetThreads, 3);
+    AsioProtonet pn(conf);
+    ck_assert(pn.threads() == 3);
+    string uri_str("tcp://127.0.0.1:0");
+
+    Acceptor* acc = pn.acceptor(uri_str);
+    acc->listen(uri_str);
+    uri_str = acc->listen_addr();
+
+    SocketPtr cl = pn.socket(uri_str);
+    cl->connect(uri_str);
+    pn.event_loop(gu::datetime::Sec);
+
+    SocketPtr sr = acc->accept();
+    ck_assert(sr->state() == Socket::S_CONNECTED);
+
+    CountingToplay top(conf);
+    Protostack pstack;
+    pstack.push_proto(&top);
+    pn.insert(&pstack);
+
+    vector<byte_t> buf(cl->mtu());
+    for (size_t i = 0; i < buf.size(); ++i)
+    {
+        buf[i] = static_cast<byte_t>(i & 0xff);
+    }
+
+    size_t const n_msgs(100);
+    for (size_t i = 0; i < n_msgs; ++i)
+    {
+        Datagram dg(Buffer(&buf[0], &buf[0] + buf.size()));
+        ck_assert(cl->send(0, dg) == 0);
+    }
+    for (int i(0); i < 10 && top.msgs_ < n_msgs; ++i)
+    {
+        pn.event_loop(gu::datetime::Sec/10);
+    }
+
+    {
+        Critical<Protonet> crit(pn);
+        ck_assert_msg(top.msgs_ == n_msgs, "received %zu messages", top.msgs_);
+        ck_assert(top.bytes_ == n_msgs * buf.size());
+    }
+
+    gu::Status status;
+    pn.get_status(status);
+    // protonet_threads, busy and run time of each thread
+    ck_assert(status.size() == 1 + 2*pn.threads());
+
+    pn.erase(&pstack);
+    pstack.pop_proto(&top);
+    cl->close();
+    sr->close();
+    pn.event_loop(gu::datetime::Sec/10);
+    delete acc;
+}
+END_TEST
+
+class ThrowingToplay : public Toplay
+{
+public:
+    ThrowingToplay(gu::Config& conf) : Toplay(conf) { }
+
+    void handle_up(const void*, const Datagram& dg, const ProtoUpMeta& um)
+    {
+        if (um.err_no() == 0 && dg.len() > 0)
+        {
+            throw std::runtime_error("handle_up() failed");
+        }
+    }
+};
+
+// Exception in any event loop thread is passed to event_loop() caller,
+// helper threads are stopped then.
+START_TEST(test_asio_threads_error)
+{
+    gu::Config conf;
+    gu::ssl_register_params(conf);
+    gcomm::Conf::register_params(conf);
+    conf.set(gcomm::Conf::ProtonetThreads, 3);
+    AsioProtonet pn(conf);
+    string uri_str("tcp://127.0.0.1:0");
+
+    Acceptor* acc = pn.acceptor(uri_str);
+    acc->listen(uri_str);
+    uri_str = acc->listen_addr();
+
+    SocketPtr cl = pn.socket(uri_str);
+    cl->connect(uri_str);
+    pn.event_loop(gu::datetime::Sec);
+
+    SocketPtr sr = acc->accept();
+    ck_assert(sr->state() == Socket::S_CONNECTED);
+
+    ThrowingToplay top(conf);
+    Protostack pstack;
+    pstack.push_proto(&top);
+    pn.insert(&pstack);
+
+    vector<byte_t> buf(100);
+    Datagram dg(Buffer(&buf[0], &buf[0] + buf.size()));
+    ck_assert(cl->send(0, dg) == 0);
+
+    bool failed(false);
+    for (int i(0); i < 10 && failed == false; ++i)
+    {
+        try
+        {
+            pn.event_loop(gu::datetime::Sec/10);
+        }
+        catch (std::exception& e)
+        {
+            failed = true;
+        }
+    }
+
+    ck_assert(failed);
+    ck_assert(pn.threads() == 1);
+
+    pn.erase(&pstack);
+    pstack.pop_proto(&top);
+    cl->close();
+    sr->close();
+    pn.event_loop(gu::datetime::Sec/10);
+    delete acc;
+}
+END_TEST
 #endif // HAVE_ASIO_HPP
 
 START_TEST(test_protonet)
@@ -94,6 +246,14 @@ Suite* util_nondet_suite()
     tc = tcase_create("test_asio");
     tcase_add_test(tc, test_asio);
     suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_asio_threads");
+    tcase_add_test(tc, test_asio_threads);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_asio_threads_error");
+    tcase_add_test(tc, test_asio_threads_error);
+    suite_add_tcase(s, tc);
 #endif // HAVE_ASIO_HPP
 
     tc = tcase_create("test_protonet");
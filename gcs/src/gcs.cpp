@@ -18,6 +18,7 @@
 #include <galerautils.h>
 #include "gu_debug_sync.hpp"
 #include <gu_uuid.hpp>
+#include <gu_spmc_fifo.hpp>
 
 #include "gcs_priv.hpp"
 #include "gcs_params.hpp"
@@ -129,9 +130,10 @@ struct gcs_conn
     gu_thread_t      send_thread;
 
     /* A queue for threads waiting for received actions */
-    gu_fifo_t*   recv_q;
-    ssize_t      recv_q_size;
+    gu::SpmcFifo<struct gcs_recv_act>* recv_q;
+    ssize_t      recv_q_size;         // updated atomically
     gu_thread_t  recv_thread;
+    gu_mutex_t   recv_lock;           // FC and sync decisions on recv_q
 
     /* Message receiving timeout - absolute date in nanoseconds */
     long long    timeout;
@@ -181,14 +183,18 @@ struct gcs_conn
 
     /* sync control */
     bool         sync_sent_;
-    bool         sync_sent() const
+    bool         sync_sent()
     {
-        assert(gu_fifo_locked(recv_q));
+#ifdef GU_DEBUG_MUTEX
+        assert(gu_mutex_owned(&recv_lock));
+#endif
         return sync_sent_;
     }
     void         sync_sent(bool const val)
     {
-        assert(gu_fifo_locked(recv_q));
+#ifdef GU_DEBUG_MUTEX
+        assert(gu_mutex_owned(&recv_lock));
+#endif
         sync_sent_ = val;
     }
 
@@ -327,7 +333,15 @@ gcs_create (gu_config_t* const conf, gcache_t* const gcache,
         else
         {
             gu_debug ("Requesting recv queue len: %zu", recv_q_len);
-            conn->recv_q = gu_fifo_create (recv_q_len, sizeof(struct gcs_recv_act));
+            try
+            {
+                conn->recv_q =
+                    new gu::SpmcFifo<struct gcs_recv_act>(recv_q_len);
+            }
+            catch (gu::Exception& e)
+            {
+                gu_error ("%s", e.what());
+            }
         }
     }
     if (!conn->recv_q) {
@@ -353,12 +367,13 @@ gcs_create (gu_config_t* const conf, gcache_t* const gcache,
         GCS_CONN_DONOR : GCS_CONN_JOINED;
 
     gu_mutex_init (&conn->fc_lock, NULL);
+    gu_mutex_init (&conn->recv_lock, NULL);
 
     return conn; // success
 
 sm_create_failed:
 
-    gu_fifo_destroy (conn->recv_q);
+    delete conn->recv_q;
 
 recv_q_failed:
 
@@ -431,7 +446,7 @@ gcs_send_fc_event (gcs_conn_t* conn, bool stop)
     return gcs_core_send_fc (conn->core, &fc, sizeof(fc));
 }
 
-/* To be called under slave queue lock. Returns true if FC_STOP must be sent */
+/* To be called under recv_lock. Returns true if FC_STOP must be sent */
 static inline bool
 gcs_fc_stop_begin (gcs_conn_t* conn)
 {
@@ -494,7 +509,7 @@ gcs_fc_stop_end (gcs_conn_t* conn)
     return ret;
 }
 
-/* To be called under slave queue lock. Returns true if FC_CONT must be sent */
+/* To be called under recv_lock. Returns true if FC_CONT must be sent */
 static inline bool
 gcs_fc_cont_begin (gcs_conn_t* conn)
 {
@@ -556,7 +571,7 @@ gcs_fc_cont_end (gcs_conn_t* conn)
     return ret;
 }
 
-/* To be called under slave queue lock. Returns true if SYNC must be sent */
+/* To be called under recv_lock. Returns true if SYNC must be sent */
 static inline bool
 gcs_send_sync_begin (gcs_conn_t* conn)
 {
@@ -598,9 +613,9 @@ gcs_send_sync_end (gcs_conn_t* conn)
         ret = 0;
     }
     else {
-        gu_fifo_lock(conn->recv_q);
+        gu_mutex_lock(&conn->recv_lock);
         conn->sync_sent(false);
-        gu_fifo_release(conn->recv_q);
+        gu_mutex_unlock(&conn->recv_lock);
     }
 
     ret = gcs_check_error (ret, "Failed to send SYNC signal");
@@ -611,9 +626,10 @@ gcs_send_sync_end (gcs_conn_t* conn)
 static inline long
 gcs_send_sync (gcs_conn_t* conn)
 {
-    gu_fifo_lock(conn->recv_q);
+    gu_mutex_lock(&conn->recv_lock);
+    conn->queue_len = conn->recv_q->length();
     bool const send_sync(gcs_send_sync_begin (conn));
-    gu_fifo_release(conn->recv_q);
+    gu_mutex_unlock(&conn->recv_lock);
 
     if (send_sync) {
         return gcs_send_sync_end (conn);
@@ -752,7 +768,7 @@ gcs_become_joiner (gcs_conn_t* conn)
         abort();
     }
 
-    gcs_fc_reset (&conn->stfc, conn->recv_q_size);
+    gcs_fc_reset (&conn->stfc, gu_atomic_get_n(&conn->recv_q_size));
     gcs_fc_debug (&conn->stfc, conn->params.fc_debug);
 }
 
@@ -828,7 +844,7 @@ gcs_become_joined (gcs_conn_t* conn)
 
     /* See also gcs_handle_act_conf () for a case of cluster bootstrapping */
     if (gcs_shift_state (conn, GCS_CONN_JOINED)) {
-        conn->fc_offset    = conn->queue_len;
+        conn->fc_offset    = conn->recv_q->length();
         conn->join_seqno   = GCS_SEQNO_NIL;
         conn->need_to_join = false;
         gu_debug("Become joined, FC offset %ld", conn->fc_offset);
@@ -845,17 +861,17 @@ gcs_become_joined (gcs_conn_t* conn)
 static void
 gcs_become_synced (gcs_conn_t* conn)
 {
-    gu_fifo_lock(conn->recv_q);
+    gu_mutex_lock(&conn->recv_lock);
     {
         gcs_shift_state (conn, GCS_CONN_SYNCED);
         conn->sync_sent(false);
     }
-    gu_fifo_release(conn->recv_q);
+    gu_mutex_unlock(&conn->recv_lock);
     gu_debug("Become synced, FC offset %ld", conn->fc_offset);
     conn->fc_offset = 0;
 }
 
-/* to be called under protection of both recv_q and fc_lock */
+/* to be called under protection of both recv_lock and fc_lock */
 static void
 _set_fc_limits (gcs_conn_t* conn)
 {
@@ -869,8 +885,8 @@ _set_fc_limits (gcs_conn_t* conn)
 
     /* The upper/lower limits cannot exceed the number of items in the
      * receive queue, so bound them by the max length. */
-    conn->upper_limit = std::min(conn->upper_limit, gu_fifo_max_length(conn->recv_q));
-    conn->lower_limit = std::min(conn->lower_limit, gu_fifo_max_length(conn->recv_q));
+    conn->upper_limit = std::min(conn->upper_limit, conn->recv_q->max_length());
+    conn->lower_limit = std::min(conn->lower_limit, conn->recv_q->max_length());
 
     gu_info ("Flow-control interval: [%ld, %ld]",
              conn->lower_limit, conn->upper_limit);
@@ -946,7 +962,7 @@ gcs_handle_act_conf (gcs_conn_t* conn, const void* action)
 
     conn->my_idx = conf->my_idx;
 
-    gu_fifo_lock(conn->recv_q);
+    gu_mutex_lock(&conn->recv_lock);
     {
         /* reset flow control as membership is most likely changed */
         if (!gu_mutex_lock (&conn->fc_lock)) {
@@ -984,7 +1000,7 @@ gcs_handle_act_conf (gcs_conn_t* conn, const void* action)
 
         conn->sync_sent(false);
     }
-    gu_fifo_release (conn->recv_q);
+    gu_mutex_unlock (&conn->recv_lock);
 
     if (conf->conf_id < 0) {
         if (0 == conf->memb_num) {
@@ -1148,9 +1164,9 @@ gcs_handle_actions (gcs_conn_t*          conn,
         break;
     case GCS_ACT_SYNC:
         if (rcvd->id < 0) {
-            gu_fifo_lock(conn->recv_q);
+            gu_mutex_lock(&conn->recv_lock);
             conn->sync_sent(false);
-            gu_fifo_release(conn->recv_q);
+            gu_mutex_unlock(&conn->recv_lock);
             gcs_send_sync(conn);
         } else {
             ret = gcs_handle_state_change (conn, &rcvd->act);
@@ -1165,18 +1181,19 @@ gcs_handle_actions (gcs_conn_t*          conn,
 }
 
 static inline void
-GCS_FIFO_PUSH_TAIL (gcs_conn_t* conn, ssize_t size)
+GCS_FIFO_PUSH_TAIL (gcs_conn_t* conn, ssize_t size, bool barrier = false)
 {
-    conn->recv_q_size += size;
-    gu_fifo_push_tail(conn->recv_q);
+    gu_atomic_fetch_and_add(&conn->recv_q_size, size);
+    conn->recv_q->push_tail(barrier);
 }
 
+/* item is already copied out of the queue, only account for its size */
 static inline void
 GCS_FIFO_POP_HEAD (gcs_conn_t* conn, ssize_t size)
 {
-    assert (conn->recv_q_size >= size);
-    conn->recv_q_size -= size;
-    gu_fifo_pop_head (conn->recv_q);
+    ssize_t const old_size(gu_atomic_fetch_and_sub(&conn->recv_q_size, size));
+    assert (old_size >= size);
+    (void)old_size;
 }
 
 /* Returns true if timeout was handled and false otherwise */
@@ -1315,22 +1332,19 @@ _close(gcs_conn_t* conn, bool join_recv_thread)
         // gcs_destroy().
         if (GCS_CONN_CLOSED == conn->state && !explicit_close) {
             int err = 0;
-            struct gcs_recv_act* recv_act = NULL;
+            struct gcs_recv_act recv_act;
 
             // Reopen the queue if it is either in closed or in cancelled state (for getters).
-            gu_fifo_open(conn->recv_q);
-            while (gu_fifo_length(conn->recv_q) != 0 &&
-                   (recv_act = static_cast<gcs_recv_act*>
-                    (gu_fifo_get_head (conn->recv_q, &err))))
+            conn->recv_q->open();
+            while (conn->recv_q->try_get_head (recv_act, err))
             {
-                ::free(const_cast<void*>(recv_act->rcvd.act.buf));
-                recv_act->rcvd.act.buf = NULL;
-                GCS_FIFO_POP_HEAD (conn, recv_act->rcvd.act.buf_len); // release the queue
+                ::free(const_cast<void*>(recv_act.rcvd.act.buf));
+                GCS_FIFO_POP_HEAD (conn, recv_act.rcvd.act.buf_len);
             }
         }
 #endif /* GCS_FOR_GARB */
 
-        gu_fifo_close (conn->recv_q);
+        conn->recv_q->close();
     }
 
     return ret;
@@ -1384,11 +1398,10 @@ static void *gcs_recv_thread (void *arg)
                 /* In the case of inconsistency our concern is to report it to
                  * replicator ASAP. Current contents of the slave queue are
                  * meaningless. */
-                gu_fifo_clear(conn->recv_q);
+                conn->recv_q->clear();
             }
 
-            struct gcs_recv_act* err_act =
-                (struct gcs_recv_act*) gu_fifo_get_tail(conn->recv_q);
+            struct gcs_recv_act* err_act = conn->recv_q->get_tail();
 
             err_act->rcvd     = rcvd;
             err_act->local_id = GCS_SEQNO_ILL;
@@ -1451,19 +1464,30 @@ static void *gcs_recv_thread (void *arg)
         else if (gu_likely(this_act_id >= 0))
         {
             /* remote/non-repl'ed action */
-            struct gcs_recv_act* recv_act =
-                (struct gcs_recv_act*)gu_fifo_get_tail (conn->recv_q);
+            struct gcs_recv_act* recv_act = conn->recv_q->get_tail();
 
             if (gu_likely (NULL != recv_act)) {
 
                 recv_act->rcvd     = rcvd;
                 recv_act->local_id = this_act_id;
 
-                conn->queue_len = gu_fifo_length (conn->recv_q) + 1;
-                bool const send_stop(gcs_fc_stop_begin(conn));
+                long const queue_len(conn->recv_q->length() + 1);
+                bool send_stop(false);
+
+                /* recv_lock is needed only when FC_STOP may be due,
+                 * see gcs_fc_stop_begin() */
+                if (gu_unlikely(queue_len >
+                                conn->upper_limit + conn->fc_offset)) {
+                    gu_mutex_lock(&conn->recv_lock);
+                    conn->queue_len = queue_len;
+                    send_stop = gcs_fc_stop_begin(conn);
+                    gu_mutex_unlock(&conn->recv_lock);
+                }
 
-                // release queue
-                GCS_FIFO_PUSH_TAIL (conn, rcvd.act.buf_len);
+                /* fetching configuration change must stop other getters
+                 * until gcs_resume_recv() */
+                GCS_FIFO_PUSH_TAIL (conn, rcvd.act.buf_len,
+                                    GCS_ACT_CONF == rcvd.act.type);
 
                 if (gu_unlikely(GCS_CONN_JOINER == conn->state && !send_stop)) {
                     ret = _check_recv_queue_growth (conn, rcvd.act.buf_len);
@@ -1560,7 +1584,7 @@ long gcs_open (gcs_conn_t* conn, const char* channel, const char* url,
             if (!(ret = gu_thread_create (&conn->recv_thread, NULL,
                                           gcs_recv_thread, conn))) {
                 gcs_fifo_lite_open(conn->repl_q);
-                gu_fifo_open(conn->recv_q);
+                conn->recv_q->open();
                 gcs_shift_state (conn, GCS_CONN_OPEN);
                 gu_debug ("Opened channel '%s'", channel);
                 conn->inner_close_count = 0;
@@ -1664,7 +1688,7 @@ long gcs_destroy (gcs_conn_t *conn)
     gu_cond_destroy (&tmp_cond);
     gcs_sm_destroy (conn->sm);
     /* this should cancel all recv calls */
-    gu_fifo_destroy (conn->recv_q);
+    delete conn->recv_q;
 
     if ((err = gcs_fifo_lite_destroy (conn->repl_q)))
     {
@@ -1683,6 +1707,7 @@ long gcs_destroy (gcs_conn_t *conn)
 
     /* This must not last for long */
     while (gu_mutex_destroy (&conn->fc_lock));
+    while (gu_mutex_destroy (&conn->recv_lock));
 
     _cleanup_params (conn);
 
@@ -1982,45 +2007,51 @@ long gcs_desync (gcs_conn_t* conn, gcs_seqno_t* local)
     }
 }
 
-/* Returns when an action from another process is received */
-long gcs_recv (gcs_conn_t*        conn,
-               struct gcs_action* action)
+/* Gets next action from recv queue, blocks on empty queue if block is true */
+static long
+_recv (gcs_conn_t* conn, struct gcs_action* action, bool const block)
 {
-    int                  err;
-    struct gcs_recv_act* recv_act = NULL;
+    int                 err;
+    struct gcs_recv_act recv_act;
 
     assert (action);
 
-    if ((recv_act = (struct gcs_recv_act*)gu_fifo_get_head (conn->recv_q, &err)))
+    if (block ? conn->recv_q->get_head     (recv_act, err) :
+                conn->recv_q->try_get_head (recv_act, err))
     {
-        conn->queue_len = gu_fifo_length (conn->recv_q) - 1;
-        bool send_cont  = gcs_fc_cont_begin   (conn);
-        bool send_sync  = gcs_send_sync_begin (conn);
+        long const queue_len(conn->recv_q->length());
+        bool send_cont(false);
+        bool send_sync(false);
+
+        /* recv_lock is needed only when FC_CONT or SYNC may be due,
+         * see gcs_fc_cont_begin() and gcs_send_sync_begin() */
+        if (gu_unlikely(gu_atomic_get_n(&conn->stop_sent_) > 0  ||
+                        gu_atomic_get_n(&conn->fc_offset) > queue_len ||
+                        GCS_CONN_JOINED == conn->state)) {
+            gu_mutex_lock(&conn->recv_lock);
+            conn->queue_len = queue_len;
+            send_cont = gcs_fc_cont_begin   (conn);
+            send_sync = gcs_send_sync_begin (conn);
+            gu_mutex_unlock(&conn->recv_lock);
+        }
 
-        action->buf     = (void*)recv_act->rcvd.act.buf;
-        action->size    = recv_act->rcvd.act.buf_len;
-        action->type    = recv_act->rcvd.act.type;
-        action->seqno_g = recv_act->rcvd.id;
-        action->seqno_l = recv_act->local_id;
+        action->buf     = (void*)recv_act.rcvd.act.buf;
+        action->size    = recv_act.rcvd.act.buf_len;
+        action->type    = recv_act.rcvd.act.type;
+        action->seqno_g = recv_act.rcvd.id;
+        action->seqno_l = recv_act.local_id;
 
-        if (gu_likely(recv_act->rcvd.sender_id[0] == 0)) {
+        if (gu_likely(recv_act.rcvd.sender_id[0] == 0)) {
             action->sender_id[0] = 0;
         } else {
-            memcpy(action->sender_id, recv_act->rcvd.sender_id, GU_UUID_STR_LEN);
+            memcpy(action->sender_id, recv_act.rcvd.sender_id, GU_UUID_STR_LEN);
             action->sender_id[GU_UUID_STR_LEN] = 0;
         }
 
-        if (gu_unlikely (GCS_ACT_CONF == action->type)) {
-            err = gu_fifo_cancel_gets (conn->recv_q);
-            if (err) {
-                gu_fatal ("Internal logic error: failed to cancel recv_q "
-                          "\"gets\": %d (%s). Aborting.",
-                          err, strerror(-err));
-                gu_abort();
-            }
-        }
+        /* GCS_ACT_CONF was pushed as a barrier, so fetching it has already
+         * canceled further gets */
 
-        GCS_FIFO_POP_HEAD (conn, action->size); // release the queue
+        GCS_FIFO_POP_HEAD (conn, action->size);
 
         if (gu_unlikely(send_cont) && (err = gcs_fc_cont_end(conn))) {
             // We have successfully received an action, but failed to send
@@ -2065,12 +2096,25 @@ long gcs_recv (gcs_conn_t*        conn,
     }
 }
 
+/* Returns when an action from another process is received */
+long gcs_recv (gcs_conn_t*        conn,
+               struct gcs_action* action)
+{
+    return _recv (conn, action, true);
+}
+
+long gcs_try_recv (gcs_conn_t*        conn,
+                   struct gcs_action* action)
+{
+    return _recv (conn, action, false);
+}
+
 long
 gcs_resume_recv (gcs_conn_t* conn)
 {
     int ret = GCS_CLOSED_ERROR;
 
-    ret = gu_fifo_resume_gets (conn->recv_q);
+    ret = conn->recv_q->resume_gets();
 
     if (ret) {
         if (conn->state < GCS_CONN_CLOSED) {
@@ -2091,7 +2135,8 @@ long
 gcs_wait (gcs_conn_t* conn)
 {
     if (gu_likely(GCS_CONN_SYNCED == conn->state)) {
-       return (conn->stop_count > 0 || (conn->queue_len > conn->upper_limit));
+       return (conn->stop_count > 0 ||
+               (conn->recv_q->length() > conn->upper_limit));
     }
     else {
         switch (conn->state) {
@@ -2181,13 +2226,12 @@ gcs_seqno_t gcs_local_sequence(gcs_conn_t* conn)
 void
 gcs_get_stats (gcs_conn_t* conn, struct gcs_stats* stats)
 {
-    gu_fifo_stats_get (conn->recv_q,
-                       &stats->recv_q_len,
-                       &stats->recv_q_len_max,
-                       &stats->recv_q_len_min,
-                       &stats->recv_q_len_avg);
+    conn->recv_q->stats_get (&stats->recv_q_len,
+                             &stats->recv_q_len_max,
+                             &stats->recv_q_len_min,
+                             &stats->recv_q_len_avg);
 
-    stats->recv_q_size = conn->recv_q_size;
+    stats->recv_q_size = gu_atomic_get_n(&conn->recv_q_size);
 
     gcs_sm_stats_get (conn->sm,
                       &stats->send_q_len,
@@ -2212,7 +2256,7 @@ gcs_get_stats (gcs_conn_t* conn, struct gcs_stats* stats)
 void
 gcs_flush_stats(gcs_conn_t* conn)
 {
-    gu_fifo_stats_flush(conn->recv_q);
+    conn->recv_q->stats_flush();
     gcs_sm_stats_flush (conn->sm);
     conn->stats_fc_stop_sent = 0;
     conn->stats_fc_cont_sent = 0;
@@ -2249,7 +2293,7 @@ _set_fc_limit (gcs_conn_t* conn, const char* value)
 
         if (limit > LONG_MAX) limit = LONG_MAX;
 
-        gu_fifo_lock(conn->recv_q);
+        gu_mutex_lock(&conn->recv_lock);
         {
             if (!gu_mutex_lock (&conn->fc_lock)) {
                 conn->params.fc_base_limit = limit;
@@ -2263,7 +2307,7 @@ _set_fc_limit (gcs_conn_t* conn, const char* value)
                 abort();
             }
         }
-        gu_fifo_release (conn->recv_q);
+        gu_mutex_unlock (&conn->recv_lock);
 
         return 0;
     }
@@ -2282,7 +2326,7 @@ _set_fc_factor (gcs_conn_t* conn, const char* value)
 
         if (factor == conn->params.fc_resume_factor) return 0;
 
-        gu_fifo_lock(conn->recv_q);
+        gu_mutex_lock(&conn->recv_lock);
         {
             if (!gu_mutex_lock (&conn->fc_lock)) {
                 conn->params.fc_resume_factor = factor;
@@ -2296,7 +2340,7 @@ _set_fc_factor (gcs_conn_t* conn, const char* value)
                 abort();
             }
         }
-        gu_fifo_release (conn->recv_q);
+        gu_mutex_unlock (&conn->recv_lock);
 
         return 0;
     }
@@ -253,6 +253,18 @@ static inline long gcs_repl (gcs_conn_t*        const conn,
 extern long gcs_recv (gcs_conn_t*        conn,
                       struct gcs_action* action);
 
+/*! @brief Receives an action from group if there is one already queued.
+ * Same as gcs_recv() but never blocks.
+ *
+ * @param conn   group connection handle
+ * @param action action object
+ * @return       negative error code, action size in case of success,
+ * @retval -EAGAIN if there are no actions in the queue
+ * @retval 0     on connection close
+ */
+extern long gcs_try_recv (gcs_conn_t*        conn,
+                          struct gcs_action* action);
+
 /*!
  * @brief Schedules entry to CGS send monitor.
  * Locks send monitor and should be quickly followed by gcs_repl()/gcs_send()
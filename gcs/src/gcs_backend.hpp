@@ -73,6 +73,29 @@ long fn (gcs_backend_t* const backend,    \
          size_t         const len,        \
          gcs_msg_type_t const msg_type)
 
+/*!
+ * Send a message gathered from several buffers, optional.
+ * Saves copying message pieces into a contiguous buffer first.
+ *
+ * @param backend
+ *        a pointer to the backend handle
+ * @param bufs
+ *        an array of message pieces
+ * @param count
+ *        number of pieces in the array
+ * @param msg_type
+ *        type of the message
+ * @return
+ *        negative error code in case of error
+ *        OR
+ *        amount of bytes sent
+ */
+#define GCS_BACKEND_SEND_V_FN(fn)                 \
+long fn (gcs_backend_t*       const backend,      \
+         const struct gu_buf* const bufs,         \
+         int                  const count,        \
+         gcs_msg_type_t       const msg_type)
+
 /*!
  * Receive a message from the backend.
  *
@@ -167,6 +190,7 @@ typedef GCS_BACKEND_DESTROY_FN   ((*gcs_backend_destroy_t));
 typedef GCS_BACKEND_OPEN_FN      ((*gcs_backend_open_t));
 typedef GCS_BACKEND_CLOSE_FN     ((*gcs_backend_close_t));
 typedef GCS_BACKEND_SEND_FN      ((*gcs_backend_send_t));
+typedef GCS_BACKEND_SEND_V_FN    ((*gcs_backend_send_v_t));
 typedef GCS_BACKEND_RECV_FN      ((*gcs_backend_recv_t));
 typedef GCS_BACKEND_NAME_FN      ((*gcs_backend_name_t));
 typedef GCS_BACKEND_MSG_SIZE_FN  ((*gcs_backend_msg_size_t));
@@ -181,6 +205,7 @@ struct gcs_backend
     gcs_backend_close_t     close;
     gcs_backend_destroy_t   destroy;
     gcs_backend_send_t      send;
+    gcs_backend_send_v_t    send_v; // may be NULL
     gcs_backend_recv_t      recv;
     gcs_backend_name_t      name;
     gcs_backend_msg_size_t  msg_size;
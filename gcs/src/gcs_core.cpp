@@ -25,6 +25,8 @@
 #include <string.h> // for mempcpy
 #include <errno.h>
 
+#include <vector>
+
 bool
 gcs_core_register (gu_config_t* conf)
 {
@@ -239,12 +241,17 @@ core_error (core_state_t state)
  * restart flag may be raised if configuration changes and new nodes are
  * added - that would require all previous members to resend partially sent
  * actions.
+ *
+ * If msg_v is given, the message is gathered from msg_v_count pieces of
+ * the total size msg_len by backend send_v() call, msg is ignored.
  */
 static inline ssize_t
-core_msg_send (gcs_core_t*    core,
-               const void*    msg,
-               size_t         msg_len,
-               gcs_msg_type_t msg_type)
+core_msg_send (gcs_core_t*          core,
+               const void*          msg,
+               size_t               msg_len,
+               gcs_msg_type_t       msg_type,
+               const struct gu_buf* msg_v       = NULL,
+               int                  msg_v_count = 0)
 {
     ssize_t ret;
 
@@ -254,7 +261,15 @@ core_msg_send (gcs_core_t*    core,
                       (CORE_EXCHANGE == core->state && GCS_MSG_STATE_MSG ==
                        msg_type))) {
 
-            ret = core->backend.send (&core->backend, msg, msg_len, msg_type);
+            if (msg_v) {
+                assert (core->backend.send_v);
+                ret = core->backend.send_v (&core->backend, msg_v,
+                                            msg_v_count, msg_type);
+            }
+            else {
+                ret = core->backend.send (&core->backend, msg, msg_len,
+                                          msg_type);
+            }
 
             if (ret > 0 && ret != (ssize_t)msg_len &&
                 GCS_MSG_ACTION != msg_type) {
@@ -285,13 +300,16 @@ core_msg_send (gcs_core_t*    core,
  * by core_msg_send()
  */
 static inline ssize_t
-core_msg_send_retry (gcs_core_t*    core,
-                     const void*    buf,
-                     size_t         buf_len,
-                     gcs_msg_type_t type)
+core_msg_send_retry (gcs_core_t*          core,
+                     const void*          buf,
+                     size_t               buf_len,
+                     gcs_msg_type_t       type,
+                     const struct gu_buf* buf_v       = NULL,
+                     int                  buf_v_count = 0)
 {
     ssize_t ret;
-    while ((ret = core_msg_send (core, buf, buf_len, type)) == -EAGAIN) {
+    while ((ret = core_msg_send (core, buf, buf_len, type, buf_v, buf_v_count))
+           == -EAGAIN) {
         /* wait for primary configuration - sleep 0.01 sec */
         gu_debug ("Backend requested wait");
         usleep (10000);
@@ -348,6 +366,11 @@ gcs_core_send (gcs_core_t*          const conn,
     const uint8_t* ptr  = (const uint8_t*)action[idx].ptr;
     size_t         left = action[idx].size;
 
+    /* If backend can gather, pass it fragment pieces straight from action
+     * buffers following the header in send_buf instead of copying them. */
+    bool const gather (conn->backend.send_v != NULL);
+    std::vector<struct gu_buf> frag_v;
+
     do {
         const size_t chunk_size =
             act_size < frg.frag_len ? act_size : frg.frag_len;
@@ -356,15 +379,34 @@ gcs_core_send (gcs_core_t*          const conn,
         char* dst = (char*)frg.frag;
         size_t to_copy = chunk_size;
 
+        if (gather) {
+            struct gu_buf const hdr = { conn->send_buf, hdr_size };
+            frag_v.assign (1, hdr);
+        }
+
         while (to_copy > 0) {        // gather action bufs into one
             if (to_copy <= left) {
-                memcpy (dst, ptr, to_copy);
+                if (gather) {
+                    struct gu_buf const piece = { ptr, ssize_t(to_copy) };
+                    frag_v.push_back (piece);
+                }
+                else {
+                    memcpy (dst, ptr, to_copy);
+                }
                 ptr     += to_copy;
                 left    -= to_copy;
                 to_copy = 0;
             }
             else {
-                memcpy (dst, ptr, left);
+                if (gather) {
+                    if (left > 0) {
+                        struct gu_buf const piece = { ptr, ssize_t(left) };
+                        frag_v.push_back (piece);
+                    }
+                }
+                else {
+                    memcpy (dst, ptr, left);
+                }
                 dst     += left;
                 to_copy -= left;
                 idx++;
@@ -380,8 +422,14 @@ gcs_core_send (gcs_core_t*          const conn,
         gu_info ("Sent %p of size %zu. Total sent: %zu, left: %zu",
                  (char*)conn->send_buf + hdr_size, chunk_size, sent, act_size);
 #endif
-        ret = core_msg_send_retry (conn, conn->send_buf, send_size,
-                                   GCS_MSG_ACTION);
+        if (gather) {
+            ret = core_msg_send_retry (conn, NULL, send_size, GCS_MSG_ACTION,
+                                       &frag_v[0], frag_v.size());
+        }
+        else {
+            ret = core_msg_send_retry (conn, conn->send_buf, send_size,
+                                       GCS_MSG_ACTION);
+        }
         GU_DBUG_SYNC_WAIT("gcs_core_after_frag_send");
 #ifdef GCS_CORE_TESTING
 //        gu_lock_step_wait (&conn->ls); // pause after every fragment
@@ -124,6 +124,28 @@ GCS_BACKEND_SEND_FN(dummy_send)
     return err;
 }
 
+static
+GCS_BACKEND_SEND_V_FN(dummy_send_v)
+{
+    size_t len = 0;
+    for (int i = 0; i < count; i++) len += bufs[i].size;
+
+    char* const buf = static_cast<char*>(gu_malloc (len));
+    if (gu_unlikely(NULL == buf)) return -ENOMEM;
+
+    size_t off = 0;
+    for (int i = 0; i < count; i++) {
+        memcpy (buf + off, bufs[i].ptr, bufs[i].size);
+        off += bufs[i].size;
+    }
+
+    long const ret = dummy_send (backend, buf, len, msg_type);
+
+    gu_free (buf);
+
+    return ret;
+}
+
 static
 GCS_BACKEND_RECV_FN(dummy_recv)
 {
@@ -298,6 +320,7 @@ GCS_BACKEND_CREATE_FN(gcs_dummy_create)
     backend->close     = dummy_close;
     backend->destroy   = dummy_destroy;
     backend->send      = dummy_send;
+    backend->send_v    = dummy_send_v;
     backend->recv      = dummy_recv;
     backend->name      = dummy_name;
     backend->msg_size  = dummy_msg_size;
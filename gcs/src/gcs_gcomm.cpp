@@ -283,6 +283,7 @@ public:
     void        get_status(gu::Status& status) const
     {
         if (tp_ != 0) tp_->get_status(status);
+        net_->get_status(status);
     }
 
     gu::ThreadSchedparam schedparam() const { return schedparam_; }
@@ -568,23 +569,10 @@ static GCS_BACKEND_MSG_SIZE_FN(gcomm_msg_size)
 }
 
 
-static GCS_BACKEND_SEND_FN(gcomm_send)
+static int
+gcomm_send_dg(GCommConn& conn, Datagram& dg, gcs_msg_type_t const msg_type)
 {
-    GCommConn::Ref ref(backend);
-
-    if (gu_unlikely(ref.get() == 0))
-    {
-        return -EBADFD;
-    }
-
-    GCommConn& conn(*ref.get());
-
-    Datagram dg(
-        SharedBuffer(
-            new Buffer(reinterpret_cast<const byte_t*>(buf),
-                       reinterpret_cast<const byte_t*>(buf) + len)));
-
-    int err;
+    int err(0);
     // Set thread scheduling params if gcomm thread runs with
     // non-default params
     gu::ThreadSchedparam orig_sp;
@@ -629,10 +617,64 @@ static GCS_BACKEND_SEND_FN(gcomm_send)
         }
     }
 
+    return err;
+}
+
+
+static GCS_BACKEND_SEND_FN(gcomm_send)
+{
+    GCommConn::Ref ref(backend);
+
+    if (gu_unlikely(ref.get() == 0))
+    {
+        return -EBADFD;
+    }
+
+    GCommConn& conn(*ref.get());
+
+    Datagram dg(
+        SharedBuffer(
+            new Buffer(reinterpret_cast<const byte_t*>(buf),
+                       reinterpret_cast<const byte_t*>(buf) + len)));
+
+    int const err(gcomm_send_dg(conn, dg, msg_type));
+
     return (err == 0 ? len : -err);
 }
 
 
+static GCS_BACKEND_SEND_V_FN(gcomm_send_v)
+{
+    GCommConn::Ref ref(backend);
+
+    if (gu_unlikely(ref.get() == 0))
+    {
+        return -EBADFD;
+    }
+
+    GCommConn& conn(*ref.get());
+
+    size_t len(0);
+    for (int i(0); i < count; ++i) len += bufs[i].size;
+
+    // the only copy of the message: the protocol stack holds on to the
+    // payload until it is delivered everywhere
+    SharedBuffer payload(new Buffer());
+    payload->reserve(len);
+    for (int i(0); i < count; ++i)
+    {
+        const byte_t* const ptr(static_cast<const byte_t*>(bufs[i].ptr));
+        payload->insert(payload->end(), ptr, ptr + bufs[i].size);
+    }
+
+    Datagram dg(payload);
+
+    int const err(gcomm_send_dg(conn, dg, msg_type));
+
+    return (err == 0 ? long(len) : -err);
+}
+
+
 static void fill_cmp_msg(const View& view, const gcomm::UUID& my_uuid,
                          gcs_comp_msg_t* cm)
 {
@@ -989,6 +1031,7 @@ GCS_BACKEND_CREATE_FN(gcs_gcomm_create)
     backend->close     = gcomm_close;
     backend->destroy   = gcomm_destroy;
     backend->send      = gcomm_send;
+    backend->send_v    = gcomm_send_v;
     backend->recv      = gcomm_recv;
     backend->name      = gcomm_name;
     backend->msg_size  = gcomm_msg_size;